@@ -0,0 +1,127 @@
+#pragma once
+
+#include <ituGL/core/DeviceGL.h>
+#include <ituGL/application/Window.h>
+#include <ituGL/asset/ShaderLoader.h>
+#include <ituGL/shader/ShaderProgram.h>
+#include <ituGL/geometry/Mesh.h>
+#include <ituGL/geometry/VertexFormat.h>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdio>
+
+// Hidden window with a GL context, for the benchmarks that draw
+class BenchmarkContext
+{
+public:
+    BenchmarkContext(int width, int height)
+    {
+        // DeviceGL initializes GLFW. The window keeps the hints set before it is created
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        m_window = std::make_unique<Window>(width, height, "Benchmark");
+        if (m_window->IsValid())
+        {
+            m_device.SetCurrentWindow(*m_window);
+        }
+    }
+
+    // False if the window or the context could not be created, for instance on a machine without a GPU
+    bool IsReady() const { return m_window->IsValid() && m_device.IsReady(); }
+
+    DeviceGL& GetDevice() { return m_device; }
+
+    // Wait until the GPU executed all the commands, so that their cost is included in the time
+    void Finish() { glFinish(); }
+
+private:
+    DeviceGL m_device;
+    std::unique_ptr<Window> m_window;
+};
+
+// Load a shader from the source files of the exercises, with paths relative to the exercises directory
+inline Shader LoadExerciseShader(Shader::Type type, std::initializer_list<const char*> paths)
+{
+    std::vector<std::string> fullPaths;
+    for (const char* path : paths)
+    {
+        fullPaths.push_back(std::string(EXERCISES_PATH) + path);
+    }
+    std::vector<const char*> fullPathPointers;
+    for (const std::string& fullPath : fullPaths)
+    {
+        fullPathPointers.push_back(fullPath.c_str());
+    }
+    return ShaderLoader(type).Load(fullPathPointers);
+}
+
+// Build a shader program from source code. Returns nullptr if it fails
+inline std::shared_ptr<ShaderProgram> BuildShaderProgram(const char* vertexSource, const char* fragmentSource)
+{
+    Shader vertexShader(Shader::VertexShader);
+    vertexShader.SetSource(vertexSource);
+    Shader fragmentShader(Shader::FragmentShader);
+    fragmentShader.SetSource(fragmentSource);
+    if (!vertexShader.Compile() || !fragmentShader.Compile())
+    {
+        std::printf("error: shader compilation failed\n");
+        return nullptr;
+    }
+
+    std::shared_ptr<ShaderProgram> shaderProgram = std::make_shared<ShaderProgram>();
+    if (!shaderProgram->Build(vertexShader, fragmentShader))
+    {
+        std::printf("error: shader program linking failed\n");
+        return nullptr;
+    }
+    return shaderProgram;
+}
+
+// Cube of size 1, centered at the origin. Positions, normals and texture coordinates are in locations 0, 1 and 2
+inline std::shared_ptr<Mesh> CreateCubeMesh()
+{
+    struct Vertex
+    {
+        glm::vec3 position;
+        glm::vec3 normal;
+        glm::vec2 texCoord;
+    };
+
+    std::vector<Vertex> vertices;
+    std::vector<unsigned short> elements;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        for (float side : { -1.0f, 1.0f })
+        {
+            // 4 corners of the face, counter-clockwise seen from outside
+            glm::vec3 normal(0.0f);
+            normal[axis] = side;
+            glm::vec3 u(0.0f), v(0.0f);
+            u[(axis + 1) % 3] = 0.5f;
+            v[(axis + 2) % 3] = 0.5f * side;
+
+            unsigned short first = static_cast<unsigned short>(vertices.size());
+            vertices.push_back(Vertex{ 0.5f * normal - u - v, normal, glm::vec2(0, 0) });
+            vertices.push_back(Vertex{ 0.5f * normal + u - v, normal, glm::vec2(1, 0) });
+            vertices.push_back(Vertex{ 0.5f * normal + u + v, normal, glm::vec2(1, 1) });
+            vertices.push_back(Vertex{ 0.5f * normal - u + v, normal, glm::vec2(0, 1) });
+            for (unsigned short corner : { 0, 1, 2, 0, 2, 3 })
+            {
+                elements.push_back(first + corner);
+            }
+        }
+    }
+
+    VertexFormat vertexFormat;
+    vertexFormat.AddVertexAttribute<float>(3, VertexAttribute::Semantic::Position);
+    vertexFormat.AddVertexAttribute<float>(3, VertexAttribute::Semantic::Normal);
+    vertexFormat.AddVertexAttribute<float>(2, VertexAttribute::Semantic::TexCoord0);
+
+    std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>();
+    mesh->AddSubmesh<Vertex, unsigned short, VertexFormat::LayoutIterator>(Drawcall::Primitive::Triangles, vertices, elements,
+        vertexFormat.LayoutBegin(static_cast<int>(vertices.size()), true), vertexFormat.LayoutEnd());
+    return mesh;
+}
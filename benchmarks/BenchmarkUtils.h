@@ -0,0 +1,43 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+
+// Run setup and then function runCount times, and return the median time of function in milliseconds
+// setup is not timed. The median ignores the few runs slowed down by other processes
+template<typename SetupFunction, typename Function>
+double MeasureMedian(unsigned int runCount, SetupFunction&& setup, Function&& function)
+{
+    std::vector<double> times;
+    times.reserve(runCount);
+    for (unsigned int run = 0; run < runCount; ++run)
+    {
+        setup();
+        auto start = std::chrono::steady_clock::now();
+        function();
+        auto end = std::chrono::steady_clock::now();
+        times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    std::nth_element(times.begin(), times.begin() + runCount / 2, times.end());
+    return times[runCount / 2];
+}
+
+template<typename Function>
+double MeasureMedian(unsigned int runCount, Function&& function)
+{
+    return MeasureMedian(runCount, []() {}, function);
+}
+
+inline void PrintResult(const char* name, unsigned int count, double milliseconds)
+{
+    std::printf("%-40s %9u %10.3f ms\n", name, count, milliseconds);
+}
+
+// Print the ratio between a reference time and a new one
+inline void PrintSpeedup(double referenceMilliseconds, double milliseconds)
+{
+    std::printf("%-40s %9s %10.2fx\n", "speedup", "", referenceMilliseconds / milliseconds);
+}
+
@@ -0,0 +1,78 @@
+#include "BenchmarkUtils.h"
+
+#include <ituGL/scene/BoundsArray.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <random>
+
+// Compares the SIMD frustum test of BoundsArray with the reference test, one element at a time.
+// The SIMD path is chosen when the library is compiled: build with -mavx (or /arch:AVX) to measure AVX
+
+static const unsigned int RunCount = 21;
+
+static void AddBounds(BoundsArray& boundsArray, unsigned int count)
+{
+    // Half spheres and half AABBs, spread around the camera so that some of them are visible
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> position(-200.0f, 200.0f);
+    std::uniform_real_distribution<float> size(0.5f, 5.0f);
+
+    boundsArray.Reserve(count);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        glm::vec3 center(position(random), position(random), position(random));
+        if (i % 2 == 0)
+        {
+            boundsArray.Add(SphereBounds(center, size(random)));
+        }
+        else
+        {
+            boundsArray.Add(AabbBounds(center, glm::vec3(size(random), size(random), size(random))));
+        }
+    }
+}
+
+static bool RunBenchmark(unsigned int count)
+{
+    BoundsArray boundsArray;
+    AddBounds(boundsArray, count);
+
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 150.0f);
+    FrustumBounds frustum(projection * view);
+
+    std::vector<std::uint8_t> referenceMask(boundsArray.GetVisibilityMaskSize());
+    std::vector<std::uint8_t> mask(boundsArray.GetVisibilityMaskSize());
+
+    double referenceTime = MeasureMedian(RunCount, [&]() { boundsArray.TestFrustumReference(frustum, referenceMask); });
+    double simdTime = MeasureMedian(RunCount, [&]() { boundsArray.TestFrustum(frustum, mask); });
+
+    PrintResult("TestFrustumReference", count, referenceTime);
+    PrintResult("TestFrustum", count, simdTime);
+    PrintSpeedup(referenceTime, simdTime);
+
+    return mask == referenceMask;
+}
+
+int main()
+{
+#if defined(__AVX__)
+    std::printf("TestFrustum uses AVX\n");
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    std::printf("TestFrustum uses SSE\n");
+#else
+    std::printf("TestFrustum uses the scalar fallback\n");
+#endif
+
+    bool equal = true;
+    for (unsigned int count : { 10000u, 100000u, 1000000u })
+    {
+        equal &= RunBenchmark(count);
+    }
+
+    if (!equal)
+    {
+        std::printf("error: TestFrustum and TestFrustumReference masks are different\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,158 @@
+#include "BenchmarkUtils.h"
+#include "BenchmarkContext.h"
+
+#include <ituGL/renderer/Renderer.h>
+#include <ituGL/renderer/ForwardRenderPass.h>
+#include <ituGL/camera/Camera.h>
+#include <ituGL/geometry/Model.h>
+#include <ituGL/shader/Material.h>
+#include <ituGL/lighting/PointLight.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <random>
+
+// Draws a grid of cubes lit by 16 to 4096 point lights through ForwardRenderPass, with the forward shader of exercise07
+// reading the light clusters, and with the same shader drawn once per light. Needs a GPU
+
+static const unsigned int RunCount = 9;
+static const unsigned int GridSize = 32;
+
+// One pass per light draws every object once per light, more lights take too long to be measured
+static const unsigned int MaxPerLightCount = 256;
+
+static std::shared_ptr<Material> CreateMaterial(Renderer& renderer, const char* lightingPath)
+{
+    Shader vertexShader = LoadExerciseShader(Shader::VertexShader, { "exercise07/shaders/version330.glsl", "exercise07/shaders/lit.vert" });
+    Shader fragmentShader = LoadExerciseShader(Shader::FragmentShader, { "exercise07/shaders/version330.glsl",
+        "exercise07/shaders/utils.glsl", "exercise07/shaders/blinn-phong.glsl", lightingPath, "exercise07/shaders/lit.frag" });
+
+    std::shared_ptr<ShaderProgram> shaderProgram = std::make_shared<ShaderProgram>();
+    if (!shaderProgram->Build(vertexShader, fragmentShader))
+    {
+        std::printf("error: shader program linking failed\n");
+        return nullptr;
+    }
+
+    ShaderProgram::Location cameraPositionLocation = shaderProgram->GetUniformLocation("CameraPosition");
+    ShaderProgram::Location worldMatrixLocation = shaderProgram->GetUniformLocation("WorldMatrix");
+    ShaderProgram::Location viewProjMatrixLocation = shaderProgram->GetUniformLocation("ViewProjMatrix");
+    renderer.RegisterShaderProgram(shaderProgram,
+        [=](const ShaderProgram& shaderProgram, const glm::mat4& worldMatrix, const Camera& camera, bool cameraChanged)
+        {
+            if (cameraChanged)
+            {
+                shaderProgram.SetUniform(cameraPositionLocation, camera.ExtractTranslation());
+                shaderProgram.SetUniform(viewProjMatrixLocation, camera.GetViewProjectionMatrix());
+            }
+            shaderProgram.SetUniform(worldMatrixLocation, worldMatrix);
+        },
+        renderer.GetDefaultUpdateLightsFunction(*shaderProgram));
+
+    ShaderUniformCollection::NameSet filteredUniforms;
+    filteredUniforms.insert("CameraPosition");
+    filteredUniforms.insert("WorldMatrix");
+    filteredUniforms.insert("ViewProjMatrix");
+    filteredUniforms.insert("AmbientColor");
+    filteredUniforms.insert("LightColor");
+    filteredUniforms.insert("LightPosition");
+    filteredUniforms.insert("LightDirection");
+    filteredUniforms.insert("LightAttenuation");
+    filteredUniforms.insert("LightData");
+    filteredUniforms.insert("LightClusters");
+    filteredUniforms.insert("LightIndices");
+    filteredUniforms.insert("ClusterGridSize");
+    filteredUniforms.insert("ClusterGridParams");
+    filteredUniforms.insert("ClusterDepthPlane");
+    filteredUniforms.insert("ClusterGlobalLightCount");
+
+    std::shared_ptr<Material> material = std::make_shared<Material>(shaderProgram, filteredUniforms);
+    material->SetUniformValue("Color", glm::vec3(1.0f));
+    material->SetUniformValue("AmbientReflectance", 1.0f);
+    material->SetUniformValue("DiffuseReflectance", 1.0f);
+    material->SetUniformValue("SpecularReflectance", 0.5f);
+    material->SetUniformValue("SpecularExponent", 100.0f);
+    return material;
+}
+
+int main()
+{
+    BenchmarkContext context(1280, 720);
+    if (!context.IsReady())
+    {
+        std::printf("No GL context available, skipping\n");
+        return 0;
+    }
+
+    Renderer renderer(context.GetDevice());
+    renderer.AddRenderPass(std::make_unique<ForwardRenderPass>());
+
+    Camera camera;
+    camera.SetViewMatrix(glm::vec3(0.0f, 30.0f, 45.0f), glm::vec3(0.0f));
+    camera.SetPerspectiveProjectionMatrix(glm::radians(60.0f), 1280.0f / 720.0f, 0.1f, 200.0f);
+
+    std::vector<glm::mat4> worldMatrices;
+    for (unsigned int i = 0; i < GridSize * GridSize; ++i)
+    {
+        glm::vec3 position((i % GridSize) * 2.0f - GridSize, 0.0f, (i / GridSize) * 2.0f - GridSize);
+        worldMatrices.push_back(glm::scale(glm::translate(glm::mat4(1.0f), position), glm::vec3(1.8f)));
+    }
+
+    // Small lights spread over the grid, each one reaches a few cubes
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> position(-float(GridSize), float(GridSize));
+    std::uniform_real_distribution<float> height(1.0f, 4.0f);
+    std::uniform_real_distribution<float> color(0.2f, 1.0f);
+    std::vector<PointLight> lights(4096);
+    for (PointLight& light : lights)
+    {
+        light.SetPosition(glm::vec3(position(random), height(random), position(random)));
+        light.SetColor(glm::vec3(color(random), color(random), color(random)));
+        light.SetDistanceAttenuation(glm::vec2(2.0f, 5.0f));
+    }
+
+    std::shared_ptr<Mesh> mesh = CreateCubeMesh();
+
+    std::shared_ptr<Material> clusteredMaterial = CreateMaterial(renderer, "exercise07/shaders/clustered.glsl");
+    std::shared_ptr<Material> perLightMaterial = CreateMaterial(renderer, "exercise07/shaders/lighting.glsl");
+    if (!clusteredMaterial || !perLightMaterial)
+    {
+        return 1;
+    }
+
+    for (unsigned int lightCount : { 16u, 64u, 256u, 1024u, 4096u })
+    {
+        double times[2] = {};
+        for (bool clustered : { false, true })
+        {
+            if (!clustered && lightCount > MaxPerLightCount)
+            {
+                continue;
+            }
+
+            Model model(mesh);
+            model.AddMaterial(clustered ? clusteredMaterial : perLightMaterial);
+
+            // Time of the frame including the GPU, lighting is mostly GPU work
+            times[clustered] = MeasureMedian(RunCount, [&]() { context.Finish(); }, [&]()
+                {
+                    renderer.SetCurrentCamera(camera);
+                    for (unsigned int i = 0; i < lightCount; ++i)
+                    {
+                        renderer.AddLight(lights[i]);
+                    }
+                    for (const glm::mat4& worldMatrix : worldMatrices)
+                    {
+                        renderer.AddModel(model, worldMatrix);
+                    }
+                    context.GetDevice().Clear(true, Color(0.0f, 0.0f, 0.0f, 1.0f), true, 1.0f);
+                    renderer.Render();
+                    context.Finish();
+                });
+            PrintResult(clustered ? "clustered, CPU + GPU" : "one pass per light, CPU + GPU", lightCount, times[clustered]);
+        }
+        if (times[0] > 0.0)
+        {
+            PrintSpeedup(times[0], times[1]);
+        }
+    }
+    return 0;
+}
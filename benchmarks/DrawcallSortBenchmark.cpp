@@ -0,0 +1,175 @@
+#include "BenchmarkUtils.h"
+
+#include <ituGL/renderer/Renderer.h>
+#include <ituGL/shader/Material.h>
+#include <ituGL/shader/ShaderProgram.h>
+#include <ituGL/geometry/VertexArrayObject.h>
+#include <ituGL/geometry/Drawcall.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <random>
+#include <bit>
+
+// Compares the radix sort by precomputed keys with the comparator sort that it replaced.
+// Sorting never reads the GL objects, so the few GL functions that their constructors call are replaced and no
+// context is needed
+
+static GLuint s_lastHandle = 0;
+
+// The debug build of glad checks glGetError after every call
+static GLenum APIENTRY GetError() { return GL_NO_ERROR; }
+static GLuint APIENTRY CreateProgram() { return ++s_lastHandle; }
+static void APIENTRY DeleteProgram(GLuint) {}
+static void APIENTRY GetProgramiv(GLuint, GLenum, GLint* params) { *params = 0; }
+static void APIENTRY GenVertexArrays(GLsizei n, GLuint* arrays) { for (GLsizei i = 0; i < n; ++i) arrays[i] = ++s_lastHandle; }
+static void APIENTRY DeleteVertexArrays(GLsizei, const GLuint*) {}
+
+static void ReplaceGLFunctions()
+{
+    glad_glGetError = GetError;
+    glad_glCreateProgram = CreateProgram;
+    glad_glDeleteProgram = DeleteProgram;
+    glad_glGetProgramiv = GetProgramiv;
+    glad_glGenVertexArrays = GenVertexArrays;
+    glad_glDeleteVertexArrays = DeleteVertexArrays;
+}
+
+static const unsigned int RunCount = 21;
+
+// Variety of state of a typical scene
+static const unsigned int MaterialCount = 64;
+static const unsigned int VAOCount = 256;
+
+struct Scene
+{
+    std::vector<std::shared_ptr<ShaderProgram>> shaderPrograms;
+    std::vector<std::unique_ptr<Material>> materials;
+    std::vector<std::unique_ptr<VertexArrayObject>> vaos;
+    Drawcall drawcall;
+
+    std::vector<glm::mat4> worldMatrices;
+    glm::mat4 viewMatrix;
+};
+
+static void CreateScene(Scene& scene, unsigned int drawcallCount)
+{
+    for (unsigned int i = 0; i < 8; ++i)
+    {
+        scene.shaderPrograms.push_back(std::make_shared<ShaderProgram>());
+    }
+    for (unsigned int i = 0; i < MaterialCount; ++i)
+    {
+        scene.materials.push_back(std::make_unique<Material>(scene.shaderPrograms[i % scene.shaderPrograms.size()]));
+    }
+    for (unsigned int i = 0; i < VAOCount; ++i)
+    {
+        scene.vaos.push_back(std::make_unique<VertexArrayObject>());
+    }
+
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+    for (unsigned int i = 0; i < drawcallCount; ++i)
+    {
+        scene.worldMatrices.push_back(glm::translate(glm::mat4(1.0f), glm::vec3(position(random), position(random), position(random))));
+    }
+    scene.viewMatrix = glm::lookAt(glm::vec3(0.0f, 0.0f, 600.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+static void AddDrawcalls(const Scene& scene, Renderer::DrawcallCollection& collection)
+{
+    collection.Clear();
+    for (unsigned int i = 0; i < scene.worldMatrices.size(); ++i)
+    {
+        // Same mix of state that AddModel produces for models with several submeshes
+        const Material& material = *scene.materials[(i * 7) % MaterialCount];
+        const VertexArrayObject& vao = *scene.vaos[(i * 13) % VAOCount];
+        collection.AddDrawcall(Renderer::DrawcallInfo(material, i, vao, scene.drawcall));
+    }
+}
+
+static float GetViewDepth(const Scene& scene, unsigned int worldMatrixIndex)
+{
+    const glm::mat4& viewMatrix = scene.viewMatrix;
+    glm::vec3 position = scene.worldMatrices[worldMatrixIndex][3];
+    return -(viewMatrix[0][2] * position.x + viewMatrix[1][2] * position.y + viewMatrix[2][2] * position.z + viewMatrix[3][2]);
+}
+
+// Same layout as Renderer::ComputeSortKey for opaque drawcalls
+static Renderer::SortKey ComputeSortKey(const Scene& scene, const Renderer::DrawcallInfo& drawcallInfo)
+{
+    const Material& material = drawcallInfo.GetMaterial();
+    Renderer::SortKey program = material.GetShaderProgram()->GetHandle() & 0x7FF;
+    Renderer::SortKey vao = drawcallInfo.GetVAO().GetHandle() & 0xFFF;
+    Renderer::SortKey materialAddress = reinterpret_cast<std::uintptr_t>(&material);
+    Renderer::SortKey materialHash = ((materialAddress >> 4) * 0x9E3779B97F4A7C15ull) >> (64 - 12);
+
+    Renderer::SortKey depth = 0;
+    float viewDepth = GetViewDepth(scene, drawcallInfo.GetWorldMatrixIndex());
+    if (viewDepth > 0.0f)
+    {
+        depth = std::bit_cast<std::uint32_t>(viewDepth) >> (31 - 24);
+    }
+    return (program << 48) | (materialHash << 36) | (vao << 24) | depth;
+}
+
+static bool RunBenchmark(unsigned int drawcallCount)
+{
+    Scene scene;
+    CreateScene(scene, drawcallCount);
+
+    Renderer::DrawcallCollection collection;
+    std::vector<Renderer::DrawcallInfo> scratch;
+
+    // Before: std::sort with a comparator that computes the view depth of both drawcalls on every comparison,
+    // like Renderer::IsFrontToBack
+    double comparatorTime = MeasureMedian(RunCount,
+        [&]() { AddDrawcalls(scene, collection); },
+        [&]()
+        {
+            std::span<Renderer::DrawcallInfo> drawcalls = collection.GetFrameDrawcalls();
+            std::sort(drawcalls.begin(), drawcalls.end(), [&](const Renderer::DrawcallInfo& a, const Renderer::DrawcallInfo& b)
+                {
+                    return GetViewDepth(scene, a.GetWorldMatrixIndex()) < GetViewDepth(scene, b.GetWorldMatrixIndex());
+                });
+        });
+
+    // After: one key per drawcall, computed when it is added, and the radix sort of the collection
+    double radixTime = MeasureMedian(RunCount,
+        [&]() { AddDrawcalls(scene, collection); },
+        [&]()
+        {
+            for (Renderer::DrawcallInfo& drawcallInfo : collection.GetFrameDrawcalls())
+            {
+                drawcallInfo.SetSortKey(ComputeSortKey(scene, drawcallInfo));
+            }
+            collection.SortByKey(scratch);
+        });
+
+    std::span<Renderer::DrawcallInfo> drawcalls = collection.GetFrameDrawcalls();
+    bool sorted = std::is_sorted(drawcalls.begin(), drawcalls.end(), [](const Renderer::DrawcallInfo& a, const Renderer::DrawcallInfo& b)
+        {
+            return a.GetSortKey() < b.GetSortKey();
+        });
+
+    PrintResult("std::sort with depth comparator", drawcallCount, comparatorTime);
+    PrintResult("keys + radix sort", drawcallCount, radixTime);
+    PrintSpeedup(comparatorTime, radixTime);
+    return sorted;
+}
+
+int main()
+{
+    ReplaceGLFunctions();
+
+    bool sorted = true;
+    for (unsigned int drawcallCount : { 1000u, 10000u, 100000u })
+    {
+        sorted &= RunBenchmark(drawcallCount);
+    }
+
+    if (!sorted)
+    {
+        std::printf("error: radix sort result is not in key order\n");
+        return 1;
+    }
+    return 0;
+}
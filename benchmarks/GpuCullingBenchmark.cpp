@@ -0,0 +1,149 @@
+#include "BenchmarkUtils.h"
+#include "BenchmarkContext.h"
+
+#include <ituGL/renderer/Renderer.h>
+#include <ituGL/renderer/ForwardRenderPass.h>
+#include <ituGL/renderer/GpuDrivenRenderPass.h>
+#include <ituGL/camera/Camera.h>
+#include <ituGL/geometry/Model.h>
+#include <ituGL/shader/Material.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <random>
+
+// Draws 50k cubes around the camera, culled on the CPU and drawn with instancing by ForwardRenderPass, and culled and
+// drawn by GpuDrivenRenderPass with the culling program of exercise09. Needs a GPU with GL 4.3
+
+static const unsigned int RunCount = 21;
+static const unsigned int ObjectCount = 50000;
+
+static const char* VertexSource = R"(
+#version 330 core
+layout (location = 0) in vec3 VertexPosition;
+layout (location = 3) in mat4 InstanceWorldMatrix;
+uniform mat4 ViewProjMatrix;
+void main()
+{
+    gl_Position = ViewProjMatrix * (InstanceWorldMatrix * vec4(VertexPosition, 1.0));
+}
+)";
+
+static const char* FragmentSource = R"(
+#version 330 core
+uniform vec3 Color;
+out vec4 FragColor;
+void main()
+{
+    FragColor = vec4(Color, 1.0);
+}
+)";
+
+int main()
+{
+    BenchmarkContext context(1280, 720);
+    if (!context.IsReady())
+    {
+        std::printf("No GL context available, skipping\n");
+        return 0;
+    }
+    if (!GpuDrivenRenderPass::IsSupported())
+    {
+        std::printf("GPU culling needs OpenGL 4.3, skipping\n");
+        return 0;
+    }
+
+    Renderer renderer(context.GetDevice());
+    renderer.AddRenderPass(std::make_unique<ForwardRenderPass>());
+
+    Shader computeShader = LoadExerciseShader(Shader::ComputeShader, { "exercise09/shaders/version430.glsl", "exercise09/shaders/renderer/gpuculling.comp" });
+    std::shared_ptr<ShaderProgram> cullingProgram = std::make_shared<ShaderProgram>();
+    if (!cullingProgram->Build(computeShader))
+    {
+        std::printf("error: culling program linking failed\n");
+        return 1;
+    }
+    std::unique_ptr<GpuDrivenRenderPass> gpuDrivenRenderPass = std::make_unique<GpuDrivenRenderPass>(cullingProgram);
+    const GpuDrivenRenderPass* gpuDrivenRenderPassPtr = gpuDrivenRenderPass.get();
+    renderer.AddRenderPass(std::move(gpuDrivenRenderPass));
+
+    std::shared_ptr<ShaderProgram> shaderProgram = BuildShaderProgram(VertexSource, FragmentSource);
+    if (!shaderProgram)
+    {
+        return 1;
+    }
+    ShaderProgram::Location viewProjMatrixLocation = shaderProgram->GetUniformLocation("ViewProjMatrix");
+    renderer.RegisterShaderProgram(shaderProgram,
+        [=](const ShaderProgram& shaderProgram, const glm::mat4& /*worldMatrix*/, const Camera& camera, bool cameraChanged)
+        {
+            if (cameraChanged)
+            {
+                shaderProgram.SetUniform(viewProjMatrixLocation, camera.GetViewProjectionMatrix());
+            }
+        },
+        renderer.GetDefaultUpdateLightsFunction(*shaderProgram));
+
+    ShaderUniformCollection::NameSet filteredUniforms;
+    filteredUniforms.insert("ViewProjMatrix");
+    std::shared_ptr<Material> material = std::make_shared<Material>(shaderProgram, filteredUniforms);
+    material->SetUniformValue("Color", glm::vec3(1.0f));
+
+    Model model(CreateCubeMesh());
+    model.AddMaterial(material);
+
+    Camera camera;
+    camera.SetViewMatrix(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f));
+    camera.SetPerspectiveProjectionMatrix(glm::radians(60.0f), 1280.0f / 720.0f, 0.1f, 500.0f);
+
+    // Objects all around the camera, only a part of them is in the frustum
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> position(-300.0f, 300.0f);
+    std::vector<glm::mat4> worldMatrices;
+    std::vector<AabbBounds> worldBounds;
+    for (unsigned int i = 0; i < ObjectCount; ++i)
+    {
+        glm::vec3 center(position(random), position(random), position(random));
+        worldMatrices.push_back(glm::translate(glm::mat4(1.0f), center));
+        worldBounds.push_back(AabbBounds(center, glm::vec3(0.5f)));
+    }
+
+    double cpuTimes[2], frameTimes[2];
+    for (bool gpuCulling : { false, true })
+    {
+        auto renderFrame = [&]()
+            {
+                renderer.SetCurrentCamera(camera);
+                for (unsigned int i = 0; i < ObjectCount; ++i)
+                {
+                    if (gpuCulling)
+                    {
+                        renderer.AddGpuCulledModel(model, worldMatrices[i], worldBounds[i]);
+                    }
+                    else if (renderer.IsVisible(worldBounds[i]))
+                    {
+                        renderer.AddModel(model, worldMatrices[i]);
+                    }
+                }
+                context.GetDevice().Clear(true, Color(0.0f, 0.0f, 0.0f, 1.0f), true, 1.0f);
+                renderer.Render();
+            };
+        cpuTimes[gpuCulling] = MeasureMedian(RunCount, [&]() { context.Finish(); }, renderFrame);
+        frameTimes[gpuCulling] = MeasureMedian(RunCount, [&]() { context.Finish(); }, [&]() { renderFrame(); context.Finish(); });
+
+        PrintResult(gpuCulling ? "GPU culling, CPU" : "CPU culling, CPU", ObjectCount, cpuTimes[gpuCulling]);
+        PrintResult(gpuCulling ? "GPU culling, CPU + GPU" : "CPU culling, CPU + GPU", ObjectCount, frameTimes[gpuCulling]);
+        if (gpuCulling)
+        {
+            const GpuDrivenRenderPass::Stats& stats = gpuDrivenRenderPassPtr->GetStats();
+            std::printf("%u objects in %u groups, %u multi-draw calls\n", stats.objects, stats.groups, stats.multiDraws);
+        }
+        else
+        {
+            const Renderer::CullingStats& stats = renderer.GetCullingStats();
+            std::printf("%u visible, %u culled\n", stats.visible, stats.culled);
+        }
+    }
+
+    std::printf("GPU culling against CPU culling:\n");
+    PrintSpeedup(cpuTimes[0], cpuTimes[1]);
+    PrintSpeedup(frameTimes[0], frameTimes[1]);
+    return 0;
+}
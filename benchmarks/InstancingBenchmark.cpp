@@ -0,0 +1,153 @@
+#include "BenchmarkUtils.h"
+#include "BenchmarkContext.h"
+
+#include <ituGL/renderer/Renderer.h>
+#include <ituGL/renderer/ForwardRenderPass.h>
+#include <ituGL/camera/Camera.h>
+#include <ituGL/geometry/Model.h>
+#include <ituGL/shader/Material.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+// Draws 10k cubes with the same mesh and material through ForwardRenderPass, with a program that uses the instance
+// world matrix attribute and with one that has the world matrix uniform. Needs a GPU
+
+static const unsigned int RunCount = 21;
+static const unsigned int GridSize = 100;
+
+static const char* InstancedVertexSource = R"(
+#version 330 core
+layout (location = 0) in vec3 VertexPosition;
+layout (location = 3) in mat4 InstanceWorldMatrix;
+uniform mat4 ViewProjMatrix;
+void main()
+{
+    gl_Position = ViewProjMatrix * (InstanceWorldMatrix * vec4(VertexPosition, 1.0));
+}
+)";
+
+static const char* VertexSource = R"(
+#version 330 core
+layout (location = 0) in vec3 VertexPosition;
+uniform mat4 WorldMatrix;
+uniform mat4 ViewProjMatrix;
+void main()
+{
+    gl_Position = ViewProjMatrix * (WorldMatrix * vec4(VertexPosition, 1.0));
+}
+)";
+
+static const char* FragmentSource = R"(
+#version 330 core
+uniform vec3 Color;
+out vec4 FragColor;
+void main()
+{
+    FragColor = vec4(Color, 1.0);
+}
+)";
+
+static std::shared_ptr<Material> CreateMaterial(Renderer& renderer, const char* vertexSource)
+{
+    std::shared_ptr<ShaderProgram> shaderProgram = BuildShaderProgram(vertexSource, FragmentSource);
+    if (!shaderProgram)
+    {
+        return nullptr;
+    }
+
+    ShaderProgram::Location worldMatrixLocation = shaderProgram->GetUniformLocation("WorldMatrix");
+    ShaderProgram::Location viewProjMatrixLocation = shaderProgram->GetUniformLocation("ViewProjMatrix");
+    renderer.RegisterShaderProgram(shaderProgram,
+        [=](const ShaderProgram& shaderProgram, const glm::mat4& worldMatrix, const Camera& camera, bool cameraChanged)
+        {
+            if (cameraChanged)
+            {
+                shaderProgram.SetUniform(viewProjMatrixLocation, camera.GetViewProjectionMatrix());
+            }
+            shaderProgram.SetUniform(worldMatrixLocation, worldMatrix);
+        },
+        renderer.GetDefaultUpdateLightsFunction(*shaderProgram));
+
+    ShaderUniformCollection::NameSet filteredUniforms;
+    filteredUniforms.insert("WorldMatrix");
+    filteredUniforms.insert("ViewProjMatrix");
+    std::shared_ptr<Material> material = std::make_shared<Material>(shaderProgram, filteredUniforms);
+    material->SetUniformValue("Color", glm::vec3(1.0f));
+    return material;
+}
+
+int main()
+{
+    BenchmarkContext context(1280, 720);
+    if (!context.IsReady())
+    {
+        std::printf("No GL context available, skipping\n");
+        return 0;
+    }
+
+    Renderer renderer(context.GetDevice());
+    renderer.AddRenderPass(std::make_unique<ForwardRenderPass>());
+
+    Camera camera;
+    camera.SetViewMatrix(glm::vec3(0.0f, 150.0f, 150.0f), glm::vec3(0.0f));
+    camera.SetPerspectiveProjectionMatrix(glm::radians(60.0f), 1280.0f / 720.0f, 0.1f, 1000.0f);
+
+    std::vector<glm::mat4> worldMatrices;
+    for (unsigned int i = 0; i < GridSize * GridSize; ++i)
+    {
+        glm::vec3 position((i % GridSize) * 2.0f - GridSize, 0.0f, (i / GridSize) * 2.0f - GridSize);
+        worldMatrices.push_back(glm::translate(glm::mat4(1.0f), position));
+    }
+
+    std::shared_ptr<Mesh> mesh = CreateCubeMesh();
+
+    bool instanced = true;
+    double cpuTimes[2], frameTimes[2];
+    for (const char* vertexSource : { VertexSource, InstancedVertexSource })
+    {
+        std::shared_ptr<Material> material = CreateMaterial(renderer, vertexSource);
+        if (!material)
+        {
+            return 1;
+        }
+        Model model(mesh);
+        model.AddMaterial(material);
+
+        // Adding the models and rendering is the CPU time of the frame, waiting for the GPU gives the total
+        auto renderFrame = [&]()
+            {
+                renderer.SetCurrentCamera(camera);
+                for (const glm::mat4& worldMatrix : worldMatrices)
+                {
+                    renderer.AddModel(model, worldMatrix);
+                }
+                context.GetDevice().Clear(true, Color(0.0f, 0.0f, 0.0f, 1.0f), true, 1.0f);
+                renderer.Render();
+            };
+        double cpuTime = MeasureMedian(RunCount, [&]() { context.Finish(); }, renderFrame);
+        double frameTime = MeasureMedian(RunCount, [&]() { context.Finish(); }, [&]() { renderFrame(); context.Finish(); });
+
+        const Renderer::DrawcallStats& stats = renderer.GetDrawcallStats();
+        bool isInstanced = vertexSource == InstancedVertexSource;
+        cpuTimes[isInstanced] = cpuTime;
+        frameTimes[isInstanced] = frameTime;
+        PrintResult(isInstanced ? "instanced, CPU" : "world matrix uniform, CPU", GridSize * GridSize, cpuTime);
+        PrintResult(isInstanced ? "instanced, CPU + GPU" : "world matrix uniform, CPU + GPU", GridSize * GridSize, frameTime);
+        std::printf("%u drawcalls, %u instanced drawcalls with %u instances\n", stats.drawcalls, stats.instancedDrawcalls, stats.instances);
+
+        if (isInstanced && stats.instancedDrawcalls == 0)
+        {
+            instanced = false;
+        }
+    }
+
+    std::printf("instanced against world matrix uniform:\n");
+    PrintSpeedup(cpuTimes[0], cpuTimes[1]);
+    PrintSpeedup(frameTimes[0], frameTimes[1]);
+
+    if (!instanced)
+    {
+        std::printf("error: the instanced program was not drawn with instancing\n");
+        return 1;
+    }
+    return 0;
+}
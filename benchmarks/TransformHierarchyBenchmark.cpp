@@ -0,0 +1,151 @@
+#include "BenchmarkUtils.h"
+
+#include <ituGL/scene/Transform.h>
+#include <ituGL/scene/TransformHierarchy.h>
+#include <random>
+#include <memory>
+#include <cmath>
+
+// Compares the batched sweep of TransformHierarchy with the lazy world matrices of Transform, for the same nodes
+
+static const unsigned int RunCount = 21;
+
+// 4 levels of 100, 1000, 10000 and 88900 nodes. Nodes are added level by level, so each level is a run
+static const unsigned int NodeCount = 100000;
+static const unsigned int RootCount = 100;
+static const unsigned int ChildCount = 10;
+
+struct Nodes
+{
+    std::vector<unsigned int> parents;
+    std::vector<glm::vec3> translations;
+    std::vector<glm::vec3> rotations;
+    std::vector<glm::vec3> scales;
+};
+
+static void CreateNodes(Nodes& nodes)
+{
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> translation(-10.0f, 10.0f);
+    std::uniform_real_distribution<float> angle(-3.14f, 3.14f);
+    std::uniform_real_distribution<float> scale(0.5f, 1.5f);
+
+    unsigned int levelFirst = 0;
+    unsigned int levelSize = RootCount;
+    while (nodes.parents.size() < NodeCount)
+    {
+        unsigned int nextLevelFirst = static_cast<unsigned int>(nodes.parents.size());
+        for (unsigned int i = 0; i < levelSize && nodes.parents.size() < NodeCount; ++i)
+        {
+            bool isRoot = nextLevelFirst == 0;
+            nodes.parents.push_back(isRoot ? TransformHierarchy::InvalidHandle : levelFirst + i / ChildCount);
+            nodes.translations.emplace_back(translation(random), translation(random), translation(random));
+            nodes.rotations.emplace_back(angle(random), angle(random), angle(random));
+            nodes.scales.emplace_back(scale(random));
+        }
+        levelFirst = nextLevelFirst;
+        levelSize *= ChildCount;
+    }
+}
+
+static float GetMaxError(const std::vector<std::shared_ptr<Transform>>& transforms, const TransformHierarchy& hierarchy)
+{
+    float maxError = 0.0f;
+    for (unsigned int i = 0; i < NodeCount; ++i)
+    {
+        glm::mat4 a = transforms[i]->GetTransformMatrix();
+        const glm::mat4& b = hierarchy.GetWorldMatrix(i);
+        for (int column = 0; column < 4; ++column)
+        {
+            for (int row = 0; row < 4; ++row)
+            {
+                maxError = std::max(maxError, std::abs(a[column][row] - b[column][row]));
+            }
+        }
+    }
+    return maxError;
+}
+
+int main()
+{
+    Nodes nodes;
+    CreateNodes(nodes);
+
+    std::vector<std::shared_ptr<Transform>> transforms;
+    TransformHierarchy hierarchy;
+    for (unsigned int i = 0; i < NodeCount; ++i)
+    {
+        unsigned int parent = nodes.parents[i];
+
+        std::shared_ptr<Transform> transform = std::make_shared<Transform>();
+        transform->SetTranslation(nodes.translations[i]);
+        transform->SetScale(nodes.scales[i]);
+        if (parent != TransformHierarchy::InvalidHandle)
+        {
+            transform->SetParent(transforms[parent]);
+        }
+        transforms.push_back(transform);
+
+        TransformHierarchy::Handle handle = hierarchy.Add(parent);
+        hierarchy.SetTranslation(handle, nodes.translations[i]);
+        hierarchy.SetScale(handle, nodes.scales[i]);
+    }
+
+    // Frame where every node rotates, and all the world matrices are needed
+    float angleOffset = 0.0f;
+    double lazyTime = MeasureMedian(RunCount, [&]()
+        {
+            angleOffset += 0.01f;
+            for (unsigned int i = 0; i < NodeCount; ++i)
+            {
+                transforms[i]->SetRotation(nodes.rotations[i] + angleOffset);
+            }
+            for (unsigned int i = 0; i < NodeCount; ++i)
+            {
+                transforms[i]->GetTransformMatrix();
+            }
+        });
+
+    auto updateHierarchy = [&]()
+        {
+            for (unsigned int i = 0; i < NodeCount; ++i)
+            {
+                hierarchy.SetRotation(i, nodes.rotations[i] + angleOffset);
+            }
+            hierarchy.Update();
+        };
+
+    hierarchy.SetThreadCount(1);
+    double sweepTime = MeasureMedian(RunCount, updateHierarchy);
+
+    hierarchy.SetThreadCount(0);
+    double threadedSweepTime = MeasureMedian(RunCount, updateHierarchy);
+
+    PrintResult("Transform, all changed", NodeCount, lazyTime);
+    PrintResult("TransformHierarchy, all changed, 1 thread", NodeCount, sweepTime);
+    PrintSpeedup(lazyTime, sweepTime);
+    PrintResult("TransformHierarchy, all changed, threads", NodeCount, threadedSweepTime);
+    PrintSpeedup(lazyTime, threadedSweepTime);
+
+    // Frame where nothing changed
+    double lazyUnchangedTime = MeasureMedian(RunCount, [&]()
+        {
+            for (unsigned int i = 0; i < NodeCount; ++i)
+            {
+                transforms[i]->GetTransformMatrix();
+            }
+        });
+    double sweepUnchangedTime = MeasureMedian(RunCount, [&]() { hierarchy.Update(); });
+
+    PrintResult("Transform, nothing changed", NodeCount, lazyUnchangedTime);
+    PrintResult("TransformHierarchy, nothing changed", NodeCount, sweepUnchangedTime);
+
+    float maxError = GetMaxError(transforms, hierarchy);
+    std::printf("max difference of the world matrices: %g\n", maxError);
+    if (maxError > 1e-3f)
+    {
+        std::printf("error: TransformHierarchy and Transform matrices are different\n");
+        return 1;
+    }
+    return 0;
+}
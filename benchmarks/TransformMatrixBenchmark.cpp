@@ -0,0 +1,99 @@
+#include "BenchmarkUtils.h"
+
+#include <ituGL/scene/Transform.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <random>
+#include <cmath>
+
+// Compares the matrix of Transform, built from the cached rotation basis, with the product of the translation,
+// the 3 axis rotations and the scale matrices that it replaced
+
+static const unsigned int RunCount = 21;
+static const unsigned int TransformCount = 100000;
+
+// Matrix as Transform used to compute it
+static glm::mat4 ComputeReferenceMatrix(const glm::vec3& translation, const glm::vec3& rotation, const glm::vec3& scale)
+{
+    glm::mat4 rotationMatrix = glm::mat4(1.0f);
+    rotationMatrix = glm::rotate(rotationMatrix, rotation.y, glm::vec3(0, 1, 0));
+    rotationMatrix = glm::rotate(rotationMatrix, rotation.x, glm::vec3(1, 0, 0));
+    rotationMatrix = glm::rotate(rotationMatrix, rotation.z, glm::vec3(0, 0, 1));
+    return glm::translate(glm::mat4(1.0f), translation) * rotationMatrix * glm::scale(glm::mat4(1.0f), scale);
+}
+
+int main()
+{
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> position(-10.0f, 10.0f);
+    std::uniform_real_distribution<float> angle(-3.14f, 3.14f);
+    std::uniform_real_distribution<float> size(0.5f, 1.5f);
+
+    std::vector<glm::vec3> translations, rotations, scales;
+    std::vector<Transform> transforms(TransformCount);
+    for (unsigned int i = 0; i < TransformCount; ++i)
+    {
+        translations.emplace_back(position(random), position(random), position(random));
+        rotations.emplace_back(angle(random), angle(random), angle(random));
+        scales.emplace_back(size(random), size(random), size(random));
+        transforms[i].SetScale(scales[i]);
+    }
+
+    std::vector<glm::mat4> matrices(TransformCount);
+    float offset = 0.0f;
+
+    // Every transform rotates and moves
+    double referenceTime = MeasureMedian(RunCount, [&]()
+        {
+            offset += 0.01f;
+            for (unsigned int i = 0; i < TransformCount; ++i)
+            {
+                matrices[i] = ComputeReferenceMatrix(translations[i] + offset, rotations[i] + offset, scales[i]);
+            }
+        });
+    double rotationTime = MeasureMedian(RunCount, [&]()
+        {
+            for (unsigned int i = 0; i < TransformCount; ++i)
+            {
+                transforms[i].SetTranslation(translations[i] + offset);
+                transforms[i].SetRotation(rotations[i] + offset);
+                matrices[i] = transforms[i].GetTransformMatrix();
+            }
+        });
+
+    // Every transform moves, the rotation stays the same
+    double translationTime = MeasureMedian(RunCount, [&]()
+        {
+            offset += 0.01f;
+            for (unsigned int i = 0; i < TransformCount; ++i)
+            {
+                transforms[i].SetTranslation(translations[i] + offset);
+                matrices[i] = transforms[i].GetTransformMatrix();
+            }
+        });
+
+    PrintResult("glm::rotate TRS", TransformCount, referenceTime);
+    PrintResult("Transform, rotation changed", TransformCount, rotationTime);
+    PrintSpeedup(referenceTime, rotationTime);
+    PrintResult("Transform, only translation changed", TransformCount, translationTime);
+    PrintSpeedup(referenceTime, translationTime);
+
+    float maxError = 0.0f;
+    for (unsigned int i = 0; i < TransformCount; ++i)
+    {
+        glm::mat4 reference = ComputeReferenceMatrix(transforms[i].GetTranslation(), transforms[i].GetRotation(), scales[i]);
+        for (int column = 0; column < 4; ++column)
+        {
+            for (int row = 0; row < 4; ++row)
+            {
+                maxError = std::max(maxError, std::abs(matrices[i][column][row] - reference[column][row]));
+            }
+        }
+    }
+    std::printf("max difference of the matrices: %g\n", maxError);
+    if (maxError > 1e-4f)
+    {
+        std::printf("error: Transform matrices are different from the reference\n");
+        return 1;
+    }
+    return 0;
+}
@@ -4,12 +4,14 @@
 #include <ituGL/core/DeviceGL.h>
 #include <ituGL/application/Window.h>
 #include <ituGL/geometry/VertexBufferObject.h>
+#include <ituGL/core/StreamingBuffer.h>
 #include <ituGL/geometry/VertexArrayObject.h>
 #include <ituGL/geometry/VertexAttribute.h>
 #include <ituGL/geometry/ElementBufferObject.h>
 
 #include <iostream>
 #include <vector>
+#include <algorithm>
 
 #include "Utils.h"
 #include "Circle.h"
@@ -77,7 +79,9 @@ int main()
 
     Circle circle(.5f, 100);
 
-    VertexBufferObject vbo;
+    // The vertices change every frame, stream them instead of updating a buffer that the GL may still be reading
+    const size_t vertexSize = 3 * sizeof(float);
+    StreamingBuffer vbo(circle.vertices.size() * sizeof(float));
     VertexArrayObject vao;
     ElementBufferObject ebo;
 
@@ -85,7 +89,6 @@ int main()
     vao.Bind();
 
     vbo.Bind();
-    vbo.AllocateData<const float>(circle.vertices);
 
     ebo.Bind();
     ebo.AllocateData<const unsigned int>(circle.indices);
@@ -95,7 +98,7 @@ int main()
     vao.SetAttribute(0, position, 0);
 
     // note that this is allowed, the call to glVertexAttribPointer registered VBO as the vertex attribute's bound vertex buffer object so afterwards we can safely unbind
-    vbo.Unbind();
+    VertexBufferObject::Unbind();
 
     // You can unbind the VAO afterwards so other VAO calls won't accidentally modify this VAO, but this rarely happens. Modifying other
     // VAOs requires a call to glBindVertexArray anyways so we generally don't unbind VAOs (nor VBOs) when it's not directly necessary.
@@ -119,9 +122,10 @@ int main()
         Vector2 movementVector = GetMovementVector(movementSpeed);
         circle.TranslateCircle(movementVector.x, movementVector.y);
 
-        vbo.Bind();
-        vbo.UpdateData<const float>(circle.vertices, 0);
-        vbo.Unbind();
+        vbo.BeginFrame();
+        StreamingBuffer::Allocation allocation = vbo.Allocate<float>(circle.vertices.size(), vertexSize);
+        std::copy(circle.vertices.begin(), circle.vertices.end(), allocation.As<float>().begin());
+        vbo.Flush();
 
         // render
         // ------
@@ -132,7 +136,10 @@ int main()
         glUseProgram(shaderProgram);
         vao.Bind(); // seeing as we only have a single VAO there's no need to bind it every time, but we'll do so to keep things a bit more organized
 
-        glDrawElements(GL_TRIANGLES, circle.indices.size(), GL_UNSIGNED_INT, 0);
+        // The allocation starts at a whole vertex, use it as base vertex instead of changing the attribute pointer
+        GLint baseVertex = static_cast<GLint>(allocation.offset / vertexSize);
+        glDrawElementsBaseVertex(GL_TRIANGLES, circle.indices.size(), GL_UNSIGNED_INT, 0, baseVertex);
+        vbo.EndFrame();
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
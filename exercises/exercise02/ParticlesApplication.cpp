@@ -2,24 +2,15 @@
 
 #include <ituGL/shader/Shader.h>
 #include <ituGL/geometry/VertexAttribute.h>
+#include <ituGL/geometry/VertexBufferObject.h>
 #include <cassert>
 #include <array>
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 
-// Structure defining that Particle data
-struct Particle
-{
-    glm::vec2 position;
-    float size;
-    float birth;
-    float duration;
-    Color color;
-    glm::vec2 velocity;
-};
-
-// List of attributes of the particle. Must match the structure above
+// List of attributes of the particle. Must match ParticlesApplication::Particle
 const std::array<VertexAttribute, 6> s_vertexAttributes =
 {
     VertexAttribute(Data::Type::Float, 2), // position
@@ -38,6 +29,7 @@ ParticlesApplication::ParticlesApplication()
     , m_mousePosition(0)
     , m_particleCount(0)
     , m_particleCapacity(2048)  // You can change the capacity here to have more particles
+    , m_streamingBuffer(m_particleCapacity * sizeof(Particle))
 {
 }
 
@@ -56,7 +48,7 @@ void ParticlesApplication::Initialize()
     GetDevice().EnableFeature(GL_PROGRAM_POINT_SIZE);
 
     GetDevice().EnableFeature(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+    GetDevice().SetBlendFunction(GL_SRC_ALPHA, GL_ONE, GL_SRC_ALPHA, GL_ONE);
 
     // Get "Gravity" uniform location in the shader program
     m_gravityUniform = m_shaderProgram.GetUniformLocation("Gravity");
@@ -98,11 +90,23 @@ void ParticlesApplication::Render()
     // (todo) 02.6: Set Gravity uniform
     m_shaderProgram.SetUniform(m_gravityUniformLocation, m_gravity);
 
+    // Copy the particles to this frame's region of the streaming buffer
+    unsigned int particleCount = std::min(m_particleCount, m_particleCapacity);
+    m_streamingBuffer.BeginFrame();
+    StreamingBuffer::Allocation allocation = m_streamingBuffer.Allocate<Particle>(particleCount);
+    assert(allocation.IsValid());
+    std::copy_n(m_particles.data(), particleCount, allocation.As<Particle>().data());
+    m_streamingBuffer.Flush();
+
     // Bind the particle system VAO
     m_vao.Bind();
 
-    // Draw points. The amount of points can't exceed the capacity
-    glDrawArrays(GL_POINTS, 0, std::min(m_particleCount, m_particleCapacity));
+    // Draw points. The offset is a multiple of the particle size, so the attributes don't need to change
+    GLint firstParticle = static_cast<GLint>(allocation.offset / sizeof(Particle));
+    glDrawArrays(GL_POINTS, firstParticle, particleCount);
+
+    // The region can be reused once the GL is done with this drawcall
+    m_streamingBuffer.EndFrame();
 
     Application::Render();
 }
@@ -111,11 +115,10 @@ void ParticlesApplication::Render()
 // Change s_vertexAttributes and the Particle struct to add new vertex attributes
 void ParticlesApplication::InitializeGeometry()
 {
-    m_vbo.Bind();
+    // Particles are stored on the CPU, and streamed to the GL every frame
+    m_particles.resize(m_particleCapacity);
 
-    // Allocate enough data for all the particles
-    // Notice the DynamicDraw usage, because we will update the buffer every time we emit a particle
-    m_vbo.AllocateData(m_particleCapacity * sizeof(Particle), BufferObject::Usage::DynamicDraw);
+    m_streamingBuffer.Bind();
 
     m_vao.Bind();
 
@@ -176,15 +179,8 @@ void ParticlesApplication::EmitParticle(
     // Get the index in the circular buffer
     unsigned int particleIndex = m_particleCount % m_particleCapacity;
 
-    // Bind the VBO before updating data
-    m_vbo.Bind();
-
-    // Update the particle data in the VBO
-    int offset = particleIndex * sizeof(Particle);
-    m_vbo.UpdateData(std::span(&particle, 1), offset);
-
-    // Unbind the VBO
-    VertexBufferObject::Unbind();
+    // Store the particle, it will be copied to the GL when rendering
+    m_particles[particleIndex] = particle;
 
     // Increment the particle count
     m_particleCount++;
@@ -1,9 +1,12 @@
 #pragma once
 
 #include <ituGL/application/Application.h>
-#include <ituGL/geometry/VertexBufferObject.h>
+#include <ituGL/core/StreamingBuffer.h>
 #include <ituGL/geometry/VertexArrayObject.h>
 #include <ituGL/shader/ShaderProgram.h>
+#include <ituGL/core/Color.h>
+#include <glm/vec2.hpp>
+#include <vector>
 
 class ParticlesApplication : public Application
 {
@@ -15,6 +18,18 @@ protected:
     void Update() override;
     void Render() override;
 
+private:
+    // Structure defining the Particle data
+    struct Particle
+    {
+        glm::vec2 position;
+        float size;
+        float birth;
+        float duration;
+        Color color;
+        glm::vec2 velocity;
+    };
+
 private:
     // Initialize the VBO and VAO
     void InitializeGeometry();
@@ -40,9 +55,6 @@ private:
     static Color RandomColor();
 
 private:
-    // All particles stored in a single VBO with interleaved attributes
-    VertexBufferObject m_vbo;
-
     // VAO that represents the particle system
     VertexArrayObject m_vao;
 
@@ -64,6 +76,10 @@ private:
     // Max number of particles that can exist at the same time
     const unsigned int m_particleCapacity;
 
+    // All particles, copied every frame to the streaming buffer with interleaved attributes
+    std::vector<Particle> m_particles;
+    StreamingBuffer m_streamingBuffer;
+
     GLint m_currentTimeUniformLocation;
     GLint m_gravityUniformLocation;
 
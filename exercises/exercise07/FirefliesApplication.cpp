@@ -7,6 +7,7 @@
 #include <ituGL/renderer/ForwardRenderPass.h>
 #include <ituGL/renderer/GBufferRenderPass.h>
 #include <ituGL/renderer/DeferredRenderPass.h>
+#include <ituGL/texture/FramebufferObject.h>
 #include <glm/gtx/transform.hpp>
 #include <imgui.h>
 
@@ -131,7 +132,7 @@ void FirefliesApplication::InitializeForwardMaterials()
     fragmentShaderPaths.push_back("shaders/version330.glsl");
     fragmentShaderPaths.push_back("shaders/utils.glsl");
     fragmentShaderPaths.push_back("shaders/blinn-phong.glsl");
-    fragmentShaderPaths.push_back("shaders/lighting.glsl");
+    fragmentShaderPaths.push_back("shaders/clustered.glsl");
     fragmentShaderPaths.push_back("shaders/lit.frag");
     Shader fragmentShader = ShaderLoader(Shader::FragmentShader).Load(fragmentShaderPaths);
 
@@ -162,10 +163,13 @@ void FirefliesApplication::InitializeForwardMaterials()
     filteredUniforms.insert("WorldMatrix");
     filteredUniforms.insert("ViewProjMatrix");
     filteredUniforms.insert("AmbientColor");
-    filteredUniforms.insert("LightColor");
-    filteredUniforms.insert("LightPosition");
-    filteredUniforms.insert("LightDirection");
-    filteredUniforms.insert("LightAttenuation");
+    filteredUniforms.insert("LightData");
+    filteredUniforms.insert("LightClusters");
+    filteredUniforms.insert("LightIndices");
+    filteredUniforms.insert("ClusterGridSize");
+    filteredUniforms.insert("ClusterGridParams");
+    filteredUniforms.insert("ClusterDepthPlane");
+    filteredUniforms.insert("ClusterGlobalLightCount");
 
     // Create reference material
     m_forwardMaterial = std::make_shared<Material>(shaderProgramPtr, filteredUniforms);
@@ -322,9 +326,12 @@ void FirefliesApplication::InitializeRenderer()
             m_deferredMaterial->SetUniformValue("NormalTexture", gbufferRenderPass->GetNormalTexture());
             m_deferredMaterial->SetUniformValue("OthersTexture", gbufferRenderPass->GetOthersTexture());
 
+            // The lighting pass copies the g-buffer depth to the default framebuffer, to cull the light volumes with stencil
+            std::shared_ptr<const FramebufferObject> gbufferFramebuffer = gbufferRenderPass->GetTargetFramebuffer();
+
             // Add the render passes
             m_renderer.AddRenderPass(std::move(gbufferRenderPass));
-            m_renderer.AddRenderPass(std::make_unique<DeferredRenderPass>(m_deferredMaterial));
+            m_renderer.AddRenderPass(std::make_unique<DeferredRenderPass>(m_deferredMaterial, FramebufferObject::GetDefault(), gbufferFramebuffer));
             break;
         }
     }
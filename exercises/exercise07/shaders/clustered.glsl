@@ -0,0 +1,92 @@
+
+// Light lists built by LightClusterGrid, see ForwardRenderPass
+uniform samplerBuffer LightData;
+uniform usamplerBuffer LightClusters;
+uniform usamplerBuffer LightIndices;
+
+uniform uvec3 ClusterGridSize;
+uniform vec4 ClusterGridParams;
+uniform vec4 ClusterDepthPlane;
+uniform uint ClusterGlobalLightCount;
+
+struct LightInfo
+{
+	vec3 color;
+	vec3 position;
+	vec3 direction;
+	vec4 attenuation;
+};
+
+// Each light takes 4 texels: position, direction, color and attenuation
+LightInfo GetLightInfo(int lightIndex)
+{
+	LightInfo light;
+	light.position = texelFetch(LightData, lightIndex * 4).xyz;
+	light.direction = texelFetch(LightData, lightIndex * 4 + 1).xyz;
+	light.color = texelFetch(LightData, lightIndex * 4 + 2).rgb;
+	light.attenuation = texelFetch(LightData, lightIndex * 4 + 3);
+	return light;
+}
+
+// Cluster of the fragment, from its screen position and its view depth
+int GetClusterIndex(vec3 position)
+{
+	float depth = dot(ClusterDepthPlane, vec4(position, 1));
+	uvec2 tile = min(uvec2(gl_FragCoord.xy / ClusterGridParams.xy), ClusterGridSize.xy - 1u);
+	uint slice = uint(clamp(log(depth) * ClusterGridParams.z + ClusterGridParams.w, 0, float(ClusterGridSize.z - 1u)));
+	return int((slice * ClusterGridSize.y + tile.y) * ClusterGridSize.x + tile.x);
+}
+
+// Same attenuation as lighting.glsl, with the values of the light
+float ComputeAttenuation(LightInfo light, vec3 position, vec3 lightDir)
+{
+	float attenuation = 1.0f;
+	if (light.attenuation.y > 0)
+	{
+		attenuation *= smoothstep(light.attenuation.y, light.attenuation.x, distance(position, light.position));
+	}
+	if (light.attenuation.w > 0)
+	{
+		float angle = acos(dot(light.direction, lightDir));
+		attenuation *= smoothstep(light.attenuation.w, light.attenuation.z, angle);
+	}
+	return attenuation;
+}
+
+vec3 ComputeLight(LightInfo light, SurfaceData data, vec3 viewDir, vec3 position)
+{
+	vec3 lightDir = light.attenuation.y >= 0 ? GetDirection(position, light.position) : light.direction;
+
+	vec3 lighting = vec3(0);
+	lighting += ComputeDiffuseLighting(data, lightDir);
+	lighting += ComputeSpecularLighting(data, lightDir, viewDir);
+
+	return lighting * light.color * ComputeAttenuation(light, position, lightDir);
+}
+
+vec3 ComputeLighting(vec3 position, SurfaceData data, vec3 viewDir, bool indirect)
+{
+	vec3 lighting = vec3(0);
+
+	if (indirect)
+	{
+		lighting += ComputeDiffuseIndirectLighting(data);
+		lighting += ComputeSpecularIndirectLighting(data, viewDir);
+	}
+
+	// Global lights affect all the fragments
+	for (int i = 0; i < int(ClusterGlobalLightCount); ++i)
+	{
+		lighting += ComputeLight(GetLightInfo(i), data, viewDir, position);
+	}
+
+	// Then the lights of the cluster
+	uvec2 cluster = texelFetch(LightClusters, GetClusterIndex(position)).xy;
+	for (uint i = 0u; i < cluster.y; ++i)
+	{
+		int lightIndex = int(texelFetch(LightIndices, int(cluster.x + i)).x);
+		lighting += ComputeLight(GetLightInfo(lightIndex), data, viewDir, position);
+	}
+
+	return lighting;
+}
@@ -1,6 +1,3 @@
-//Inputs
-in vec2 TexCoord;
-
 //Outputs
 out vec4 FragColor;
 
@@ -23,6 +20,9 @@ struct SurfaceData {
 
 void main()
 {
+	// Texture coordinates from the screen position, the light volumes don't cover the screen
+	vec2 TexCoord = gl_FragCoord.xy / vec2(textureSize(DepthTexture, 0));
+
 	SurfaceData data;
 	data.normal = (InvViewMatrix * vec4(GetImplicitNormal(texture(NormalTexture, TexCoord).xy), 0.0)).xyz;
 	data.reflectionColor = texture(AlbedoTexture, TexCoord).xyz;
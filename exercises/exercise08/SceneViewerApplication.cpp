@@ -19,6 +19,7 @@
 
 #include <ituGL/renderer/SkyboxRenderPass.h>
 #include <ituGL/renderer/ForwardRenderPass.h>
+#include <ituGL/renderer/DepthPrepassRenderPass.h>
 #include <ituGL/scene/RendererSceneVisitor.h>
 
 #include <ituGL/scene/ImGuiSceneVisitor.h>
@@ -27,6 +28,8 @@
 SceneViewerApplication::SceneViewerApplication()
     : Application(1024, 1024, "Scene Viewer demo")
     , m_renderer(GetDevice())
+    , m_depthPrepassRenderPass(nullptr)
+    , m_forwardRenderPass(nullptr)
 {
 }
 
@@ -53,7 +56,7 @@ void SceneViewerApplication::Update()
 
     // Add the scene nodes to the renderer
     RendererSceneVisitor rendererSceneVisitor(m_renderer);
-    m_scene.AcceptVisitor(rendererSceneVisitor);
+    rendererSceneVisitor.VisitScene(m_scene);
 }
 
 void SceneViewerApplication::Render()
@@ -145,6 +148,28 @@ void SceneViewerApplication::InitializeMaterials()
 
         m_blinnPhongMaterial = InitializeMaterial(vertexShader, fragmentShader);
     }
+    {
+        // Load and build shader
+        std::vector<const char*> vertexShaderPaths;
+        vertexShaderPaths.push_back("shaders/version330.glsl");
+        vertexShaderPaths.push_back("shaders/renderer/depth.vert");
+        Shader vertexShader = ShaderLoader(Shader::VertexShader).Load(vertexShaderPaths);
+
+        std::vector<const char*> fragmentShaderPaths;
+        fragmentShaderPaths.push_back("shaders/version330.glsl");
+        fragmentShaderPaths.push_back("shaders/renderer/depth.frag");
+        Shader fragmentShader = ShaderLoader(Shader::FragmentShader).Load(fragmentShaderPaths);
+
+        std::shared_ptr<ShaderProgram> shaderProgramPtr = std::make_shared<ShaderProgram>();
+        shaderProgramPtr->Build(vertexShader, fragmentShader);
+
+        // The depth prepass sets the transforms
+        ShaderUniformCollection::NameSet filteredUniforms;
+        filteredUniforms.insert("WorldMatrix");
+        filteredUniforms.insert("ViewProjMatrix");
+
+        m_depthMaterial = std::make_shared<Material>(shaderProgramPtr, filteredUniforms);
+    }
 }
 
 std::shared_ptr<Material> SceneViewerApplication::InitializeMaterial(Shader& vertexShader, Shader& fragmentShader)
@@ -266,7 +291,15 @@ void SceneViewerApplication::InitializeModels()
 
 void SceneViewerApplication::InitializeRenderer()
 {
-    m_renderer.AddRenderPass(std::make_unique<ForwardRenderPass>());
+    // Depth prepass, so the forward pass only shades the visible fragments
+    std::unique_ptr<DepthPrepassRenderPass> depthPrepassRenderPass = std::make_unique<DepthPrepassRenderPass>(m_depthMaterial);
+    std::unique_ptr<ForwardRenderPass> forwardRenderPass = std::make_unique<ForwardRenderPass>();
+    forwardRenderPass->SetDepthPrepass(depthPrepassRenderPass.get());
+    m_depthPrepassRenderPass = depthPrepassRenderPass.get();
+    m_forwardRenderPass = forwardRenderPass.get();
+
+    m_renderer.AddRenderPass(std::move(depthPrepassRenderPass));
+    m_renderer.AddRenderPass(std::move(forwardRenderPass));
     m_renderer.AddRenderPass(std::make_unique<SkyboxRenderPass>(m_skyboxTexture));
 }
 
@@ -276,10 +309,22 @@ void SceneViewerApplication::RenderGUI()
 
     // Draw GUI for scene nodes, using the visitor pattern
     ImGuiSceneVisitor imGuiVisitor(m_imGui, "Scene");
-    m_scene.AcceptVisitor(imGuiVisitor);
+    imGuiVisitor.VisitScene(m_scene);
 
     // Draw GUI for camera controller
     m_cameraController.DrawGUI(m_imGui);
 
+    // Draw GUI for the depth prepass, with the samples shaded per pixel to compare
+    if (auto window = m_imGui.UseWindow("Depth prepass"))
+    {
+        bool depthPrepassEnabled = m_depthPrepassRenderPass->IsEnabled();
+        if (ImGui::Checkbox("Enabled", &depthPrepassEnabled))
+        {
+            m_depthPrepassRenderPass->SetEnabled(depthPrepassEnabled);
+        }
+        const ForwardRenderPass::OverdrawStats& overdrawStats = m_forwardRenderPass->GetOverdrawStats();
+        ImGui::Text("Overdraw: %.2f samples per pixel", overdrawStats.samplesPerPixel);
+    }
+
     m_imGui.EndFrame();
 }
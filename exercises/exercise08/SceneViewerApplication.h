@@ -9,6 +9,8 @@
 
 class TextureCubemapObject;
 class Material;
+class DepthPrepassRenderPass;
+class ForwardRenderPass;
 
 class SceneViewerApplication : public Application
 {
@@ -50,4 +52,11 @@ private:
     // Default material
     std::shared_ptr<Material> m_defaultMaterial;
     std::shared_ptr<Material> m_blinnPhongMaterial;
+
+    // Position-only material shared by the depth prepass
+    std::shared_ptr<Material> m_depthMaterial;
+
+    // Passes that the GUI controls, owned by the renderer
+    DepthPrepassRenderPass* m_depthPrepassRenderPass;
+    ForwardRenderPass* m_forwardRenderPass;
 };
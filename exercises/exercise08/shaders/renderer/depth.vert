@@ -0,0 +1,13 @@
+//Inputs
+layout (location = 0) in vec3 VertexPosition;
+
+//Uniforms
+uniform mat4 WorldMatrix;
+uniform mat4 ViewProjMatrix;
+
+void main()
+{
+	// Same operations as default.vert, so the depth is exactly the same
+	vec3 WorldPosition = (WorldMatrix * vec4(VertexPosition, 1.0)).xyz;
+	gl_Position = ViewProjMatrix * vec4(WorldPosition, 1.0);
+}
@@ -17,8 +17,10 @@
 #include <ituGL/scene/SceneModel.h>
 
 #include <ituGL/renderer/SkyboxRenderPass.h>
+#include <ituGL/renderer/ShadowMapRenderPass.h>
 #include <ituGL/renderer/GBufferRenderPass.h>
 #include <ituGL/renderer/DeferredRenderPass.h>
+#include <ituGL/renderer/GpuDrivenRenderPass.h>
 #include <ituGL/renderer/PostFXRenderPass.h>
 #include <ituGL/scene/RendererSceneVisitor.h>
 
@@ -29,6 +31,7 @@ PostFXSceneViewerApplication::PostFXSceneViewerApplication()
     : Application(1024, 1024, "Post FX Scene Viewer demo")
     , m_renderer(GetDevice())
     , m_sceneFramebuffer(std::make_shared<FramebufferObject>())
+    , m_gpuDrivenRenderPass(nullptr)
     , m_exposure(1.0f)
     , m_contrast(1.0f)
     , m_hueShift(0.0f)
@@ -63,7 +66,7 @@ void PostFXSceneViewerApplication::Update()
 
     // Add the scene nodes to the renderer
     RendererSceneVisitor rendererSceneVisitor(m_renderer);
-    m_scene.AcceptVisitor(rendererSceneVisitor);
+    rendererSceneVisitor.VisitScene(m_scene);
 }
 
 void PostFXSceneViewerApplication::Render()
@@ -126,6 +129,7 @@ void PostFXSceneViewerApplication::InitializeMaterials()
         // Load and build shader
         std::vector<const char*> vertexShaderPaths;
         vertexShaderPaths.push_back("shaders/version330.glsl");
+        vertexShaderPaths.push_back("shaders/frame.glsl");
         vertexShaderPaths.push_back("shaders/default.vert");
         Shader vertexShader = ShaderLoader(Shader::VertexShader).Load(vertexShaderPaths);
 
@@ -138,28 +142,36 @@ void PostFXSceneViewerApplication::InitializeMaterials()
         std::shared_ptr<ShaderProgram> shaderProgramPtr = std::make_shared<ShaderProgram>();
         shaderProgramPtr->Build(vertexShader, fragmentShader);
 
-        // Get transform related uniform locations
-        ShaderProgram::Location worldViewMatrixLocation = shaderProgramPtr->GetUniformLocation("WorldViewMatrix");
-        ShaderProgram::Location worldViewProjMatrixLocation = shaderProgramPtr->GetUniformLocation("WorldViewProjMatrix");
+        // Register shader with renderer. The world matrix comes in the instance attribute, and the camera in the frame uniforms
+        m_renderer.RegisterShaderProgram(shaderProgramPtr, nullptr, nullptr);
 
-        // Register shader with renderer
-        m_renderer.RegisterShaderProgram(shaderProgramPtr,
-            [=](const ShaderProgram& shaderProgram, const glm::mat4& worldMatrix, const Camera& camera, bool cameraChanged)
-            {
-                shaderProgram.SetUniform(worldViewMatrixLocation, camera.GetViewMatrix() * worldMatrix);
-                shaderProgram.SetUniform(worldViewProjMatrixLocation, camera.GetViewProjectionMatrix() * worldMatrix);
-            },
-            nullptr
-        );
+        // Create material
+        m_defaultMaterial = std::make_shared<Material>(shaderProgramPtr);
+        m_defaultMaterial->SetUniformValue("Color", glm::vec3(1.0f));
+    }
 
-        // Filter out uniforms that are not material properties
+    // Shadow map material
+    {
+        // Load and build shader
+        std::vector<const char*> vertexShaderPaths;
+        vertexShaderPaths.push_back("shaders/version330.glsl");
+        vertexShaderPaths.push_back("shaders/renderer/shadow.vert");
+        Shader vertexShader = ShaderLoader(Shader::VertexShader).Load(vertexShaderPaths);
+
+        std::vector<const char*> fragmentShaderPaths;
+        fragmentShaderPaths.push_back("shaders/version330.glsl");
+        fragmentShaderPaths.push_back("shaders/renderer/shadow.frag");
+        Shader fragmentShader = ShaderLoader(Shader::FragmentShader).Load(fragmentShaderPaths);
+
+        std::shared_ptr<ShaderProgram> shaderProgramPtr = std::make_shared<ShaderProgram>();
+        shaderProgramPtr->Build(vertexShader, fragmentShader);
+
+        // The shadow map pass sets the transform of each caster
         ShaderUniformCollection::NameSet filteredUniforms;
-        filteredUniforms.insert("WorldViewMatrix");
         filteredUniforms.insert("WorldViewProjMatrix");
 
         // Create material
-        m_defaultMaterial = std::make_shared<Material>(shaderProgramPtr, filteredUniforms);
-        m_defaultMaterial->SetUniformValue("Color", glm::vec3(1.0f));
+        m_shadowMaterial = std::make_shared<Material>(shaderProgramPtr, filteredUniforms);
     }
 
     // Deferred material
@@ -173,6 +185,7 @@ void PostFXSceneViewerApplication::InitializeMaterials()
         fragmentShaderPaths.push_back("shaders/version330.glsl");
         fragmentShaderPaths.push_back("shaders/utils.glsl");
         fragmentShaderPaths.push_back("shaders/lambert-ggx.glsl");
+        fragmentShaderPaths.push_back("shaders/shadows.glsl");
         fragmentShaderPaths.push_back("shaders/lighting.glsl");
         fragmentShaderPaths.push_back("shaders/renderer/deferred.frag");
         Shader fragmentShader = ShaderLoader(Shader::FragmentShader).Load(fragmentShaderPaths);
@@ -190,6 +203,9 @@ void PostFXSceneViewerApplication::InitializeMaterials()
         filteredUniforms.insert("LightPosition");
         filteredUniforms.insert("LightDirection");
         filteredUniforms.insert("LightAttenuation");
+        filteredUniforms.insert(ShadowMapRenderPass::ShadowMapName);
+        filteredUniforms.insert(ShadowMapRenderPass::ShadowMatricesName);
+        filteredUniforms.insert(ShadowMapRenderPass::CascadeCountName);
 
         // Get transform related uniform locations
         ShaderProgram::Location invViewMatrixLocation = shaderProgramPtr->GetUniformLocation("InvViewMatrix");
@@ -231,6 +247,9 @@ void PostFXSceneViewerApplication::InitializeModels()
     // Configure loader
     ModelLoader loader(m_defaultMaterial);
 
+    // Models with the same vertex format share their buffers and VAO
+    loader.SetGeometryArena(&m_geometryArena);
+
     // Create a new material copy for each submaterial
     loader.SetCreateMaterials(true);
 
@@ -300,6 +319,24 @@ void PostFXSceneViewerApplication::InitializeRenderer()
     int width, height;
     GetMainWindow().GetDimensions(width, height);
 
+    // Shadow map pass, before the lighting that uses it
+    {
+        // Casters outside of the view also cast shadows
+        m_renderer.SetShadowCastersEnabled(true);
+
+        std::unique_ptr<ShadowMapRenderPass> shadowMapRenderPass(std::make_unique<ShadowMapRenderPass>(m_shadowMaterial));
+
+        // The pass is owned by the renderer, that lives as long as the material
+        const ShadowMapRenderPass* shadowMapRenderPassPtr = shadowMapRenderPass.get();
+        ShadowMapRenderPass::Locations shadowLocations = ShadowMapRenderPass::GetLocations(*m_deferredMaterial->GetShaderProgram());
+        m_deferredMaterial->SetShaderSetupFunction([=](ShaderProgram& shaderProgram)
+            {
+                shadowMapRenderPassPtr->Use(shaderProgram, shadowLocations, 12);
+            });
+
+        m_renderer.AddRenderPass(std::move(shadowMapRenderPass));
+    }
+
     // Set up deferred passes
     {
         std::unique_ptr<GBufferRenderPass> gbufferRenderPass(std::make_unique<GBufferRenderPass>(width, height));
@@ -313,8 +350,25 @@ void PostFXSceneViewerApplication::InitializeRenderer()
         // Get the depth texture from the gbuffer pass - This could be reworked
         m_depthTexture = gbufferRenderPass->GetDepthTexture();
 
+        // Models culled on the GPU are drawn to the same g-buffer, after the ones culled on the CPU
+        std::shared_ptr<const FramebufferObject> gbufferFramebuffer = gbufferRenderPass->GetTargetFramebuffer();
+
         // Add the render passes
         m_renderer.AddRenderPass(std::move(gbufferRenderPass));
+        if (GpuDrivenRenderPass::IsSupported())
+        {
+            std::vector<const char*> computeShaderPaths;
+            computeShaderPaths.push_back("shaders/version430.glsl");
+            computeShaderPaths.push_back("shaders/renderer/gpuculling.comp");
+            Shader computeShader = ShaderLoader(Shader::ComputeShader).Load(computeShaderPaths);
+
+            std::shared_ptr<ShaderProgram> cullingProgram = std::make_shared<ShaderProgram>();
+            cullingProgram->Build(computeShader);
+
+            std::unique_ptr<GpuDrivenRenderPass> gpuDrivenRenderPass(std::make_unique<GpuDrivenRenderPass>(cullingProgram, gbufferFramebuffer));
+            m_gpuDrivenRenderPass = gpuDrivenRenderPass.get();
+            m_renderer.AddRenderPass(std::move(gpuDrivenRenderPass));
+        }
         m_renderer.AddRenderPass(std::make_unique<DeferredRenderPass>(m_deferredMaterial, m_sceneFramebuffer));
     }
 
@@ -404,7 +458,7 @@ void PostFXSceneViewerApplication::RenderGUI()
 
     // Draw GUI for scene nodes, using the visitor pattern
     ImGuiSceneVisitor imGuiVisitor(m_imGui, "Scene");
-    m_scene.AcceptVisitor(imGuiVisitor);
+    imGuiVisitor.VisitScene(m_scene);
 
     // Draw GUI for camera controller
     m_cameraController.DrawGUI(m_imGui);
@@ -437,5 +491,34 @@ void PostFXSceneViewerApplication::RenderGUI()
         }
     }
 
+    if (auto window = m_imGui.UseWindow("Renderer"))
+    {
+        // Only available if the context has compute shaders
+        if (m_gpuDrivenRenderPass)
+        {
+            bool gpuCulling = m_renderer.GetGpuCullingEnabled();
+            if (ImGui::Checkbox("GPU culling", &gpuCulling))
+            {
+                m_renderer.SetGpuCullingEnabled(gpuCulling);
+            }
+            const GpuDrivenRenderPass::Stats& stats = m_gpuDrivenRenderPass->GetStats();
+            ImGui::Text("Objects: %u, groups: %u, multi-draws: %u, fallback: %u", stats.objects, stats.groups, stats.multiDraws, stats.fallbackDrawcalls);
+        }
+        else
+        {
+            ImGui::Text("GPU culling needs OpenGL 4.3");
+        }
+
+        GeometryArena::Stats arenaStats = m_geometryArena.GetStats();
+        ImGui::Text("Geometry: %u meshes in %u pools", arenaStats.allocationCount, arenaStats.poolCount);
+        ImGui::Text("Vertices: %zu / %zu KB, elements: %zu / %zu KB", arenaStats.vertexUsed >> 10, arenaStats.vertexCapacity >> 10,
+            arenaStats.elementUsed >> 10, arenaStats.elementCapacity >> 10);
+        ImGui::Text("Free blocks: %u, fragmentation: %.2f", arenaStats.freeBlockCount, arenaStats.fragmentation);
+        if (ImGui::Button("Defragment"))
+        {
+            m_geometryArena.Defragment();
+        }
+    }
+
     m_imGui.EndFrame();
 }
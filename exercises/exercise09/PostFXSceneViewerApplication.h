@@ -3,6 +3,7 @@
 #include <ituGL/application/Application.h>
 
 #include <ituGL/scene/Scene.h>
+#include <ituGL/geometry/GeometryArena.h>
 #include <ituGL/texture/FramebufferObject.h>
 #include <ituGL/renderer/Renderer.h>
 #include <ituGL/camera/CameraController.h>
@@ -11,6 +12,7 @@
 class Texture2DObject;
 class TextureCubemapObject;
 class Material;
+class GpuDrivenRenderPass;
 
 class PostFXSceneViewerApplication : public Application
 {
@@ -44,6 +46,9 @@ private:
     // Camera controller
     CameraController m_cameraController;
 
+    // Shared buffers for the meshes of the models. Declared before the scene, so it is destroyed after the models
+    GeometryArena m_geometryArena;
+
     // Global scene
     Scene m_scene;
 
@@ -55,6 +60,7 @@ private:
 
     // Materials
     std::shared_ptr<Material> m_defaultMaterial;
+    std::shared_ptr<Material> m_shadowMaterial;
     std::shared_ptr<Material> m_deferredMaterial;
     std::shared_ptr<Material> m_composeMaterial;
     // (todo) 09.4: Add a new material for bloom
@@ -66,6 +72,9 @@ private:
     std::shared_ptr<FramebufferObject> m_blurBuffers[2];
     std::shared_ptr<Texture2DObject> m_blurTextures[2];
 
+    // Optional pass that culls and draws the models on the GPU, owned by the renderer
+    GpuDrivenRenderPass* m_gpuDrivenRenderPass;
+
     // Configuration values
     float m_exposure, m_contrast, m_hueShift, m_saturation;
     glm::vec3 m_colorFilter;
@@ -5,30 +5,31 @@ layout (location = 2) in vec3 VertexTangent;
 layout (location = 3) in vec3 VertexBitangent;
 layout (location = 4) in vec2 VertexTexCoord;
 
+// World matrix of each instance, set by the renderer. See Renderer::InstanceWorldMatrixName
+layout (location = 5) in mat4 InstanceWorldMatrix;
+
 //Outputs
 out vec3 ViewNormal;
 out vec3 ViewTangent;
 out vec3 ViewBitangent;
 out vec2 TexCoord;
 
-//Uniforms
-uniform mat4 WorldViewMatrix;
-uniform mat4 WorldViewProjMatrix;
-
 void main()
 {
+	mat4 worldViewMatrix = ViewMatrix * InstanceWorldMatrix;
+
 	// normal in view space (for lighting computation)
-	ViewNormal = (WorldViewMatrix * vec4(VertexNormal, 0.0)).xyz;
+	ViewNormal = (worldViewMatrix * vec4(VertexNormal, 0.0)).xyz;
 
 	// tangent in view space (for lighting computation)
-	ViewTangent = (WorldViewMatrix * vec4(VertexTangent, 0.0)).xyz;
+	ViewTangent = (worldViewMatrix * vec4(VertexTangent, 0.0)).xyz;
 
 	// bitangent in view space (for lighting computation)
-	ViewBitangent = (WorldViewMatrix * vec4(VertexBitangent, 0.0)).xyz;
+	ViewBitangent = (worldViewMatrix * vec4(VertexBitangent, 0.0)).xyz;
 
 	// texture coordinates
 	TexCoord = VertexTexCoord;
 
 	// final vertex position (for opengl rendering, not for lighting)
-	gl_Position = WorldViewProjMatrix * vec4(VertexPosition, 1.0);
+	gl_Position = ViewProjMatrix * (InstanceWorldMatrix * vec4(VertexPosition, 1.0));
 }
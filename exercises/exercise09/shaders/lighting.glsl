@@ -46,6 +46,13 @@ vec3 ComputeLight(SurfaceData data, vec3 viewDir, vec3 position)
 	vec3 light = CombineLighting(diffuse, specular, data, lightDir, viewDir);
 
 	float attenuation = ComputeAttenuation(position, lightDir);
+#ifdef SHADOWS
+	// Shadows are computed for the main directional light
+	if (LightAttenuation.y < 0)
+	{
+		attenuation *= ComputeShadow(position);
+	}
+#endif
 	return light * LightColor * attenuation;
 }
 
@@ -1,6 +1,3 @@
-//Inputs
-in vec2 TexCoord;
-
 //Outputs
 out vec4 FragColor;
 
@@ -14,6 +11,9 @@ uniform mat4 InvProjMatrix;
 
 void main()
 {
+	// Texture coordinates from the screen position, the light volumes don't cover the screen
+	vec2 TexCoord = gl_FragCoord.xy / vec2(textureSize(DepthTexture, 0));
+
 	// Extract information from g-buffers
 	vec3 position = ReconstructViewPosition(DepthTexture, TexCoord, InvProjMatrix);
 	vec3 albedo = texture(AlbedoTexture, TexCoord).rgb;
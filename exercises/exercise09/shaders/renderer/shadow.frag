@@ -0,0 +1,4 @@
+void main()
+{
+	// Nothing to do, the depth is written automatically
+}
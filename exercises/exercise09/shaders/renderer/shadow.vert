@@ -0,0 +1,11 @@
+//Inputs
+layout (location = 0) in vec3 VertexPosition;
+
+//Uniforms
+uniform mat4 WorldViewProjMatrix;
+
+void main()
+{
+	// Only the depth is written, from the light projection
+	gl_Position = WorldViewProjMatrix * vec4(VertexPosition, 1.0);
+}
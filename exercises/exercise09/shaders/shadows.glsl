@@ -0,0 +1,21 @@
+
+#define SHADOWS
+
+uniform sampler2DArrayShadow ShadowMap;
+uniform mat4 ShadowMatrices[4];
+uniform int ShadowCascadeCount;
+
+// Visibility of the main directional light, from the first cascade that contains the world position
+float ComputeShadow(vec3 position)
+{
+	for (int i = 0; i < ShadowCascadeCount; ++i)
+	{
+		vec3 shadowCoord = (ShadowMatrices[i] * vec4(position, 1)).xyz;
+		if (all(greaterThanEqual(shadowCoord, vec3(0))) && all(lessThanEqual(shadowCoord, vec3(1))))
+		{
+			// Linear filtering blends the comparisons of the 4 nearest texels
+			return texture(ShadowMap, vec4(shadowCoord.xy, i, shadowCoord.z));
+		}
+	}
+	return 1.0f;
+}
@@ -0,0 +1 @@
+#version 430 core
@@ -70,7 +70,9 @@ void FramebufferRenderPass::UpdateTextures(int width, int height)
 void FramebufferRenderPass::Render()
 {
     Renderer& renderer = GetRenderer();
-    renderer.GetDevice().Clear(true, Color(0.0f, 0.0f, 0.0f, 1.0f), true, 1.0f);
+
+    // The depth prepass already cleared and filled the depth
+    renderer.GetDevice().Clear(true, Color(0.0f, 0.0f, 0.0f, 1.0f), !IsDepthPrepassEnabled(), 1.0f);
     
     ForwardRenderPass::Render();
 }
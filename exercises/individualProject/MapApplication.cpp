@@ -6,6 +6,7 @@
 #include <ituGL/texture/FramebufferObject.h>
 
 #include <ituGL/renderer/ForwardRenderPass.h>
+#include <ituGL/renderer/DepthPrepassRenderPass.h>
 #include "FramebufferRenderPass.h"
 #include <ituGL/renderer/SkyboxRenderPass.h>
 #include <ituGL/renderer/PostFXRenderPass.h>
@@ -29,6 +30,7 @@
 
 #include <imgui.h>
 #include <format>
+#include <algorithm>
 #include <iostream>
 
 MapApplication::MapApplication()
@@ -38,12 +40,17 @@ MapApplication::MapApplication()
     , m_vertexShaderLoader(Shader::Type::VertexShader)
     , m_fragmentShaderLoader(Shader::Type::FragmentShader)
     , m_renderer(GetDevice())
+    , m_terrainBoundsParameters(-1.0f)
+    , m_retainedRenderLists(false)
+    , m_sceneProxies(m_renderer, m_scene)
+    , m_waterSceneProxies(m_renderer, m_waterScene)
     , m_ambientColor(.25f)
     , m_heightScale(.7f)
     , m_smoothingAmount(0.845f)
     , m_waterLevel(3.2f)
     , m_levels(10)
     , m_quantizeTerrain(true)
+    , m_terrainUniformsParameters(-1.0f)
     , m_smoothness(.8f)
     , m_cloudColor(0.68, 0.68, 0.68)
     , m_sphereCenter(-7.0f, 4.8f, -10.0f)
@@ -51,6 +58,9 @@ MapApplication::MapApplication()
     , m_boxRotation(0.0f)
     , m_frame(0)
     , m_maxRenderDistance(30.0f)
+    , m_depthPrepassRenderPass(nullptr)
+    , m_framebufferRenderPass(nullptr)
+    , m_occlusionCullingEnabled(true)
 {
 }
 
@@ -73,6 +83,7 @@ void MapApplication::Initialize()
 
     InitializeCamera();
     InitializeRenderer();
+    InitializeOccluders();
     
     //Enable depth test
     GetDevice().EnableFeature(GL_DEPTH_TEST);
@@ -104,25 +115,162 @@ void MapApplication::Update()
     const Window& window = GetMainWindow();
     m_cameraController.Update(GetMainWindow(), GetDeltaTime());
 
-    m_waterMaterial->SetUniformValue("Time", GetCurrentTime());
-    UpdateMaterialsUniform("AmbientColor", m_ambientColor);
-    UpdateTerrainMaterialsUniform("HeightScale", m_heightScale);
-    UpdateTerrainMaterialsUniform("SmoothingAmount", m_smoothingAmount);
-    UpdateTerrainMaterialsUniform("Levels", m_levels);
-    UpdateTerrainMaterialsUniform("QuantizeTerrain", static_cast<int>(m_quantizeTerrain));
-    
+    // Shared by all the materials through uniform blocks
+    m_renderer.SetTime(GetCurrentTime());
+    m_renderer.SetAmbientColor(m_ambientColor);
+    UpdateTerrainUniforms();
+    UpdateTerrainBounds();
 
     for (int i = 0; i < m_gridWidth * m_gridHeight; i++)
     {
-        auto waterChunk = m_waterScene.GetSceneNode(std::format("Water chunk {}", i));
+        auto waterChunk = m_waterScene.GetSceneNode(m_waterChunks[i]);
         auto currentTranslation = waterChunk->GetTransform()->GetTranslation();
-        waterChunk->GetTransform()->SetTranslation(glm::vec3(currentTranslation.x, m_waterLevel, currentTranslation.z));
+        // Setting it changes the transform version, only do it if the level moved
+        if (currentTranslation.y != m_waterLevel)
+        {
+            waterChunk->GetTransform()->SetTranslation(glm::vec3(currentTranslation.x, m_waterLevel, currentTranslation.z));
+        }
     }
 
-    // Add the scene nodes to the renderer
+    if (m_retainedRenderLists)
+    {
+        // Nothing is culled, so the occluders are not needed
+        m_renderer.SetOcclusionCuller(nullptr);
+        m_sceneProxies.Update();
+        m_waterSceneProxies.Update();
+        return;
+    }
+    m_sceneProxies.Clear();
+    m_waterSceneProxies.Clear();
+
+    // Occluders are rasterized when the visitor sets the camera
+    UpdateOccluders();
+
+    // Add the scene nodes to the renderer, skipping the chunks outside the camera with the BVH
     RendererSceneVisitor rendererSceneVisitor(m_renderer);
-    m_scene.AcceptVisitor(rendererSceneVisitor);
-    m_waterScene.AcceptVisitor(rendererSceneVisitor);
+    FrustumBounds frustum(camera.GetViewProjectionMatrix());
+    rendererSceneVisitor.VisitScene(m_scene, frustum);
+    rendererSceneVisitor.VisitScene(m_waterScene, frustum);
+}
+
+void MapApplication::UpdateTerrainUniforms()
+{
+    glm::vec4 parameters(m_heightScale, m_smoothingAmount, static_cast<float>(m_levels), m_quantizeTerrain ? 1.0f : 0.0f);
+    if (parameters == m_terrainUniformsParameters)
+    {
+        return;
+    }
+    m_terrainUniformsParameters = parameters;
+
+    // The writer is empty until the first upload, the size of the block doesn't change after that
+    bool allocated = m_terrainUniforms.GetSize() > 0;
+
+    // Same order as the block in terrain.glsl
+    m_terrainUniforms.Clear();
+    m_terrainUniforms.Write(m_heightScale);
+    m_terrainUniforms.Write(m_smoothingAmount);
+    m_terrainUniforms.Write(m_levels);
+    m_terrainUniforms.Write(m_quantizeTerrain);
+    m_terrainUniforms.EndStruct();
+
+    m_terrainUniformBuffer.Bind();
+    if (allocated)
+    {
+        m_terrainUniformBuffer.UpdateData(m_terrainUniforms.GetData());
+    }
+    else
+    {
+        m_terrainUniformBuffer.AllocateData(m_terrainUniforms.GetData(), BufferObject::Usage::DynamicDraw);
+        m_terrainUniformBuffer.BindBase(TerrainUniformsBinding);
+    }
+}
+
+void MapApplication::UpdateOccluders()
+{
+    m_renderer.SetOcclusionCuller(m_occlusionCullingEnabled ? &m_occlusionCuller : nullptr);
+    m_occlusionCuller.ClearOccluders();
+    if (!m_occlusionCullingEnabled)
+    {
+        return;
+    }
+
+    // Lowered a little, so the rounding of the heightmap texture doesn't push them above the terrain
+    const float heightBias = 0.005f;
+
+    std::vector<glm::vec3> vertices;
+    for (int i = 0; i < m_gridWidth * m_gridHeight; i++)
+    {
+        // The vertex shader scales and quantizes the heights, both keep the lowest height the lowest
+        const std::vector<float>& heights = m_occluderHeights[i];
+        vertices.clear();
+        for (unsigned int j = 0; j <= OccluderResolution; ++j)
+        {
+            for (unsigned int k = 0; k <= OccluderResolution; ++k)
+            {
+                float height = heights[j * (OccluderResolution + 1) + k] * m_heightScale;
+                if (m_quantizeTerrain)
+                {
+                    height = QuantizeHeight(height);
+                }
+                float x = (k * (m_gridX - 1) / OccluderResolution) / static_cast<float>(m_gridX - 1);
+                float z = (j * (m_gridY - 1) / OccluderResolution) / static_cast<float>(m_gridY - 1);
+                vertices.emplace_back(x, height - heightBias, z);
+            }
+        }
+        m_occlusionCuller.SetOccluderVertices(m_occluderMeshes[i], vertices);
+
+        auto terrainChunk = m_scene.GetSceneNode(m_terrainChunks[i]);
+        m_occlusionCuller.AddOccluder(m_occluderMeshes[i], terrainChunk->GetTransform()->GetTransformMatrix());
+    }
+}
+
+void MapApplication::UpdateTerrainBounds()
+{
+    glm::vec4 parameters(m_heightScale, m_smoothingAmount, static_cast<float>(m_levels), m_quantizeTerrain ? 1.0f : 0.0f);
+    if (parameters == m_terrainBoundsParameters)
+    {
+        return;
+    }
+    m_terrainBoundsParameters = parameters;
+
+    // The patch is flat, the heights come from the heightmap in the vertex shader
+    AabbBounds patchBounds = m_terrainPatch->GetAabbBounds();
+    for (int i = 0; i < m_gridWidth * m_gridHeight; i++)
+    {
+        float minHeight = m_terrainHeightRanges[i].x * m_heightScale;
+        float maxHeight = m_terrainHeightRanges[i].y * m_heightScale;
+        if (m_quantizeTerrain)
+        {
+            minHeight = std::min(minHeight, QuantizeHeight(minHeight));
+            maxHeight = std::max(maxHeight, QuantizeHeight(maxHeight));
+        }
+
+        glm::vec3 min = patchBounds.GetMin();
+        glm::vec3 max = patchBounds.GetMax();
+        min.y += minHeight;
+        max.y += maxHeight;
+
+        auto terrainChunk = std::static_pointer_cast<SceneModel>(m_scene.GetSceneNode(m_terrainChunks[i]));
+        terrainChunk->GetModel()->SetBounds(AabbBounds(0.5f * (min + max), 0.5f * (max - min)));
+    }
+}
+
+float MapApplication::QuantizeHeight(float height) const
+{
+    if (m_levels <= 0)
+    {
+        return height;
+    }
+
+    float level = std::ceil(height * m_levels);
+    float base = level / m_levels;
+    float above = (level + 1.0f) / m_levels;
+
+    // get how close we are to the next plateau
+    float t = height * m_levels - (level - 1.0f);
+
+    float smoothTransition = glm::smoothstep(0.0f, m_smoothingAmount, t);
+    return glm::mix(base, above, smoothTransition);
 }
 
 void MapApplication::UpdateRaymarchMaterial(const Camera& camera)
@@ -172,6 +320,45 @@ void MapApplication::RenderGui()
     if (auto window = m_imGui.UseWindow("Performance Options"))
     {
         ImGui::Text("FPS: %.2f", 1.0f / GetDeltaTime());
+
+        const Renderer::DrawcallStats& drawcallStats = m_renderer.GetDrawcallStats();
+        ImGui::Text("Drawcalls: %u", drawcallStats.drawcalls);
+        ImGui::Text("Program switches: %u (skipped %u)", drawcallStats.shaderPrograms.issued, drawcallStats.shaderPrograms.skipped);
+        ImGui::Text("Material setups: %u (skipped %u)", drawcallStats.materials.issued, drawcallStats.materials.skipped);
+        ImGui::Text("Texture binds: %u (skipped %u)", drawcallStats.textures.issued, drawcallStats.textures.skipped);
+        ImGui::Text("VAO binds: %u (skipped %u)", drawcallStats.vaos.issued, drawcallStats.vaos.skipped);
+        ImGui::Text("Instanced drawcalls: %u (%u instances)", drawcallStats.instancedDrawcalls, drawcallStats.instances);
+
+        const Renderer::CullingStats& cullingStats = m_renderer.GetCullingStats();
+        ImGui::Text("Objects drawn: %u (culled %u, occluded %u)", cullingStats.visible, cullingStats.culled, cullingStats.occluded);
+
+        // Chunks kept in the renderer between frames, instead of culled and added again every frame
+        ImGui::Checkbox("Retained render lists", &m_retainedRenderLists);
+        if (m_retainedRenderLists)
+        {
+            const RendererSceneProxies::Stats& sceneStats = m_sceneProxies.GetStats();
+            const RendererSceneProxies::Stats& waterStats = m_waterSceneProxies.GetStats();
+            ImGui::Text("Proxies: %u (added %u, updated %u, removed %u)", sceneStats.proxies + waterStats.proxies,
+                sceneStats.added + waterStats.added, sceneStats.updated + waterStats.updated, sceneStats.removed + waterStats.removed);
+        }
+
+        // Terrain chunks rasterized on the CPU to hide the objects behind them
+        ImGui::Checkbox("Occlusion culling", &m_occlusionCullingEnabled);
+        if (m_occlusionCullingEnabled)
+        {
+            const OcclusionCuller::Stats& occlusionStats = m_occlusionCuller.GetStats();
+            ImGui::Text("Occluded: %u of %u tested", occlusionStats.occluded, occlusionStats.tested);
+            ImGui::Text("Occluders: %u (%u triangles) in %.3f ms", occlusionStats.occluders, occlusionStats.triangles, occlusionStats.rasterizeTime);
+        }
+
+        // Samples shaded per pixel by the scene pass, to compare with and without the depth prepass
+        bool depthPrepassEnabled = m_depthPrepassRenderPass->IsEnabled();
+        if (ImGui::Checkbox("Depth prepass", &depthPrepassEnabled))
+        {
+            m_depthPrepassRenderPass->SetEnabled(depthPrepassEnabled);
+        }
+        const ForwardRenderPass::OverdrawStats& overdrawStats = m_framebufferRenderPass->GetOverdrawStats();
+        ImGui::Text("Overdraw: %.2f samples per pixel", overdrawStats.samplesPerPixel);
         ImGui::SliderFloat("March size", m_cloudsMaterial->GetDataUniformPointer<float>("MarchSize"), .02f, 1.0f);
         ImGui::SliderInt("Max steps", (int*)(m_cloudsMaterial->GetDataUniformPointer<unsigned int>("MaxSteps")), 0, 1000);
         ImGui::DragFloat("Max Render Distance", &m_maxRenderDistance, 1.0f);
@@ -193,8 +380,8 @@ void MapApplication::RenderGui()
 
     // Draw GUI for scene nodes, using the visitor pattern
     ImGuiSceneVisitor imGuiVisitor(m_imGui, "Scene");
-    m_scene.AcceptVisitor(imGuiVisitor);
-    m_waterScene.AcceptVisitor(imGuiVisitor);
+    imGuiVisitor.VisitScene(m_scene);
+    imGuiVisitor.VisitScene(m_waterScene);
 
     // Draw GUI for camera controller
     m_cameraController.DrawGUI(m_imGui);
@@ -281,29 +468,31 @@ void MapApplication::InitializeMaterials()
     TextureCubemapObject::Unbind();
     {
         // terrain material
+        std::vector<const char*> vertexShaderPaths;
+        vertexShaderPaths.push_back("shaders/version330.glsl");
+        vertexShaderPaths.push_back("shaders/frame.glsl");
+        vertexShaderPaths.push_back("shaders/terrain.glsl");
+        vertexShaderPaths.push_back("shaders/quantizedTerrain.vert");
         std::vector<const char*> fragmentShaderPaths;
         fragmentShaderPaths.push_back("shaders/version330.glsl");
+        fragmentShaderPaths.push_back("shaders/frame.glsl");
         fragmentShaderPaths.push_back("shaders/utils.glsl");
         fragmentShaderPaths.push_back("shaders/blinn-phong.glsl");
         fragmentShaderPaths.push_back("shaders/lighting.glsl");
         fragmentShaderPaths.push_back("shaders/quantizedTerrain.frag");
-        Shader terrainVS = m_vertexShaderLoader.Load("shaders/quantizedTerrain.vert");
+        Shader terrainVS = m_vertexShaderLoader.Load(vertexShaderPaths);
         Shader terrainFS = m_fragmentShaderLoader.Load(fragmentShaderPaths);
         std::shared_ptr<ShaderProgram> terrainShaderProgram = std::make_shared<ShaderProgram>();
         terrainShaderProgram->Build(terrainVS, terrainFS);
 
-        ShaderProgram::Location viewProjMatrixLocation = terrainShaderProgram->GetUniformLocation("ViewProjMatrix");
-        ShaderProgram::Location cameraPositionLocation = terrainShaderProgram->GetUniformLocation("CameraPosition");
+        // Terrain parameters come from our own uniform buffer
+        terrainShaderProgram->SetUniformBlockBinding(terrainShaderProgram->GetUniformBlockIndex("TerrainUniforms"), TerrainUniformsBinding);
+
         ShaderProgram::Location locationWorldMatrix = terrainShaderProgram->GetUniformLocation("WorldMatrix");
-        // Register shader with renderer
+        // Register shader with renderer. Camera uniforms are in the per-frame block of the renderer
         m_renderer.RegisterShaderProgram(terrainShaderProgram,
             [=](const ShaderProgram& shaderProgram, const glm::mat4& worldMatrix, const Camera& camera, bool cameraChanged)
             {
-                if (cameraChanged)
-                {
-                    shaderProgram.SetUniform(cameraPositionLocation, camera.ExtractTranslation());
-                    shaderProgram.SetUniform(viewProjMatrixLocation, camera.GetViewProjectionMatrix());
-                }
                 shaderProgram.SetUniform(locationWorldMatrix, worldMatrix);
             },
             m_renderer.GetDefaultUpdateLightsFunction(*terrainShaderProgram)
@@ -320,9 +509,6 @@ void MapApplication::InitializeMaterials()
         m_terrainMaterials[0]->SetUniformValue("ColorTextureScale", glm::vec2(0.05f));
         m_terrainMaterials[0]->SetUniformValue("Color", glm::vec4(1.0f));
         m_terrainMaterials[0]->SetUniformValue("TerrainWidth", static_cast<int>(m_gridX));
-        
-        m_terrainMaterials[0]->SetUniformValue("AmbientColor", glm::vec3(0.25f));
-        m_terrainMaterials[0]->SetUniformValue("Levels", m_levels);
 
         m_terrainMaterials[0]->SetUniformValue("EnvironmentTexture", m_skyboxTexture);
         m_terrainMaterials[0]->SetUniformValue("EnvironmentMaxLod", maxLod);
@@ -341,36 +527,29 @@ void MapApplication::InitializeMaterials()
         // water material
         std::vector<const char*> waterFragmentShaderPaths;
         waterFragmentShaderPaths.push_back("shaders/version330.glsl");
+        waterFragmentShaderPaths.push_back("shaders/frame.glsl");
         waterFragmentShaderPaths.push_back("shaders/utils.glsl");
         waterFragmentShaderPaths.push_back("shaders/blinn-phong.glsl");
         waterFragmentShaderPaths.push_back("shaders/lighting.glsl");
         waterFragmentShaderPaths.push_back("shaders/water.frag");
-        Shader waterVS = m_vertexShaderLoader.Load("shaders/water.vert");
+        std::vector<const char*> waterVertexShaderPaths;
+        waterVertexShaderPaths.push_back("shaders/version330.glsl");
+        waterVertexShaderPaths.push_back("shaders/frame.glsl");
+        waterVertexShaderPaths.push_back("shaders/water.vert");
+        Shader waterVS = m_vertexShaderLoader.Load(waterVertexShaderPaths);
         Shader waterFS = m_fragmentShaderLoader.Load(waterFragmentShaderPaths);
         std::shared_ptr<ShaderProgram> waterShaderProgram = std::make_shared<ShaderProgram>();
         waterShaderProgram->Build(waterVS, waterFS);
 
-        ShaderProgram::Location waterViewProjMatrixLocation = waterShaderProgram->GetUniformLocation("ViewProjMatrix");
-        ShaderProgram::Location waterCameraPositionLocation = waterShaderProgram->GetUniformLocation("CameraPosition");
-        ShaderProgram::Location waterLocationWorldMatrix = waterShaderProgram->GetUniformLocation("WorldMatrix");
-        // Register shader with renderer
+        // Register shader with renderer. The world matrices come from the instance attribute, all chunks are drawn at once,
+        // and the camera uniforms from the per-frame block, so there are no transforms to update
         m_renderer.RegisterShaderProgram(waterShaderProgram,
-            [=](const ShaderProgram& shaderProgram, const glm::mat4& worldMatrix, const Camera& camera, bool cameraChanged)
-            {
-                if (cameraChanged)
-                {
-                    shaderProgram.SetUniform(waterViewProjMatrixLocation, camera.GetViewProjectionMatrix());
-                    shaderProgram.SetUniform(waterCameraPositionLocation, camera.ExtractTranslation());
-                }
-                shaderProgram.SetUniform(waterLocationWorldMatrix, worldMatrix);
-            },
+            nullptr,
             m_renderer.GetDefaultUpdateLightsFunction(*waterShaderProgram)
         );
 
         m_waterMaterial = std::make_shared<Material>(waterShaderProgram);
 
-        m_waterMaterial->SetUniformValue("AmbientColor", glm::vec3(0.25f));
-
         m_waterMaterial->SetUniformValue("EnvironmentMaxLod", maxLod);
         m_waterMaterial->SetUniformValue("EnvironmentTexture", m_skyboxTexture);
         
@@ -415,18 +594,25 @@ void MapApplication::InitializeModels()
         terrainTransform->SetScale(scale);
         terrainTransform->SetTranslation(scale * gridPositionTranslations[i]);
         terrainModelPointer->AddMaterial(m_terrainMaterials[i]);
+        const std::vector<float>& heights = m_heightMapData[i];
+        auto heightRange = std::minmax_element(heights.begin(), heights.end());
+        m_terrainHeightRanges.emplace_back(*heightRange.first, *heightRange.second);
+
         const std::string& terrainChunkName = std::format("Terrain chunk {}", i);
         auto terrainChunkNode = std::make_shared<SceneModel>(terrainChunkName, terrainModelPointer, terrainTransform);
-        m_scene.AddSceneNode(terrainChunkNode);
+        m_terrainChunks.push_back(m_scene.AddSceneNode(terrainChunkNode));
 
         auto waterTransform = std::make_shared<Transform>();
         waterTransform->SetScale(scale);
         waterTransform->SetTranslation(scale * (gridPositionTranslations[i]));
         const std::string& waterChunkName = std::format("Water chunk {}", i);
-        m_waterScene.AddSceneNode(
+        m_waterChunks.push_back(m_waterScene.AddSceneNode(
             std::make_shared<SceneModel>(
-                waterChunkName, waterModelPointer, waterTransform));
+                waterChunkName, waterModelPointer, waterTransform)));
     }
+
+    m_scene.SetBvhEnabled(true);
+    m_waterScene.SetBvhEnabled(true);
 }
 
 void MapApplication::InitializeRenderer()
@@ -439,6 +625,15 @@ void MapApplication::InitializeRenderer()
     m_depthTexture = framebufferRenderPass->GetDepthTexture();
     m_sceneFramebuffer = framebufferRenderPass->GetTargetFramebuffer();
 
+    // The prepass gets its own collection, routed by the material capabilities, instead of skipping the water every frame
+    unsigned int depthPrepassCollection = m_renderer.AddDrawcallCollection(Material::Opaque | Material::DepthWrite);
+
+    // The terrain vertex shader reads the height from a texture, so the drawcalls use their own material for the depth
+    std::unique_ptr<DepthPrepassRenderPass> depthPrepassRenderPass = std::make_unique<DepthPrepassRenderPass>(nullptr, depthPrepassCollection, m_sceneFramebuffer);
+    framebufferRenderPass->SetDepthPrepass(depthPrepassRenderPass.get());
+    m_depthPrepassRenderPass = depthPrepassRenderPass.get();
+    m_framebufferRenderPass = framebufferRenderPass.get();
+
     m_cloudsMaterial = CreateRaymarchingMaterial("shaders/raymarching/cloud.glsl");
     std::shared_ptr<Material> copyMaterial = CreatePostFXMaterial("shaders/raymarching/copy.frag", m_sceneTexture);
 
@@ -458,12 +653,67 @@ void MapApplication::InitializeRenderer()
     m_cloudsMaterial->SetUniformValue("MaxSafeStep", 5.0f);
     m_cloudsMaterial->SetDepthWrite(false);
 
+    m_renderer.AddRenderPass(std::move(depthPrepassRenderPass));
     m_renderer.AddRenderPass(std::move(framebufferRenderPass));
     m_renderer.AddRenderPass(std::make_unique<SkyboxRenderPass>(m_skyboxTexture));
     m_renderer.AddRenderPass(std::make_unique<PostFXRenderPass>(m_cloudsMaterial, m_sceneFramebuffer));
     m_renderer.AddRenderPass(std::make_unique<PostFXRenderPass>(copyMaterial, m_renderer.GetDefaultFramebuffer()));
 }
 
+void MapApplication::InitializeOccluders()
+{
+    // Each occluder vertex takes the lowest height of the terrain vertices in the cells around it,
+    // so the occluder triangles stay below the terrain triangles that they replace
+    auto coarseToFine = [](unsigned int coarse, unsigned int fineCount)
+    {
+        return coarse * (fineCount - 1) / OccluderResolution;
+    };
+
+    std::vector<unsigned int> indices;
+    for (unsigned int j = 1; j <= OccluderResolution; ++j)
+    {
+        for (unsigned int i = 1; i <= OccluderResolution; ++i)
+        {
+            // Same triangles as the terrain mesh, counter-clockwise from above
+            unsigned int top_right = j * (OccluderResolution + 1) + i;
+            unsigned int top_left = top_right - 1;
+            unsigned int bottom_right = top_right - (OccluderResolution + 1);
+            unsigned int bottom_left = bottom_right - 1;
+            indices.insert(indices.end(), { bottom_right, bottom_left, top_left, bottom_right, top_left, top_right });
+        }
+    }
+
+    // Vertices are placed in UpdateOccluders, with the terrain parameters of the frame
+    std::vector<glm::vec3> vertices((OccluderResolution + 1) * (OccluderResolution + 1), glm::vec3(0.0f));
+
+    for (const std::vector<float>& heightMap : m_heightMapData)
+    {
+        std::vector<float> heights;
+        for (unsigned int j = 0; j <= OccluderResolution; ++j)
+        {
+            unsigned int firstRow = coarseToFine(j > 0 ? j - 1 : 0, m_gridY);
+            unsigned int lastRow = coarseToFine(std::min(j + 1, OccluderResolution), m_gridY);
+            for (unsigned int i = 0; i <= OccluderResolution; ++i)
+            {
+                unsigned int firstColumn = coarseToFine(i > 0 ? i - 1 : 0, m_gridX);
+                unsigned int lastColumn = coarseToFine(std::min(i + 1, OccluderResolution), m_gridX);
+
+                float minHeight = 1.0f;
+                for (unsigned int row = firstRow; row <= lastRow; ++row)
+                {
+                    for (unsigned int column = firstColumn; column <= lastColumn; ++column)
+                    {
+                        minHeight = std::min(minHeight, heightMap[row * m_gridX + column]);
+                    }
+                }
+                heights.push_back(minHeight);
+            }
+        }
+        m_occluderHeights.push_back(heights);
+        m_occluderMeshes.push_back(m_occlusionCuller.AddOccluderMesh(vertices, indices));
+    }
+}
+
 void MapApplication::InitializeCamera()
 {
     // Create the main camera
@@ -545,6 +795,7 @@ void MapApplication::CreateHeightMap(unsigned int width, unsigned int height, gl
     
     heightmap->Bind();
     heightmap->SetImage<float>(0, width, height, TextureObject::FormatR, TextureObject::InternalFormatR16F, pixels);
+    m_heightMapData.push_back(pixels);
     heightmap->GenerateMipmap();
     heightmap->SetParameter(Texture2DObject::ParameterEnum::WrapS, GL_MIRRORED_REPEAT);
     heightmap->SetParameter(Texture2DObject::ParameterEnum::WrapT, GL_MIRRORED_REPEAT);
@@ -568,9 +819,9 @@ void MapApplication::CreateTerrainMesh(unsigned int gridX, unsigned int gridY)
 
     // Define the vertex format (should match the vertex structure)
     VertexFormat vertexFormat;
-    vertexFormat.AddVertexAttribute<float>(3);
-    vertexFormat.AddVertexAttribute<float>(3);
-    vertexFormat.AddVertexAttribute<float>(2);
+    vertexFormat.AddVertexAttribute<float>(3, VertexAttribute::Semantic::Position);
+    vertexFormat.AddVertexAttribute<float>(3, VertexAttribute::Semantic::Normal);
+    vertexFormat.AddVertexAttribute<float>(2, VertexAttribute::Semantic::TexCoord0);
 
     // List of vertices (VBO)
     std::vector<Vertex> vertices;
@@ -4,13 +4,16 @@
 
 #include <ituGL/application/Application.h>
 #include <ituGL/scene/Scene.h>
+#include <ituGL/scene/RendererSceneProxies.h>
 #include <ituGL/asset/ShaderLoader.h>
 #include <ituGL/geometry/Mesh.h>
 #include <ituGL/camera/CameraController.h>
 #include <ituGL/utils/DearImGui.h>
 #include <ituGL/camera/Camera.h>
 #include <ituGL/shader/Material.h>
+#include <ituGL/shader/UniformBufferObject.h>
 #include <ituGL/lighting/DirectionalLight.h>
+#include <ituGL/renderer/OcclusionCuller.h>
 
 #include <glm/mat4x4.hpp>
 #include <vector>
@@ -18,6 +21,8 @@
 class Texture2DObject;
 class Texture3DObject;
 class TextureCubemapObject;
+class DepthPrepassRenderPass;
+class FramebufferRenderPass;
 
 class MapApplication : public Application
 {
@@ -40,45 +45,23 @@ private:
     void InitializeModels();
     void InitializeCamera();
     void InitializeRenderer();
+    void InitializeOccluders();
 
     void RenderGui();
 
     void DrawRaymarchGui();
 
-    template <typename T>
-    void UpdateMaterialsUniform(const char* uniformName, T value)
-    {
-        MapApplication::UpdateTerrainMaterialsUniform(uniformName, value);
-        MapApplication::UpdateWaterMaterialUniform(uniformName, value);
-    }
-
-    template <typename T>
-    void UpdateTerrainMaterialsUniform(const char* uniformName, T value)
-    {
-        for (std::shared_ptr<Material> terrainUniform : m_terrainMaterials)
-        {
-            ShaderProgram::Location location = terrainUniform->GetUniformLocation(uniformName);
-            if (location >= 0)
-                terrainUniform->SetUniformValue(location, value);
-        }
-        ShaderProgram::Location location = m_waterMaterial->GetUniformLocation(uniformName);
-        if (location >= 0)
-            m_waterMaterial->SetUniformValue(location, value);
-    }
-
-    template <typename T>
-    void UpdateWaterMaterialUniform(const char* uniformName, T value)
-    {
-        for (std::shared_ptr<Material> terrainUniform : m_terrainMaterials)
-        {
-            ShaderProgram::Location location = terrainUniform->GetUniformLocation(uniformName);
-            if (location >= 0)
-                terrainUniform->SetUniformValue(location, value);
-        }
-        ShaderProgram::Location location = m_waterMaterial->GetUniformLocation(uniformName);
-        if (location >= 0)
-            m_waterMaterial->SetUniformValue(location, value);
-    }
+    // Upload the terrain parameters to their uniform block, when they change
+    void UpdateTerrainUniforms();
+
+    // Move the occluder vertices to the current terrain height, and add the occluders of the frame
+    void UpdateOccluders();
+
+    // Same height as QuantizeHeight in the terrain vertex shader
+    float QuantizeHeight(float height) const;
+
+    // Extend the bounds of the terrain models to the heights of the vertex shader, when the terrain parameters change
+    void UpdateTerrainBounds();
 
     void CreateHeightMap(unsigned int width, unsigned int height, glm::ivec2 coords);
     std::shared_ptr<Texture2DObject> CreateDefaultTexture();
@@ -97,6 +80,12 @@ private:
 private:
     const int TERRAIN_MESH_COUNT = 4;
 
+    // Cells per side of the simplified terrain chunks used as occluders
+    static const unsigned int OccluderResolution = 16;
+
+    // Binding point of the terrain uniform block. The renderer uses Renderer::FrameUniformsBinding
+    static const GLuint TerrainUniformsBinding = 1;
+
     int m_frame;
 
     unsigned int m_gridX, m_gridY, m_gridWidth, m_gridHeight;
@@ -110,6 +99,19 @@ private:
     // Needed for transparent water
     Scene m_waterScene;
 
+    // Chunk nodes, so the per-frame updates don't look them up by name
+    std::vector<SceneNodeHandle> m_terrainChunks;
+    std::vector<SceneNodeHandle> m_waterChunks;
+
+    // Lowest and highest value of the heightmap of each chunk, and the terrain parameters of their current bounds
+    std::vector<glm::vec2> m_terrainHeightRanges;
+    glm::vec4 m_terrainBoundsParameters;
+
+    // Retained render lists: the chunks stay in the renderer and only the moved ones are sent again, without culling
+    bool m_retainedRenderLists;
+    RendererSceneProxies m_sceneProxies;
+    RendererSceneProxies m_waterSceneProxies;
+
     DearImGui m_imGui;
 
     // Camera controller
@@ -124,6 +126,11 @@ private:
     int m_levels;
     bool m_quantizeTerrain;
 
+    UniformBufferObject m_terrainUniformBuffer;
+    UniformBufferObject::Std140Writer m_terrainUniforms;
+    // Terrain parameters of the last upload
+    glm::vec4 m_terrainUniformsParameters;
+
     // Raymarching
     float m_smoothness, m_maxRenderDistance;
     glm::vec3 m_cloudColor;
@@ -145,12 +152,25 @@ private:
     std::shared_ptr<Texture2DObject> m_snowTexture;
     std::shared_ptr<Texture2DObject> m_waterTexture;
 
+    // Passes that the GUI controls, owned by the renderer
+    DepthPrepassRenderPass* m_depthPrepassRenderPass;
+    FramebufferRenderPass* m_framebufferRenderPass;
+
     // Framebuffers
     std::shared_ptr<const FramebufferObject> m_sceneFramebuffer;
     std::shared_ptr<Texture2DObject> m_depthTexture;
     std::shared_ptr<Texture2DObject> m_sceneTexture;
 
     std::vector<std::shared_ptr<Texture2DObject>> m_heightMaps;
+    // Heights of the heightmaps, kept to build the occluders
+    std::vector<std::vector<float>> m_heightMapData;
+
+    // Terrain chunks hide the chunks and the water behind them
+    OcclusionCuller m_occlusionCuller;
+    bool m_occlusionCullingEnabled;
+    // For each chunk, its occluder mesh, and the lowest height of the heightmap around each of its vertices
+    std::vector<unsigned int> m_occluderMeshes;
+    std::vector<std::vector<float>> m_occluderHeights;
 
     std::shared_ptr<TextureCubemapObject> m_skyboxTexture;
 };
\ No newline at end of file
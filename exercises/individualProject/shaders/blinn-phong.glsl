@@ -1,6 +1,4 @@
 
-uniform vec3 AmbientColor;
-
 struct SurfaceData
 {
 	vec3 normal;
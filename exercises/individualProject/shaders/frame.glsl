@@ -0,0 +1,14 @@
+
+// Per-frame values, uploaded once per frame by the renderer. Same layout as in Renderer::FrameUniformsName
+layout (std140) uniform FrameUniforms
+{
+	mat4 ViewMatrix;
+	mat4 ProjMatrix;
+	mat4 ViewProjMatrix;
+	mat4 InvViewMatrix;
+	mat4 InvProjMatrix;
+	vec3 CameraPosition;
+	float Time;
+	vec3 AmbientColor;
+	int LightCount;
+};
@@ -17,8 +17,6 @@ uniform vec2 ColorTextureRange12;
 uniform vec2 ColorTextureRange23;
 uniform vec2 ColorTextureScale;
 
-uniform vec3 CameraPosition;
-
 
 float inverseMix(vec2 range, float value)
 {
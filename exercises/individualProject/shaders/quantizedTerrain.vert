@@ -1,5 +1,3 @@
-#version 330 core
-
 layout (location = 0) in vec3 VertexPosition;
 layout (location = 1) in vec3 VertexNormal;
 layout (location = 2) in vec2 VertexTexCoord;
@@ -12,14 +10,8 @@ out float Height;
 uniform sampler2D Heightmap;
 
 uniform mat4 WorldMatrix;
-uniform mat4 ViewProjMatrix;
 
 uniform int TerrainWidth;
-uniform bool QuantizeTerrain;
-
-uniform int Levels;
-uniform float SmoothingAmount;
-uniform float HeightScale;
 
 float QuantizeHeight(float height)
 {
@@ -0,0 +1,9 @@
+
+// Terrain parameters shared by all the chunks, uploaded by MapApplication when they change
+layout (std140) uniform TerrainUniforms
+{
+	float HeightScale;
+	float SmoothingAmount;
+	int Levels;
+	bool QuantizeTerrain;
+};
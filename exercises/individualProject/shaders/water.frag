@@ -8,10 +8,6 @@ uniform vec4 Color;
 uniform vec2 ColorTextureScale;
 uniform sampler2D ColorTexture;
 
-uniform float Time;
-
-uniform vec3 CameraPosition;
-
 void main()
 {
 	vec2 samplingSpot = TexCoord * ColorTextureScale + vec2(sin(Time * .5), 0);
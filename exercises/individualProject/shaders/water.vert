@@ -1,20 +1,17 @@
-#version 330 core
-
 layout (location = 0) in vec3 VertexPosition;
 layout (location = 1) in vec3 VertexNormal;
 layout (location = 2) in vec2 VertexTexCoord;
+// Drawn with instancing, the renderer fills it with the world matrix of each water chunk
+layout (location = 8) in mat4 InstanceWorldMatrix;
 
 out vec3 WorldPosition;
 out vec3 WorldNormal;
 out vec2 TexCoord;
 
-uniform mat4 WorldMatrix;
-uniform mat4 ViewProjMatrix;
-
 void main()
 {
-	WorldPosition = (WorldMatrix * vec4(VertexPosition, 1.0)).xyz;
-	WorldNormal = (WorldMatrix * vec4(VertexNormal, 0.0)).xyz;
+	WorldPosition = (InstanceWorldMatrix * vec4(VertexPosition, 1.0)).xyz;
+	WorldNormal = (InstanceWorldMatrix * vec4(VertexNormal, 0.0)).xyz;
 	TexCoord = VertexTexCoord;
 	gl_Position = ViewProjMatrix * vec4(WorldPosition, 1.0);
 }
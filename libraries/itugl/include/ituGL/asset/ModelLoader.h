@@ -27,6 +27,10 @@ public:
     bool GetCreateMaterials() const;
     void SetCreateMaterials(bool createMaterials);
 
+    // Arena where the meshes store their vertices and elements. If null, each mesh gets its own buffers
+    GeometryArena* GetGeometryArena() const;
+    void SetGeometryArena(GeometryArena* geometryArena);
+
     Texture2DLoader& GetTexture2DLoader();
     const Texture2DLoader& GetTexture2DLoader() const;
 
@@ -50,8 +54,9 @@ private:
     void LoadTexture(const aiMaterial& materialData, int textureType, Material& material, ShaderProgram::Location location,
         TextureObject::Format format, TextureObject::InternalFormat internalFormat) const;
 
-    // Build the vertex data from the mesh data
-    static std::vector<GLubyte> CollectVertexData(const aiMesh& meshData, VertexFormat& vertexFormat, bool interleaved);
+    // Build the vertex data from the mesh data, and the bounds of the positions while they are copied
+    static std::vector<GLubyte> CollectVertexData(const aiMesh& meshData, VertexFormat& vertexFormat, bool interleaved,
+        glm::vec3& boundsMin, glm::vec3& boundsMax);
 
     // Build the element data from the mesh data
     static std::vector<GLubyte> CollectElementData(const aiMesh& meshData, Data::Type& elementType,
@@ -84,6 +89,9 @@ private:
 
     // Texture loader to cache already loaded shared textures
     mutable Texture2DLoader m_textureLoader;
+
+    // Optional arena for the mesh data, not owned by the loader
+    GeometryArena* m_geometryArena;
 };
 
 enum class ModelLoader::MaterialProperty
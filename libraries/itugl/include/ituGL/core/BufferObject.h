@@ -13,6 +13,14 @@ public:
         ArrayBuffer = GL_ARRAY_BUFFER,
         // Element Buffer Object
         ElementArrayBuffer = GL_ELEMENT_ARRAY_BUFFER,
+        // Uniform Buffer Object
+        UniformBuffer = GL_UNIFORM_BUFFER,
+        // Texture Buffer Object, storage of a buffer texture
+        TextureBuffer = GL_TEXTURE_BUFFER,
+        // Shader Storage Buffer Object, read and written by the shaders. GL 4.3
+        ShaderStorageBuffer = GL_SHADER_STORAGE_BUFFER,
+        // Parameters of indirect drawcalls. GL 4.0
+        DrawIndirectBuffer = GL_DRAW_INDIRECT_BUFFER,
         // TODO: There are more types, add them when they are supported
     };
 
@@ -58,6 +66,10 @@ public:
     // Modify the contents of the buffer, starting at offset
     void UpdateData(std::span<const std::byte> data, size_t offset = 0);
 
+    // Copy a range between two buffers on the GPU, without changing the buffers bound to the other targets
+    // If source and destination are the same buffer, the ranges can't overlap
+    static void CopyData(const BufferObject& source, size_t sourceOffset, const BufferObject& destination, size_t destinationOffset, size_t size);
+
 protected:
     // Bind the specific target. Used by the Bind() method in derived classes
     void Bind(Target target) const;
@@ -2,12 +2,15 @@
 
 #include <ituGL/core/Color.h>
 #include <glad/glad.h>
+#include <array>
+#include <unordered_map>
 
 class Window;
 struct GLFWwindow;
 
 // Class that represent the device where we run OpenGL
 // Implemented as a Singleton pattern, as there can only be one
+// Keeps a CPU copy of the GL state it sets, so setters can skip redundant calls and getters never wait for the driver
 class DeviceGL
 {
 public:
@@ -28,6 +31,11 @@ public:
 
     // Set the dimensions of the viewport
     void SetViewport(GLint x, GLint y, GLsizei width, GLsizei height);
+    // Get the dimensions of the viewport
+    void GetViewport(GLint& x, GLint& y, GLsizei& width, GLsizei& height) const;
+
+    // Set the rectangle of the scissor test, enabled with GL_SCISSOR_TEST
+    void SetScissor(GLint x, GLint y, GLsizei width, GLsizei height);
 
     // Poll the events in the window event queue
     void PollEvents();
@@ -46,6 +54,50 @@ public:
     inline void EnableFeature(GLenum feature) { SetFeatureEnabled(feature, true); }
     inline void DisableFeature(GLenum feature) { SetFeatureEnabled(feature, false); }
 
+    // Set the blend equation for color and alpha
+    void SetBlendEquation(GLenum colorEquation, GLenum alphaEquation);
+    // Set the blend parameters for color and alpha
+    void SetBlendFunction(GLenum sourceColor, GLenum destColor, GLenum sourceAlpha, GLenum destAlpha);
+    // Set the color used by constant color and constant alpha blend parameters
+    void SetBlendColor(const Color& color);
+
+    // Set the test function for the depth test
+    void SetDepthFunction(GLenum function);
+    // enable / disable writing to the depth buffer
+    void SetDepthMask(bool enabled);
+
+    // enable / disable writing to the color buffers
+    void SetColorMask(bool enabled);
+
+    // Set the faces discarded when GL_CULL_FACE is enabled: GL_FRONT, GL_BACK or GL_FRONT_AND_BACK
+    void SetCullFace(GLenum face);
+
+    // Set the depth offset applied when GL_POLYGON_OFFSET_FILL is enabled: factor * slope + units * resolution
+    void SetPolygonOffset(GLfloat factor, GLfloat units);
+
+    // Set the stencil test function for GL_FRONT, GL_BACK or GL_FRONT_AND_BACK faces
+    void SetStencilFunction(GLenum face, GLenum function, GLint refValue, GLuint mask);
+    // Set the stencil operations for GL_FRONT, GL_BACK or GL_FRONT_AND_BACK faces
+    void SetStencilOperations(GLenum face, GLenum stencilFail, GLenum depthFail, GLenum depthPass);
+
+    // Set the shader program in use
+    void UseShaderProgram(GLuint handle);
+    // Bind a vertex array object
+    void BindVertexArray(GLuint handle);
+    // Set the texture unit affected by BindTexture
+    void SetActiveTextureUnit(GLint textureUnit);
+    // Bind a texture to the active texture unit
+    void BindTexture(GLenum target, GLuint handle);
+
+    // Called when objects are deleted, as GL may reuse their handles
+    void OnShaderProgramDeleted(GLuint handle);
+    void OnVertexArrayDeleted(GLuint handle);
+    void OnTextureDeleted(GLuint handle);
+
+    // Forget the shadowed state. Call it after other code (like the imgui backend) modified GL state directly
+    // Every setter will reach GL the next time, and features will be queried once
+    void InvalidateState();
+
     // enable / disable wireframe mode
     void SetWireframeEnabled(bool enabled);
 
@@ -53,9 +105,66 @@ public:
     void SetVSyncEnabled(bool enabled);
 
 private:
+    // Set the shadowed state to the initial values of a new GL context
+    void ResetState();
+
+private:
+    // Value used for unknown shadowed state
+    static const GLuint UnknownValue = ~0u;
+
+    // Texture units with shadowed bindings. Bindings in higher units always reach GL
+    static const int ShadowedTextureUnits = 32;
+
     // Has a context been loaded? We use the context of the current window
     bool m_contextLoaded;
 
+    // Enabled features. Features missing in the map are unknown
+    mutable std::unordered_map<GLenum, bool> m_features;
+
+    // Blend equations, color and alpha
+    std::array<GLenum, 2> m_blendEquations;
+
+    // Blend parameters: source color, destination color, source alpha, destination alpha
+    std::array<GLenum, 4> m_blendFunction;
+
+    // Blend color, and if it is known
+    Color m_blendColor;
+    bool m_blendColorKnown;
+
+    // Depth function and write mask
+    GLenum m_depthFunction;
+    GLuint m_depthMask;
+
+    // Color write mask, the same for all components
+    GLuint m_colorMask;
+
+    // Faces discarded by face culling
+    GLenum m_cullFace;
+
+    // Polygon offset factor and units, and if they are known
+    std::array<GLfloat, 2> m_polygonOffset;
+    bool m_polygonOffsetKnown;
+
+    // Stencil function, reference value and mask, front and back
+    std::array<GLenum, 2> m_stencilFunctions;
+    std::array<GLint, 2> m_stencilRefValues;
+    std::array<GLuint, 2> m_stencilMasks;
+
+    // Stencil operations for stencil fail, depth fail and depth pass, front and back
+    std::array<std::array<GLenum, 3>, 2> m_stencilOperations;
+
+    // Viewport x, y, width and height. Queried if unknown
+    mutable std::array<GLint, 4> m_viewport;
+
+    // Scissor rectangle x, y, width and height
+    std::array<GLint, 4> m_scissor;
+
+    // Bound objects
+    GLuint m_shaderProgram;
+    GLuint m_vertexArray;
+    GLint m_activeTextureUnit;
+    std::unordered_map<GLenum, std::array<GLuint, ShadowedTextureUnits>> m_textures;
+
 private:
     // Singleton instance
     static DeviceGL* m_instance;
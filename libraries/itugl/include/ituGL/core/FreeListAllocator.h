@@ -0,0 +1,54 @@
+#pragma once
+
+#include <map>
+#include <cstddef>
+
+// Sub-allocator of ranges inside a block of a given capacity, like the vertices or elements of a large buffer
+// It only does the bookkeeping: the free ranges are kept sorted by offset and merged with their neighbours when freed.
+// Allocations take the smallest free range that fits, to keep the large ones for large requests
+// Units are up to the caller: bytes, vertices...
+class FreeListAllocator
+{
+public:
+    // Returned by Allocate when no free range is large enough
+    static const size_t InvalidOffset = ~static_cast<size_t>(0);
+
+    struct Stats
+    {
+        size_t capacity = 0;
+        size_t used = 0;
+        size_t largestFreeBlock = 0;
+        unsigned int freeBlockCount = 0;
+        unsigned int allocationCount = 0;
+
+        // Free space that can't be used by a single allocation: 0 if it is all in one block, close to 1 if it is scattered
+        float GetFragmentation() const;
+    };
+
+public:
+    FreeListAllocator(size_t capacity = 0);
+
+    inline size_t GetCapacity() const { return m_capacity; }
+
+    // Get a range of size units, starting at a multiple of alignment. InvalidOffset if there is no space
+    size_t Allocate(size_t size, size_t alignment = 1);
+
+    // Release a range returned by Allocate, with the same size
+    void Free(size_t offset, size_t size);
+
+    // Add free space at the end
+    void Grow(size_t capacity);
+
+    // Forget all the allocations, and mark the first used units as a single allocation. Used after compacting the data
+    void Reset(size_t used, unsigned int allocationCount);
+
+    Stats GetStats() const;
+
+private:
+    // Free ranges, from offset to size
+    std::map<size_t, size_t> m_freeBlocks;
+
+    size_t m_capacity;
+    size_t m_used;
+    unsigned int m_allocationCount;
+};
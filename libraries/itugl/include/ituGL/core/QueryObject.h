@@ -0,0 +1,38 @@
+#pragma once
+
+#include <ituGL/core/Object.h>
+
+// Measures a value in the GL while the query is active, like the samples that pass the depth test
+// The result arrives some time after End, usually a few frames later. Check IsResultAvailable to read it without waiting
+class QueryObject : public Object
+{
+public:
+    enum class Target : GLenum
+    {
+        SamplesPassed = GL_SAMPLES_PASSED,
+        AnySamplesPassed = GL_ANY_SAMPLES_PASSED,
+        TimeElapsed = GL_TIME_ELAPSED,
+    };
+
+public:
+    QueryObject();
+    virtual ~QueryObject();
+
+    QueryObject(QueryObject&& query) noexcept;
+    QueryObject& operator = (QueryObject&& query) noexcept;
+
+    // Queries are not bound, they are active between Begin and End
+    void Bind() const override;
+
+    // Start measuring. Only one query can be active per target
+    void Begin(Target target);
+
+    // Stop measuring with the active query of the target
+    static void End(Target target);
+
+    // Check if the result of the last measure is ready
+    bool IsResultAvailable() const;
+
+    // Get the result of the last measure. Waits for it if it is not available
+    GLuint64 GetResult() const;
+};
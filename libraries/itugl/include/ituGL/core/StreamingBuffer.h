@@ -0,0 +1,98 @@
+#pragma once
+
+#include <ituGL/core/BufferObject.h>
+#include <vector>
+#include <span>
+#include <cstddef>
+
+// Buffer for data that is written by the CPU every frame: dynamic vertices, indices or uniform blocks
+// The buffer is split in regions, one per frame in flight. Each frame writes to the next region, after waiting on the
+// fence placed when the GL was last using it. With enough regions, the CPU never waits and there is no implicit sync
+// If glBufferStorage is available (GL 4.4), the buffer is mapped once with persistent coherent mapping, and allocations
+// point straight to GL memory. Otherwise, allocations are staged in CPU memory and copied by Flush, with an unsynchronized map
+class StreamingBuffer : public BufferObject
+{
+public:
+    // Part of the current region given to the caller
+    struct Allocation
+    {
+        // Memory to write to. nullptr if the region was full
+        std::byte* data = nullptr;
+        // Offset from the start of the buffer, to bind or point attributes to
+        size_t offset = 0;
+        size_t size = 0;
+
+        inline bool IsValid() const { return data != nullptr; }
+
+        // Get the memory as an array of T
+        template<typename T>
+        std::span<T> As() const { return std::span<T>(reinterpret_cast<T*>(data), size / sizeof(T)); }
+    };
+
+public:
+    // Create the buffer with regionCount regions of regionSize bytes. target is used by Bind()
+    StreamingBuffer(size_t regionSize, unsigned int regionCount = 3, Target target = Target::ArrayBuffer);
+    virtual ~StreamingBuffer();
+
+    // Bind to the target given in the constructor
+    inline Target GetTarget() const override { return m_target; }
+    void Bind() const override;
+
+    // The same buffer can be bound to other targets, for instance as a uniform buffer
+    using BufferObject::Bind;
+
+    // Check if the buffer is persistently mapped, or if the allocations go through a staging copy
+    inline bool IsPersistent() const { return m_persistent; }
+
+    inline size_t GetRegionSize() const { return m_regionSize; }
+    inline unsigned int GetRegionCount() const { return m_regionCount; }
+
+    // Move to the next region, waiting until the GL is done with it
+    void BeginFrame();
+
+    // Get size bytes from the current region. The offset is a multiple of alignment, that doesn't need to be a power of 2,
+    // so vertices can be drawn with the offset divided by the vertex size as first vertex
+    Allocation Allocate(size_t size, size_t alignment = 4);
+
+    template<typename T>
+    inline Allocation Allocate(size_t count, size_t alignment = sizeof(T)) { return Allocate(count * sizeof(T), alignment); }
+
+    // Make the allocations visible to the GL. Call it before the drawcalls that read them
+    void Flush();
+
+    // Place the fence for the current region, after the drawcalls that use it
+    void EndFrame();
+
+    // Number of frames, and the number of them that had to wait on a fence in BeginFrame
+    inline unsigned int GetFrameCount() const { return m_frameCount; }
+    inline unsigned int GetWaitCount() const { return m_waitCount; }
+
+private:
+    // Wait until the fence is signaled and delete it. Returns true if it had to wait
+    static bool WaitFence(GLsync fence);
+
+private:
+    Target m_target;
+
+    size_t m_regionSize;
+    unsigned int m_regionCount;
+
+    bool m_persistent;
+
+    // Pointer to the mapped buffer, if persistent
+    std::byte* m_mappedData;
+
+    // CPU copy of the current region, if not persistent
+    std::vector<std::byte> m_stagingData;
+
+    // One fence per region, null if the GL is not using it
+    std::vector<GLsync> m_fences;
+
+    // Current region, and the bytes used in it. flushedSize is the part already copied to the GL
+    unsigned int m_region;
+    size_t m_usedSize;
+    size_t m_flushedSize;
+
+    unsigned int m_frameCount;
+    unsigned int m_waitCount;
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <vector>
+
+// Threads that stay alive between calls, to split per-frame work without creating and joining threads every frame
+// Workers are started the first time they are needed, and then wait for the next Run until the pool is destroyed
+class WorkerPool
+{
+public:
+    WorkerPool();
+    ~WorkerPool();
+
+    // The workers keep a pointer to the pool
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator = (const WorkerPool&) = delete;
+
+    // Number of workers started so far, not counting the calling thread
+    unsigned int GetWorkerCount() const;
+
+    // Call task(0) to task(taskCount - 1) in parallel, and wait for all of them. The calling thread runs task(0)
+    void Run(unsigned int taskCount, const std::function<void(unsigned int)>& task);
+
+private:
+    void WorkerLoop(unsigned int taskIndex, unsigned int generation);
+
+private:
+    std::vector<std::thread> m_workers;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_startCondition;
+    std::condition_variable m_doneCondition;
+
+    // Current Run, protected by the mutex. Each Run increments the generation to wake up the workers
+    const std::function<void(unsigned int)>* m_task;
+    unsigned int m_taskCount;
+    unsigned int m_pendingCount;
+    unsigned int m_generation;
+    bool m_stopping;
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <ituGL/core/BufferObject.h>
+#include <ituGL/core/Data.h>
+#include <ituGL/geometry/Drawcall.h>
+
+// Buffer with the parameters of drawcalls, so they can be written by the GPU and submitted with a single call
+// Multi-draw indirect requires GL 4.3
+class DrawIndirectBufferObject : public BufferObjectBase<BufferObject::DrawIndirectBuffer>
+{
+public:
+    // Parameters of one drawcall, with the layout of DrawElementsIndirectCommand. Drawcalls without elements use the
+    // layout of DrawArraysIndirectCommand, so baseInstance moves to the place of baseVertex. See Command::Create
+    struct Command
+    {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint first;
+        GLuint baseVertex;
+        GLuint baseInstance;
+
+        // Command that draws the drawcall instanceCount times, with the instance attributes starting at baseInstance
+        static Command Create(const Drawcall& drawcall, GLuint instanceCount, GLuint baseInstance);
+    };
+
+public:
+    DrawIndirectBufferObject();
+
+    // Use the same AllocateData methods from the base class
+    using BufferObject::AllocateData;
+    // Additionally, provide AllocateData for a span of commands
+    inline void AllocateData(std::span<const Command> commands, Usage usage = Usage::StreamDraw) { AllocateData(Data::GetBytes(commands), usage); }
+
+    // Use the same UpdateData methods from the base class
+    using BufferObject::UpdateData;
+    // Additionally, provide UpdateData for a span of commands
+    inline void UpdateData(std::span<const Command> commands, size_t offsetBytes = 0) { UpdateData(Data::GetBytes(commands), offsetBytes); }
+
+    // Execute drawCount commands of the bound buffer, starting at firstCommand, with the bound VAO
+    // All of them must have the same primitive and element type
+    static void MultiDraw(Drawcall::Primitive primitive, Data::Type eboType, unsigned int firstCommand, GLsizei drawCount);
+};
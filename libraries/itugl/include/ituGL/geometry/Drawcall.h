@@ -2,6 +2,8 @@
 
 #include <ituGL/core/Data.h>
 
+class CommandBuffer;
+
 // Helper class to store the parameters of a drawcall
 class Drawcall
 {
@@ -27,13 +29,30 @@ public:
     Drawcall();
     Drawcall(Primitive primitive, GLsizei count, GLint first = 0);
     Drawcall(Primitive primitive, GLsizei count, Data::Type eboType, GLint first = 0);
+    // Drawcall with elements, where baseVertex is added to every element. Used by meshes that share their buffers
+    Drawcall(Primitive primitive, GLsizei count, Data::Type eboType, GLint first, GLint baseVertex);
 
     // Check if the drawcall is valid
     inline bool IsValid() const { return m_primitive != Primitive::Invalid && m_count > 0; }
 
+    inline Primitive GetPrimitive() const { return m_primitive; }
+    // First vertex, or offset in bytes of the first element
+    inline GLint GetFirst() const { return m_first; }
+    inline GLsizei GetCount() const { return m_count; }
+    // Type of the elements, None if the drawcall doesn't use an EBO
+    inline Data::Type GetEboType() const { return m_eboType; }
+    // Value added to the elements before reading the vertices
+    inline GLint GetBaseVertex() const { return m_baseVertex; }
+
     // Execute the drawcall
     void Draw() const;
 
+    // Execute the drawcall instanceCount times. Attributes with a divisor advance once per instance
+    void DrawInstanced(GLsizei instanceCount) const;
+
+    // Record the drawcall into the command buffer, after the VAO. instanceCount 0 records a draw without instancing
+    void Record(CommandBuffer& commandBuffer, GLsizei instanceCount = 0) const;
+
 private:
     // Type of primitive to be rendered
     Primitive m_primitive;
@@ -46,4 +65,7 @@ private:
 
     // Data type of the elements in the EBO (int, uint, short, byte, etc.). A value of None means no EBO
     Data::Type m_eboType;
+
+    // Offset added to the elements, only with an EBO
+    GLint m_baseVertex;
 };
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <ituGL/core/FreeListAllocator.h>
+#include <ituGL/geometry/VertexBufferObject.h>
+#include <ituGL/geometry/ElementBufferObject.h>
+#include <ituGL/geometry/VertexArrayObject.h>
+#include <ituGL/geometry/VertexFormat.h>
+#include <ituGL/geometry/Drawcall.h>
+#include <ituGL/shader/ShaderProgram.h>
+#include <unordered_map>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <span>
+
+// Storage for the vertices and elements of many meshes, so they can share buffers and VAOs
+// Meshes with the same vertex format, and the same attribute locations, go to the same pool: one large VBO, one large EBO
+// and a VAO pointing to both of them. Each allocation takes a range of vertices and a range of elements, given by a
+// FreeListAllocator. The drawcalls use the first element and the base vertex of the allocation, so switching between
+// meshes of the same pool doesn't need to bind a different VAO
+// Pools grow when they are full, copying the data to larger buffers on the GPU. Freed ranges can be reused by other
+// allocations, and Defragment compacts each pool to remove the holes
+// Vertices must be interleaved. Use it through Mesh::AddSubmeshes, that frees the allocation when the mesh is destroyed
+class GeometryArena
+{
+public:
+    // Index of an allocation
+    using AllocationId = unsigned int;
+    static const AllocationId InvalidAllocation = ~0u;
+
+    // Same as Mesh::SemanticMap
+    using SemanticMap = std::unordered_map<VertexAttribute::Semantic, ShaderProgram::Location>;
+
+    struct Stats
+    {
+        unsigned int poolCount = 0;
+        unsigned int allocationCount = 0;
+
+        // Sizes in bytes
+        size_t vertexCapacity = 0;
+        size_t vertexUsed = 0;
+        size_t elementCapacity = 0;
+        size_t elementUsed = 0;
+
+        // Free ranges in all the pools, and the worst fragmentation of them, see FreeListAllocator::Stats
+        unsigned int freeBlockCount = 0;
+        float fragmentation = 0.0f;
+    };
+
+public:
+    // Initial size of the buffers of each new pool
+    GeometryArena(size_t vertexBufferSize = 4 << 20, size_t elementBufferSize = 2 << 20);
+
+    // Copy the vertices and elements to the pool of the vertex format, and create a drawcall for each of the ones provided
+    // Drawcalls are relative to the data: first vertex in vertexData, or offset in bytes in elementData
+    // elementData can be empty if the drawcalls don't use elements
+    AllocationId Allocate(const VertexFormat& vertexFormat, std::span<const GLubyte> vertexData,
+        std::span<const GLubyte> elementData, std::span<const Drawcall> drawcalls, const SemanticMap& locations = SemanticMap());
+
+    // Release the ranges of the allocation, its drawcalls must not be used anymore
+    void Free(AllocationId allocationId);
+
+    // VAO shared by all the allocations of the same pool
+    const VertexArrayObject& GetVertexArray(AllocationId allocationId) const;
+
+    // Drawcalls with the offsets in the shared buffers. They are kept up to date when the data is moved
+    inline unsigned int GetDrawcallCount(AllocationId allocationId) const { return static_cast<unsigned int>(m_allocations[allocationId].drawcalls.size()); }
+    inline const Drawcall& GetDrawcall(AllocationId allocationId, unsigned int index) const { return m_allocations[allocationId].drawcalls[index]; }
+
+    // Move the allocations of each fragmented pool to the start of new buffers, removing the holes between them
+    // Returns the number of pools compacted
+    unsigned int Defragment(float minFragmentation = 0.0f);
+
+    Stats GetStats() const;
+
+private:
+    struct AttributeKey
+    {
+        Data::Type type;
+        int components;
+        bool normalized;
+        GLuint location;
+
+        bool operator == (const AttributeKey& other) const = default;
+    };
+
+    struct Pool
+    {
+        std::vector<AttributeKey> key;
+        VertexFormat vertexFormat;
+        SemanticMap locations;
+
+        // Replaced when the pool is resized
+        std::unique_ptr<VertexBufferObject> vbo;
+        std::unique_ptr<ElementBufferObject> ebo;
+        VertexArrayObject vao;
+
+        // Vertices are allocated in vertex units, elements in bytes
+        FreeListAllocator vertexAllocator;
+        FreeListAllocator elementAllocator;
+    };
+
+    struct Allocation
+    {
+        unsigned int poolIndex = 0;
+        size_t firstVertex = 0;
+        size_t vertexCount = 0;
+        size_t elementOffset = 0;
+        size_t elementSize = 0;
+
+        // Drawcalls as given, and with the offsets of the allocation applied
+        std::vector<Drawcall> localDrawcalls;
+        std::vector<Drawcall> drawcalls;
+
+        bool IsFree() const { return vertexCount == 0; }
+    };
+
+private:
+    // Find the pool for this vertex format and locations, creating it if there is none
+    unsigned int GetPool(const VertexFormat& vertexFormat, const SemanticMap& locations);
+
+    // Resize the buffers of the pool, copying the data of the allocations. If compact, they are packed at the start
+    void ResizePool(unsigned int poolIndex, size_t vertexCapacity, size_t elementCapacity, bool compact);
+
+    // Point the VAO of the pool to its current buffers
+    void SetupVertexArray(Pool& pool);
+
+    // Apply the offsets of the allocation to its drawcalls
+    static void UpdateDrawcalls(Allocation& allocation);
+
+private:
+    size_t m_vertexBufferSize;
+    size_t m_elementBufferSize;
+
+    std::vector<std::unique_ptr<Pool>> m_pools;
+
+    // Deque, so the drawcalls keep their address when allocations are added
+    std::deque<Allocation> m_allocations;
+    std::vector<AllocationId> m_freeAllocations;
+};
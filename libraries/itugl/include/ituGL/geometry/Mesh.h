@@ -5,9 +5,12 @@
 #include <ituGL/geometry/VertexArrayObject.h>
 #include <ituGL/geometry/VertexAttribute.h>
 #include <ituGL/geometry/Drawcall.h>
+#include <ituGL/geometry/GeometryArena.h>
 #include <ituGL/shader/ShaderProgram.h>
+#include <ituGL/scene/Bounds.h>
 #include <vector>
 #include <unordered_map>
+#include <limits>
 
 // Class that groups several VBO, EBO and VAO that are part of the same object
 // Can contain several drawcalls using the data in those objects
@@ -19,6 +22,11 @@ public:
 
 public:
     Mesh();
+    // Frees the data stored in the arena
+    ~Mesh();
+
+    Mesh(Mesh&& mesh) noexcept;
+    Mesh& operator = (Mesh&& mesh) noexcept;
 
     // Adds a new VBO with uninitialized data
     unsigned int AddVertexData(size_t size);
@@ -100,6 +108,14 @@ public:
         std::span<const TVertex> vertices, std::span<const TElement> elements,
         TIterator it, const TIterator itEnd, const SemanticMap& locations = SemanticMap());
 
+    // Adds a submesh for each drawcall, with the vertices and elements stored in the arena instead of in buffers of this mesh
+    // Vertices are interleaved. Drawcalls are relative to vertexData and elementData. The arena must outlive the mesh
+    // The bounds are not computed, the caller usually has them already, see ModelLoader
+    // Returns the index of the first submesh
+    unsigned int AddSubmeshes(GeometryArena& arena, const VertexFormat& vertexFormat,
+        std::span<const GLubyte> vertexData, std::span<const GLubyte> elementData,
+        std::span<const Drawcall> drawcalls, const SemanticMap& locations = SemanticMap());
+
     inline unsigned int GetVertexBufferCount() const { return static_cast<unsigned int>(m_vbos.size()); }
     inline const VertexBufferObject& GetVertexBuffer(unsigned int vboIndex) const { return m_vbos[vboIndex]; }
 
@@ -110,19 +126,50 @@ public:
     inline const VertexArrayObject& GetVertexArray(unsigned int vaoIndex) const { return m_vaos[vaoIndex]; }
 
     inline unsigned int GetSubmeshCount() const { return static_cast<unsigned int>(m_submeshes.size()); }
-    inline const VertexArrayObject& GetSubmeshVertexArray(unsigned int submeshIndex) const { return m_vaos[m_submeshes[submeshIndex].vaoIndex]; }
-    inline const Drawcall& GetSubmeshDrawcall(unsigned int submeshIndex) const { return m_submeshes[submeshIndex].drawcall; }
+    const VertexArrayObject& GetSubmeshVertexArray(unsigned int submeshIndex) const;
+    const Drawcall& GetSubmeshDrawcall(unsigned int submeshIndex) const;
 
     // Draws a submesh
     void DrawSubmesh(int submeshIndex) const;
 
+    // Local bounds of a submesh, computed from the vertex positions when the submesh is added with its vertex data
+    // Submeshes added with existing buffers or with AddSubmeshes are empty until their bounds are set or computed
+    AabbBounds GetSubmeshAabbBounds(unsigned int submeshIndex) const;
+    SphereBounds GetSubmeshSphereBounds(unsigned int submeshIndex) const;
+    void SetSubmeshBounds(unsigned int submeshIndex, const glm::vec3& min, const glm::vec3& max, float radius);
+
+    // Compute the bounds of a submesh from count positions of 3 floats, stride bytes apart
+    void ComputeSubmeshBounds(unsigned int submeshIndex, const void* positions, size_t stride, size_t count);
+
+    // Local bounds containing all the submeshes, combined on the first call after the bounds of a submesh change
+    AabbBounds GetAabbBounds() const;
+    SphereBounds GetSphereBounds() const;
+
+    // Incremented when the bounds of any submesh change
+    inline unsigned int GetBoundsVersion() const { return m_boundsVersion; }
+
+    // Expand min and max with count positions of 3 floats, srcStride bytes apart, using SSE when available
+    // If dstBuffer is not null, the positions are copied there too, dstStride bytes apart, in the same pass
+    static void AccumulatePositionBounds(const void* srcBuffer, size_t srcStride, size_t count, glm::vec3& min, glm::vec3& max,
+        void* dstBuffer = nullptr, size_t dstStride = 0);
+
+    // Radius of the smallest sphere centered at center that contains the positions
+    static float ComputePositionRadius(const void* positions, size_t stride, size_t count, const glm::vec3& center);
+
 private:
 
     // Helper structure that contains a drawcall and its VAO to be bound
+    // Submeshes in the arena use the VAO and drawcall of their allocation instead, with vaoIndex as the drawcall index
     struct Submesh
     {
         unsigned int vaoIndex;
         Drawcall drawcall;
+        GeometryArena::AllocationId allocationId = GeometryArena::InvalidAllocation;
+
+        // Local bounds, empty while min is above max
+        glm::vec3 boundsMin = glm::vec3(std::numeric_limits<float>::max());
+        glm::vec3 boundsMax = glm::vec3(-std::numeric_limits<float>::max());
+        float boundsRadius = 0.0f;
     };
 
 private:
@@ -139,6 +186,13 @@ private:
     // Set a vertex attribute in a VAO, using the specified layout, and increases the location index according to the size of the attribute
     void SetupVertexAttribute(VertexArrayObject& vao, const VertexAttribute::Layout& attributeLayout, GLuint& location, const SemanticMap& locations);
 
+    // Compute the bounds of a submesh from the position attribute of the layout, if there is one
+    template<typename TIterator>
+    void ComputeSubmeshBounds(unsigned int submeshIndex, const void* vertexData, int vertexCount, TIterator it, const TIterator itEnd);
+
+    // Combine the bounds of all the submeshes, if they changed since the last time
+    void UpdateBounds() const;
+
 private:
     // All the VBOs used in this mesh
     std::vector<VertexBufferObject> m_vbos;
@@ -151,6 +205,17 @@ private:
 
     // Submeshes contained in this mesh
     std::vector<Submesh> m_submeshes;
+
+    // Arena with the data of the submeshes added with AddSubmeshes, and their allocations
+    GeometryArena* m_arena;
+    std::vector<GeometryArena::AllocationId> m_arenaAllocations;
+
+    // Bounds of all the submeshes, combined when requested after the bounds of one of them change
+    mutable glm::vec3 m_boundsMin;
+    mutable glm::vec3 m_boundsMax;
+    mutable float m_boundsRadius;
+    mutable bool m_boundsDirty;
+    unsigned int m_boundsVersion;
 };
 
 template<typename T>
@@ -290,7 +355,9 @@ unsigned int Mesh::AddSubmesh(Drawcall::Primitive primitive,
     TIterator it, const TIterator itEnd, const SemanticMap& locations)
 {
     unsigned int vboIndex = AddVertexData(vertices);
-    return AddSubmesh(primitive, 0, static_cast<int>(vertices.size()), vboIndex, it, itEnd, locations);
+    unsigned int submeshIndex = AddSubmesh(primitive, 0, static_cast<int>(vertices.size()), vboIndex, it, itEnd, locations);
+    ComputeSubmeshBounds(submeshIndex, vertices.data(), static_cast<int>(vertices.size()), it, itEnd);
+    return submeshIndex;
 }
 
 template<typename TVertex, typename TElement, typename TIterator>
@@ -300,6 +367,24 @@ unsigned int Mesh::AddSubmesh(Drawcall::Primitive primitive,
 {
     int vboIndex = AddVertexData(vertices);
     int eboIndex = AddElementData(elements);
-    return AddSubmesh(primitive, 0, static_cast<int>(elements.size()), Data::GetType<TElement>(), vboIndex, eboIndex, it, itEnd, locations);
+    unsigned int submeshIndex = AddSubmesh(primitive, 0, static_cast<int>(elements.size()), Data::GetType<TElement>(), vboIndex, eboIndex, it, itEnd, locations);
+    ComputeSubmeshBounds(submeshIndex, vertices.data(), static_cast<int>(vertices.size()), it, itEnd);
+    return submeshIndex;
+}
+
+template<typename TIterator>
+void Mesh::ComputeSubmeshBounds(unsigned int submeshIndex, const void* vertexData, int vertexCount, TIterator it, const TIterator itEnd)
+{
+    for (; it != itEnd; it++)
+    {
+        const VertexAttribute& attribute = it->GetAttribute();
+        if (attribute.GetSemantic() == VertexAttribute::Semantic::Position && attribute.GetType() == Data::Type::Float && attribute.GetComponents() >= 3)
+        {
+            const GLubyte* positions = static_cast<const GLubyte*>(vertexData) + it->GetOffset();
+            size_t stride = it->GetStride() ? it->GetStride() : attribute.GetSize();
+            ComputeSubmeshBounds(submeshIndex, positions, stride, vertexCount);
+            break;
+        }
+    }
 }
 
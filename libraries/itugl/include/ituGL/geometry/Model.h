@@ -1,5 +1,6 @@
 #pragma once
 
+#include <ituGL/scene/Bounds.h>
 #include <memory>
 #include <vector>
 
@@ -36,10 +37,32 @@ public:
     // Draw all the submeshes of the mesh, each one with a material on the list
     void Draw();
 
+    // Local bounds of the model. The bounds of the mesh, unless they were set
+    AabbBounds GetAabbBounds() const;
+    SphereBounds GetSphereBounds() const;
+
+    // Replace the bounds of the mesh, for shaders that move the vertices outside of it, like a heightmap displacement
+    void SetBounds(const AabbBounds& bounds);
+    // Go back to the bounds of the mesh
+    void ResetBounds();
+
+    // Changes when the bounds of the model or of its mesh change
+    unsigned int GetBoundsVersion() const;
+
 private:
     // Pointer to the model Mesh
     std::shared_ptr<Mesh> m_mesh;
 
     // List of material pointers, one for each submesh
     std::vector<std::shared_ptr<Material>> m_materials;
+
+    // Bounds set with SetBounds, used instead of the ones of the mesh
+    bool m_hasBounds;
+    glm::vec3 m_boundsCenter;
+    glm::vec3 m_boundsSize;
+
+    // Increased when the bounds change, or when the mesh or its bounds version differ from the last ones seen
+    mutable unsigned int m_boundsVersion;
+    mutable const Mesh* m_boundsMesh;
+    mutable unsigned int m_boundsMeshVersion;
 };
@@ -0,0 +1,244 @@
+#pragma once
+
+#include <ituGL/core/Data.h>
+#include <ituGL/core/Color.h>
+#include <glm/mat4x4.hpp>
+#include <vector>
+#include <array>
+#include <span>
+#include <unordered_map>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cassert>
+
+// Linear buffer of compact POD commands, recorded without touching GL
+// A CommandExecutor replays them later, against GL or against nothing (for tests and profiling without a context)
+// Recording is not thread safe, but different threads can record different buffers
+// Code that sets uniforms through ShaderProgram can be recorded with ShaderProgram::SetRecordingCommandBuffer
+// Other code that can only set its state through GL is recorded as a function call. Those functions must not change
+// the state tracked by the buffer: program, VAO, textures and render states
+class CommandBuffer
+{
+public:
+    // Type of each command
+    enum class CommandType : std::uint16_t
+    {
+        SetFeature,
+        SetDepthFunction,
+        SetDepthMask,
+        SetBlendEquation,
+        SetBlendFunction,
+        SetBlendColor,
+        SetStencilFunction,
+        SetStencilOperations,
+        SetScissor,
+        UseProgram,
+        SetUniforms,
+        BindUniformBlock,
+        BindVertexArray,
+        BindTexture,
+        DrawArrays,
+        DrawElements,
+        CallFunction,
+        Count
+    };
+
+    // Header stored before each command. size includes the header, the command and its payload
+    struct CommandHeader
+    {
+        CommandType type;
+        std::uint16_t padding;
+        std::uint32_t size;
+    };
+
+    // Commands. Each one only stores handles and values, so they can be copied as bytes
+    struct SetFeatureCommand { static const CommandType Type = CommandType::SetFeature; GLenum feature; GLboolean enabled; };
+    struct SetDepthFunctionCommand { static const CommandType Type = CommandType::SetDepthFunction; GLenum function; };
+    struct SetDepthMaskCommand { static const CommandType Type = CommandType::SetDepthMask; GLboolean enabled; };
+    struct SetBlendEquationCommand { static const CommandType Type = CommandType::SetBlendEquation; GLenum colorEquation; GLenum alphaEquation; };
+    struct SetBlendFunctionCommand { static const CommandType Type = CommandType::SetBlendFunction; GLenum sourceColor; GLenum destColor; GLenum sourceAlpha; GLenum destAlpha; };
+    struct SetBlendColorCommand { static const CommandType Type = CommandType::SetBlendColor; GLfloat color[4]; };
+    struct SetStencilFunctionCommand { static const CommandType Type = CommandType::SetStencilFunction; GLenum face; GLenum function; GLint refValue; GLuint mask; };
+    struct SetStencilOperationsCommand { static const CommandType Type = CommandType::SetStencilOperations; GLenum face; GLenum stencilFail; GLenum depthFail; GLenum depthPass; };
+    struct SetScissorCommand { static const CommandType Type = CommandType::SetScissor; GLint x; GLint y; GLsizei width; GLsizei height; };
+    struct UseProgramCommand { static const CommandType Type = CommandType::UseProgram; GLuint handle; };
+    // Followed by count * columns * components values of type in the payload. columns is 1 for scalars and vectors
+    struct SetUniformsCommand { static const CommandType Type = CommandType::SetUniforms; GLint location; Data::Type type; GLubyte components; GLubyte columns; GLsizei count; };
+    struct BindUniformBlockCommand { static const CommandType Type = CommandType::BindUniformBlock; GLuint bindingIndex; GLuint bufferHandle; GLintptr offset; GLsizeiptr size; };
+    struct BindVertexArrayCommand { static const CommandType Type = CommandType::BindVertexArray; GLuint handle; };
+    struct BindTextureCommand { static const CommandType Type = CommandType::BindTexture; GLint textureUnit; GLenum target; GLuint handle; };
+    // instanceCount is 0 for draws without instancing
+    struct DrawArraysCommand { static const CommandType Type = CommandType::DrawArrays; GLenum primitive; GLint first; GLsizei count; GLsizei instanceCount; };
+    struct DrawElementsCommand { static const CommandType Type = CommandType::DrawElements; GLenum primitive; GLsizei count; GLenum eboType; GLint first; GLint baseVertex; GLsizei instanceCount; };
+    // index of the function in the buffer, see GetFunction
+    struct CallFunctionCommand { static const CommandType Type = CommandType::CallFunction; std::uint32_t index; };
+
+    using Function = std::function<void()>;
+
+    // Iterates over the recorded commands
+    class ConstIterator
+    {
+    public:
+        ConstIterator(const std::byte* position) : m_position(position) {}
+
+        const CommandHeader& GetHeader() const { return *reinterpret_cast<const CommandHeader*>(m_position); }
+        CommandType GetType() const { return GetHeader().type; }
+
+        // Get the command, T must match the type in the header
+        template<typename T>
+        const T& Get() const;
+
+        // Get the bytes stored after the command
+        template<typename T>
+        std::span<const std::byte> GetPayload() const;
+
+        ConstIterator& operator++() { m_position += GetHeader().size; return *this; }
+        bool operator==(const ConstIterator& other) const { return m_position == other.m_position; }
+        bool operator!=(const ConstIterator& other) const { return m_position != other.m_position; }
+        const ConstIterator& operator*() const { return *this; }
+
+    private:
+        const std::byte* m_position;
+    };
+
+    // Texture units with record time deduplication
+    static const int DedupTextureUnits = 32;
+
+public:
+    CommandBuffer();
+
+    // Remove all the commands and forget the recorded state. Keeps the memory allocated
+    void Clear();
+
+    // Number of recorded commands
+    unsigned int GetCommandCount() const { return m_commandCount; }
+
+    // Number of commands that were not recorded because they set the state that was already recorded
+    unsigned int GetSkippedCount() const { return m_skippedCount; }
+
+    // Size of the recorded commands in bytes
+    std::size_t GetSize() const { return m_data.size(); }
+
+    // Functions recorded with CallFunction
+    unsigned int GetFunctionCount() const { return static_cast<unsigned int>(m_functions.size()); }
+    const Function& GetFunction(std::uint32_t index) const { return m_functions[index]; }
+
+    ConstIterator begin() const { return ConstIterator(m_data.data()); }
+    ConstIterator end() const { return ConstIterator(m_data.data() + m_data.size()); }
+
+    // Record the commands. Those that change state are skipped if the state is the same as the last recorded one
+    void SetFeatureEnabled(GLenum feature, bool enabled);
+    void SetDepthFunction(GLenum function);
+    void SetDepthMask(bool enabled);
+    void SetBlendEquation(GLenum colorEquation, GLenum alphaEquation);
+    void SetBlendFunction(GLenum sourceColor, GLenum destColor, GLenum sourceAlpha, GLenum destAlpha);
+    void SetBlendColor(const Color& color);
+    void SetStencilFunction(GLenum face, GLenum function, GLint refValue, GLuint mask);
+    void SetStencilOperations(GLenum face, GLenum stencilFail, GLenum depthFail, GLenum depthPass);
+    void SetScissor(GLint x, GLint y, GLsizei width, GLsizei height);
+    void UseProgram(GLuint handle);
+    void BindUniformBlock(GLuint bindingIndex, GLuint bufferHandle, GLintptr offset, GLsizeiptr size);
+    void BindVertexArray(GLuint handle);
+    void BindTexture(GLint textureUnit, GLenum target, GLuint handle);
+    void DrawArrays(GLenum primitive, GLint first, GLsizei count, GLsizei instanceCount = 0);
+    void DrawElements(GLenum primitive, GLsizei count, GLenum eboType, GLint first, GLint baseVertex = 0, GLsizei instanceCount = 0);
+
+    // Call the function when the commands are executed against GL. It is kept in the buffer until Clear
+    void CallFunction(Function function);
+
+    // Uniforms are always recorded, they are part of the program state
+    void SetUniforms(GLint location, Data::Type type, int components, int columns, GLsizei count, std::span<const std::byte> values);
+    template<typename T>
+    void SetUniform(GLint location, const T& value);
+    template<typename T, int N>
+    void SetUniform(GLint location, const glm::vec<N, T>& value);
+    template<typename T, int C, int R>
+    void SetUniform(GLint location, const glm::mat<C, R, T>& value);
+
+    // Name of each command, for debugging
+    static const char* GetCommandName(CommandType type);
+
+private:
+    // Add a command with its payload to the buffer
+    template<typename T>
+    void AddCommand(const T& command, std::span<const std::byte> payload = {});
+
+    // Keep commands aligned, so they can be read in place
+    static const std::size_t CommandAlignment = alignof(std::max_align_t) < 8 ? alignof(std::max_align_t) : 8;
+    static std::size_t AlignSize(std::size_t size) { return (size + CommandAlignment - 1) & ~(CommandAlignment - 1); }
+
+private:
+    std::vector<std::byte> m_data;
+    std::vector<Function> m_functions;
+
+    unsigned int m_commandCount;
+    unsigned int m_skippedCount;
+
+    // Last recorded state, to skip redundant commands. UnknownValue until recorded
+    static const GLuint UnknownValue = ~0u;
+    std::unordered_map<GLenum, bool> m_features;
+    GLenum m_depthFunction;
+    GLuint m_depthMask;
+    SetBlendEquationCommand m_blendEquation;
+    SetBlendFunctionCommand m_blendFunction;
+    SetScissorCommand m_scissor;
+    GLuint m_program;
+    GLuint m_vertexArray;
+    std::array<std::pair<GLenum, GLuint>, DedupTextureUnits> m_textures;
+};
+
+template<typename T>
+const T& CommandBuffer::ConstIterator::Get() const
+{
+    assert(GetType() == T::Type);
+    return *reinterpret_cast<const T*>(m_position + AlignSize(sizeof(CommandHeader)));
+}
+
+template<typename T>
+std::span<const std::byte> CommandBuffer::ConstIterator::GetPayload() const
+{
+    assert(GetType() == T::Type);
+    std::size_t offset = AlignSize(AlignSize(sizeof(CommandHeader)) + sizeof(T));
+    return std::span<const std::byte>(m_position + offset, GetHeader().size - offset);
+}
+
+template<typename T>
+void CommandBuffer::AddCommand(const T& command, std::span<const std::byte> payload)
+{
+    std::size_t commandOffset = AlignSize(sizeof(CommandHeader));
+    std::size_t payloadOffset = AlignSize(commandOffset + sizeof(T));
+    std::size_t size = AlignSize(payloadOffset + payload.size());
+
+    std::size_t position = m_data.size();
+    m_data.resize(position + size);
+    std::byte* data = m_data.data() + position;
+
+    CommandHeader header = { T::Type, 0, static_cast<std::uint32_t>(size) };
+    std::memcpy(data, &header, sizeof(header));
+    std::memcpy(data + commandOffset, &command, sizeof(T));
+    if (!payload.empty())
+    {
+        std::memcpy(data + payloadOffset, payload.data(), payload.size());
+    }
+    m_commandCount++;
+}
+
+template<typename T>
+void CommandBuffer::SetUniform(GLint location, const T& value)
+{
+    SetUniforms(location, Data::GetType<T>(), 1, 1, 1, Data::GetBytes(value));
+}
+
+template<typename T, int N>
+void CommandBuffer::SetUniform(GLint location, const glm::vec<N, T>& value)
+{
+    SetUniforms(location, Data::GetType<T>(), N, 1, 1, Data::GetBytes(value));
+}
+
+template<typename T, int C, int R>
+void CommandBuffer::SetUniform(GLint location, const glm::mat<C, R, T>& value)
+{
+    SetUniforms(location, Data::GetType<T>(), R, C, 1, Data::GetBytes(value));
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+class CommandBuffer;
+
+// Replays the commands recorded in a CommandBuffer
+class CommandExecutor
+{
+public:
+    virtual ~CommandExecutor();
+
+    // Execute all the commands in the buffer, in order
+    virtual void Execute(const CommandBuffer& commandBuffer) = 0;
+};
@@ -2,23 +2,48 @@
 
 #include <ituGL/renderer/RenderPass.h>
 
+#include <ituGL/renderer/LightScreenProjector.h>
 #include <ituGL/shader/ShaderProgram.h>
 #include <ituGL/geometry/Mesh.h>
+#include <glm/mat4x4.hpp>
 #include <memory>
 
 class Texture2DObject;
 class Material;
+class Light;
 
+// Lighting pass of deferred shading. The ambient pass and the lights without a range (directional) cover the whole
+// screen. Point and spot lights draw a sphere or a cone scaled to their range, so they only shade the pixels they reach
+// If depthStencilSource is set (usually the g-buffer framebuffer, with a depth-stencil attachment), its depth is copied to
+// the target, and each volume is first marked in the stencil: a pixel is shaded only if its surface is inside the volume
+// Without it, only the back faces of the volume are drawn, with a depth test against the depth in the target, if any
+// Each light is also limited to its rectangle of the screen with the scissor test, and skipped if it can't reach any pixel
 class DeferredRenderPass: public RenderPass
 {
 public:
-    DeferredRenderPass(std::shared_ptr<Material> material, std::shared_ptr<const FramebufferObject> targetFramebuffer = nullptr);
+    DeferredRenderPass(std::shared_ptr<Material> material, std::shared_ptr<const FramebufferObject> targetFramebuffer = nullptr,
+        std::shared_ptr<const FramebufferObject> depthStencilSource = nullptr);
 
     void Render() override;
 
 private:
     void InitializeMeshes();
 
+    // Select the light volume and its world matrix. Returns false if the light needs the fullscreen pass
+    bool GetLightVolume(const Light& light, const Mesh*& mesh, glm::mat4& worldMatrix) const;
+
+    // Draw the volume, setting the states for stencil marking, if enabled, and for the lighting of the back faces
+    void DrawLightVolume(const Mesh& mesh, bool useStencil);
+
 private:
     std::shared_ptr<Material> m_material;
+
+    std::shared_ptr<const FramebufferObject> m_depthStencilSource;
+
+    LightScreenProjector m_lightScreenProjector;
+
+    // Unit sphere and cone, with their faces outside of the shape so they fully contain it
+    // The cone has its apex in the origin, and its base of radius 1 at Z = 1
+    Mesh m_sphereMesh;
+    Mesh m_coneMesh;
 };
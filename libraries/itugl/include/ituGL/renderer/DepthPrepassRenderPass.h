@@ -0,0 +1,73 @@
+#pragma once
+
+#include <ituGL/renderer/RenderPass.h>
+
+#include <ituGL/renderer/Renderer.h>
+#include <ituGL/shader/ShaderProgram.h>
+#include <vector>
+#include <memory>
+
+class Material;
+
+// Fills the depth buffer with the opaque drawcalls, front to back and without color writes, before the forward pass
+// The forward pass then draws them with the depth test set to GetDepthFunction and no depth writes, so only the visible
+// fragments are shaded. See ForwardRenderPass::SetDepthPrepass
+// Drawcalls use the shared depth material, with the uniforms WorldMatrix and ViewProjMatrix, and the position in location 0.
+// Its vertex shader must compute the position the same way as the forward shaders, so GL_EQUAL matches the same depth:
+//   gl_Position = ViewProjMatrix * vec4((WorldMatrix * vec4(VertexPosition, 1.0)).xyz, 1.0);
+// Drawcalls whose vertex shader moves the vertices are drawn with their own material instead, see SetOwnMaterialFunction
+// The depth of the target is cleared first, so the forward pass must not clear it again
+class DepthPrepassRenderPass : public RenderPass
+{
+public:
+    // Without depthMaterial, all the drawcalls are drawn with their own material
+    DepthPrepassRenderPass(std::shared_ptr<Material> depthMaterial, int drawcallCollectionIndex = 0,
+        std::shared_ptr<const FramebufferObject> targetFramebuffer = nullptr);
+
+    void Render() override;
+
+    // When disabled, the pass draws nothing and the forward pass uses the depth test of the materials
+    inline bool IsEnabled() const { return m_enabled; }
+    inline void SetEnabled(bool enabled) { m_enabled = enabled; }
+
+    // Depth test of the included drawcalls in the forward pass. GL_EQUAL by default, GL_LEQUAL tolerates vertex shaders
+    // that don't compute exactly the same position
+    inline GLenum GetDepthFunction() const { return m_depthFunction; }
+    inline void SetDepthFunction(GLenum depthFunction) { m_depthFunction = depthFunction; }
+
+    // Drawcalls that need their own material to get the right depth
+    void SetOwnMaterialFunction(const Renderer::DrawcallSupportedFunction& ownMaterialFunction);
+
+    // True if the drawcall is drawn by this pass: opaque and writing depth
+    bool IsIncluded(const Renderer::DrawcallInfo& drawcallInfo) const;
+
+    // Drawcalls drawn in the last frame with the shared material and with their own
+    inline unsigned int GetSharedDrawcallCount() const { return m_sharedDrawcallCount; }
+    inline unsigned int GetOwnMaterialDrawcallCount() const { return m_ownMaterialDrawcallCount; }
+
+private:
+    bool UsesOwnMaterial(const Renderer::DrawcallInfo& drawcallInfo) const;
+
+private:
+    std::shared_ptr<Material> m_depthMaterial;
+    ShaderProgram::Location m_worldMatrixLocation;
+    ShaderProgram::Location m_viewProjMatrixLocation;
+
+    int m_drawcallCollectionIndex;
+
+    bool m_enabled;
+    GLenum m_depthFunction;
+
+    Renderer::DrawcallSupportedFunction m_ownMaterialFunction;
+
+    // Included drawcalls of the frame with their view depth, to sort them front to back
+    struct SortedDrawcall
+    {
+        float depth;
+        const Renderer::DrawcallInfo* drawcallInfo;
+    };
+    std::vector<SortedDrawcall> m_sortedDrawcalls;
+
+    unsigned int m_sharedDrawcallCount;
+    unsigned int m_ownMaterialDrawcallCount;
+};
@@ -1,15 +1,98 @@
 #pragma once
 
 #include <ituGL/renderer/RenderPass.h>
+#include <ituGL/renderer/LightClusterGrid.h>
+#include <ituGL/renderer/LightScreenProjector.h>
+#include <ituGL/renderer/CommandBuffer.h>
+#include <ituGL/core/QueryObject.h>
+#include <unordered_map>
+#include <array>
+#include <vector>
+#include <memory>
 
+class ShaderProgram;
+class DepthPrepassRenderPass;
+
+// Draws the drawcalls with their lighting. Shader programs that declare the light cluster samplers (see
+// LightClusterGrid) are drawn once, with all the lights. The others are drawn once per light, adding the results
+// Each additional light is limited to its rectangle of the screen with the scissor test, and skipped if it can't reach any pixel
+// With an enabled depth prepass, the drawcalls it includes are drawn with its depth test and without writing depth
+// The drawcalls are recorded into a command buffer and then executed. The recorded light passes assume that the update
+// lights function of the program draws once per light and at least once, like Renderer::GetDefaultUpdateLightsFunction
 class ForwardRenderPass : public RenderPass
 {
+public:
+    // Samples shaded by the pass, counted with occlusion queries. The results are a few frames old
+    struct OverdrawStats
+    {
+        // Samples that passed the depth test, adding all the light passes
+        GLuint64 samples = 0;
+        // Samples per pixel of the viewport. 1 means that each pixel was shaded once
+        float samplesPerPixel = 0.0f;
+    };
+
 public:
     ForwardRenderPass();
     ForwardRenderPass(int drawcallCollectionIndex);
 
     void Render() override;
 
+    // Grid with the light lists, built only in the frames that draw programs that use it
+    LightClusterGrid& GetLightClusterGrid() { return m_lightClusterGrid; }
+    const LightClusterGrid& GetLightClusterGrid() const { return m_lightClusterGrid; }
+
+    // First of the 3 texture units used by the light lists. Materials use the units from 0
+    static const int LightClusterTextureUnit = 13;
+
+    // Depth prepass drawn before this pass, in the same framebuffer. nullptr to use the depth test of the materials
+    inline const DepthPrepassRenderPass* GetDepthPrepass() const { return m_depthPrepass; }
+    inline void SetDepthPrepass(const DepthPrepassRenderPass* depthPrepass) { m_depthPrepass = depthPrepass; }
+    bool IsDepthPrepassEnabled() const;
+
+    // Last overdraw measured
+    inline const OverdrawStats& GetOverdrawStats() const { return m_overdrawStats; }
+
+    // Commands recorded in the last frame
+    inline const CommandBuffer& GetCommandBuffer() const { return m_commandBuffer; }
+
+protected:
+    // Get the locations of the cluster uniforms, queried the first time the program is found
+    const LightClusterGrid::Locations& GetLightClusterLocations(std::shared_ptr<const ShaderProgram> shaderProgram);
+
+    // Build the light clusters and the screen bounds of the lights, if the programs of the drawcalls need them. Calls GL
+    void PrepareLights(GLint x, GLint y, GLsizei width, GLsizei height);
+
+    // Record the drawcalls with their lighting, after PrepareLights
+    void Record(CommandBuffer& commandBuffer);
+
+    // Read the finished overdraw queries, and start the one for this frame
+    void BeginOverdrawQuery(GLsizei pixelCount);
+    void EndOverdrawQuery();
+
 protected:
     int m_drawcallCollectionIndex;
+
+    LightClusterGrid m_lightClusterGrid;
+    std::unordered_map<std::shared_ptr<const ShaderProgram>, LightClusterGrid::Locations> m_lightClusterLocations;
+
+    // Screen bounds of each light, computed once per frame when the first program needs one pass per light
+    LightScreenProjector m_lightScreenProjector;
+    std::vector<LightScreenProjector::ScreenBounds> m_lightScreenBounds;
+
+    const DepthPrepassRenderPass* m_depthPrepass;
+
+    // Reused every frame, so it keeps its memory
+    CommandBuffer m_commandBuffer;
+
+    // Ring of queries, so the results can be read without waiting for the GL
+    static const unsigned int OverdrawQueryCount = 3;
+    struct OverdrawQuery
+    {
+        QueryObject query;
+        GLsizei pixelCount = 0;
+        bool pending = false;
+    };
+    std::array<OverdrawQuery, OverdrawQueryCount> m_overdrawQueries;
+    unsigned int m_overdrawQueryIndex;
+    OverdrawStats m_overdrawStats;
 };
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <ituGL/renderer/RenderPass.h>
+#include <ituGL/renderer/CommandBuffer.h>
 
 class Texture2DObject;
 
@@ -16,6 +17,9 @@ public:
     const std::shared_ptr<Texture2DObject> GetNormalTexture() const { return m_normalTexture; }
     const std::shared_ptr<Texture2DObject> GetOthersTexture() const { return m_othersTexture; }
 
+    // Commands recorded in the last frame
+    const CommandBuffer& GetCommandBuffer() const { return m_commandBuffer; }
+
 private:
     void InitTextures(int width, int height);
     void InitFramebuffer();
@@ -27,4 +31,7 @@ private:
     std::shared_ptr<Texture2DObject> m_albedoTexture;
     std::shared_ptr<Texture2DObject> m_normalTexture;
     std::shared_ptr<Texture2DObject> m_othersTexture;
+
+    // Reused every frame, so it keeps its memory
+    CommandBuffer m_commandBuffer;
 };
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <ituGL/renderer/CommandExecutor.h>
+#include <ituGL/renderer/CommandBuffer.h>
+
+class DeviceGL;
+
+// Executes the commands against the current GL context
+// State changes go through the device, so they are skipped if GL already has that state
+class GLCommandExecutor : public CommandExecutor
+{
+public:
+    GLCommandExecutor(DeviceGL& device);
+
+    void Execute(const CommandBuffer& commandBuffer) override;
+
+private:
+    // Set the uniforms of the program in use
+    static void SetUniforms(const CommandBuffer::SetUniformsCommand& command, std::span<const std::byte> payload);
+
+private:
+    DeviceGL& m_device;
+};
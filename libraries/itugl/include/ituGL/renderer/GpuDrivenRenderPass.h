@@ -0,0 +1,131 @@
+#pragma once
+
+#include <ituGL/renderer/RenderPass.h>
+
+#include <ituGL/renderer/Renderer.h>
+#include <ituGL/shader/ShaderProgram.h>
+#include <ituGL/shader/ShaderStorageBufferObject.h>
+#include <ituGL/geometry/DrawIndirectBufferObject.h>
+#include <ituGL/geometry/VertexBufferObject.h>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+#include <vector>
+#include <memory>
+
+class Material;
+class VertexArrayObject;
+class Drawcall;
+
+// Draws the models added with Renderer::AddGpuCulledModel, culled by a compute shader instead of the CPU
+// All the submeshes sharing material, VAO and drawcall form a group with one indirect command. The compute shader tests
+// the bounds of each object against the frustum and the depth hierarchy of the occlusion culler, if the renderer has one,
+// and appends the world matrix of the visible ones to the instances of their group. Groups sharing material and VAO are
+// then submitted with a single glMultiDrawElementsIndirect, so the CPU cost no longer depends on the number of objects
+// The materials get the world matrices in the InstanceWorldMatrix attribute, see Renderer::InstanceWorldMatrixName.
+// Drawcalls of programs without it are culled on the CPU and drawn one by one
+// Culling program interface (std430 storage blocks and uniforms):
+//   binding 0: Objects { vec4 center; vec4 extents; mat4 worldMatrix; uvec4 info; }, info.x is the group, info.y its first instance
+//   binding 1: Commands, the indirect commands as uints. The shader increments instanceCount, the second of 5
+//   binding 2: InstanceMatrices, mat4 per instance
+//   binding 3: HiZDepth, all the levels of the depth hierarchy as floats
+//   uniforms: ObjectCount, FrustumPlanes[6], HiZViewProjMatrix, HiZSize, HiZLevels[16] (width, height, offset), HiZLevelCount
+// Requires GL 4.3, see IsSupported. Drawcalls are drawn once, without lights, like in GBufferRenderPass
+class GpuDrivenRenderPass : public RenderPass
+{
+public:
+    struct Stats
+    {
+        // Objects sent to the compute shader, groups and multi-draw calls used to draw them
+        unsigned int objects = 0;
+        unsigned int groups = 0;
+        unsigned int multiDraws = 0;
+        // Drawcalls of programs without instancing, culled and drawn on the CPU
+        unsigned int fallbackDrawcalls = 0;
+    };
+
+    static const GLuint ObjectsBinding = 0;
+    static const GLuint CommandsBinding = 1;
+    static const GLuint InstanceMatricesBinding = 2;
+    static const GLuint HiZDepthBinding = 3;
+
+    static const int MaxHiZLevels = 16;
+    static const unsigned int WorkGroupSize = 64;
+
+public:
+    GpuDrivenRenderPass(std::shared_ptr<ShaderProgram> cullingProgram, std::shared_ptr<const FramebufferObject> targetFramebuffer = nullptr);
+
+    // Check if the context supports compute shaders and multi-draw indirect
+    static bool IsSupported();
+
+    void Render() override;
+
+    // Test the depth hierarchy of the occlusion culler, if the renderer has one. Enabled by default
+    inline bool GetHiZEnabled() const { return m_hiZEnabled; }
+    inline void SetHiZEnabled(bool enabled) { m_hiZEnabled = enabled; }
+
+    // Statistics of the last frame
+    inline const Stats& GetStats() const { return m_stats; }
+
+private:
+    // Submesh of a model, instance of a group
+    struct Item
+    {
+        const Material* material;
+        const VertexArrayObject* vao;
+        const Drawcall* drawcall;
+        unsigned int modelIndex;
+    };
+
+    // Same layout as the Objects block in the culling program
+    struct ObjectData
+    {
+        glm::vec4 center;
+        glm::vec4 extents;
+        glm::mat4 worldMatrix;
+        glm::uvec4 info;
+    };
+
+    // Consecutive groups drawn with one multi-draw call
+    struct Batch
+    {
+        unsigned int firstGroup;
+        unsigned int groupCount;
+        Renderer::DrawcallInfo drawcallInfo;
+    };
+
+    // Sort the submeshes into groups and batches, and fill the buffers of the compute shader
+    void BuildGroups(std::span<const Renderer::GpuCulledModel> models);
+
+    void UploadBuffers();
+    void Cull();
+    void DrawBatches();
+
+    // Drawcalls that can't be instanced, culled one by one on the CPU
+    void DrawFallback(std::span<const Renderer::GpuCulledModel> models);
+
+private:
+    std::shared_ptr<ShaderProgram> m_cullingProgram;
+    ShaderProgram::Location m_objectCountLocation;
+    ShaderProgram::Location m_frustumPlanesLocation;
+    ShaderProgram::Location m_hiZViewProjMatrixLocation;
+    ShaderProgram::Location m_hiZSizeLocation;
+    ShaderProgram::Location m_hiZLevelsLocation;
+    ShaderProgram::Location m_hiZLevelCountLocation;
+
+    bool m_hiZEnabled;
+
+    // Frame data, kept to reuse the allocations
+    std::vector<Item> m_items;
+    std::vector<Item> m_fallbackItems;
+    std::vector<ObjectData> m_objects;
+    std::vector<DrawIndirectBufferObject::Command> m_commands;
+    std::vector<Batch> m_batches;
+    std::vector<float> m_hiZDepth;
+
+    ShaderStorageBufferObject m_objectBuffer;
+    DrawIndirectBufferObject m_commandBuffer;
+    VertexBufferObject m_instanceBuffer;
+    ShaderStorageBufferObject m_hiZBuffer;
+
+    Stats m_stats;
+};
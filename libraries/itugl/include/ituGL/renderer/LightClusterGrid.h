@@ -0,0 +1,168 @@
+#pragma once
+
+#include <ituGL/core/WorkerPool.h>
+#include <ituGL/texture/TextureBufferObject.h>
+#include <ituGL/shader/ShaderProgram.h>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+#include <vector>
+#include <span>
+
+class Camera;
+class Light;
+class CommandBuffer;
+
+// Froxel grid for clustered forward shading: the view frustum is split in tiles on screen, and in slices along the
+// view depth, with exponential spacing. Each cluster stores the list of lights whose volume overlaps it, so a fragment
+// only evaluates the lights of its cluster, in a single pass
+// The lists are built on the CPU, splitting the depth slices between worker threads, and uploaded as texture buffers:
+// - LightData (samplerBuffer, RGBA32F): 4 texels per light. Position, direction, color * intensity and attenuation
+// - LightClusters (usamplerBuffer, RG32UI): 1 texel per cluster. Offset and count in LightIndices
+// - LightIndices (usamplerBuffer, R32UI): light indices of all the clusters, one after the other
+// Lights without a range (directional, or with no distance attenuation) are global: they are stored first in LightData,
+// and they are not added to the clusters
+class LightClusterGrid
+{
+public:
+    // Names of the samplers and uniforms that the shader programs declare to use the grid
+    static constexpr const char* LightDataName = "LightData";
+    static constexpr const char* LightClustersName = "LightClusters";
+    static constexpr const char* LightIndicesName = "LightIndices";
+    // uvec3 with the number of clusters in X, Y and Z
+    static constexpr const char* GridSizeName = "ClusterGridSize";
+    // vec4 with the size of a tile in pixels (xy), and the scale and bias that give the slice from log(view depth) (zw)
+    static constexpr const char* GridParamsName = "ClusterGridParams";
+    // vec4 plane that gives the view depth from a world position: depth = dot(plane, vec4(position, 1))
+    static constexpr const char* DepthPlaneName = "ClusterDepthPlane";
+    // uint with the number of global lights at the start of LightData
+    static constexpr const char* GlobalLightCountName = "ClusterGlobalLightCount";
+
+    // Uniform locations of a shader program that uses the grid
+    struct Locations
+    {
+        ShaderProgram::Location lightData = -1;
+        ShaderProgram::Location lightClusters = -1;
+        ShaderProgram::Location lightIndices = -1;
+        ShaderProgram::Location gridSize = -1;
+        ShaderProgram::Location gridParams = -1;
+        ShaderProgram::Location depthPlane = -1;
+        ShaderProgram::Location globalLightCount = -1;
+
+        // True if the program reads the light lists
+        inline bool IsValid() const { return lightClusters >= 0; }
+    };
+
+public:
+    LightClusterGrid(unsigned int tilesX = 16, unsigned int tilesY = 9, unsigned int slices = 24);
+
+    inline glm::uvec3 GetGridSize() const { return glm::uvec3(m_tilesX, m_tilesY, m_slices); }
+    inline unsigned int GetClusterCount() const { return m_tilesX * m_tilesY * m_slices; }
+
+    // Number of threads used to assign the lights. 0 uses one per hardware thread
+    inline unsigned int GetThreadCount() const { return m_threadCount; }
+    inline void SetThreadCount(unsigned int threadCount) { m_threadCount = threadCount; }
+
+    // Assign the lights to the clusters of the camera frustum, and upload the lists. width and height are the
+    // dimensions of the viewport, in pixels
+    void Build(const Camera& camera, int width, int height, std::span<const Light* const> lights);
+
+    // The CPU part of Build: assign the lights to the clusters, without uploading the lists
+    void BuildLists(const Camera& camera, int width, int height, std::span<const Light* const> lights);
+
+    // Get the locations of the grid uniforms in the program
+    static Locations GetLocations(const ShaderProgram& shaderProgram);
+
+    // Set the grid uniforms, and bind the texture buffers to 3 consecutive texture units starting at firstTextureUnit
+    void Use(const ShaderProgram& shaderProgram, const Locations& locations, int firstTextureUnit) const;
+    void Record(CommandBuffer& commandBuffer, const Locations& locations, int firstTextureUnit) const;
+
+    // Statistics of the last Build
+    inline unsigned int GetLightCount() const { return m_lightCount; }
+    inline unsigned int GetGlobalLightCount() const { return m_globalLightCount; }
+    inline unsigned int GetIndexCount() const { return static_cast<unsigned int>(m_lightIndices.size()); }
+    inline unsigned int GetMaxClusterLightCount() const { return m_maxClusterLightCount; }
+
+    // Lights of a cluster in the last Build, as indices in LightData. The global lights are not in the lists
+    std::span<const unsigned int> GetClusterLights(const glm::uvec3& cluster) const;
+
+private:
+    // View space AABB of a cluster
+    struct ClusterBounds
+    {
+        glm::vec3 min;
+        glm::vec3 max;
+    };
+
+    // Light with a range, in view space, and the clusters that its bounding box touches
+    struct LocalLight
+    {
+        unsigned int index;
+        glm::vec3 center;
+        float radius;
+        glm::uvec3 clusterMin;
+        glm::uvec3 clusterMax;
+    };
+
+    // Light lists of a range of slices, filled by one thread
+    struct SliceRangeLists
+    {
+        unsigned int firstSlice = 0;
+        unsigned int lastSlice = 0;
+        // Offset (relative to this range) and count per cluster
+        std::vector<glm::uvec2> clusters;
+        std::vector<unsigned int> indices;
+        // (cluster, light) pairs found, before sorting by cluster
+        std::vector<glm::uvec2> pairs;
+    };
+
+    // Recompute the cluster bounds if the projection or the viewport changed
+    void UpdateClusterBounds(const glm::mat4& projMatrix, int width, int height);
+
+    // View depth of the start of the slice
+    float GetSliceDepth(unsigned int slice) const;
+
+    // Find the clusters touched by the bounding box of the light
+    bool ComputeClusterRange(LocalLight& localLight) const;
+
+    // Test the lights against the clusters in the range of slices, and build their lists
+    void AssignLights(SliceRangeLists& lists) const;
+
+private:
+    unsigned int m_tilesX;
+    unsigned int m_tilesY;
+    unsigned int m_slices;
+
+    unsigned int m_threadCount;
+    WorkerPool m_workerPool;
+
+    // Projection and viewport the bounds were computed for
+    glm::mat4 m_projMatrix;
+    int m_width;
+    int m_height;
+
+    // Depth range of the frustum, and the factors to get the slice from the log of the depth
+    float m_nearDepth;
+    float m_farDepth;
+    float m_sliceScale;
+    float m_sliceBias;
+
+    std::vector<ClusterBounds> m_clusterBounds;
+
+    // Per-frame data, kept to reuse the memory
+    std::vector<LocalLight> m_localLights;
+    std::vector<SliceRangeLists> m_sliceRangeLists;
+    std::vector<glm::vec4> m_lightData;
+    std::vector<glm::uvec2> m_clusters;
+    std::vector<unsigned int> m_lightIndices;
+
+    glm::vec4 m_depthPlane;
+    unsigned int m_lightCount;
+    unsigned int m_globalLightCount;
+    unsigned int m_maxClusterLightCount;
+
+    TextureBufferObject m_lightDataTexture;
+    TextureBufferObject m_clustersTexture;
+    TextureBufferObject m_lightIndicesTexture;
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/mat4x4.hpp>
+#include <array>
+
+class Camera;
+class Light;
+class DeviceGL;
+class CommandBuffer;
+
+// Projects the range of the lights through the camera, to get the rectangle of the screen and the range of view depth
+// that they can reach. The lighting passes use them to limit the pixels shaded per light with the scissor test, and to
+// skip the lights that can't reach any pixel
+// Point lights use the sphere of their range. Spot lights use the sphere around their cone, and the depth range of the cone
+class LightScreenProjector
+{
+public:
+    // Rectangle in pixels, as used by glScissor, and range of view depth. Empty if the light is not visible
+    struct ScreenBounds
+    {
+        GLint x = 0;
+        GLint y = 0;
+        GLsizei width = 0;
+        GLsizei height = 0;
+        float nearDepth = 0.0f;
+        float farDepth = 0.0f;
+
+        inline bool IsEmpty() const { return width <= 0 || height <= 0; }
+    };
+
+public:
+    LightScreenProjector();
+
+    // Set the camera and the viewport used for the next lights
+    void SetCamera(const Camera& camera, GLint x, GLint y, GLsizei width, GLsizei height);
+
+    // Get the bounds of the light. Lights without a range get the whole viewport
+    ScreenBounds GetScreenBounds(const Light& light) const;
+
+    // Smallest bounds that contain both, for passes that draw several lights
+    static ScreenBounds GetUnion(const ScreenBounds& a, const ScreenBounds& b);
+
+    // True if the bounds cover the whole viewport, and the scissor test is not needed
+    bool IsFullViewport(const ScreenBounds& bounds) const;
+
+    // Enable the scissor test with the rectangle of the bounds, or disable it if they cover the viewport
+    void SetScissor(DeviceGL& device, const ScreenBounds& bounds) const;
+    void RecordScissor(CommandBuffer& commandBuffer, const ScreenBounds& bounds) const;
+
+private:
+    // Bounds of a sphere in view space, with its view depth range limited to [minDepth, maxDepth]
+    ScreenBounds GetSphereScreenBounds(const glm::vec3& center, float radius, float minDepth, float maxDepth) const;
+
+    // Range in NDC, along one axis, of a sphere with center (c.x, c.y) in the plane of that axis and view Z
+    glm::vec2 GetSphereAxisRange(glm::vec2 c, float radius, float scale, float offset) const;
+
+    // Bounds covering the whole viewport, with the depth range of the camera
+    ScreenBounds GetViewportScreenBounds() const;
+
+private:
+    glm::mat4 m_viewMatrix;
+    glm::mat4 m_projMatrix;
+
+    bool m_perspective;
+
+    // View depth of the near and far planes
+    float m_nearDepth;
+    float m_farDepth;
+
+    // Viewport x, y, width and height
+    std::array<GLint, 4> m_viewport;
+};
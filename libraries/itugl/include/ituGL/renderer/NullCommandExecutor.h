@@ -0,0 +1,53 @@
+#pragma once
+
+#include <ituGL/renderer/CommandExecutor.h>
+#include <ituGL/renderer/CommandBuffer.h>
+#include <array>
+
+// Executes the commands without GL: counts them and checks that they are valid
+// Used to test and profile the renderer on machines with no GPU. Recorded functions are counted, but not called
+class NullCommandExecutor : public CommandExecutor
+{
+public:
+    NullCommandExecutor(int maxTextureUnits = CommandBuffer::DedupTextureUnits);
+
+    void Execute(const CommandBuffer& commandBuffer) override;
+
+    // Reset the counters and the simulated state
+    void Reset();
+
+    // Number of commands executed of each type
+    unsigned int GetCommandCount(CommandBuffer::CommandType type) const { return m_commandCounts[static_cast<int>(type)]; }
+
+    // Number of commands executed
+    unsigned int GetCommandCount() const { return m_commandCount; }
+
+    // Number of draw commands, and number of vertices or elements drawn, adding all the instances
+    unsigned int GetDrawCount() const { return m_drawCount; }
+    unsigned int GetVertexCount() const { return m_vertexCount; }
+
+    // Number of commands that failed validation, and the description of the last failure
+    unsigned int GetInvalidCount() const { return m_invalidCount; }
+    const char* GetLastError() const { return m_lastError; }
+
+private:
+    // Check a command against the simulated state. Returns false and stores the error if it is not valid
+    bool Validate(const CommandBuffer& commandBuffer, const CommandBuffer::ConstIterator& command);
+
+    // Record a validation error
+    bool Fail(const char* error);
+
+private:
+    int m_maxTextureUnits;
+
+    std::array<unsigned int, static_cast<int>(CommandBuffer::CommandType::Count)> m_commandCounts;
+    unsigned int m_commandCount;
+    unsigned int m_drawCount;
+    unsigned int m_vertexCount;
+    unsigned int m_invalidCount;
+    const char* m_lastError;
+
+    // Simulated bindings
+    GLuint m_program;
+    GLuint m_vertexArray;
+};
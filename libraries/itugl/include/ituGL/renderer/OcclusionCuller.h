@@ -0,0 +1,140 @@
+#pragma once
+
+#include <ituGL/core/WorkerPool.h>
+#include <ituGL/scene/Bounds.h>
+#include <glm/vec2.hpp>
+#include <glm/ext/vector_int2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/mat4x4.hpp>
+#include <vector>
+#include <span>
+
+// Software occlusion culling: a few big occluders are rasterized on the CPU to a small depth buffer, and the bounds of the
+// objects are tested against it before their drawcalls are created
+// The depth buffer is split in bands of rows, rasterized by the threads of a WorkerPool, 4 pixels at a time with SSE when available.
+// Then a hierarchy keeps the farthest depth of each 2x2 block, so each test only reads a few texels
+// Occluders should be inside the surfaces they stand for, for example a simplified mesh with the vertices moved inwards:
+// anything they cover must also be covered by the real geometry. Pixels are covered if their center is inside a triangle,
+// and triangles facing away from the camera are skipped, like the back faces culled by the GPU
+// Set it with Renderer::SetOcclusionCuller, and the renderer rasterizes it when the camera is set
+class OcclusionCuller
+{
+public:
+    struct Stats
+    {
+        // Occluders and triangles rasterized, and the time it took in milliseconds
+        unsigned int occluders = 0;
+        unsigned int triangles = 0;
+        float rasterizeTime = 0.0f;
+
+        // Bounds tested, and the ones hidden by the occluders
+        unsigned int tested = 0;
+        unsigned int occluded = 0;
+    };
+
+public:
+    OcclusionCuller(int width = 256, int height = 128);
+
+    inline int GetWidth() const { return m_width; }
+    inline int GetHeight() const { return m_height; }
+
+    // Number of threads used to rasterize. 0 uses one per hardware thread
+    inline unsigned int GetThreadCount() const { return m_threadCount; }
+    inline void SetThreadCount(unsigned int threadCount) { m_threadCount = threadCount; }
+
+    // Add an occluder mesh, with the triangles counter-clockwise from the front, and return its index
+    unsigned int AddOccluderMesh(std::span<const glm::vec3> vertices, std::span<const unsigned int> indices);
+
+    // Replace the vertices of an occluder mesh, keeping the same number of them
+    void SetOccluderVertices(unsigned int meshIndex, std::span<const glm::vec3> vertices);
+
+    // Occluders of the frame: a mesh placed with a world matrix. Cleared by ClearOccluders, not by Rasterize
+    void AddOccluder(unsigned int meshIndex, const glm::mat4& worldMatrix);
+    void ClearOccluders();
+
+    // Rasterize the occluders as seen by the camera, and build the depth hierarchy
+    void Rasterize(const glm::mat4& viewProjMatrix);
+
+    // Test the world bounds against the depth hierarchy. False if they are hidden behind the occluders
+    // Bounds crossing the near plane are always visible
+    bool IsVisible(const BoxBounds& worldBounds);
+
+    // Statistics since the last Rasterize
+    inline const Stats& GetStats() const { return m_stats; }
+
+    // Depth of each pixel in the last frame, from 0 in the near plane to 1 in the far plane or where nothing was drawn
+    // Rows go from the bottom of the screen to the top
+    inline std::span<const float> GetDepthBuffer() const { return m_levels[0].depth; }
+
+    // Levels of the depth hierarchy, with the same layout as the depth buffer. Each one is half the size of the one below,
+    // rounded up, so a pixel (x, y) of the depth buffer is inside the texel (x >> level, y >> level)
+    inline int GetLevelCount() const { return static_cast<int>(m_levels.size()); }
+    inline glm::ivec2 GetLevelSize(int level) const { return glm::ivec2(m_levels[level].width, m_levels[level].height); }
+    inline std::span<const float> GetLevelDepth(int level) const { return m_levels[level].depth; }
+
+    // Transform used by the last Rasterize
+    inline const glm::mat4& GetViewProjectionMatrix() const { return m_viewProjMatrix; }
+
+private:
+    struct OccluderMesh
+    {
+        std::vector<glm::vec3> vertices;
+        std::vector<unsigned int> indices;
+    };
+
+    struct Occluder
+    {
+        unsigned int meshIndex;
+        glm::mat4 worldMatrix;
+    };
+
+    // Triangle in screen space, ready to be rasterized
+    struct Triangle
+    {
+        // Edge functions, inside if all are >= 0: edge.x * x + edge.y * y + edge.z
+        glm::vec3 edges[3];
+        // Depth plane: depth.x * x + depth.y * y + depth.z
+        glm::vec3 depth;
+        // Pixel rectangle covered by the triangle, max excluded
+        int minX, minY, maxX, maxY;
+    };
+
+    // One level of the hierarchy, with the farthest depth of each 2x2 block of the level below
+    struct Level
+    {
+        int width, height;
+        std::vector<float> depth;
+    };
+
+    // Transform the triangles of an occluder, clip them against the near plane and add them to the list
+    void SetupTriangles(const Occluder& occluder, const glm::mat4& viewProjMatrix);
+
+    // Add a triangle with the vertices in clip space, w > 0
+    void AddTriangle(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2);
+
+    // Rasterize all the triangles in the rows between firstRow and lastRow, last excluded
+    void RasterizeRows(int firstRow, int lastRow);
+    void RasterizeTriangle(const Triangle& triangle, int firstRow, int lastRow);
+
+    void BuildHierarchy();
+
+private:
+    int m_width;
+    int m_height;
+    unsigned int m_threadCount;
+    WorkerPool m_workerPool;
+
+    std::vector<OccluderMesh> m_meshes;
+    std::vector<Occluder> m_occluders;
+
+    // Triangles of the frame
+    std::vector<Triangle> m_triangles;
+
+    // Level 0 is the depth buffer
+    std::vector<Level> m_levels;
+
+    // Transform from world space to clip space of the last Rasterize
+    glm::mat4 m_viewProjMatrix;
+
+    Stats m_stats;
+};
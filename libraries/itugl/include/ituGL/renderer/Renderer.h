@@ -2,69 +2,184 @@
 
 #include <ituGL/core/DeviceGL.h>
 #include <ituGL/renderer/RenderPass.h>
+#include <ituGL/renderer/GLCommandExecutor.h>
 #include <ituGL/geometry/Drawcall.h>
 #include <ituGL/geometry/Mesh.h>
+#include <ituGL/geometry/VertexBufferObject.h>
 #include <ituGL/shader/Material.h>
+#include <ituGL/shader/UniformBufferObject.h>
+#include <ituGL/scene/Bounds.h>
 #include <glm/mat4x4.hpp>
 #include <vector>
 #include <unordered_map>
 #include <memory>
 #include <span>
+#include <array>
 #include <functional>
+#include <cstdint>
+#include <cassert>
 
 class Camera;
 class Light;
 class ShaderProgram;
 class Material;
+class TextureObject;
 class VertexArrayObject;
 class Drawcall;
 class Model;
 class FramebufferObject;
+class OcclusionCuller;
 
 class Renderer
 {
 public:
+    // Packed 64-bit key used to sort drawcalls, computed once when the drawcall is added
+    // Layout from most to least significant bits:
+    // - Opaque:      layer (4) | translucent = 0 (1) | program (11) | material (12) | VAO (12) | view depth, front to back (24)
+    // - Translucent: layer (4) | translucent = 1 (1) | view depth, back to front (24) | program (11) | material (12) | VAO (12)
+    using SortKey = std::uint64_t;
+
     class DrawcallInfo
     {
     public:
-        DrawcallInfo(const Material& material, unsigned int worldMatrixIndex, const VertexArrayObject& vao, const Drawcall& drawcall);
+        DrawcallInfo(const Material& material, unsigned int worldMatrixIndex, const VertexArrayObject& vao, const Drawcall& drawcall, SortKey sortKey = 0);
 
         const Material& GetMaterial() const { return m_material; }
         unsigned int GetWorldMatrixIndex() const { return m_worldMatrixIndex; }
         const VertexArrayObject& GetVAO() const { return m_vao; }
         const Drawcall& GetDrawcall() const { return m_drawcall; }
 
+        SortKey GetSortKey() const { return m_sortKey; }
+        void SetSortKey(SortKey sortKey) { m_sortKey = sortKey; }
+
     private:
         std::reference_wrapper<const Material> m_material;
         unsigned int m_worldMatrixIndex;
         std::reference_wrapper<const VertexArrayObject> m_vao;
         std::reference_wrapper<const Drawcall> m_drawcall;
+        SortKey m_sortKey;
     };
 
     using DrawcallSupportedFunction = std::function<bool(const DrawcallInfo& drawcallInfo)>;
+    using DrawcallSortFunction = std::function<bool(const DrawcallInfo&, const DrawcallInfo&)>;
+
+    // Drawcalls are routed to a collection if their material has all the required capabilities and none of the excluded
+    // ones (see Material::Capabilities), and then, only if set, if the supported function returns true.
+    // The masks cost a few instructions per drawcall, use the function only for what they can't express
     class DrawcallCollection
     {
     public:
         DrawcallCollection(const DrawcallSupportedFunction &isSupported = nullptr);
+        DrawcallCollection(unsigned int requiredCapabilities, unsigned int excludedCapabilities = 0);
 
         bool IsSupported(const DrawcallInfo& drawcallInfo) const;
         void SetSupportedFunction(const DrawcallSupportedFunction& isSupported);
+        void SetCapabilities(unsigned int requiredCapabilities, unsigned int excludedCapabilities = 0);
+
+        // Drawcalls to render: the ones of the frame merged with the retained ones, in key order after MergeFrameDrawcalls,
+        // or in the order of the sort function if there is one
+        std::span<DrawcallInfo> GetDrawcalls();
+        std::span<const DrawcallInfo> GetDrawcalls() const;
 
-        std::span<DrawcallInfo> GetDrawcalls() { return m_drawcallInfos; }
-        std::span<const DrawcallInfo> GetDrawcalls() const { return m_drawcallInfos; }
+        // Drawcalls added since the last Clear
+        std::span<DrawcallInfo> GetFrameDrawcalls() { return m_drawcallInfos; }
 
         void AddDrawcall(const DrawcallInfo& drawcallInfo);
+        // Remove the drawcalls of the frame and the sort function. Retained drawcalls stay
         void Clear();
 
+        // Stable LSD radix sort of the drawcalls of the frame by their sort key. scratch is reused between calls to avoid allocations
+        void SortByKey(std::vector<DrawcallInfo>& scratch);
+
+        // Order the drawcalls of this frame with a comparison function instead of the sort keys, see Renderer::SortDrawcallCollection
+        void SetSortFunction(const DrawcallSortFunction& sortFunction);
+        bool HasSortFunction() const { return static_cast<bool>(m_sortFunction); }
+        // Sort the drawcalls of the frame with the sort function if there is one, by key otherwise
+        void Sort(std::vector<DrawcallInfo>& scratch);
+
+        // Retained drawcalls stay in the collection between frames, always sorted by key. See Renderer::AddModelProxy
+        std::span<DrawcallInfo> GetRetainedDrawcalls() { return m_retainedDrawcalls; }
+        // Added to a pending list, merged with the rest by MergeRetainedDrawcalls
+        void AddRetainedDrawcall(const DrawcallInfo& drawcallInfo);
+        // Remove the retained drawcalls, merged or pending, for which isRemoved returns true
+        void RemoveRetainedDrawcalls(const DrawcallSupportedFunction& isRemoved);
+        // Sort the pending retained drawcalls and merge them with the rest, in linear time
+        void MergeRetainedDrawcalls(std::vector<DrawcallInfo>& scratch);
+
+        // Merge the sorted drawcalls of the frame with the retained ones. Copies only if the collection has both,
+        // or if it has a sort function and retained drawcalls, which keep their key order and are sorted in the copy
+        void MergeFrameDrawcalls();
+
+    private:
+        static void SortByKey(std::vector<DrawcallInfo>& drawcallInfos, std::vector<DrawcallInfo>& scratch);
+
     private:
+        unsigned int m_requiredCapabilities;
+        unsigned int m_excludedCapabilities;
         DrawcallSupportedFunction m_isSupported;
+        DrawcallSortFunction m_sortFunction;
         std::vector<DrawcallInfo> m_drawcallInfos;
-    };
 
-    using DrawcallSortFunction = std::function<bool(const DrawcallInfo&, const DrawcallInfo&)>;
+        std::vector<DrawcallInfo> m_retainedDrawcalls;
+        std::vector<DrawcallInfo> m_pendingRetainedDrawcalls;
+        // Frame and retained drawcalls together, only used when there are both or when there is a sort function
+        std::vector<DrawcallInfo> m_mergedDrawcalls;
+    };
 
     using UpdateTransformsFunction = std::function<void(const ShaderProgram&, const glm::mat4&, const Camera&, bool)>;
     using UpdateLightsFunction = std::function<bool(const ShaderProgram&, std::span<const Light* const>, unsigned int&)>;
+    // Same as UpdateTransformsFunction, but records the uniforms into a command buffer
+    using RecordTransformsFunction = std::function<void(CommandBuffer&, const ShaderProgram&, const glm::mat4&, const Camera&, bool)>;
+
+    // Number of state changes that PrepareDrawcall had to do, and the ones it skipped because they were redundant
+    struct StateCounter
+    {
+        unsigned int issued = 0;
+        unsigned int skipped = 0;
+    };
+
+    // Per-frame statistics of PrepareDrawcall
+    struct DrawcallStats
+    {
+        unsigned int drawcalls = 0;
+        StateCounter shaderPrograms;
+        StateCounter materials;
+        StateCounter renderStates;
+        StateCounter transforms;
+        StateCounter vaos;
+        StateCounter textures;
+        // Instanced drawcalls, and the number of drawcalls they replaced
+        unsigned int instancedDrawcalls = 0;
+        unsigned int instances = 0;
+    };
+
+    // Number of objects that passed the culling tests, the ones outside of the frustum, and the ones hidden by the occluders
+    struct CullingStats
+    {
+        unsigned int visible = 0;
+        unsigned int culled = 0;
+        unsigned int occluded = 0;
+    };
+
+    // Model that casts shadows, with its bounds in world space. Added even if it is not visible from the camera
+    struct ShadowCaster
+    {
+        const Model* model;
+        unsigned int worldMatrixIndex;
+        AabbBounds worldBounds;
+    };
+
+    // Model culled on the GPU, added without drawcalls. See GpuDrivenRenderPass
+    struct GpuCulledModel
+    {
+        const Model* model;
+        unsigned int worldMatrixIndex;
+        AabbBounds worldBounds;
+    };
+
+    // Model kept by the renderer between frames, see AddModelProxy
+    using ProxyId = unsigned int;
+    static const ProxyId InvalidProxyId = ~0u;
 
 public:
     Renderer(DeviceGL& device);
@@ -78,6 +193,21 @@ public:
     const Camera& GetCurrentCamera() const;
     void SetCurrentCamera(const Camera& camera);
 
+    // Frustum of the current camera, updated when the camera is set
+    const FrustumBounds& GetCurrentFrustum() const;
+
+    // Test the world bounds of an object against the current frustum and the occlusion culler, and count the result
+    template<typename T>
+    bool IsVisible(const T& worldBounds);
+
+    // Occluders that hide the objects behind them, not owned by the renderer. It is rasterized when the camera is set,
+    // so the occluders of the frame must be added before
+    OcclusionCuller* GetOcclusionCuller() const { return m_occlusionCuller; }
+    void SetOcclusionCuller(OcclusionCuller* occlusionCuller) { m_occlusionCuller = occlusionCuller; }
+
+    // Culling statistics of the last rendered frame
+    const CullingStats& GetCullingStats() const { return m_lastCullingStats; }
+
     std::shared_ptr<const FramebufferObject> GetDefaultFramebuffer() const;
     std::shared_ptr<const FramebufferObject> GetCurrentFramebuffer() const;
     void SetCurrentFramebuffer(std::shared_ptr<const FramebufferObject> framebuffer);
@@ -85,18 +215,82 @@ public:
     std::span<const Light* const> GetLights() const;
     void AddLight(const Light& light);
 
+    // Shadow passes need the casters outside of the view. If enabled, the scene also adds all the models as casters
+    bool GetShadowCastersEnabled() const { return m_shadowCastersEnabled; }
+    void SetShadowCastersEnabled(bool enabled) { m_shadowCastersEnabled = enabled; }
+
+    std::span<const ShadowCaster> GetShadowCasters() const { return m_shadowCasters; }
+    void AddShadowCaster(const Model& model, const glm::mat4& worldMatrix, const AabbBounds& worldBounds);
+
+    // When enabled, the scene adds the models without culling them, to be culled and drawn by a GPU-driven pass
+    bool GetGpuCullingEnabled() const { return m_gpuCullingEnabled; }
+    void SetGpuCullingEnabled(bool enabled) { m_gpuCullingEnabled = enabled; }
+
+    std::span<const GpuCulledModel> GetGpuCulledModels() const { return m_gpuCulledModels; }
+    void AddGpuCulledModel(const Model& model, const glm::mat4& worldMatrix, const AabbBounds& worldBounds);
+
+    const glm::mat4& GetWorldMatrix(unsigned int worldMatrixIndex) const
+    {
+        return (worldMatrixIndex & ProxyWorldMatrixFlag) ? m_proxyWorldMatrices[worldMatrixIndex & ~ProxyWorldMatrixFlag] : m_worldMatrices[worldMatrixIndex];
+    }
+
     std::span<const DrawcallInfo> GetDrawcalls(unsigned int collectionIndex) const;
-    void AddModel(const Model& model, const glm::mat4& worldMatrix);
+    // layer is stored in the top bits of the sort key, lower layers are drawn first
+    void AddModel(const Model& model, const glm::mat4& worldMatrix, unsigned int layer = 0);
+
+    // Retained mode: the drawcalls of a model proxy stay in the collections until it is removed, so a static model costs
+    // nothing per frame. Render merges the added ones into the sorted lists and drops the removed ones, without a full sort.
+    // Opaque drawcalls are sorted by state only, translucent ones are sorted back to front again every frame.
+    // Proxies are not culled. The model must stay alive until the proxy is removed and the next frame is rendered,
+    // and the collections must be added before the proxies
+    ProxyId AddModelProxy(const Model& model, const glm::mat4& worldMatrix, unsigned int layer = 0);
+    // Move the proxy. The drawcalls keep their place in the lists
+    void UpdateModelProxy(ProxyId proxyId, const glm::mat4& worldMatrix);
+    void RemoveModelProxy(ProxyId proxyId);
+    unsigned int GetModelProxyCount() const;
 
     unsigned int AddDrawcallCollection(const DrawcallSupportedFunction &drawcallSupportedFunction);
+    // Collection of the drawcalls whose material has all the required capabilities and none of the excluded ones
+    unsigned int AddDrawcallCollection(unsigned int requiredCapabilities, unsigned int excludedCapabilities = 0);
     void SetDrawcallCollectionSupportedFunction(unsigned int index, const DrawcallSupportedFunction& drawcallSupportedFunction);
+    void SetDrawcallCollectionCapabilities(unsigned int index, unsigned int requiredCapabilities, unsigned int excludedCapabilities = 0);
 
+    // Sort using the precomputed sort keys, in linear time. Render does it for every collection without a sort function
+    void SortDrawcallCollection(unsigned int index);
+    // Sort using a comparison function instead of the sort keys, for this frame. The drawcalls are sorted in Render,
+    // including the ones added after this call. Slower, use only if the order can't be expressed with the sort key
     void SortDrawcallCollection(unsigned int index, const DrawcallSortFunction& drawcallSortFunction);
     bool IsBackToFront(const DrawcallInfo& a, const DrawcallInfo& b) const;
     bool IsFrontToBack(const DrawcallInfo& a, const DrawcallInfo& b) const;
 
     const Mesh& GetFullscreenMesh() const;
 
+    // Shader programs that declare this mat4 vertex attribute are drawn with hardware instancing.
+    // It receives the world matrix of each instance, instead of the world matrix uniform
+    static constexpr const char* InstanceWorldMatrixName = "InstanceWorldMatrix";
+
+    // Location of the instance world matrix attribute, -1 if the program doesn't support instancing
+    ShaderProgram::Location GetInstanceMatrixLocation(std::shared_ptr<const ShaderProgram> shaderProgramPtr) const;
+
+    // Point the instance world matrix attribute of the bound VAO to the matrices of the bound array buffer, at offset bytes
+    static void SetInstanceMatrixAttribute(ShaderProgram::Location location, size_t offset);
+    // Disable the instance world matrix attribute of the bound VAO again. VAOs are shared by instanced and regular
+    // drawcalls, call it after the instanced draws
+    static void ResetInstanceMatrixAttribute(ShaderProgram::Location location);
+
+    // Uniform block with the per-frame values, uploaded once per frame. Programs that declare it are assigned to
+    // FrameUniformsBinding when registered. Layout (std140):
+    //   mat4 ViewMatrix; mat4 ProjMatrix; mat4 ViewProjMatrix; mat4 InvViewMatrix; mat4 InvProjMatrix;
+    //   vec3 CameraPosition; float Time; vec3 AmbientColor; int LightCount;
+    static constexpr const char* FrameUniformsName = "FrameUniforms";
+    static const GLuint FrameUniformsBinding = 0;
+
+    // Global values of the per-frame uniform block
+    float GetTime() const { return m_time; }
+    void SetTime(float time) { m_time = time; }
+    const glm::vec3& GetAmbientColor() const { return m_ambientColor; }
+    void SetAmbientColor(const glm::vec3& ambientColor) { m_ambientColor = ambientColor; }
+
     void RegisterShaderProgram(std::shared_ptr<const ShaderProgram> shaderProgramPtr,
         const UpdateTransformsFunction& updateTransformFunction,
         const UpdateLightsFunction& updateLightsFunction);
@@ -104,11 +298,41 @@ public:
     void UpdateTransforms(std::shared_ptr<const ShaderProgram> shaderProgramPtr, const glm::mat4& worldMatrix, bool cameraChanged = true) const;
     void UpdateTransforms(std::shared_ptr<const ShaderProgram> shaderProgramPtr, unsigned int worldMatrixIndex, bool cameraChanged = true) const;
 
+    // Records the transforms of a shader program as commands. Without it, UpdateTransformsFunction is recorded as a function call
+    void RegisterRecordTransformsFunction(std::shared_ptr<const ShaderProgram> shaderProgramPtr, const RecordTransformsFunction& recordTransformsFunction);
+
     UpdateLightsFunction GetDefaultUpdateLightsFunction(const ShaderProgram& shaderProgram);
     bool UpdateLights(std::shared_ptr<const ShaderProgram> shaderProgramPtr, std::span<const Light* const> lights, unsigned int& lightIndex) const;
+    bool HasUpdateLightsFunction(std::shared_ptr<const ShaderProgram> shaderProgramPtr) const;
 
     void PrepareDrawcall(const DrawcallInfo& drawcallInfo, Material::OverrideFlags materialOverride = Material::NoOverride);
 
+    // Prepare the first drawcall. If its shader program supports instancing, also prepare the next ones with the same
+    // material, VAO and drawcall as instances of it. Returns the number of drawcalls prepared
+    unsigned int PrepareDrawcalls(std::span<const DrawcallInfo> drawcallInfos, Material::OverrideFlags materialOverride = Material::NoOverride);
+
+    // Draw the drawcall prepared last, with all its instances
+    void DrawPreparedDrawcall(const DrawcallInfo& drawcallInfo) const;
+
+    // Record the same commands as PrepareDrawcalls and DrawPreparedDrawcall, without calling GL. The state is tracked
+    // separately from the one of PrepareDrawcall, and forgotten by InvalidateDrawcallState: start each buffer after it
+    unsigned int RecordPrepareDrawcalls(CommandBuffer& commandBuffer, std::span<const DrawcallInfo> drawcallInfos, Material::OverrideFlags materialOverride = Material::NoOverride);
+    void RecordDrawPreparedDrawcall(CommandBuffer& commandBuffer, const DrawcallInfo& drawcallInfo) const;
+
+    // Same as UpdateLights, but the uniforms set by the function are recorded as commands
+    bool RecordUpdateLights(CommandBuffer& commandBuffer, std::shared_ptr<const ShaderProgram> shaderProgramPtr, std::span<const Light* const> lights, unsigned int& lightIndex) const;
+    void RecordLightingRenderStates(CommandBuffer& commandBuffer, bool firstPass);
+
+    // Execute the commands against GL, and invalidate the drawcall state. Debug builds check them with a NullCommandExecutor first
+    void ExecuteCommands(const CommandBuffer& commandBuffer);
+
+    // Forget the state set by the last PrepareDrawcall, and the state recorded by the last RecordPrepareDrawcalls.
+    // Call it after changing GL state by other means
+    void InvalidateDrawcallState();
+
+    // Statistics of the current frame, or of the last one after Render
+    const DrawcallStats& GetDrawcallStats() const { return m_drawcallStats; }
+
     void SetLightingRenderStates(bool firstPass);
 
     void Render();
@@ -120,13 +344,61 @@ private:
 
     void InitializeFullscreenMesh();
 
+    // Test the bounds against the occlusion culler, outside of the header so it doesn't need to be included
+    bool IsOccluded(const BoxBounds& worldBounds) const;
+
+    // Write the per-frame uniform block and bind it
+    void UpdateFrameUniforms();
+
     const glm::mat4& GetWorldMatrix(const DrawcallInfo& drawcallInfo) const;
 
+    // Copy the world matrices of the instances to the instance buffer. Returns their offset in bytes, the buffer stays bound
+    size_t UpdateInstanceBuffer(std::span<const glm::mat4> worldMatrices);
+
+    void RecordPrepareDrawcall(CommandBuffer& commandBuffer, const DrawcallInfo& drawcallInfo, Material::OverrideFlags materialOverride);
+
+    // Record the transforms of a drawcall with the record function of the program, or as a call to UpdateTransforms
+    void RecordTransforms(CommandBuffer& commandBuffer, const DrawcallInfo& drawcallInfo, bool cameraChanged) const;
+
+    // Without viewDepth, the depth bits are left empty
+    SortKey ComputeSortKey(const DrawcallInfo& drawcallInfo, unsigned int layer, bool viewDepth = true) const;
+    void UpdateSortKeysDepth();
+
+    // Apply the proxies added and removed since the last frame to the collections, and sort the translucent ones
+    void UpdateRetainedDrawcalls();
+
+private:
+    // State left by the last PrepareDrawcall, to skip redundant changes on the next one
+    struct DrawcallState
+    {
+        const ShaderProgram* shaderProgram = nullptr;
+        const Material* material = nullptr;
+        Material::OverrideFlags materialOverride = Material::NoOverride;
+        bool renderStatesDirty = true;
+        unsigned int worldMatrixIndex = ~0u;
+        const VertexArrayObject* vao = nullptr;
+        // Texture bound to each texture unit by the materials
+        std::array<const TextureObject*, 32> boundTextures = {};
+        // Instances prepared with the last drawcall, 0 if it is not instanced
+        unsigned int instanceCount = 0;
+        // Instance matrix attribute of the instanced drawcall, and offset of its matrices in the instance buffer
+        ShaderProgram::Location instanceLocation = -1;
+        size_t instanceOffset = 0;
+    };
+
 private:
     DeviceGL& m_device;
 
     const Camera *m_currentCamera;
 
+    FrustumBounds m_currentFrustum;
+
+    // Culling statistics of the frame being built, and of the last rendered one
+    CullingStats m_cullingStats;
+    CullingStats m_lastCullingStats;
+
+    OcclusionCuller* m_occlusionCuller;
+
     std::shared_ptr<const Material> m_currentMaterial;
 
     std::shared_ptr<const FramebufferObject> m_defaultFramebuffer;
@@ -136,12 +408,82 @@ private:
 
     std::vector<glm::mat4> m_worldMatrices;
 
+    // World matrix indices with this bit refer to m_proxyWorldMatrices, indexed by ProxyId
+    static const unsigned int ProxyWorldMatrixFlag = 1u << 31;
+
+    struct ModelProxy
+    {
+        const Model* model = nullptr;
+        // Removed, but its drawcalls are still in the collections until the next Render
+        bool removed = false;
+    };
+    std::vector<ModelProxy> m_modelProxies;
+    std::vector<glm::mat4> m_proxyWorldMatrices;
+    std::vector<ProxyId> m_freeProxyIds;
+    std::vector<ProxyId> m_removedProxyIds;
+    unsigned int m_modelProxyCount;
+
+    bool m_shadowCastersEnabled;
+    std::vector<ShadowCaster> m_shadowCasters;
+
+    bool m_gpuCullingEnabled;
+    std::vector<GpuCulledModel> m_gpuCulledModels;
+
     std::vector<DrawcallCollection> m_drawcallCollections;
 
+    // Scratch buffer for the radix sort
+    std::vector<DrawcallInfo> m_sortScratch;
+
+    // True if models were added before the camera was set, so the depth bits of the keys are missing
+    bool m_sortKeysNeedDepth;
+
     std::unordered_map<std::shared_ptr<const ShaderProgram>, UpdateTransformsFunction> m_updateTransformsFunctions;
     std::unordered_map<std::shared_ptr<const ShaderProgram>, UpdateLightsFunction> m_updateLightsFunctions;
+    std::unordered_map<std::shared_ptr<const ShaderProgram>, RecordTransformsFunction> m_recordTransformsFunctions;
+
+    // Location of the instance world matrix attribute, for the programs that support instancing
+    std::unordered_map<std::shared_ptr<const ShaderProgram>, ShaderProgram::Location> m_instanceMatrixLocations;
+
+    // Per-instance world matrices, streamed every frame. Orphaned when full
+    VertexBufferObject m_instanceBuffer;
+    size_t m_instanceBufferSize;
+    size_t m_instanceBufferOffset;
+    std::vector<glm::mat4> m_instanceMatrices;
+
+    DrawcallState m_drawcallState;
+    DrawcallStats m_drawcallStats;
+
+    // State left by the last RecordPrepareDrawcalls, and the instance matrices recorded in the frame, uploaded when executed
+    DrawcallState m_recordState;
+    std::vector<glm::mat4> m_recordedInstanceMatrices;
+
+    GLCommandExecutor m_commandExecutor;
 
     Mesh m_fullscreenMesh;
 
+    // Per-frame uniform block, and the values that don't come from the camera
+    UniformBufferObject m_frameUniformBuffer;
+    UniformBufferObject::Std140Writer m_frameUniforms;
+    float m_time;
+    glm::vec3 m_ambientColor;
+
     std::vector<std::unique_ptr<RenderPass>> m_passes;
 };
+
+template<typename T>
+bool Renderer::IsVisible(const T& worldBounds)
+{
+    assert(m_currentCamera);
+    if (!Bounds::Intersects(m_currentFrustum, worldBounds))
+    {
+        m_cullingStats.culled++;
+        return false;
+    }
+    if (m_occlusionCuller && IsOccluded(BoxBounds(worldBounds)))
+    {
+        m_cullingStats.occluded++;
+        return false;
+    }
+    m_cullingStats.visible++;
+    return true;
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <ituGL/renderer/RenderPass.h>
+
+#include <ituGL/shader/ShaderProgram.h>
+#include <ituGL/scene/Bounds.h>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+#include <vector>
+#include <memory>
+#include <span>
+
+class Material;
+class Camera;
+class DirectionalLight;
+class Texture2DArrayObject;
+class FramebufferObject;
+
+// Cascaded shadow maps for the main directional light: the first one in the renderer lights
+// The view range, limited by the maximum distance and by the bounds of the casters, is split in cascades, each one with
+// its own orthographic projection and layer in a depth texture array. The projections are stable: their size only
+// depends on the shape of the frustum slice, and their position is snapped to whole texels, so the edges don't shimmer
+// Casters are taken from Renderer::GetShadowCasters, so the renderer needs SetShadowCastersEnabled(true). They are culled
+// per cascade, and drawn with a depth-only material that is set once per cascade: each draw only sets its matrix
+// A cascade is only drawn again if its projection, or the casters inside it, changed since it was drawn last
+class ShadowMapRenderPass : public RenderPass
+{
+public:
+    // Names of the uniforms that the lighting shaders declare to receive the shadows
+    // sampler2DArrayShadow with one cascade per layer
+    static constexpr const char* ShadowMapName = "ShadowMap";
+    // mat4 array from world space to the texture coordinates and depth of each cascade
+    static constexpr const char* ShadowMatricesName = "ShadowMatrices";
+    // int with the number of cascades
+    static constexpr const char* CascadeCountName = "ShadowCascadeCount";
+
+    // Uniform locations of a shader program that receives the shadows
+    struct Locations
+    {
+        ShaderProgram::Location shadowMap = -1;
+        ShaderProgram::Location shadowMatrices = -1;
+        ShaderProgram::Location cascadeCount = -1;
+
+        // True if the program samples the shadow map
+        inline bool IsValid() const { return shadowMap >= 0; }
+    };
+
+    static const unsigned int MaxCascadeCount = 4;
+
+public:
+    // depthMaterial only needs to write the depth. Its program must have the WorldViewProjMatrix uniform
+    ShadowMapRenderPass(std::shared_ptr<Material> depthMaterial, int resolution = 2048, unsigned int cascadeCount = 4);
+    ~ShadowMapRenderPass();
+
+    void Render() override;
+
+    inline std::shared_ptr<const Texture2DArrayObject> GetShadowMap() const { return m_shadowMap; }
+
+    inline int GetResolution() const { return m_resolution; }
+    inline unsigned int GetCascadeCount() const { return m_cascadeCount; }
+
+    // Shadows are only computed up to this view depth
+    inline float GetMaxDistance() const { return m_maxDistance; }
+    inline void SetMaxDistance(float maxDistance) { m_maxDistance = maxDistance; }
+
+    // Blend between uniform (0) and logarithmic (1) split distances
+    inline float GetSplitLambda() const { return m_splitLambda; }
+    inline void SetSplitLambda(float splitLambda) { m_splitLambda = splitLambda; }
+
+    // Depth offset of the casters, to avoid shadow acne: factor scales with the slope, units with the depth resolution
+    inline void SetDepthBias(float factor, float units) { m_depthBiasFactor = factor; m_depthBiasUnits = units; }
+
+    // View depth where each cascade ends
+    inline std::span<const float> GetSplitDepths() const { return std::span<const float>(m_splitDepths.data(), m_cascadeCount); }
+
+    // Matrix from world space to the texture coordinates and depth of the cascade
+    inline const glm::mat4& GetShadowMatrix(unsigned int cascade) const { return m_cascades[cascade].shadowMatrix; }
+
+    // Cascades drawn and skipped because they were up to date, and casters drawn, in the last frame
+    inline unsigned int GetDrawnCascadeCount() const { return m_drawnCascadeCount; }
+    inline unsigned int GetCachedCascadeCount() const { return m_cachedCascadeCount; }
+    inline unsigned int GetDrawnCasterCount() const { return m_drawnCasterCount; }
+
+    // Get the locations of the shadow uniforms in the program
+    static Locations GetLocations(const ShaderProgram& shaderProgram);
+
+    // Set the shadow uniforms, and bind the shadow map to textureUnit
+    void Use(const ShaderProgram& shaderProgram, const Locations& locations, int textureUnit) const;
+
+private:
+    struct Cascade
+    {
+        // Bounds of the orthographic projection in light view space. Z grows toward the light
+        glm::vec3 boundsMin = glm::vec3(0.0f);
+        glm::vec3 boundsMax = glm::vec3(0.0f);
+
+        // Light view-projection of the cascade, and the same with the bias to texture coordinates
+        glm::mat4 viewProjMatrix = glm::mat4(1.0f);
+        glm::mat4 shadowMatrix = glm::mat4(1.0f);
+
+        // Hash of the projection and the casters when the layer was drawn. Only valid if drawn is true
+        size_t drawnHash = 0;
+        bool drawn = false;
+
+        // Casters inside the cascade, indices in Renderer::GetShadowCasters
+        std::vector<unsigned int> casters;
+    };
+
+    // Find the first directional light of the renderer
+    const DirectionalLight* FindLight() const;
+
+    // Compute the split depths between the camera near plane and the end of the shadows
+    void ComputeSplitDepths(float nearDepth, float farDepth);
+
+    // Fit the bounds of the cascade to the slice of the view between nearDepth and farDepth
+    void FitCascade(Cascade& cascade, const Camera& camera, float nearDepth, float farDepth) const;
+
+    // Find the casters inside the cascade and extend its bounds toward the light to include them. Then compute the
+    // matrices, and return the hash of the projection and the casters
+    size_t CullCasters(Cascade& cascade) const;
+
+    // Draw the casters of the cascade in its layer
+    void DrawCascade(const Cascade& cascade, unsigned int cascadeIndex);
+
+    void InitializeTextures();
+
+private:
+    std::shared_ptr<Material> m_depthMaterial;
+    ShaderProgram::Location m_worldViewProjMatrixLocation;
+
+    int m_resolution;
+    unsigned int m_cascadeCount;
+
+    float m_maxDistance;
+    float m_splitLambda;
+    float m_depthBiasFactor;
+    float m_depthBiasUnits;
+
+    std::shared_ptr<Texture2DArrayObject> m_shadowMap;
+
+    // False if there was no directional light in the last frame, so there are no shadows
+    bool m_hasLight;
+    glm::mat4 m_lightViewMatrix;
+
+    // One framebuffer per cascade, with its layer of the shadow map attached
+    std::vector<std::shared_ptr<FramebufferObject>> m_framebuffers;
+
+    std::vector<Cascade> m_cascades;
+    std::vector<float> m_splitDepths;
+
+    // Light view space bounds of all the casters
+    std::vector<AabbBounds> m_casterLightBounds;
+
+    unsigned int m_drawnCascadeCount;
+    unsigned int m_cachedCascadeCount;
+    unsigned int m_drawnCasterCount;
+};
@@ -1,7 +1,11 @@
 #pragma once
 
 #include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
 #include <glm/mat3x3.hpp>
+#include <glm/mat4x4.hpp>
+#include <array>
+#include <cassert>
 
 class Bounds
 {
@@ -103,21 +107,42 @@ private:
     glm::vec3 m_size;
 };
 
-class FrustumBounds : public RotatedBounds
+class FrustumBounds : public Bounds
 {
 public:
-    FrustumBounds(const glm::vec3& center, const glm::vec3& size);
+    enum Plane
+    {
+        Left, Right,
+        Bottom, Top,
+        Near, Far,
+        PlaneCount
+    };
+
+public:
+    // Extract the planes of the frustum from a view-projection matrix
+    FrustumBounds(const glm::mat4& viewProjMatrix = glm::mat4(1.0f));
 
     inline Type GetType() const override { return Type::Frustum; }
 
+    void SetViewProjectionMatrix(const glm::mat4& viewProjMatrix);
+
+    // Planes as (normal, distance), with normalized normals pointing inside. Points inside have dot(normal, p) + distance >= 0
+    inline const glm::vec4& GetPlane(Plane plane) const { return m_planes[plane]; }
+    inline const std::array<glm::vec4, PlaneCount>& GetPlanes() const { return m_planes; }
+
+    // Corners of the frustum, the corners of the clip space volume in world space
+    inline const std::array<glm::vec3, 8>& GetCorners() const { return m_corners; }
+
 private:
+    std::array<glm::vec4, PlaneCount> m_planes;
+    std::array<glm::vec3, 8> m_corners;
 };
 
 
 template<typename T>
 bool Bounds::Intersects(const T& other) const
 {
-    Bounds::Intersects(this, other);
+    return Bounds::Intersects(*this, other);
 }
 
 template<typename TA, typename TB>
@@ -144,6 +169,8 @@ bool Bounds::Intersects(const Bounds& boundsA, const TB& boundsB)
         return Bounds::Intersects(static_cast<const AabbBounds&>(boundsA), boundsB);
     case Type::Box:
         return Bounds::Intersects(static_cast<const BoxBounds&>(boundsA), boundsB);
+    case Type::Frustum:
+        return Bounds::Intersects(static_cast<const FrustumBounds&>(boundsA), boundsB);
     default:
         assert(false);
         return false;
@@ -168,8 +195,8 @@ template<>
 bool Bounds::Intersects(const FrustumBounds& boundsA, const AabbBounds& boundsB);
 template<>
 bool Bounds::Intersects(const FrustumBounds& boundsA, const BoxBounds& boundsB);
-//template<>
-//bool Bounds::Intersects(const FrustumBounds& boundsA, const FrustumBounds& boundsB);
+template<>
+bool Bounds::Intersects(const FrustumBounds& boundsA, const FrustumBounds& boundsB);
 
 
 
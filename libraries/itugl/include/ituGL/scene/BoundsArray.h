@@ -0,0 +1,76 @@
+#pragma once
+
+#include <ituGL/scene/Bounds.h>
+#include <vector>
+#include <span>
+#include <cstdint>
+
+// Structure of arrays with the bounds of many objects, to test them in batches with SIMD instructions
+// Each element is a sphere or an AABB. Spheres have zero extents and AABBs have zero radius,
+// so both are tested with the same formula: distance to the plane >= -(radius + projected extents)
+class BoundsArray
+{
+public:
+    // Elements tested by each SIMD instruction. Arrays are padded to a multiple of this
+    static const unsigned int BatchSize = 8;
+
+public:
+    BoundsArray();
+
+    // Number of elements
+    inline unsigned int GetSize() const { return m_size; }
+
+    // Size in bytes of the visibility mask, 1 bit per element
+    inline unsigned int GetVisibilityMaskSize() const { return (m_size + 7) / 8; }
+
+    void Reserve(unsigned int capacity);
+    void Clear();
+
+    // Add bounds and return their index
+    unsigned int Add(const SphereBounds& bounds);
+    unsigned int Add(const AabbBounds& bounds);
+
+    // Replace the bounds of an element
+    void Set(unsigned int index, const SphereBounds& bounds);
+    void Set(unsigned int index, const AabbBounds& bounds);
+
+    // Check if the element is a sphere or an AABB
+    bool IsSphere(unsigned int index) const;
+
+    // Test all the elements against the frustum. Bit i of the mask is set if element i is visible, the bits after the last element are cleared
+    // Uses AVX or SSE when the compiler targets them
+    void TestFrustum(const FrustumBounds& frustum, std::span<std::uint8_t> visibilityMask) const;
+
+    // Same test, one element at a time with Bounds::Intersects. Reference for the SIMD version
+    void TestFrustumReference(const FrustumBounds& frustum, std::span<std::uint8_t> visibilityMask) const;
+
+private:
+    // Make the arrays big enough for the current size, padding the last batch
+    void Resize(unsigned int size);
+
+    void Set(unsigned int index, const glm::vec3& center, float radius, const glm::vec3& extents);
+
+    void TestFrustumScalar(const FrustumBounds& frustum, unsigned int begin, std::span<std::uint8_t> visibilityMask) const;
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    void TestFrustumSSE(const FrustumBounds& frustum, std::span<std::uint8_t> visibilityMask) const;
+#endif
+#if defined(__AVX__)
+    void TestFrustumAVX(const FrustumBounds& frustum, std::span<std::uint8_t> visibilityMask) const;
+#endif
+
+private:
+    unsigned int m_size;
+
+    // Components of the centers
+    std::vector<float> m_centersX;
+    std::vector<float> m_centersY;
+    std::vector<float> m_centersZ;
+
+    // Radius of the spheres, 0 for AABBs
+    std::vector<float> m_radii;
+
+    // Half size of the AABBs, 0 for spheres
+    std::vector<float> m_extentsX;
+    std::vector<float> m_extentsY;
+    std::vector<float> m_extentsZ;
+};
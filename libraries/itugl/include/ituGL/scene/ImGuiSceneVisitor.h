@@ -1,24 +1,28 @@
 #pragma once
 
-#include <ituGL/scene/SceneVisitor.h>
 #include <string>
 
 class DearImGui;
+class Scene;
 class SceneCamera;
 class SceneLight;
 class SceneModel;
 class Transform;
 
-class ImGuiSceneVisitor : public SceneVisitor
+// Shows the nodes of a scene in a window, grouped by type, to edit their transforms and properties
+class ImGuiSceneVisitor
 {
 public:
     ImGuiSceneVisitor(DearImGui& imGui, const char *windowName);
 
-    void VisitCamera(SceneCamera& sceneCamera) override;
+    // Show the cameras, the lights and the models of the scene, walked with Scene::ForEach
+    void VisitScene(Scene& scene);
 
-    void VisitLight(SceneLight& sceneLight) override;
+    void VisitCamera(SceneCamera& sceneCamera);
 
-    void VisitModel(SceneModel& sceneModel) override;
+    void VisitLight(SceneLight& sceneLight);
+
+    void VisitModel(SceneModel& sceneModel);
 
 private:
     void VisitTransform(Transform& transform);
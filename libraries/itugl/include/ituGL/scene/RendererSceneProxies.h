@@ -0,0 +1,67 @@
+#pragma once
+
+#include <ituGL/renderer/Renderer.h>
+#include <vector>
+#include <memory>
+
+class Scene;
+class SceneModel;
+class Transform;
+
+// Keeps the models of a scene in the renderer between frames, as model proxies. Update sends only the models whose
+// transform or model changed, instead of adding all of them again like RendererSceneVisitor
+// The camera and the lights are still added every frame. Models are not culled, see Renderer::AddModelProxy
+class RendererSceneProxies
+{
+public:
+    // Proxies of the scene models after the last Update, and what it had to change
+    struct Stats
+    {
+        unsigned int proxies = 0;
+        unsigned int added = 0;
+        unsigned int updated = 0;
+        unsigned int removed = 0;
+    };
+
+public:
+    RendererSceneProxies(Renderer& renderer, Scene& scene);
+    // Removes the proxies from the renderer
+    ~RendererSceneProxies();
+
+    // Sync the proxies with the scene, then add the camera and the lights to the renderer
+    void Update();
+
+    // Remove all the proxies from the renderer, the next Update adds them again
+    void Clear();
+
+    const Stats& GetStats() const { return m_stats; }
+
+private:
+    struct Proxy
+    {
+        SceneModel* sceneModel;
+        // Model and transform sent to the renderer, to find the changes. The model is kept alive until the proxy is removed
+        std::shared_ptr<const Model> model;
+        const Transform* transform;
+        unsigned int version;
+        Renderer::ProxyId proxyId;
+    };
+
+    // Match the proxies with the models of the scene, after nodes were added or removed
+    void CollectNodes();
+
+    void AddProxy(Proxy& proxy);
+    void RemoveProxy(Proxy& proxy);
+
+private:
+    Renderer& m_renderer;
+    Scene& m_scene;
+
+    // Nodes version of the scene when the nodes were collected
+    unsigned int m_nodesVersion;
+    bool m_nodesCollected;
+
+    std::vector<Proxy> m_proxies;
+
+    Stats m_stats;
+};
@@ -1,24 +1,42 @@
 #pragma once
 
-#include <ituGL/scene/SceneVisitor.h>
+#include <vector>
 
 class Renderer;
+class Scene;
+class FrustumBounds;
 class SceneCamera;
 class SceneLight;
 class SceneModel;
 class Transform;
 
-class RendererSceneVisitor : public SceneVisitor
+// Adds the scene to the renderer. Models outside the camera frustum are culled
+// The scene is walked by node type with Scene::ForEach, so there are no virtual calls per node
+class RendererSceneVisitor
 {
 public:
     RendererSceneVisitor(Renderer& renderer);
+    // Adds the models that were waiting for a camera, without culling
+    ~RendererSceneVisitor();
 
-    void VisitCamera(SceneCamera& sceneCamera) override;
+    // Add the cameras, the lights and the models of the scene. The cameras go first, so the models are culled as they come
+    void VisitScene(Scene& scene);
+    // Same, but only the models intersecting the frustum, found with the BVH of the scene if enabled
+    void VisitScene(Scene& scene, const FrustumBounds& frustum);
 
-    void VisitLight(SceneLight& sceneLight) override;
+    void VisitCamera(SceneCamera& sceneCamera);
 
-    void VisitModel(SceneModel& sceneModel) override;
+    void VisitLight(SceneLight& sceneLight);
+
+    void VisitModel(SceneModel& sceneModel);
+
+private:
+    // Cull the model and, if visible, add it to the renderer
+    void AddModel(const SceneModel& sceneModel);
 
 private:
     Renderer& m_renderer;
+
+    // Models visited before the camera, they can't be culled yet
+    std::vector<const SceneModel*> m_pendingModels;
 };
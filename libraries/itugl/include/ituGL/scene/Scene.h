@@ -1,12 +1,22 @@
 #pragma once
 
+#include <ituGL/scene/SceneBvh.h>
+#include <ituGL/scene/SceneNode.h>
 #include <unordered_map>
+#include <vector>
 #include <string>
 #include <memory>
+#include <span>
+#include <type_traits>
 
-class SceneNode;
 class SceneVisitor;
+class SceneModel;
+class SceneLight;
+class SceneCamera;
 
+// Nodes are stored in a slot map: each one gets a slot and a handle that stays valid until it is removed.
+// The live nodes are also kept in dense arrays, all of them and one per type, so traversals are linear walks.
+// Names are unique, and found through a side index from name to handle
 class Scene
 {
 public:
@@ -14,15 +24,178 @@ public:
     ~Scene();
 
     std::shared_ptr<SceneNode> GetSceneNode(const std::string& name) const;
+    // Null if the handle is stale
+    std::shared_ptr<SceneNode> GetSceneNode(SceneNodeHandle handle) const;
 
-    bool AddSceneNode(std::shared_ptr<SceneNode> node);
+    // Handle of the node with this name, or a stale handle if there is none
+    SceneNodeHandle FindSceneNode(const std::string& name) const;
+
+    // True if the handle refers to a node still in the scene
+    bool IsValid(SceneNodeHandle handle) const;
+
+    SceneNodeHandle AddSceneNode(std::shared_ptr<SceneNode> node);
 
     bool RemoveSceneNode(std::shared_ptr<SceneNode> node);
     bool RemoveSceneNode(const std::string& name);
+    bool RemoveSceneNode(SceneNodeHandle handle);
+
+    // Incremented when nodes are added or removed
+    unsigned int GetNodesVersion() const;
+
+    // Live nodes, all of them and by type. Order changes when nodes are removed
+    std::span<SceneNode* const> GetNodes() const { return m_nodes; }
+    std::span<SceneModel* const> GetModels() const { return m_models; }
+    std::span<SceneLight* const> GetLights() const { return m_lights; }
+    std::span<SceneCamera* const> GetCameras() const { return m_cameras; }
+
+    // Split the nodes between the models and the rest
+    void CollectNodes(std::vector<SceneModel*>& sceneModels, std::vector<SceneNode*>& otherNodes);
+
+    // Call function with each live node of type T: SceneModel, SceneLight, SceneCamera, or SceneNode for all of them
+    // The nodes come from the array of their type, so there is no virtual call per node and the function can be inlined
+    template<typename T, typename F>
+    void ForEach(F&& function);
+    // Same, with const nodes
+    template<typename T, typename F>
+    void ForEach(F&& function) const;
+
+    // Call function with each model intersecting the frustum, found with the BVH if enabled, otherwise with all the models
+    template<typename F>
+    void ForEachModel(const FrustumBounds& frustum, F&& function);
 
     void AcceptVisitor(SceneVisitor& visitor);
     void AcceptVisitor(SceneVisitor& visitor) const;
 
+    // Visit all the nodes that are not models, and only the models intersecting the frustum
+    // Uses the BVH if enabled, otherwise it visits all the nodes
+    void AcceptVisitor(SceneVisitor& visitor, const FrustumBounds& frustum);
+
+    // Enable the bounding volume hierarchy over the models, for spatial queries
+    bool IsBvhEnabled() const;
+    void SetBvhEnabled(bool enabled);
+
+    // Get the BVH, rebuilt if nodes were added or removed, and refitted to the current transforms
+    const SceneBvh& UpdateBvh();
+
 private:
-    std::unordered_map<std::string, std::shared_ptr<SceneNode>> m_nodes;
+    friend class SceneNode;
+
+    // Type array a node is stored in, besides the array of all nodes
+    enum class NodeType
+    {
+        Model,
+        Light,
+        Camera,
+        Other
+    };
+
+    struct Slot
+    {
+        std::shared_ptr<SceneNode> node;
+        // Incremented when the node is removed, so old handles become stale
+        unsigned int generation = 1;
+        NodeType type = NodeType::Other;
+        // Position in m_nodes and in the array of its type
+        unsigned int nodeIndex = 0;
+        unsigned int typeIndex = 0;
+    };
+
+    // Slot of a live node, null if the handle is stale
+    const Slot* GetSlot(SceneNodeHandle handle) const;
+
+    // Update the name index, called by SceneNode::Rename
+    void RenameSceneNode(const SceneNode& node, const std::string& name);
+
+    // Dense array of the nodes of type T, see ForEach
+    template<typename T>
+    std::span<T* const> GetNodesOfType() const;
+
+    // Remove the element at index by moving the last one into its place, and fix the slot of the moved node
+    template<typename T>
+    void RemoveDense(std::vector<T*>& nodes, unsigned int index, unsigned int Slot::* slotIndex);
+
+    // Rebuild the BVH and the list of nodes that are not models
+    void RebuildBvh();
+
+    // Models in the BVH intersecting the frustum. Valid until the next query
+    std::span<SceneModel* const> QueryBvh(const FrustumBounds& frustum);
+
+private:
+    std::vector<Slot> m_slots;
+    std::vector<unsigned int> m_freeSlots;
+
+    // Dense arrays of the live nodes
+    std::vector<SceneNode*> m_nodes;
+    std::vector<SceneModel*> m_models;
+    std::vector<SceneLight*> m_lights;
+    std::vector<SceneCamera*> m_cameras;
+    std::vector<SceneNode*> m_otherNodes;
+
+    std::unordered_map<std::string, SceneNodeHandle> m_nameIndex;
+
+    unsigned int m_nodesVersion;
+
+    bool m_bvhEnabled;
+    // Nodes were added or removed since the BVH was built
+    bool m_bvhDirty;
+    SceneBvh m_bvh;
+    // Nodes that are not in the BVH, visited always
+    std::vector<SceneNode*> m_nonBvhNodes;
+    // Result of the last BVH query, kept to reuse the memory
+    std::vector<SceneModel*> m_visibleModels;
 };
+
+template<typename T>
+std::span<T* const> Scene::GetNodesOfType() const
+{
+    if constexpr (std::is_same_v<T, SceneModel>)
+    {
+        return m_models;
+    }
+    else if constexpr (std::is_same_v<T, SceneLight>)
+    {
+        return m_lights;
+    }
+    else if constexpr (std::is_same_v<T, SceneCamera>)
+    {
+        return m_cameras;
+    }
+    else
+    {
+        static_assert(std::is_same_v<T, SceneNode>, "Nodes are stored as models, lights, cameras or all of them");
+        return m_nodes;
+    }
+}
+
+template<typename T, typename F>
+void Scene::ForEach(F&& function)
+{
+    for (T* node : GetNodesOfType<T>())
+    {
+        function(*node);
+    }
+}
+
+template<typename T, typename F>
+void Scene::ForEach(F&& function) const
+{
+    for (const T* node : GetNodesOfType<T>())
+    {
+        function(*node);
+    }
+}
+
+template<typename F>
+void Scene::ForEachModel(const FrustumBounds& frustum, F&& function)
+{
+    if (!m_bvhEnabled)
+    {
+        ForEach<SceneModel>(function);
+        return;
+    }
+
+    for (SceneModel* sceneModel : QueryBvh(frustum))
+    {
+        function(*sceneModel);
+    }
+}
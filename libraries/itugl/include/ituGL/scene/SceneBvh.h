@@ -0,0 +1,93 @@
+#pragma once
+
+#include <ituGL/scene/Bounds.h>
+#include <vector>
+#include <memory>
+
+class SceneModel;
+class Transform;
+class Model;
+
+// Bounding volume hierarchy over the world AABBs of the models in a scene
+// Nodes are stored in depth-first order, so queries read memory mostly forward
+// When transforms or model bounds change, the bounds are refitted without changing the tree. The tree is rebuilt when models are added or removed
+class SceneBvh
+{
+public:
+    SceneBvh();
+
+    // Build the tree from scratch
+    void Build(const std::vector<SceneModel*>& sceneModels);
+
+    // Refit the bounds of the models whose transform, model or model bounds changed since the last update, and of their ancestors
+    // Returns the number of models refitted
+    unsigned int Update();
+
+    // Number of models in the tree
+    inline unsigned int GetModelCount() const { return static_cast<unsigned int>(m_items.size()); }
+
+    // Bounds of all the models
+    AabbBounds GetBounds() const;
+
+    // Append to results the models whose bounds intersect the query, in depth-first order
+    void QueryFrustum(const FrustumBounds& frustum, std::vector<SceneModel*>& results) const;
+    void QueryOverlap(const SphereBounds& sphere, std::vector<SceneModel*>& results) const;
+    void QueryOverlap(const AabbBounds& aabb, std::vector<SceneModel*>& results) const;
+
+    // Append to results the models whose bounds are hit by the ray, sorted by distance along the ray
+    void QueryRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, std::vector<SceneModel*>& results) const;
+
+private:
+    // Maximum number of models in a leaf
+    static const unsigned int MaxLeafSize = 4;
+
+    struct Node
+    {
+        glm::vec3 min;
+        glm::vec3 max;
+        // Parent node, -1 for the root
+        int parent;
+        // For inner nodes, index of the second child. The first child is the next node
+        // For leaves, index of the first item
+        int index;
+        // Number of items in a leaf, 0 for inner nodes
+        unsigned int count;
+    };
+
+    struct Item
+    {
+        SceneModel* sceneModel;
+        // Transform and its version when the bounds were computed
+        const Transform* transform;
+        unsigned int version;
+        // Model and its bounds version when the bounds were computed
+        const Model* model;
+        unsigned int modelVersion;
+        glm::vec3 min;
+        glm::vec3 max;
+        glm::vec3 centroid;
+        // Leaf that contains the item
+        int leaf;
+    };
+
+private:
+    // Build the subtree of the items in [begin, end). Returns the index of its root
+    int BuildNode(unsigned int begin, unsigned int end, int parent);
+
+    // Recompute the bounds of an item from its model
+    static void UpdateItemBounds(Item& item);
+
+    // True if the transform, the model or the model bounds changed since the bounds of the item were computed
+    static bool IsItemChanged(const Item& item);
+
+    // Recompute the bounds of a node from its children or items
+    void RefitNode(Node& node, int nodeIndex);
+
+    // Traverse the nodes intersecting the bounds, calling visit for each item in them
+    template<typename T, typename F>
+    void Traverse(const T& isInside, F&& visit) const;
+
+private:
+    std::vector<Node> m_nodes;
+    std::vector<Item> m_items;
+};
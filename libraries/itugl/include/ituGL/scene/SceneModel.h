@@ -18,6 +18,7 @@ public:
     //int GetDrawcallCount() const override;
     //const Drawcall& GetDrawcall(int index, const VertexArrayObject*& vao, const Material*& material) const override;
 
+    // World bounds, from the local bounds of the model. Cached until the transform or the model bounds change
     SphereBounds GetSphereBounds() const override;
     AabbBounds GetAabbBounds() const override;
     BoxBounds GetBoxBounds() const override;
@@ -25,6 +26,20 @@ public:
     void AcceptVisitor(SceneVisitor& visitor) override;
     void AcceptVisitor(SceneVisitor& visitor) const override;
 
+private:
+    // Recompute the world bounds if the transform, the model or its bounds changed
+    void UpdateBounds() const;
+
 private:
     std::shared_ptr<Model> m_model;
+
+    mutable SphereBounds m_sphereBounds;
+    mutable AabbBounds m_aabbBounds;
+    mutable BoxBounds m_boxBounds;
+
+    // What the cached bounds were computed from
+    mutable const Transform* m_boundsTransform;
+    mutable const Model* m_boundsModel;
+    mutable unsigned int m_boundsTransformVersion;
+    mutable unsigned int m_boundsModelVersion;
 };
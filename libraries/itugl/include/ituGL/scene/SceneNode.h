@@ -8,6 +8,16 @@ class Scene;
 class SceneVisitor;
 class Transform;
 
+// Stable reference to a node of a scene, returned by Scene::AddSceneNode. It becomes stale when the node is removed,
+// even if its slot is reused by another node, see Scene::IsValid
+struct SceneNodeHandle
+{
+    unsigned int index = ~0u;
+    unsigned int generation = 0;
+
+    bool operator==(const SceneNodeHandle& other) const = default;
+};
+
 class SceneNode
 {
 public:
@@ -19,6 +29,9 @@ public:
     const std::string& GetName() const;
     void Rename(const std::string& name);
 
+    // Handle in the owner scene, if any
+    SceneNodeHandle GetHandle() const;
+
     std::shared_ptr<Transform> GetTransform();
     std::shared_ptr<const Transform> GetTransform() const;
     void SetTransform(std::shared_ptr<Transform> transform);
@@ -34,9 +47,10 @@ private:
     friend class Scene;
 
     Scene* GetOwnerScene() const;
-    void SetOwnerScene(Scene* scene);
+    void SetOwnerScene(Scene* scene, SceneNodeHandle handle = SceneNodeHandle());
 
     Scene* m_scene;
+    SceneNodeHandle m_handle;
 
 protected:
     std::string m_name;
@@ -1,25 +1,36 @@
 #pragma once
 
 #include <glm/vec3.hpp>
+#include <glm/mat3x3.hpp>
 #include <glm/mat4x4.hpp>
+#include <glm/gtc/quaternion.hpp>
 #include <memory>
 
+// Translation, rotation and scale of a node, relative to an optional parent. The world matrix is computed when it is
+// requested, and cached until this transform or a parent changes. For many nodes, see TransformHierarchy
 class Transform
 {
 public:
     Transform();
 
     inline glm::vec3 GetTranslation() const { return m_translation; }
-    inline void SetTranslation(const glm::vec3& translation) { m_translation = translation; m_dirty = true; }
+    inline void SetTranslation(const glm::vec3& translation) { m_translation = translation; UpdateVersion(); }
 
+    // Euler angles in radians, applied around Y, then X, then Z. Stored as a quaternion, and kept as set
     inline glm::vec3 GetRotation() const { return m_rotation; }
-    inline void SetRotation(const glm::vec3& rotation) { m_rotation = rotation; m_dirty = true; }
+    void SetRotation(const glm::vec3& rotation);
+
+    inline const glm::quat& GetRotationQuaternion() const { return m_rotationQuaternion; }
+    void SetRotationQuaternion(const glm::quat& rotation);
+
+    // Rotation as a 3x3 matrix, cached when the rotation changes
+    inline const glm::mat3& GetRotationBasis() const { return m_rotationBasis; }
 
     inline glm::vec3 GetScale() const { return m_scale; }
-    inline void SetScale(const glm::vec3& scale) { m_scale = scale; m_dirty = true; }
+    inline void SetScale(const glm::vec3& scale) { m_scale = scale; UpdateVersion(); }
 
     inline std::shared_ptr<Transform> GetParent() const { return m_parent; }
-    inline void SetParent(std::shared_ptr<Transform> parent) { m_parent = parent; m_dirty = true; }
+    inline void SetParent(std::shared_ptr<Transform> parent) { m_parent = parent; UpdateVersion(); }
 
     glm::mat4 GetTranslationMatrix() const;
     glm::mat4 GetRotationMatrix() const;
@@ -27,16 +38,32 @@ public:
 
     glm::mat4 GetTransformMatrix() const;
 
+    // True if the cached matrix is out of date
     bool IsDirty() const;
 
+    // Increases every time this transform or a parent changes, or the parent is replaced
+    unsigned int GetVersion() const;
+
+private:
+    // Take a new version from the counter shared by all the transforms
+    inline void UpdateVersion() { m_version = ++s_lastVersion; }
+
 private:
     glm::vec3 m_translation;
     glm::vec3 m_rotation;
+    glm::quat m_rotationQuaternion;
+    glm::mat3 m_rotationBasis;
     glm::vec3 m_scale;
 
     std::shared_ptr<Transform> m_parent;
 
-    // Cached matrix
+    // Cached matrix, and the version it was computed for. Comparing versions, instead of a dirty flag cleared by the
+    // parent, keeps the matrices of all the children correct when the parent changes
     mutable glm::mat4 m_matrix;
-    mutable bool m_dirty;
+    mutable unsigned int m_matrixVersion;
+
+    // Version of the last change to this transform. Versions come from a single counter, so the newest of this
+    // transform and its parents is different after any change, even if the parent is replaced by an older one
+    unsigned int m_version;
+    static unsigned int s_lastVersion;
 };
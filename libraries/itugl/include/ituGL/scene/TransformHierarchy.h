@@ -0,0 +1,78 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+#include <glm/mat4x4.hpp>
+#include <vector>
+#include <span>
+
+// Batched alternative to Transform, for hierarchies with many nodes. The local translation, rotation and scale are kept
+// in separate arrays, with every parent before its children, so Update computes the world matrices in one linear sweep,
+// only for the nodes that changed and their descendants.
+// Consecutive nodes that don't depend on each other form a run, and big runs are split between threads
+class TransformHierarchy
+{
+public:
+    using Handle = unsigned int;
+    static const Handle InvalidHandle = ~0u;
+
+public:
+    TransformHierarchy();
+
+    // Add a node with the identity transform, as a child of parent or as a root
+    // Handles are consecutive, so the parent of a node is always before it
+    Handle Add(Handle parent = InvalidHandle);
+    void Clear();
+
+    inline unsigned int GetCount() const { return static_cast<unsigned int>(m_parents.size()); }
+    inline Handle GetParent(Handle handle) const { return m_parents[handle]; }
+
+    inline const glm::vec3& GetTranslation(Handle handle) const { return m_translations[handle]; }
+    inline void SetTranslation(Handle handle, const glm::vec3& translation) { m_translations[handle] = translation; SetDirty(handle); }
+
+    // Euler angles in radians, applied in the same order as Transform
+    inline const glm::vec3& GetRotation(Handle handle) const { return m_rotations[handle]; }
+    inline void SetRotation(Handle handle, const glm::vec3& rotation) { m_rotations[handle] = rotation; SetDirty(handle); }
+
+    inline const glm::vec3& GetScale(Handle handle) const { return m_scales[handle]; }
+    inline void SetScale(Handle handle, const glm::vec3& scale) { m_scales[handle] = scale; SetDirty(handle); }
+
+    // Number of threads used by Update. 0 uses one per hardware thread
+    inline unsigned int GetThreadCount() const { return m_threadCount; }
+    inline void SetThreadCount(unsigned int threadCount) { m_threadCount = threadCount; }
+
+    // Compute the world matrices of the changed nodes and their descendants. Returns the number of matrices computed
+    unsigned int Update();
+
+    // World matrices computed by the last Update
+    inline const glm::mat4& GetWorldMatrix(Handle handle) const { return m_worldMatrices[handle]; }
+    inline std::span<const glm::mat4> GetWorldMatrices() const { return m_worldMatrices; }
+
+private:
+    inline void SetDirty(Handle handle) { m_dirty[handle] = 1; m_anyDirty = true; }
+
+    // Update the nodes in [first, last), whose parents are already up to date. Returns the number of matrices computed
+    unsigned int UpdateRange(Handle first, Handle last);
+
+    // Same as Transform: translation * rotation Y * rotation X * rotation Z * scale
+    static glm::mat4 ComputeLocalMatrix(const glm::vec3& translation, const glm::vec3& rotation, const glm::vec3& scale);
+
+    // result = a * b
+    static void Multiply(const glm::mat4& a, const glm::mat4& b, glm::mat4& result);
+
+private:
+    std::vector<glm::vec3> m_translations;
+    std::vector<glm::vec3> m_rotations;
+    std::vector<glm::vec3> m_scales;
+    std::vector<Handle> m_parents;
+
+    // Set when the local transform changes, and by Update when the parent changed. Cleared at the end of Update
+    std::vector<unsigned char> m_dirty;
+    bool m_anyDirty;
+
+    std::vector<glm::mat4> m_worldMatrices;
+
+    // First node of each run. No node in a run has its parent in the same run
+    std::vector<Handle> m_runStarts;
+
+    unsigned int m_threadCount;
+};
@@ -6,6 +6,8 @@
 #include <functional>
 #include <array>
 
+class CommandBuffer;
+
 // Class to group all the properties that may affect the look of a rendered geometry
 class Material : public ShaderUniformCollection
 {
@@ -19,6 +21,20 @@ public:
         OverrideStencilTest = 1 << 2
     };
 
+    // Compact description of the material, so the renderer can route drawcalls with a mask instead of a function
+    // Opaque, Blended and DepthWrite follow the render states and are updated when they change. The rest are set with
+    // SetCapability, and UserCapability and the bits above it are free for the application
+    enum Capabilities : unsigned int
+    {
+        NoCapabilities = 0,
+        Opaque = 1 << 0,
+        Blended = 1 << 1,
+        DepthWrite = 1 << 2,
+        ShadowCaster = 1 << 3,
+        Deferred = 1 << 4,
+        UserCapability = 1 << 8
+    };
+
     // Different conditions for depth and stencil tests
     enum class TestFunction : GLenum;
 
@@ -45,6 +61,14 @@ public:
     void SetShaderSetupFunction(ShaderSetupFunction shaderSetupFunction);
 
 
+    // Capability bits of the material. By default: Opaque, DepthWrite and ShadowCaster
+    inline unsigned int GetCapabilities() const { return m_capabilities; }
+    inline bool HasCapabilities(unsigned int capabilities) const { return (m_capabilities & capabilities) == capabilities; }
+
+    // Set the capabilities that don't come from the render states
+    void SetCapability(Capabilities capability, bool enabled);
+
+
     // The test function for the depth test, if depth test is enabled
     TestFunction GetDepthTestFunction() const;
     void SetDepthTestFunction(TestFunction function);
@@ -126,20 +150,48 @@ public:
     // You can skip depth, stencil or blending using the override flags
     void Use(OverrideFlags overrideFlags = OverrideFlags::NoOverride) const;
 
+    // The 3 steps of Use, so they can be skipped separately when they are redundant
+    // Set all uniforms and run the shader setup function. Requires the shader program to be in use
+    void UseProperties() const;
+    // Same, but skipping the textures that are already bound (see ShaderUniformCollection::SetUniforms)
+    void UseProperties(std::span<const TextureObject*> boundTextures, unsigned int& texturesBound, unsigned int& texturesSkipped) const;
+    // Set depth properties, stencil properties, and blending, unless skipped with the override flags
+    void UseRenderStates(OverrideFlags overrideFlags = OverrideFlags::NoOverride) const;
+
+    // Record the same commands as Use into the command buffer. The shader setup function is recorded as a function call
+    void Record(CommandBuffer& commandBuffer, OverrideFlags overrideFlags = OverrideFlags::NoOverride) const;
+    // Record the same commands as UseProperties
+    void RecordProperties(CommandBuffer& commandBuffer) const;
+    // Record the render states, unless skipped with the override flags
+    void RecordRenderStates(CommandBuffer& commandBuffer, OverrideFlags overrideFlags = OverrideFlags::NoOverride) const;
+
 private:
+    // Set the render states in the target, that can be the device or a command buffer
+    template<typename T>
+    void SetRenderStates(T& target, OverrideFlags overrideFlags) const;
+
     // Set all the properties relative to depth
-    void UseDepthTest() const;
+    template<typename T>
+    void SetDepthTest(T& target) const;
 
     // Set all the properties relative to stencil
-    void UseStencilTest() const;
+    template<typename T>
+    void SetStencilTest(T& target) const;
 
     // Set all the properties relative to blending
-    void UseBlend() const;
+    template<typename T>
+    void SetBlend(T& target) const;
+
+    // Update the capabilities that come from the render states
+    void UpdateCapabilities();
 
 private:
     // Function pointer to prepare the shader used by the material
     ShaderSetupFunction m_shaderSetupFunction;
 
+    // Capabilities bitmask, see Capabilities
+    unsigned int m_capabilities;
+
     // Test function for depth. Default: Less
     TestFunction m_depthTestFunction;
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <ituGL/core/Object.h>
+#include <ituGL/core/Data.h>
 
 // Include the glm types for vectors and matrices
 #include <glm/vec2.hpp>
@@ -20,6 +21,7 @@
 
 class Shader;
 class TextureObject;
+class CommandBuffer;
 
 // ShaderProgram is an OpenGL Object that represents all the shaders needed to draw primitives
 class ShaderProgram : public Object
@@ -84,6 +86,12 @@ public:
     // Find a uniform location by name
     Location GetUniformLocation(const char *name) const;
 
+    // Find the index of a uniform block by name. Returns GL_INVALID_INDEX if it doesn't exist
+    GLuint GetUniformBlockIndex(const char* name) const;
+
+    // Assign a uniform block to a binding point. The block reads from the buffer bound to that binding point
+    void SetUniformBlockBinding(GLuint blockIndex, GLuint bindingIndex) const;
+
     // Get how many uniforms exist in this shader program
     unsigned int GetUniformCount() const;
 
@@ -113,6 +121,10 @@ public:
     // Set texture value for a texture uniform
     void SetTexture(Location location, GLint textureUnit, const TextureObject& texture) const;
 
+    // While a command buffer is set, SetUniform and SetUniforms record the values in it instead of setting them, for code
+    // that only knows ShaderProgram, like the update functions of the renderer. Per thread, set nullptr to stop
+    static void SetRecordingCommandBuffer(CommandBuffer* commandBuffer);
+
     // Set the shader program as the active one to be used for rendering
     void Use() const;
 
@@ -138,7 +150,12 @@ private:
     template<typename T, int C, int R>
     void SetUniforms(Location location, const T* values, GLsizei count) const;
 
+    // Add the values to the recording command buffer
+    static void RecordUniforms(Location location, Data::Type type, int components, int columns, GLsizei count, const void* values);
+
 private:
+    static thread_local CommandBuffer* s_recordingCommandBuffer;
+
 #ifndef NDEBUG
     inline bool IsUsed() const { return s_usedHandle == GetHandle(); }
     static Handle s_usedHandle;
@@ -190,18 +207,33 @@ void ShaderProgram::SetUniform(Location location, const T& value) const
 template<typename T>
 void ShaderProgram::SetUniforms(Location location, std::span<const T> values) const
 {
+    if (s_recordingCommandBuffer)
+    {
+        RecordUniforms(location, Data::GetType<T>(), 1, 1, static_cast<GLsizei>(values.size()), values.data());
+        return;
+    }
     SetUniforms<T, 1>(location, &values[0], static_cast<GLsizei>(values.size()));
 }
 
 template<typename T, int N>
 void ShaderProgram::SetUniforms(Location location, std::span<const glm::vec<N, T>> values) const
 {
+    if (s_recordingCommandBuffer)
+    {
+        RecordUniforms(location, Data::GetType<T>(), N, 1, static_cast<GLsizei>(values.size()), values.data());
+        return;
+    }
     SetUniforms<T, N>(location, &values[0][0], static_cast<GLsizei>(values.size()));
 }
 
 template<typename T, int C, int R>
 void ShaderProgram::SetUniforms(Location location, std::span<const glm::mat<C, R, T>> values) const
 {
+    if (s_recordingCommandBuffer)
+    {
+        RecordUniforms(location, Data::GetType<T>(), R, C, static_cast<GLsizei>(values.size()), values.data());
+        return;
+    }
     SetUniforms<T, C, R>(location, &values[0][0][0], static_cast<GLsizei>(values.size()));
 }
 
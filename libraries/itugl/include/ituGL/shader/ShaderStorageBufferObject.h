@@ -0,0 +1,48 @@
+#pragma once
+
+#include <ituGL/core/BufferObject.h>
+#include <ituGL/core/Data.h>
+
+// Shader Storage Buffer Object (SSBO) is the common term for a BufferObject when shaders read and write it as an array
+// of structs, declared with layout (std430). Like uniform blocks, it is bound to a binding point. Requires GL 4.3
+class ShaderStorageBufferObject : public BufferObjectBase<BufferObject::ShaderStorageBuffer>
+{
+public:
+    ShaderStorageBufferObject();
+
+    // Use the same AllocateData methods from the base class
+    using BufferObject::AllocateData;
+    // Additionally, provide AllocateData template method for any type of data span
+    template<typename T>
+    void AllocateData(std::span<const T> data, Usage usage = Usage::StreamDraw);
+    template<typename T>
+    inline void AllocateData(std::span<T> data, Usage usage = Usage::StreamDraw) { AllocateData(std::span<const T>(data), usage); }
+
+    // Use the same UpdateData methods from the base class
+    using BufferObject::UpdateData;
+    // Additionally, provide UpdateData template method for any type of data span
+    template<typename T>
+    void UpdateData(std::span<const T> data, size_t offsetBytes = 0);
+    template<typename T>
+    inline void UpdateData(std::span<T> data, size_t offsetBytes = 0) { UpdateData(std::span<const T>(data), offsetBytes); }
+
+    // Bind the whole buffer to the storage block binding point
+    void BindBase(GLuint bindingIndex) const;
+
+    // Bind a buffer of any other target to the storage block binding point, so shaders can write vertices or commands
+    static void BindBase(GLuint bindingIndex, const BufferObject& buffer);
+};
+
+// Call the base implementation with the span converted to bytes
+template<typename T>
+void ShaderStorageBufferObject::AllocateData(std::span<const T> data, Usage usage)
+{
+    AllocateData(Data::GetBytes(data), usage);
+}
+
+// Call the base implementation with the span converted to bytes
+template<typename T>
+void ShaderStorageBufferObject::UpdateData(std::span<const T> data, size_t offsetBytes)
+{
+    UpdateData(Data::GetBytes(data), offsetBytes);
+}
@@ -10,6 +10,8 @@
 #include <cstring>
 #include <memory>
 
+class CommandBuffer;
+
 class ShaderUniformCollection
 {
 public:
@@ -71,6 +73,13 @@ public:
     // Set all the properties to the shader. Requires the shader program to be in use
     void SetUniforms() const;
 
+    // Same as SetUniforms, but skips binding textures that are already bound to their texture unit
+    // boundTextures holds the texture currently bound to each unit, and is updated with the new bindings
+    void SetUniforms(std::span<const TextureObject*> boundTextures, unsigned int& texturesBound, unsigned int& texturesSkipped) const;
+
+    // Record all the properties into the command buffer, after the shader program
+    void RecordUniforms(CommandBuffer& commandBuffer) const;
+
 private:
     // Different dimensions of the properties
     enum class UniformDimension
@@ -140,6 +149,7 @@ private:
     template<typename T>
     void UseUniform(const DataUniform& uniform) const;
     void UseUniform(const TextureUniform& uniform) const;
+    void UseUniform(const TextureUniform& uniform, std::span<const TextureObject*> boundTextures, unsigned int& texturesBound, unsigned int& texturesSkipped) const;
 
     // Get the buffer where data values are stored for a certain type
     template<typename T>
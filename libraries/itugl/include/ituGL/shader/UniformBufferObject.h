@@ -0,0 +1,130 @@
+#pragma once
+
+#include <ituGL/core/BufferObject.h>
+#include <ituGL/core/Data.h>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+#include <vector>
+#include <cstddef>
+
+// Uniform Buffer Object (UBO) is the common term for a BufferObject when it stores the values of a uniform block
+// The buffer is bound to a binding point, and all the programs with a block assigned to that binding point read from it
+class UniformBufferObject : public BufferObjectBase<BufferObject::UniformBuffer>
+{
+public:
+    class Std140Writer;
+
+public:
+    UniformBufferObject();
+
+    // Use the same AllocateData methods from the base class
+    using BufferObject::AllocateData;
+    // Additionally, provide AllocateData with DynamicDraw as default usage, uniforms usually change every frame
+    void AllocateData(size_t size);
+
+    // Use the same UpdateData methods from the base class
+    using BufferObject::UpdateData;
+    // Additionally, provide UpdateData template method for any type of data span
+    template<typename T>
+    void UpdateData(std::span<const T> data, size_t offsetBytes = 0);
+    template<typename T>
+    inline void UpdateData(std::span<T> data, size_t offsetBytes = 0) { UpdateData(std::span<const T>(data), offsetBytes); }
+
+    // Bind the whole buffer to the uniform block binding point
+    void BindBase(GLuint bindingIndex) const;
+
+    // Bind a range of the buffer to the uniform block binding point. offset must be a multiple of GetOffsetAlignment()
+    void BindRange(GLuint bindingIndex, size_t offset, size_t size) const;
+
+    // Required alignment of the offset in BindRange
+    static size_t GetOffsetAlignment();
+};
+
+// Call the base implementation with the span converted to bytes
+template<typename T>
+void UniformBufferObject::UpdateData(std::span<const T> data, size_t offsetBytes)
+{
+    UpdateData(Data::GetBytes(data), offsetBytes);
+}
+
+
+// Packs values following the std140 layout rules, so they can be copied to a uniform block declared with layout (std140)
+// Values must be written in the same order as the members of the block. Each Write returns the offset of the value
+// - Scalars are aligned to 4 bytes, vec2 to 8, vec3 and vec4 to 16. A scalar can use the padding after a vec3
+// - Matrices are stored as arrays of column vectors, each column aligned to 16 bytes
+// - Elements of arrays are aligned to 16 bytes
+// - bool is stored as a 4 byte integer
+class UniformBufferObject::Std140Writer
+{
+public:
+    Std140Writer();
+
+    // Remove the values, keeping the memory allocated
+    void Clear();
+
+    // Bytes written so far
+    inline std::span<const std::byte> GetData() const { return m_data; }
+    inline size_t GetSize() const { return m_data.size(); }
+
+    size_t Write(float value);
+    size_t Write(int value);
+    size_t Write(unsigned int value);
+    size_t Write(bool value);
+    template<typename T, int N>
+    size_t Write(const glm::vec<N, T>& value);
+    template<int C, int R>
+    size_t Write(const glm::mat<C, R, float>& value);
+
+    // Write an array. Every element starts on a 16 bytes boundary
+    template<typename T>
+    size_t WriteArray(std::span<const T> values);
+
+    // Pad the size to 16 bytes, as required after an array or at the end of a struct
+    void EndStruct();
+
+private:
+    // Add padding until the size is a multiple of alignment. Returns the new size
+    size_t Align(size_t alignment);
+
+    // Append the bytes at the end
+    void Append(const void* data, size_t size);
+
+private:
+    std::vector<std::byte> m_data;
+};
+
+template<typename T, int N>
+size_t UniformBufferObject::Std140Writer::Write(const glm::vec<N, T>& value)
+{
+    static_assert(sizeof(T) == 4, "Only 32 bits components are supported");
+    size_t offset = Align(N == 2 ? 8 : 16);
+    Append(&value[0], N * sizeof(T));
+    return offset;
+}
+
+template<int C, int R>
+size_t UniformBufferObject::Std140Writer::Write(const glm::mat<C, R, float>& value)
+{
+    size_t offset = Align(16);
+    for (int column = 0; column < C; ++column)
+    {
+        Append(&value[column][0], R * sizeof(float));
+        Align(16);
+    }
+    return offset;
+}
+
+template<typename T>
+size_t UniformBufferObject::Std140Writer::WriteArray(std::span<const T> values)
+{
+    size_t offset = Align(16);
+    for (const T& value : values)
+    {
+        Align(16);
+        Write(value);
+    }
+    EndStruct();
+    return offset;
+}
@@ -4,6 +4,7 @@
 #include <span>
 #include <memory>
 
+class TextureObject;
 class Texture2DObject;
 
 // Abstract OpenGL object that encapsulates a Framebuffer
@@ -29,8 +30,15 @@ public:
 
     void SetTexture(Target target, Attachment attachment, const Texture2DObject& texture, int level = 0);
 
+    // Attach a single layer of an array, 3D or cubemap texture
+    void SetTextureLayer(Target target, Attachment attachment, const TextureObject& texture, int layer, int level = 0);
+
     void SetDrawBuffers(std::span<const Attachment> attachments);
 
+    // Copy the buffers in mask (GL_COLOR_BUFFER_BIT, GL_DEPTH_BUFFER_BIT, GL_STENCIL_BUFFER_BIT) from the framebuffer
+    // bound to Read to the one bound to Draw. Depth and stencil can only be copied between the same formats
+    static void Blit(GLint width, GLint height, GLbitfield mask);
+
     static std::shared_ptr<const FramebufferObject> GetDefault();
 
 private:
@@ -50,6 +58,8 @@ enum class FramebufferObject::Target : GLenum
 enum class FramebufferObject::Attachment : GLenum
 {
     Depth = GL_DEPTH_ATTACHMENT,
+    Stencil = GL_STENCIL_ATTACHMENT,
+    DepthStencil = GL_DEPTH_STENCIL_ATTACHMENT,
     Color0 = GL_COLOR_ATTACHMENT0,
     Color1 = GL_COLOR_ATTACHMENT1,
     Color2 = GL_COLOR_ATTACHMENT2,
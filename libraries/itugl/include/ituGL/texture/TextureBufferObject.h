@@ -0,0 +1,32 @@
+#pragma once
+
+#include <ituGL/texture/TextureObject.h>
+#include <ituGL/core/BufferObject.h>
+#include <ituGL/core/Data.h>
+
+// Texture that reads its texels from a buffer object, as a 1D array without filtering
+// Shaders access it with texelFetch on a samplerBuffer (float formats) or usamplerBuffer (unsigned formats)
+// It is the way to give large arrays to shaders in GL 4.1, where storage buffers are not available
+class TextureBufferObject : public TextureObjectBase<TextureObject::TextureBuffer>
+{
+public:
+    TextureBufferObject();
+
+    // Copy the data to the buffer, replacing its storage, and attach it to the texture with the internal format
+    void SetData(InternalFormat internalFormat, std::span<const std::byte> data);
+
+    // Template method to set the data with any kind of data span
+    template<typename T>
+    inline void SetData(InternalFormat internalFormat, std::span<const T> data) { SetData(internalFormat, Data::GetBytes(data)); }
+    template<typename T>
+    inline void SetData(InternalFormat internalFormat, std::span<T> data) { SetData(internalFormat, std::span<const T>(data)); }
+
+    // Size of the data, in bytes
+    inline size_t GetDataSize() const { return m_dataSize; }
+
+private:
+    // Storage of the texels
+    BufferObjectBase<BufferObject::TextureBuffer> m_buffer;
+
+    size_t m_dataSize;
+};
@@ -219,6 +219,11 @@ enum TextureObject::InternalFormat : GLint
     InternalFormatRG32F = GL_RG32F,
     InternalFormatRGB32F = GL_RGB32F,
     InternalFormatRGBA32F = GL_RGBA32F,
+    // 32-bit unsigned integer
+    InternalFormatR32UI = GL_R32UI,
+    InternalFormatRG32UI = GL_RG32UI,
+    InternalFormatRGB32UI = GL_RGB32UI,
+    InternalFormatRGBA32UI = GL_RGBA32UI,
     // sRGB
     InternalFormatSRGB8 = GL_SRGB8,
     InternalFormatSRGBA8 = GL_SRGB8_ALPHA8,
@@ -269,6 +274,8 @@ enum class TextureObject::ParameterEnum : GLenum
     SwizzleBlue = GL_TEXTURE_SWIZZLE_B,  // GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA, GL_ZERO, GL_ONE
     SwizzleAlpha = GL_TEXTURE_SWIZZLE_A, // GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA, GL_ZERO, GL_ONE
     DepthStencilMode = GL_DEPTH_STENCIL_TEXTURE_MODE, // GL_DEPTH_COMPONENT, GL_STENCIL_INDEX
+    CompareMode = GL_TEXTURE_COMPARE_MODE, // GL_NONE, GL_COMPARE_REF_TO_TEXTURE
+    CompareFunction = GL_TEXTURE_COMPARE_FUNC, // GL_LEQUAL, GL_GEQUAL, GL_LESS, GL_GREATER, GL_EQUAL, GL_NOTEQUAL, GL_ALWAYS, GL_NEVER
 };
 
 enum class TextureObject::ParameterEnumVector : GLenum
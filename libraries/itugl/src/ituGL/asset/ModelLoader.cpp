@@ -12,6 +12,7 @@
 ModelLoader::ModelLoader(std::shared_ptr<Material> referenceMaterial)
     : m_referenceMaterial(referenceMaterial)
     , m_createMaterials(false)
+    , m_geometryArena(nullptr)
 {
     m_textureLoader.SetGenerateMipmap(true);
 }
@@ -39,6 +40,16 @@ void ModelLoader::SetCreateMaterials(bool createMaterials)
     m_createMaterials = createMaterials;
 }
 
+GeometryArena* ModelLoader::GetGeometryArena() const
+{
+    return m_geometryArena;
+}
+
+void ModelLoader::SetGeometryArena(GeometryArena* geometryArena)
+{
+    m_geometryArena = geometryArena;
+}
+
 Texture2DLoader& ModelLoader::GetTexture2DLoader()
 {
     return m_textureLoader;
@@ -113,26 +124,53 @@ void ModelLoader::GenerateSubmesh(Mesh& mesh, const aiMesh& meshData)
     // Collect vertex data
     VertexFormat vertexFormat;
     bool interleaved = true;
-    std::vector<GLubyte> vertexData = CollectVertexData(meshData, vertexFormat, interleaved);
-    int vboIndex = mesh.AddVertexData<GLubyte>(vertexData);
+    glm::vec3 boundsMin, boundsMax;
+    std::vector<GLubyte> vertexData = CollectVertexData(meshData, vertexFormat, interleaved, boundsMin, boundsMax);
+    float boundsRadius = Mesh::ComputePositionRadius(meshData.mVertices, sizeof(*meshData.mVertices), meshData.mNumVertices, 0.5f * (boundsMin + boundsMax));
 
     // Collect element data
     Data::Type elementType;
     std::vector<Drawcall::Primitive> primitives;
     std::vector<int> elementCounts;
     std::vector<GLubyte> elementData = CollectElementData(meshData, elementType, primitives, elementCounts);
-    int eboIndex = mesh.AddElementData<GLubyte>(elementData);
 
-    // Add submeshes
+    // One drawcall per primitive type. Element counts are the end of each range in bytes
+    std::vector<Drawcall> drawcalls;
+    int elementSize = Data::GetTypeSize(elementType);
     int start = 0;
     assert(primitives.size() == elementCounts.size());
     for (int i = 0; i < primitives.size(); ++i)
     {
-        Drawcall::Primitive primitive = primitives[i];
         int end = elementCounts[i];
-        mesh.AddSubmesh(primitive, start, end - start, elementType, eboIndex, vboIndex, vertexFormat.LayoutBegin(static_cast<int>(vertexData.size()), interleaved), vertexFormat.LayoutEnd(), m_materialAttributeMap);
+        drawcalls.emplace_back(primitives[i], (end - start) / elementSize, elementType, start);
         start = end;
     }
+
+    unsigned int firstSubmeshIndex = mesh.GetSubmeshCount();
+
+    // Shared buffers in the arena, and a VAO shared with the meshes of the same format
+    if (m_geometryArena)
+    {
+        mesh.AddSubmeshes(*m_geometryArena, vertexFormat, vertexData, elementData, drawcalls, m_materialAttributeMap);
+    }
+    else
+    {
+        int vboIndex = mesh.AddVertexData<GLubyte>(vertexData);
+        int eboIndex = mesh.AddElementData<GLubyte>(elementData);
+
+        // Add submeshes
+        for (const Drawcall& drawcall : drawcalls)
+        {
+            mesh.AddSubmesh(drawcall.GetPrimitive(), drawcall.GetFirst(), drawcall.GetCount(), elementType, vboIndex, eboIndex,
+                vertexFormat.LayoutBegin(static_cast<int>(vertexData.size()), interleaved), vertexFormat.LayoutEnd(), m_materialAttributeMap);
+        }
+    }
+
+    // All the submeshes of the loaded mesh share the vertices, and the bounds found when they were copied
+    for (unsigned int submeshIndex = firstSubmeshIndex; submeshIndex < mesh.GetSubmeshCount(); ++submeshIndex)
+    {
+        mesh.SetSubmeshBounds(submeshIndex, boundsMin, boundsMax, boundsRadius);
+    }
 }
 
 std::shared_ptr<Material> ModelLoader::GenerateMaterial(const aiMaterial& materialData)
@@ -203,7 +241,8 @@ void ModelLoader::LoadTexture(const aiMaterial& materialData, int textureTypeVal
     }
 }
 
-std::vector<GLubyte> ModelLoader::CollectVertexData(const aiMesh& meshData, VertexFormat& vertexFormat, bool interleaved)
+std::vector<GLubyte> ModelLoader::CollectVertexData(const aiMesh& meshData, VertexFormat& vertexFormat, bool interleaved,
+    glm::vec3& boundsMin, glm::vec3& boundsMax)
 {
     vertexFormat.Clear();
 
@@ -247,7 +286,17 @@ std::vector<GLubyte> ModelLoader::CollectVertexData(const aiMesh& meshData, Vert
         int srcStride = 0;
         const void* srcBuffer = GetVertexDataPointer(meshData, attribute.GetSemantic(), srcStride);
         assert(srcBuffer);
-        CopyBuffer(dstBuffer, dstStride, srcBuffer, srcStride, meshData.mNumVertices, attribute.GetSize());
+        if (attribute.GetSemantic() == VertexAttribute::Semantic::Position)
+        {
+            // The bounds are accumulated in the same pass that copies the positions
+            boundsMin = glm::vec3(std::numeric_limits<float>::max());
+            boundsMax = glm::vec3(-std::numeric_limits<float>::max());
+            Mesh::AccumulatePositionBounds(srcBuffer, srcStride, meshData.mNumVertices, boundsMin, boundsMax, dstBuffer, dstStride);
+        }
+        else
+        {
+            CopyBuffer(dstBuffer, dstStride, srcBuffer, srcStride, meshData.mNumVertices, attribute.GetSize());
+        }
     }
 
     return vertexData;
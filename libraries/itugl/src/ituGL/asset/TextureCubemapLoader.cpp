@@ -1,6 +1,10 @@
 #include <ituGL/asset/TextureCubemapLoader.h>
 
 #include <cassert>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <vector>
 #include <stb_image.h>
 
 TextureCubemapLoader::TextureCubemapLoader()
@@ -52,7 +56,7 @@ TextureCubemapObject TextureCubemapLoader::Load(const char* path)
 
             // Adjust mip levels
             textureCubemap.SetParameter(TextureObject::ParameterFloat::MinLod, 0.0f);
-            float maxLod = 1.0f + std::floorf(std::log2f(static_cast<float>(std::max(width, height))));
+            float maxLod = 1.0f + std::floor(std::log2(static_cast<float>(std::max(width, height))));
             textureCubemap.SetParameter(TextureObject::ParameterFloat::MaxLod, maxLod);
         }
 
@@ -55,6 +55,16 @@ void BufferObject::AllocateData(std::span<const std::byte> data, Usage usage)
     glBufferData(target, data.size_bytes(), data.data(), usage);
 }
 
+// Use the copy targets, so the buffers can be bound to any other target
+void BufferObject::CopyData(const BufferObject& source, size_t sourceOffset, const BufferObject& destination, size_t destinationOffset, size_t size)
+{
+    glBindBuffer(GL_COPY_READ_BUFFER, source.GetHandle());
+    glBindBuffer(GL_COPY_WRITE_BUFFER, destination.GetHandle());
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, sourceOffset, destinationOffset, size);
+    glBindBuffer(GL_COPY_READ_BUFFER, NullHandle);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, NullHandle);
+}
+
 // Get buffer Target and set buffer subdata
 void BufferObject::UpdateData(std::span<const std::byte> data, size_t offset)
 {
@@ -10,6 +10,8 @@ DeviceGL::DeviceGL() : m_contextLoaded(false)
 {
     m_instance = this;
 
+    InvalidateState();
+
     // Init GLFW
     glfwInit();
 }
@@ -35,13 +37,51 @@ void DeviceGL::SetCurrentWindow(Window& window)
     {
         // Set callback to be called when the window is resized
         glfwSetFramebufferSizeCallback(glfwWindow, FrameBufferResized);
+
+        // A new context starts with the default state
+        ResetState();
+
+        // Viewport starts with the size of the window
+        int width, height;
+        glfwGetFramebufferSize(glfwWindow, &width, &height);
+        m_viewport = { 0, 0, width, height };
     }
 }
 
 // Set the dimensions of the viewport
 void DeviceGL::SetViewport(GLint x, GLint y, GLsizei width, GLsizei height)
 {
-    glViewport(0, 0, width, height);
+    std::array<GLint, 4> viewport = { x, y, width, height };
+    if (viewport != m_viewport)
+    {
+        glViewport(x, y, width, height);
+        m_viewport = viewport;
+    }
+}
+
+// Get the dimensions of the viewport
+void DeviceGL::GetViewport(GLint& x, GLint& y, GLsizei& width, GLsizei& height) const
+{
+    // Unknown state, only after InvalidateState. Query it once
+    if (m_viewport[0] == static_cast<GLint>(UnknownValue))
+    {
+        glGetIntegerv(GL_VIEWPORT, m_viewport.data());
+    }
+    x = m_viewport[0];
+    y = m_viewport[1];
+    width = m_viewport[2];
+    height = m_viewport[3];
+}
+
+// Set the rectangle of the scissor test, enabled with GL_SCISSOR_TEST
+void DeviceGL::SetScissor(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    std::array<GLint, 4> scissor = { x, y, width, height };
+    if (scissor != m_scissor)
+    {
+        glScissor(x, y, width, height);
+        m_scissor = scissor;
+    }
 }
 
 // Poll the events in the window event queue
@@ -85,12 +125,27 @@ void DeviceGL::Clear(bool clearColor, const Color& color, bool clearDepth, GLdou
 // Get if a feature is enabled
 bool DeviceGL::IsFeatureEnabled(GLenum feature) const
 {
-    return glIsEnabled(feature);
+    auto itFind = m_features.find(feature);
+    if (itFind != m_features.end())
+    {
+        return itFind->second;
+    }
+
+    // Unknown state, only after InvalidateState. Query it once
+    bool enabled = glIsEnabled(feature);
+    m_features[feature] = enabled;
+    return enabled;
 }
 
 // enable / disable a feature
 void DeviceGL::SetFeatureEnabled(GLenum feature, bool enabled)
 {
+    auto itFind = m_features.find(feature);
+    if (itFind != m_features.end() && itFind->second == enabled)
+    {
+        return;
+    }
+
     if (enabled)
     {
         glEnable(feature);
@@ -99,6 +154,312 @@ void DeviceGL::SetFeatureEnabled(GLenum feature, bool enabled)
     {
         glDisable(feature);
     }
+    m_features[feature] = enabled;
+}
+
+// Set the blend equation for color and alpha
+void DeviceGL::SetBlendEquation(GLenum colorEquation, GLenum alphaEquation)
+{
+    std::array<GLenum, 2> blendEquations = { colorEquation, alphaEquation };
+    if (blendEquations == m_blendEquations)
+    {
+        return;
+    }
+
+    if (colorEquation == alphaEquation)
+    {
+        glBlendEquation(colorEquation);
+    }
+    else
+    {
+        glBlendEquationSeparate(colorEquation, alphaEquation);
+    }
+    m_blendEquations = blendEquations;
+}
+
+// Set the blend parameters for color and alpha
+void DeviceGL::SetBlendFunction(GLenum sourceColor, GLenum destColor, GLenum sourceAlpha, GLenum destAlpha)
+{
+    std::array<GLenum, 4> blendFunction = { sourceColor, destColor, sourceAlpha, destAlpha };
+    if (blendFunction == m_blendFunction)
+    {
+        return;
+    }
+
+    if (sourceColor == sourceAlpha && destColor == destAlpha)
+    {
+        glBlendFunc(sourceColor, destColor);
+    }
+    else
+    {
+        glBlendFuncSeparate(sourceColor, destColor, sourceAlpha, destAlpha);
+    }
+    m_blendFunction = blendFunction;
+}
+
+// Set the color used by constant color and constant alpha blend parameters
+void DeviceGL::SetBlendColor(const Color& color)
+{
+    if (m_blendColorKnown && glm::vec4(color) == glm::vec4(m_blendColor))
+    {
+        return;
+    }
+
+    glBlendColor(color.GetRed(), color.GetGreen(), color.GetBlue(), color.GetAlpha());
+    m_blendColor = color;
+    m_blendColorKnown = true;
+}
+
+// Set the test function for the depth test
+void DeviceGL::SetDepthFunction(GLenum function)
+{
+    if (function != m_depthFunction)
+    {
+        glDepthFunc(function);
+        m_depthFunction = function;
+    }
+}
+
+// enable / disable writing to the depth buffer
+void DeviceGL::SetDepthMask(bool enabled)
+{
+    GLuint depthMask = enabled ? GL_TRUE : GL_FALSE;
+    if (depthMask != m_depthMask)
+    {
+        glDepthMask(static_cast<GLboolean>(depthMask));
+        m_depthMask = depthMask;
+    }
+}
+
+// enable / disable writing to the color buffers
+void DeviceGL::SetColorMask(bool enabled)
+{
+    GLuint colorMask = enabled ? GL_TRUE : GL_FALSE;
+    if (colorMask != m_colorMask)
+    {
+        GLboolean mask = static_cast<GLboolean>(colorMask);
+        glColorMask(mask, mask, mask, mask);
+        m_colorMask = colorMask;
+    }
+}
+
+// Set the faces discarded when GL_CULL_FACE is enabled
+void DeviceGL::SetCullFace(GLenum face)
+{
+    if (face != m_cullFace)
+    {
+        glCullFace(face);
+        m_cullFace = face;
+    }
+}
+
+// Set the depth offset applied when GL_POLYGON_OFFSET_FILL is enabled
+void DeviceGL::SetPolygonOffset(GLfloat factor, GLfloat units)
+{
+    std::array<GLfloat, 2> polygonOffset = { factor, units };
+    if (m_polygonOffsetKnown && polygonOffset == m_polygonOffset)
+    {
+        return;
+    }
+
+    glPolygonOffset(factor, units);
+    m_polygonOffset = polygonOffset;
+    m_polygonOffsetKnown = true;
+}
+
+// Set the stencil test function for GL_FRONT, GL_BACK or GL_FRONT_AND_BACK faces
+void DeviceGL::SetStencilFunction(GLenum face, GLenum function, GLint refValue, GLuint mask)
+{
+    bool front = face != GL_BACK;
+    bool back = face != GL_FRONT;
+    bool frontChanged = front && (m_stencilFunctions[0] != function || m_stencilRefValues[0] != refValue || m_stencilMasks[0] != mask);
+    bool backChanged = back && (m_stencilFunctions[1] != function || m_stencilRefValues[1] != refValue || m_stencilMasks[1] != mask);
+
+    if (frontChanged && backChanged)
+    {
+        glStencilFunc(function, refValue, mask);
+    }
+    else if (frontChanged || backChanged)
+    {
+        glStencilFuncSeparate(frontChanged ? GL_FRONT : GL_BACK, function, refValue, mask);
+    }
+
+    for (int i = front ? 0 : 1; i < (back ? 2 : 1); ++i)
+    {
+        m_stencilFunctions[i] = function;
+        m_stencilRefValues[i] = refValue;
+        m_stencilMasks[i] = mask;
+    }
+}
+
+// Set the stencil operations for GL_FRONT, GL_BACK or GL_FRONT_AND_BACK faces
+void DeviceGL::SetStencilOperations(GLenum face, GLenum stencilFail, GLenum depthFail, GLenum depthPass)
+{
+    std::array<GLenum, 3> operations = { stencilFail, depthFail, depthPass };
+    bool front = face != GL_BACK;
+    bool back = face != GL_FRONT;
+    bool frontChanged = front && m_stencilOperations[0] != operations;
+    bool backChanged = back && m_stencilOperations[1] != operations;
+
+    if (frontChanged && backChanged)
+    {
+        glStencilOp(stencilFail, depthFail, depthPass);
+    }
+    else if (frontChanged || backChanged)
+    {
+        glStencilOpSeparate(frontChanged ? GL_FRONT : GL_BACK, stencilFail, depthFail, depthPass);
+    }
+
+    for (int i = front ? 0 : 1; i < (back ? 2 : 1); ++i)
+    {
+        m_stencilOperations[i] = operations;
+    }
+}
+
+// Set the shader program in use
+void DeviceGL::UseShaderProgram(GLuint handle)
+{
+    if (handle != m_shaderProgram)
+    {
+        glUseProgram(handle);
+        m_shaderProgram = handle;
+    }
+}
+
+// Bind a vertex array object
+void DeviceGL::BindVertexArray(GLuint handle)
+{
+    if (handle != m_vertexArray)
+    {
+        glBindVertexArray(handle);
+        m_vertexArray = handle;
+    }
+}
+
+// Set the texture unit affected by BindTexture
+void DeviceGL::SetActiveTextureUnit(GLint textureUnit)
+{
+    if (textureUnit != m_activeTextureUnit)
+    {
+        glActiveTexture(GL_TEXTURE0 + textureUnit);
+        m_activeTextureUnit = textureUnit;
+    }
+}
+
+// Bind a texture to the active texture unit
+void DeviceGL::BindTexture(GLenum target, GLuint handle)
+{
+    if (m_activeTextureUnit < 0 || m_activeTextureUnit >= ShadowedTextureUnits)
+    {
+        glBindTexture(target, handle);
+        return;
+    }
+
+    auto itFind = m_textures.find(target);
+    if (itFind == m_textures.end())
+    {
+        itFind = m_textures.emplace(target, std::array<GLuint, ShadowedTextureUnits>()).first;
+        itFind->second.fill(UnknownValue);
+    }
+
+    GLuint& boundHandle = itFind->second[m_activeTextureUnit];
+    if (handle != boundHandle)
+    {
+        glBindTexture(target, handle);
+        boundHandle = handle;
+    }
+}
+
+// The handle can be reused by a new program, while the deleted one stays in use. Next use must reach GL
+void DeviceGL::OnShaderProgramDeleted(GLuint handle)
+{
+    if (handle == m_shaderProgram)
+    {
+        m_shaderProgram = UnknownValue;
+    }
+}
+
+// Deleting a bound vertex array reverts the binding to 0
+void DeviceGL::OnVertexArrayDeleted(GLuint handle)
+{
+    if (handle == m_vertexArray)
+    {
+        m_vertexArray = 0;
+    }
+}
+
+// Deleting a bound texture reverts the bindings to 0, in all the units
+void DeviceGL::OnTextureDeleted(GLuint handle)
+{
+    for (auto& pair : m_textures)
+    {
+        for (GLuint& boundHandle : pair.second)
+        {
+            if (boundHandle == handle)
+            {
+                boundHandle = 0;
+            }
+        }
+    }
+}
+
+// Forget the shadowed state
+void DeviceGL::InvalidateState()
+{
+    m_features.clear();
+    m_blendEquations.fill(UnknownValue);
+    m_blendFunction.fill(UnknownValue);
+    m_blendColorKnown = false;
+    m_depthFunction = UnknownValue;
+    m_depthMask = UnknownValue;
+    m_colorMask = UnknownValue;
+    m_cullFace = UnknownValue;
+    m_polygonOffsetKnown = false;
+    m_stencilFunctions.fill(UnknownValue);
+    m_stencilRefValues.fill(static_cast<GLint>(UnknownValue));
+    m_stencilMasks.fill(UnknownValue);
+    m_stencilOperations[0].fill(UnknownValue);
+    m_stencilOperations[1].fill(UnknownValue);
+    m_viewport.fill(static_cast<GLint>(UnknownValue));
+    m_scissor.fill(static_cast<GLint>(UnknownValue));
+    m_shaderProgram = UnknownValue;
+    m_vertexArray = UnknownValue;
+    m_activeTextureUnit = static_cast<GLint>(UnknownValue);
+    m_textures.clear();
+}
+
+// Set the shadowed state to the initial values of a new GL context
+void DeviceGL::ResetState()
+{
+    InvalidateState();
+
+    // All features start disabled, except dithering and multisampling
+    for (GLenum feature : { GL_BLEND, GL_CULL_FACE, GL_DEPTH_TEST, GL_STENCIL_TEST, GL_SCISSOR_TEST, GL_POLYGON_OFFSET_FILL,
+        GL_FRAMEBUFFER_SRGB, GL_PROGRAM_POINT_SIZE, GL_TEXTURE_CUBE_MAP_SEAMLESS, GL_DEPTH_CLAMP })
+    {
+        m_features[feature] = false;
+    }
+    m_features[GL_DITHER] = true;
+    m_features[GL_MULTISAMPLE] = true;
+
+    m_blendEquations = { GL_FUNC_ADD, GL_FUNC_ADD };
+    m_blendFunction = { GL_ONE, GL_ZERO, GL_ONE, GL_ZERO };
+    m_blendColor = Color(0.0f, 0.0f, 0.0f, 0.0f);
+    m_blendColorKnown = true;
+    m_depthFunction = GL_LESS;
+    m_depthMask = GL_TRUE;
+    m_colorMask = GL_TRUE;
+    m_cullFace = GL_BACK;
+    m_polygonOffset = { 0.0f, 0.0f };
+    m_polygonOffsetKnown = true;
+    m_stencilFunctions = { GL_ALWAYS, GL_ALWAYS };
+    m_stencilRefValues = { 0, 0 };
+    m_stencilMasks = { ~0u, ~0u };
+    m_stencilOperations[0] = { GL_KEEP, GL_KEEP, GL_KEEP };
+    m_stencilOperations[1] = { GL_KEEP, GL_KEEP, GL_KEEP };
+    m_shaderProgram = 0;
+    m_vertexArray = 0;
+    m_activeTextureUnit = 0;
 }
 
 // enable / disable wireframe mode
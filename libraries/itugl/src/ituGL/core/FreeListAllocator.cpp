@@ -0,0 +1,140 @@
+#include <ituGL/core/FreeListAllocator.h>
+
+#include <algorithm>
+#include <cassert>
+
+FreeListAllocator::FreeListAllocator(size_t capacity)
+    : m_capacity(0)
+    , m_used(0)
+    , m_allocationCount(0)
+{
+    Grow(capacity);
+}
+
+size_t FreeListAllocator::Allocate(size_t size, size_t alignment)
+{
+    assert(size > 0 && alignment > 0);
+
+    // Best fit. The free list is short compared to the allocations, a linear search is fine
+    auto bestBlock = m_freeBlocks.end();
+    size_t bestPadding = 0;
+    for (auto it = m_freeBlocks.begin(); it != m_freeBlocks.end(); ++it)
+    {
+        size_t padding = (alignment - it->first % alignment) % alignment;
+        if (it->second >= size + padding && (bestBlock == m_freeBlocks.end() || it->second < bestBlock->second))
+        {
+            bestBlock = it;
+            bestPadding = padding;
+        }
+    }
+    if (bestBlock == m_freeBlocks.end())
+    {
+        return InvalidOffset;
+    }
+
+    size_t blockOffset = bestBlock->first;
+    size_t blockSize = bestBlock->second;
+    m_freeBlocks.erase(bestBlock);
+
+    // The padding before the allocation and the remainder after it stay free
+    size_t offset = blockOffset + bestPadding;
+    if (bestPadding > 0)
+    {
+        m_freeBlocks.emplace(blockOffset, bestPadding);
+    }
+    if (blockSize > bestPadding + size)
+    {
+        m_freeBlocks.emplace(offset + size, blockSize - bestPadding - size);
+    }
+
+    m_used += size;
+    m_allocationCount++;
+    return offset;
+}
+
+void FreeListAllocator::Free(size_t offset, size_t size)
+{
+    assert(offset + size <= m_capacity);
+    assert(m_used >= size && m_allocationCount > 0);
+
+    m_used -= size;
+    m_allocationCount--;
+
+    // Merge with the next block
+    auto next = m_freeBlocks.lower_bound(offset);
+    assert(next == m_freeBlocks.end() || next->first >= offset + size);
+    if (next != m_freeBlocks.end() && next->first == offset + size)
+    {
+        size += next->second;
+        next = m_freeBlocks.erase(next);
+    }
+
+    // Merge with the previous block
+    if (next != m_freeBlocks.begin())
+    {
+        auto previous = std::prev(next);
+        assert(previous->first + previous->second <= offset);
+        if (previous->first + previous->second == offset)
+        {
+            previous->second += size;
+            return;
+        }
+    }
+    m_freeBlocks.emplace(offset, size);
+}
+
+void FreeListAllocator::Grow(size_t capacity)
+{
+    assert(capacity >= m_capacity);
+    if (capacity == m_capacity)
+    {
+        return;
+    }
+
+    // Extend the last block if it reaches the end
+    size_t extra = capacity - m_capacity;
+    if (!m_freeBlocks.empty())
+    {
+        auto last = std::prev(m_freeBlocks.end());
+        if (last->first + last->second == m_capacity)
+        {
+            last->second += extra;
+            m_capacity = capacity;
+            return;
+        }
+    }
+    m_freeBlocks.emplace(m_capacity, extra);
+    m_capacity = capacity;
+}
+
+void FreeListAllocator::Reset(size_t used, unsigned int allocationCount)
+{
+    assert(used <= m_capacity);
+    m_freeBlocks.clear();
+    if (used < m_capacity)
+    {
+        m_freeBlocks.emplace(used, m_capacity - used);
+    }
+    m_used = used;
+    m_allocationCount = allocationCount;
+}
+
+FreeListAllocator::Stats FreeListAllocator::GetStats() const
+{
+    Stats stats;
+    stats.capacity = m_capacity;
+    stats.used = m_used;
+    stats.freeBlockCount = static_cast<unsigned int>(m_freeBlocks.size());
+    stats.allocationCount = m_allocationCount;
+    for (const auto& block : m_freeBlocks)
+    {
+        stats.largestFreeBlock = std::max(stats.largestFreeBlock, block.second);
+    }
+    return stats;
+}
+
+float FreeListAllocator::Stats::GetFragmentation() const
+{
+    size_t freeSize = capacity - used;
+    return freeSize > 0 ? 1.0f - static_cast<float>(largestFreeBlock) / static_cast<float>(freeSize) : 0.0f;
+}
@@ -0,0 +1,53 @@
+#include <ituGL/core/QueryObject.h>
+
+#include <utility>
+
+QueryObject::QueryObject() : Object(NullHandle)
+{
+    Handle& handle = GetHandle();
+    glGenQueries(1, &handle);
+}
+
+QueryObject::~QueryObject()
+{
+    Handle& handle = GetHandle();
+    glDeleteQueries(1, &handle);
+}
+
+QueryObject::QueryObject(QueryObject&& query) noexcept : Object(std::move(query))
+{
+}
+
+QueryObject& QueryObject::operator = (QueryObject&& query) noexcept
+{
+    Object::operator=(std::move(query));
+    return *this;
+}
+
+void QueryObject::Bind() const
+{
+}
+
+void QueryObject::Begin(Target target)
+{
+    glBeginQuery(static_cast<GLenum>(target), GetHandle());
+}
+
+void QueryObject::End(Target target)
+{
+    glEndQuery(static_cast<GLenum>(target));
+}
+
+bool QueryObject::IsResultAvailable() const
+{
+    GLuint available = GL_FALSE;
+    glGetQueryObjectuiv(GetHandle(), GL_QUERY_RESULT_AVAILABLE, &available);
+    return available != GL_FALSE;
+}
+
+GLuint64 QueryObject::GetResult() const
+{
+    GLuint64 result = 0;
+    glGetQueryObjectui64v(GetHandle(), GL_QUERY_RESULT, &result);
+    return result;
+}
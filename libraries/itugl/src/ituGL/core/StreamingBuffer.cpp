@@ -0,0 +1,138 @@
+#include <ituGL/core/StreamingBuffer.h>
+
+#include <cstring>
+#include <cassert>
+
+StreamingBuffer::StreamingBuffer(size_t regionSize, unsigned int regionCount, Target target)
+    : m_target(target)
+    , m_regionSize(regionSize)
+    , m_regionCount(regionCount)
+    , m_persistent(GLAD_GL_VERSION_4_4 != 0)
+    , m_mappedData(nullptr)
+    , m_fences(regionCount, nullptr)
+    , m_region(regionCount - 1)
+    , m_usedSize(0)
+    , m_flushedSize(0)
+    , m_frameCount(0)
+    , m_waitCount(0)
+{
+    assert(regionSize > 0);
+    assert(regionCount > 0);
+
+    size_t size = m_regionSize * m_regionCount;
+
+    Bind();
+    if (m_persistent)
+    {
+        // Immutable storage, mapped once for the lifetime of the buffer. Coherent, so writes don't need to be flushed
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(m_target, size, nullptr, flags);
+        m_mappedData = static_cast<std::byte*>(glMapBufferRange(m_target, 0, size, flags));
+        assert(m_mappedData);
+    }
+    else
+    {
+        glBufferData(m_target, size, nullptr, GL_STREAM_DRAW);
+        m_stagingData.resize(m_regionSize);
+    }
+}
+
+StreamingBuffer::~StreamingBuffer()
+{
+    for (GLsync fence : m_fences)
+    {
+        if (fence)
+        {
+            glDeleteSync(fence);
+        }
+    }
+
+    // Deleting the buffer also unmaps it
+}
+
+void StreamingBuffer::Bind() const
+{
+    BufferObject::Bind(m_target);
+}
+
+void StreamingBuffer::BeginFrame()
+{
+    m_region = (m_region + 1) % m_regionCount;
+    m_usedSize = 0;
+    m_flushedSize = 0;
+    m_frameCount++;
+
+    GLsync& fence = m_fences[m_region];
+    if (fence)
+    {
+        if (WaitFence(fence))
+        {
+            m_waitCount++;
+        }
+        fence = nullptr;
+    }
+}
+
+StreamingBuffer::Allocation StreamingBuffer::Allocate(size_t size, size_t alignment)
+{
+    assert(alignment > 0);
+
+    // Align the offset from the start of the buffer, not from the start of the region
+    size_t regionOffset = m_region * m_regionSize;
+    size_t offset = (regionOffset + m_usedSize + alignment - 1) / alignment * alignment;
+    if (offset + size > regionOffset + m_regionSize)
+    {
+        return Allocation();
+    }
+    m_usedSize = offset + size - regionOffset;
+
+    Allocation allocation;
+    allocation.data = m_persistent ? m_mappedData + offset : m_stagingData.data() + (offset - regionOffset);
+    allocation.offset = offset;
+    allocation.size = size;
+    return allocation;
+}
+
+void StreamingBuffer::Flush()
+{
+    // Coherent mapping, the GL already sees the writes
+    if (m_persistent || m_flushedSize == m_usedSize)
+    {
+        return;
+    }
+
+    // Our fences guarantee that the GL is not reading this region, so there is no need to synchronize
+    size_t regionOffset = m_region * m_regionSize;
+    size_t size = m_usedSize - m_flushedSize;
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT;
+
+    Bind();
+    void* data = glMapBufferRange(m_target, regionOffset + m_flushedSize, size, flags);
+    assert(data);
+    std::memcpy(data, m_stagingData.data() + m_flushedSize, size);
+    glUnmapBuffer(m_target);
+
+    m_flushedSize = m_usedSize;
+}
+
+void StreamingBuffer::EndFrame()
+{
+    assert(m_flushedSize == m_usedSize || m_persistent);
+    assert(!m_fences[m_region]);
+    m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+bool StreamingBuffer::WaitFence(GLsync fence)
+{
+    // Check first without waiting, most of the times the fence was signaled frames ago
+    GLenum result = glClientWaitSync(fence, 0, 0);
+    bool waited = result == GL_TIMEOUT_EXPIRED;
+    while (result == GL_TIMEOUT_EXPIRED)
+    {
+        // Make sure the fence gets to the GPU, then wait in steps of 1ms
+        result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+    }
+    assert(result != GL_WAIT_FAILED);
+    glDeleteSync(fence);
+    return waited;
+}
@@ -0,0 +1,91 @@
+#include <ituGL/core/WorkerPool.h>
+
+#include <cassert>
+
+WorkerPool::WorkerPool()
+    : m_task(nullptr)
+    , m_taskCount(0)
+    , m_pendingCount(0)
+    , m_generation(0)
+    , m_stopping(false)
+{
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_startCondition.notify_all();
+    for (std::thread& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+unsigned int WorkerPool::GetWorkerCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return static_cast<unsigned int>(m_workers.size());
+}
+
+void WorkerPool::Run(unsigned int taskCount, const std::function<void(unsigned int)>& task)
+{
+    assert(taskCount > 0);
+    if (taskCount == 1)
+    {
+        task(0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        assert(m_pendingCount == 0);
+
+        // Worker i runs task(i + 1). New workers wait for the generation after the current one, this Run
+        while (m_workers.size() < taskCount - 1)
+        {
+            unsigned int taskIndex = static_cast<unsigned int>(m_workers.size()) + 1;
+            m_workers.emplace_back(&WorkerPool::WorkerLoop, this, taskIndex, m_generation);
+        }
+        m_task = &task;
+        m_taskCount = taskCount;
+        m_pendingCount = taskCount - 1;
+        m_generation++;
+    }
+    m_startCondition.notify_all();
+
+    task(0);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_doneCondition.wait(lock, [this]() { return m_pendingCount == 0; });
+    m_task = nullptr;
+}
+
+void WorkerPool::WorkerLoop(unsigned int taskIndex, unsigned int generation)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_startCondition.wait(lock, [this, generation]() { return m_stopping || m_generation != generation; });
+        if (m_stopping)
+        {
+            return;
+        }
+        generation = m_generation;
+
+        // Workers without a task in this Run go back to wait
+        if (taskIndex < m_taskCount)
+        {
+            const std::function<void(unsigned int)>& task = *m_task;
+            lock.unlock();
+            task(taskIndex);
+            lock.lock();
+            if (--m_pendingCount == 0)
+            {
+                m_doneCondition.notify_one();
+            }
+        }
+    }
+}
@@ -0,0 +1,53 @@
+#include <ituGL/geometry/DrawIndirectBufferObject.h>
+
+#include <ituGL/geometry/VertexArrayObject.h>
+#include <ituGL/geometry/ElementBufferObject.h>
+#include <cassert>
+
+DrawIndirectBufferObject::DrawIndirectBufferObject()
+{
+    // Nothing to do here, it is done by the base class
+}
+
+DrawIndirectBufferObject::Command DrawIndirectBufferObject::Command::Create(const Drawcall& drawcall, GLuint instanceCount, GLuint baseInstance)
+{
+    assert(drawcall.IsValid());
+
+    Command command;
+    command.count = static_cast<GLuint>(drawcall.GetCount());
+    command.instanceCount = instanceCount;
+    if (drawcall.GetEboType() == Data::Type::None)
+    {
+        command.first = static_cast<GLuint>(drawcall.GetFirst());
+        command.baseVertex = baseInstance;
+        command.baseInstance = 0;
+    }
+    else
+    {
+        // The drawcall keeps the offset in bytes, the command needs the first element
+        command.first = static_cast<GLuint>(drawcall.GetFirst()) / Data::GetTypeSize(drawcall.GetEboType());
+        command.baseVertex = static_cast<GLuint>(drawcall.GetBaseVertex());
+        command.baseInstance = baseInstance;
+    }
+    return command;
+}
+
+void DrawIndirectBufferObject::MultiDraw(Drawcall::Primitive primitive, Data::Type eboType, unsigned int firstCommand, GLsizei drawCount)
+{
+    assert(IsAnyBound());
+    assert(VertexArrayObject::IsAnyBound());
+    assert(drawCount > 0);
+
+    // Commands are read from the bound buffer, starting at this offset
+    const char* offset = nullptr;
+    offset += firstCommand * sizeof(Command);
+    if (eboType == Data::Type::None)
+    {
+        glMultiDrawArraysIndirect(static_cast<GLenum>(primitive), offset, drawCount, sizeof(Command));
+    }
+    else
+    {
+        assert(ElementBufferObject::IsSupportedType(eboType));
+        glMultiDrawElementsIndirect(static_cast<GLenum>(primitive), static_cast<GLenum>(eboType), offset, drawCount, sizeof(Command));
+    }
+}
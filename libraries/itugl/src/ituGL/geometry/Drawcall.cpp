@@ -2,10 +2,11 @@
 
 #include <ituGL/geometry/VertexArrayObject.h>
 #include <ituGL/geometry/ElementBufferObject.h>
+#include <ituGL/renderer/CommandBuffer.h>
 #include <cassert>
 
 Drawcall::Drawcall()
-    : m_primitive(Primitive::Invalid), m_first(0), m_count(0), m_eboType(Data::Type::None)
+    : m_primitive(Primitive::Invalid), m_first(0), m_count(0), m_eboType(Data::Type::None), m_baseVertex(0)
 {
 }
 
@@ -15,11 +16,17 @@ Drawcall::Drawcall(Primitive primitive, GLsizei count, GLint first)
 }
 
 Drawcall::Drawcall(Primitive primitive, GLsizei count, Data::Type eboType, GLint first)
-    : m_primitive(primitive), m_first(first), m_count(count), m_eboType(eboType)
+    : Drawcall(primitive, count, eboType, first, 0)
+{
+}
+
+Drawcall::Drawcall(Primitive primitive, GLsizei count, Data::Type eboType, GLint first, GLint baseVertex)
+    : m_primitive(primitive), m_first(first), m_count(count), m_eboType(eboType), m_baseVertex(baseVertex)
 {
     assert(primitive != Primitive::Invalid);
     assert(first >= 0);
     assert(count > 0);
+    assert(baseVertex == 0 || eboType != Data::Type::None);
 }
 
 // Execute the drawcall
@@ -39,6 +46,58 @@ void Drawcall::Draw() const
         // If there is an EBO, use glDrawElements
         assert(ElementBufferObject::IsSupportedType(m_eboType));
         const char* basePointer = nullptr; // Actual element pointer is in VAO
-        glDrawElements(primitive, m_count, static_cast<GLenum>(m_eboType), basePointer + m_first);
+        if (m_baseVertex == 0)
+        {
+            glDrawElements(primitive, m_count, static_cast<GLenum>(m_eboType), basePointer + m_first);
+        }
+        else
+        {
+            glDrawElementsBaseVertex(primitive, m_count, static_cast<GLenum>(m_eboType), basePointer + m_first, m_baseVertex);
+        }
+    }
+}
+
+// Execute the drawcall with hardware instancing
+void Drawcall::DrawInstanced(GLsizei instanceCount) const
+{
+    assert(IsValid());
+    assert(VertexArrayObject::IsAnyBound());
+    assert(instanceCount > 0);
+
+    GLenum primitive = static_cast<GLenum>(m_primitive);
+    if (m_eboType == Data::Type::None)
+    {
+        glDrawArraysInstanced(primitive, m_first, m_count, instanceCount);
+    }
+    else
+    {
+        assert(ElementBufferObject::IsSupportedType(m_eboType));
+        const char* basePointer = nullptr; // Actual element pointer is in VAO
+        if (m_baseVertex == 0)
+        {
+            glDrawElementsInstanced(primitive, m_count, static_cast<GLenum>(m_eboType), basePointer + m_first, instanceCount);
+        }
+        else
+        {
+            glDrawElementsInstancedBaseVertex(primitive, m_count, static_cast<GLenum>(m_eboType), basePointer + m_first, instanceCount, m_baseVertex);
+        }
+    }
+}
+
+// Record the drawcall
+void Drawcall::Record(CommandBuffer& commandBuffer, GLsizei instanceCount) const
+{
+    assert(IsValid());
+    assert(instanceCount >= 0);
+
+    GLenum primitive = static_cast<GLenum>(m_primitive);
+    if (m_eboType == Data::Type::None)
+    {
+        commandBuffer.DrawArrays(primitive, m_first, m_count, instanceCount);
+    }
+    else
+    {
+        assert(ElementBufferObject::IsSupportedType(m_eboType));
+        commandBuffer.DrawElements(primitive, m_count, static_cast<GLenum>(m_eboType), m_first, m_baseVertex, instanceCount);
     }
 }
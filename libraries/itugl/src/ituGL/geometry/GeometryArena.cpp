@@ -0,0 +1,305 @@
+#include <ituGL/geometry/GeometryArena.h>
+
+#include <algorithm>
+#include <cassert>
+
+// Element ranges start at a multiple of the largest element type, so any type can be used
+static const size_t ElementAlignment = 4;
+
+GeometryArena::GeometryArena(size_t vertexBufferSize, size_t elementBufferSize)
+    : m_vertexBufferSize(vertexBufferSize)
+    , m_elementBufferSize(elementBufferSize)
+{
+}
+
+GeometryArena::AllocationId GeometryArena::Allocate(const VertexFormat& vertexFormat, std::span<const GLubyte> vertexData,
+    std::span<const GLubyte> elementData, std::span<const Drawcall> drawcalls, const SemanticMap& locations)
+{
+    assert(!vertexData.empty());
+    assert(!drawcalls.empty());
+
+    unsigned int poolIndex = GetPool(vertexFormat, locations);
+    Pool& pool = *m_pools[poolIndex];
+
+    size_t stride = pool.vertexFormat.GetSize();
+    assert(vertexData.size() % stride == 0);
+    size_t vertexCount = vertexData.size() / stride;
+
+    // Grow the pool if there is no free range large enough, at least doubling the size
+    size_t firstVertex = pool.vertexAllocator.Allocate(vertexCount);
+    if (firstVertex == FreeListAllocator::InvalidOffset)
+    {
+        size_t vertexCapacity = pool.vertexAllocator.GetCapacity();
+        ResizePool(poolIndex, std::max(2 * vertexCapacity, vertexCapacity + vertexCount), pool.elementAllocator.GetCapacity(), false);
+        firstVertex = pool.vertexAllocator.Allocate(vertexCount);
+    }
+    assert(firstVertex != FreeListAllocator::InvalidOffset);
+
+    size_t elementOffset = 0;
+    if (!elementData.empty())
+    {
+        elementOffset = pool.elementAllocator.Allocate(elementData.size(), ElementAlignment);
+        if (elementOffset == FreeListAllocator::InvalidOffset)
+        {
+            size_t elementCapacity = pool.elementAllocator.GetCapacity();
+            ResizePool(poolIndex, pool.vertexAllocator.GetCapacity(), std::max(2 * elementCapacity, elementCapacity + elementData.size() + ElementAlignment), false);
+            elementOffset = pool.elementAllocator.Allocate(elementData.size(), ElementAlignment);
+        }
+        assert(elementOffset != FreeListAllocator::InvalidOffset);
+    }
+
+    // Upload the data. The VAO is unbound, so binding the EBO doesn't change it
+    VertexArrayObject::Unbind();
+    pool.vbo->Bind();
+    pool.vbo->UpdateData(vertexData, firstVertex * stride);
+    VertexBufferObject::Unbind();
+    if (!elementData.empty())
+    {
+        pool.ebo->Bind();
+        pool.ebo->UpdateData(elementData, elementOffset);
+        ElementBufferObject::Unbind();
+    }
+
+    // Reuse the id of a freed allocation
+    AllocationId allocationId;
+    if (!m_freeAllocations.empty())
+    {
+        allocationId = m_freeAllocations.back();
+        m_freeAllocations.pop_back();
+    }
+    else
+    {
+        allocationId = static_cast<AllocationId>(m_allocations.size());
+        m_allocations.emplace_back();
+    }
+
+    Allocation& allocation = m_allocations[allocationId];
+    allocation.poolIndex = poolIndex;
+    allocation.firstVertex = firstVertex;
+    allocation.vertexCount = vertexCount;
+    allocation.elementOffset = elementOffset;
+    allocation.elementSize = elementData.size();
+    allocation.localDrawcalls.assign(drawcalls.begin(), drawcalls.end());
+    allocation.drawcalls.resize(drawcalls.size());
+    UpdateDrawcalls(allocation);
+
+    return allocationId;
+}
+
+void GeometryArena::Free(AllocationId allocationId)
+{
+    Allocation& allocation = m_allocations[allocationId];
+    assert(!allocation.IsFree());
+
+    Pool& pool = *m_pools[allocation.poolIndex];
+    pool.vertexAllocator.Free(allocation.firstVertex, allocation.vertexCount);
+    if (allocation.elementSize > 0)
+    {
+        pool.elementAllocator.Free(allocation.elementOffset, allocation.elementSize);
+    }
+
+    allocation = Allocation();
+    m_freeAllocations.push_back(allocationId);
+}
+
+const VertexArrayObject& GeometryArena::GetVertexArray(AllocationId allocationId) const
+{
+    assert(!m_allocations[allocationId].IsFree());
+    return m_pools[m_allocations[allocationId].poolIndex]->vao;
+}
+
+unsigned int GeometryArena::Defragment(float minFragmentation)
+{
+    unsigned int compactedCount = 0;
+    for (unsigned int poolIndex = 0; poolIndex < m_pools.size(); ++poolIndex)
+    {
+        const Pool& pool = *m_pools[poolIndex];
+        float fragmentation = std::max(pool.vertexAllocator.GetStats().GetFragmentation(), pool.elementAllocator.GetStats().GetFragmentation());
+        if (fragmentation > minFragmentation)
+        {
+            ResizePool(poolIndex, pool.vertexAllocator.GetCapacity(), pool.elementAllocator.GetCapacity(), true);
+            compactedCount++;
+        }
+    }
+    return compactedCount;
+}
+
+GeometryArena::Stats GeometryArena::GetStats() const
+{
+    Stats stats;
+    stats.poolCount = static_cast<unsigned int>(m_pools.size());
+    stats.allocationCount = static_cast<unsigned int>(m_allocations.size() - m_freeAllocations.size());
+    for (const std::unique_ptr<Pool>& pool : m_pools)
+    {
+        size_t stride = pool->vertexFormat.GetSize();
+        FreeListAllocator::Stats vertexStats = pool->vertexAllocator.GetStats();
+        FreeListAllocator::Stats elementStats = pool->elementAllocator.GetStats();
+
+        stats.vertexCapacity += vertexStats.capacity * stride;
+        stats.vertexUsed += vertexStats.used * stride;
+        stats.elementCapacity += elementStats.capacity;
+        stats.elementUsed += elementStats.used;
+        stats.freeBlockCount += vertexStats.freeBlockCount + elementStats.freeBlockCount;
+        stats.fragmentation = std::max(stats.fragmentation, std::max(vertexStats.GetFragmentation(), elementStats.GetFragmentation()));
+    }
+    return stats;
+}
+
+unsigned int GeometryArena::GetPool(const VertexFormat& vertexFormat, const SemanticMap& locations)
+{
+    assert(vertexFormat.GetAttributeCount() > 0);
+
+    // Locations are assigned like in Mesh: consecutive, unless the semantic has its own
+    std::vector<AttributeKey> key;
+    GLuint location = 0;
+    for (int attributeIndex = 0; attributeIndex < vertexFormat.GetAttributeCount(); ++attributeIndex)
+    {
+        VertexAttribute attribute = vertexFormat.GetAttribute(attributeIndex);
+        auto itLocation = locations.find(attribute.GetSemantic());
+        if (itLocation != locations.end())
+        {
+            location = itLocation->second;
+        }
+        key.push_back(AttributeKey{ attribute.GetType(), attribute.GetComponents(), attribute.IsNormalized(), location });
+        location += attribute.GetLocationSize();
+    }
+
+    for (unsigned int poolIndex = 0; poolIndex < m_pools.size(); ++poolIndex)
+    {
+        if (m_pools[poolIndex]->key == key)
+        {
+            return poolIndex;
+        }
+    }
+
+    unsigned int poolIndex = static_cast<unsigned int>(m_pools.size());
+    std::unique_ptr<Pool>& pool = m_pools.emplace_back(std::make_unique<Pool>());
+    pool->key = key;
+    pool->vertexFormat = vertexFormat;
+    pool->locations = locations;
+    ResizePool(poolIndex, std::max<size_t>(m_vertexBufferSize / vertexFormat.GetSize(), 1), m_elementBufferSize, false);
+    return poolIndex;
+}
+
+void GeometryArena::ResizePool(unsigned int poolIndex, size_t vertexCapacity, size_t elementCapacity, bool compact)
+{
+    Pool& pool = *m_pools[poolIndex];
+    size_t stride = pool.vertexFormat.GetSize();
+    assert(vertexCapacity >= pool.vertexAllocator.GetCapacity());
+    assert(elementCapacity >= pool.elementAllocator.GetCapacity());
+
+    // The VAO is unbound, so binding the EBO doesn't change it
+    VertexArrayObject::Unbind();
+
+    std::unique_ptr<VertexBufferObject> vbo = std::make_unique<VertexBufferObject>();
+    vbo->Bind();
+    vbo->AllocateData(vertexCapacity * stride);
+    VertexBufferObject::Unbind();
+
+    std::unique_ptr<ElementBufferObject> ebo = std::make_unique<ElementBufferObject>();
+    ebo->Bind();
+    ebo->AllocateData<GLubyte>(elementCapacity);
+    ElementBufferObject::Unbind();
+
+    if (!compact)
+    {
+        // Copy everything, allocations keep their offsets
+        if (pool.vbo && pool.vertexAllocator.GetCapacity() > 0)
+        {
+            BufferObject::CopyData(*pool.vbo, 0, *vbo, 0, pool.vertexAllocator.GetCapacity() * stride);
+        }
+        if (pool.ebo && pool.elementAllocator.GetCapacity() > 0)
+        {
+            BufferObject::CopyData(*pool.ebo, 0, *ebo, 0, pool.elementAllocator.GetCapacity());
+        }
+        pool.vertexAllocator.Grow(vertexCapacity);
+        pool.elementAllocator.Grow(elementCapacity);
+    }
+    else
+    {
+        // Copy the allocations one after the other, and move their drawcalls
+        size_t nextVertex = 0;
+        size_t nextElementOffset = 0;
+        unsigned int allocationCount = 0;
+        unsigned int elementAllocationCount = 0;
+        for (Allocation& allocation : m_allocations)
+        {
+            if (allocation.IsFree() || allocation.poolIndex != poolIndex)
+            {
+                continue;
+            }
+
+            BufferObject::CopyData(*pool.vbo, allocation.firstVertex * stride, *vbo, nextVertex * stride, allocation.vertexCount * stride);
+            allocation.firstVertex = nextVertex;
+            nextVertex += allocation.vertexCount;
+            allocationCount++;
+
+            if (allocation.elementSize > 0)
+            {
+                BufferObject::CopyData(*pool.ebo, allocation.elementOffset, *ebo, nextElementOffset, allocation.elementSize);
+                allocation.elementOffset = nextElementOffset;
+                nextElementOffset += (allocation.elementSize + ElementAlignment - 1) / ElementAlignment * ElementAlignment;
+                elementAllocationCount++;
+            }
+
+            UpdateDrawcalls(allocation);
+        }
+        pool.vertexAllocator.Grow(vertexCapacity);
+        pool.vertexAllocator.Reset(nextVertex, allocationCount);
+        pool.elementAllocator.Grow(elementCapacity);
+        pool.elementAllocator.Reset(nextElementOffset, elementAllocationCount);
+    }
+
+    // The old buffers are deleted here, the GL keeps them alive until the copies are done
+    pool.vbo = std::move(vbo);
+    pool.ebo = std::move(ebo);
+    SetupVertexArray(pool);
+}
+
+void GeometryArena::SetupVertexArray(Pool& pool)
+{
+    pool.vao.Bind();
+    pool.vbo->Bind();
+
+    // Same as Mesh::SetupVertexAttribute, with the interleaved layout
+    GLuint location = 0;
+    for (auto it = pool.vertexFormat.LayoutBegin(0, true); it != pool.vertexFormat.LayoutEnd(); it++)
+    {
+        const VertexAttribute& attribute = it->GetAttribute();
+        auto itLocation = pool.locations.find(attribute.GetSemantic());
+        if (itLocation != pool.locations.end())
+        {
+            location = itLocation->second;
+        }
+        pool.vao.SetAttribute(location, attribute, it->GetOffset(), it->GetStride());
+        location += attribute.GetLocationSize();
+    }
+
+    // The EBO binding is part of the VAO state
+    pool.ebo->Bind();
+
+    VertexArrayObject::Unbind();
+    VertexBufferObject::Unbind();
+    ElementBufferObject::Unbind();
+}
+
+void GeometryArena::UpdateDrawcalls(Allocation& allocation)
+{
+    // Drawcalls are assigned in place, the meshes keep references to them
+    assert(allocation.drawcalls.size() == allocation.localDrawcalls.size());
+    for (size_t index = 0; index < allocation.localDrawcalls.size(); ++index)
+    {
+        const Drawcall& local = allocation.localDrawcalls[index];
+        if (local.GetEboType() == Data::Type::None)
+        {
+            GLint first = local.GetFirst() + static_cast<GLint>(allocation.firstVertex);
+            allocation.drawcalls[index] = Drawcall(local.GetPrimitive(), local.GetCount(), first);
+        }
+        else
+        {
+            GLint first = local.GetFirst() + static_cast<GLint>(allocation.elementOffset);
+            GLint baseVertex = local.GetBaseVertex() + static_cast<GLint>(allocation.firstVertex);
+            allocation.drawcalls[index] = Drawcall(local.GetPrimitive(), local.GetCount(), local.GetEboType(), first, baseVertex);
+        }
+    }
+}
@@ -1,7 +1,74 @@
 #include <ituGL/geometry/Mesh.h>
 
+#include <ituGL/geometry/VertexFormat.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MESH_SSE
+#include <emmintrin.h>
+#endif
+
 Mesh::Mesh()
+    : m_arena(nullptr)
+    , m_boundsMin(0.0f)
+    , m_boundsMax(0.0f)
+    , m_boundsRadius(0.0f)
+    , m_boundsDirty(false)
+    , m_boundsVersion(0)
+{
+}
+
+Mesh::~Mesh()
+{
+    for (GeometryArena::AllocationId allocationId : m_arenaAllocations)
+    {
+        m_arena->Free(allocationId);
+    }
+}
+
+Mesh::Mesh(Mesh&& mesh) noexcept
+    : m_vbos(std::move(mesh.m_vbos))
+    , m_ebos(std::move(mesh.m_ebos))
+    , m_vaos(std::move(mesh.m_vaos))
+    , m_submeshes(std::move(mesh.m_submeshes))
+    , m_arena(mesh.m_arena)
+    , m_arenaAllocations(std::move(mesh.m_arenaAllocations))
+    , m_boundsMin(mesh.m_boundsMin)
+    , m_boundsMax(mesh.m_boundsMax)
+    , m_boundsRadius(mesh.m_boundsRadius)
+    , m_boundsDirty(mesh.m_boundsDirty)
+    , m_boundsVersion(mesh.m_boundsVersion)
 {
+    // The allocations belong to this mesh now
+    mesh.m_arenaAllocations.clear();
+}
+
+Mesh& Mesh::operator = (Mesh&& mesh) noexcept
+{
+    if (this != &mesh)
+    {
+        for (GeometryArena::AllocationId allocationId : m_arenaAllocations)
+        {
+            m_arena->Free(allocationId);
+        }
+
+        m_vbos = std::move(mesh.m_vbos);
+        m_ebos = std::move(mesh.m_ebos);
+        m_vaos = std::move(mesh.m_vaos);
+        m_submeshes = std::move(mesh.m_submeshes);
+        m_arena = mesh.m_arena;
+        m_arenaAllocations = std::move(mesh.m_arenaAllocations);
+        mesh.m_arenaAllocations.clear();
+        m_boundsMin = mesh.m_boundsMin;
+        m_boundsMax = mesh.m_boundsMax;
+        m_boundsRadius = mesh.m_boundsRadius;
+        m_boundsDirty = mesh.m_boundsDirty;
+        m_boundsVersion++;
+    }
+    return *this;
 }
 
 unsigned int Mesh::AddVertexData(size_t size)
@@ -35,16 +102,208 @@ unsigned int Mesh::AddSubmesh(unsigned int vaoIndex,
     return AddSubmesh(vaoIndex, Drawcall(primitive, count, eboType, first));
 }
 
+unsigned int Mesh::AddSubmeshes(GeometryArena& arena, const VertexFormat& vertexFormat,
+    std::span<const GLubyte> vertexData, std::span<const GLubyte> elementData,
+    std::span<const Drawcall> drawcalls, const SemanticMap& locations)
+{
+    // All the allocations of a mesh go to the same arena
+    assert(!m_arena || m_arena == &arena);
+    m_arena = &arena;
+
+    GeometryArena::AllocationId allocationId = arena.Allocate(vertexFormat, vertexData, elementData, drawcalls, locations);
+    m_arenaAllocations.push_back(allocationId);
+
+    unsigned int firstSubmeshIndex = GetSubmeshCount();
+    for (unsigned int drawcallIndex = 0; drawcallIndex < drawcalls.size(); ++drawcallIndex)
+    {
+        Submesh& submesh = m_submeshes.emplace_back();
+        submesh.vaoIndex = drawcallIndex;
+        submesh.allocationId = allocationId;
+    }
+
+    return firstSubmeshIndex;
+}
+
+const VertexArrayObject& Mesh::GetSubmeshVertexArray(unsigned int submeshIndex) const
+{
+    const Submesh& submesh = GetSubmesh(submeshIndex);
+    if (submesh.allocationId != GeometryArena::InvalidAllocation)
+    {
+        return m_arena->GetVertexArray(submesh.allocationId);
+    }
+    return m_vaos[submesh.vaoIndex];
+}
+
+const Drawcall& Mesh::GetSubmeshDrawcall(unsigned int submeshIndex) const
+{
+    const Submesh& submesh = GetSubmesh(submeshIndex);
+    if (submesh.allocationId != GeometryArena::InvalidAllocation)
+    {
+        return m_arena->GetDrawcall(submesh.allocationId, submesh.vaoIndex);
+    }
+    return submesh.drawcall;
+}
+
 // Bind the VAO and render the drawcall of the submesh
 void Mesh::DrawSubmesh(int submeshIndex) const
 {
-    const Submesh& submesh = GetSubmesh(submeshIndex);
-    const VertexArrayObject& vao = GetVertexArray(submesh.vaoIndex);
+    const VertexArrayObject& vao = GetSubmeshVertexArray(submeshIndex);
     vao.Bind();
-    submesh.drawcall.Draw();
+    GetSubmeshDrawcall(submeshIndex).Draw();
     //VertexArrayObject::Unbind(); // No need to unbind
 }
 
+AabbBounds Mesh::GetSubmeshAabbBounds(unsigned int submeshIndex) const
+{
+    const Submesh& submesh = GetSubmesh(submeshIndex);
+    if (glm::any(glm::greaterThan(submesh.boundsMin, submesh.boundsMax)))
+    {
+        return AabbBounds(glm::vec3(0.0f), glm::vec3(0.0f));
+    }
+    return AabbBounds(0.5f * (submesh.boundsMin + submesh.boundsMax), 0.5f * (submesh.boundsMax - submesh.boundsMin));
+}
+
+SphereBounds Mesh::GetSubmeshSphereBounds(unsigned int submeshIndex) const
+{
+    return SphereBounds(GetSubmeshAabbBounds(submeshIndex).GetCenter(), GetSubmesh(submeshIndex).boundsRadius);
+}
+
+void Mesh::SetSubmeshBounds(unsigned int submeshIndex, const glm::vec3& min, const glm::vec3& max, float radius)
+{
+    Submesh& submesh = GetSubmesh(submeshIndex);
+    submesh.boundsMin = min;
+    submesh.boundsMax = max;
+    submesh.boundsRadius = radius;
+    m_boundsDirty = true;
+    m_boundsVersion++;
+}
+
+void Mesh::ComputeSubmeshBounds(unsigned int submeshIndex, const void* positions, size_t stride, size_t count)
+{
+    glm::vec3 min(std::numeric_limits<float>::max());
+    glm::vec3 max(-std::numeric_limits<float>::max());
+    AccumulatePositionBounds(positions, stride, count, min, max);
+
+    float radius = count > 0 ? ComputePositionRadius(positions, stride, count, 0.5f * (min + max)) : 0.0f;
+    SetSubmeshBounds(submeshIndex, min, max, radius);
+}
+
+AabbBounds Mesh::GetAabbBounds() const
+{
+    UpdateBounds();
+    return AabbBounds(0.5f * (m_boundsMin + m_boundsMax), 0.5f * (m_boundsMax - m_boundsMin));
+}
+
+SphereBounds Mesh::GetSphereBounds() const
+{
+    UpdateBounds();
+    return SphereBounds(0.5f * (m_boundsMin + m_boundsMax), m_boundsRadius);
+}
+
+void Mesh::UpdateBounds() const
+{
+    if (!m_boundsDirty)
+    {
+        return;
+    }
+    m_boundsDirty = false;
+
+    glm::vec3 min(std::numeric_limits<float>::max());
+    glm::vec3 max(-std::numeric_limits<float>::max());
+    for (const Submesh& submesh : m_submeshes)
+    {
+        min = glm::min(min, submesh.boundsMin);
+        max = glm::max(max, submesh.boundsMax);
+    }
+
+    if (glm::any(glm::greaterThan(min, max)))
+    {
+        m_boundsMin = m_boundsMax = glm::vec3(0.0f);
+        m_boundsRadius = 0.0f;
+    }
+    else
+    {
+        m_boundsMin = min;
+        m_boundsMax = max;
+
+        // Spheres of the submeshes seen from the center of the mesh, but never bigger than the box around it
+        glm::vec3 center = 0.5f * (min + max);
+        float radius = 0.0f;
+        for (const Submesh& submesh : m_submeshes)
+        {
+            if (glm::all(glm::lessThanEqual(submesh.boundsMin, submesh.boundsMax)))
+            {
+                glm::vec3 submeshCenter = 0.5f * (submesh.boundsMin + submesh.boundsMax);
+                radius = std::max(radius, glm::distance(center, submeshCenter) + submesh.boundsRadius);
+            }
+        }
+        m_boundsRadius = std::min(radius, glm::length(max - center));
+    }
+}
+
+void Mesh::AccumulatePositionBounds(const void* srcBuffer, size_t srcStride, size_t count, glm::vec3& min, glm::vec3& max,
+    void* dstBuffer, size_t dstStride)
+{
+    const unsigned char* srcBytes = static_cast<const unsigned char*>(srcBuffer);
+    unsigned char* dstBytes = static_cast<unsigned char*>(dstBuffer);
+    dstStride = dstStride ? dstStride : 3 * sizeof(float);
+    size_t i = 0;
+
+#if defined(MESH_SSE)
+    if (count > 1)
+    {
+        __m128 minValues = _mm_setr_ps(min.x, min.y, min.z, min.z);
+        __m128 maxValues = _mm_setr_ps(max.x, max.y, max.z, max.z);
+
+        // A full load reads the first float of the next position, so the last one is done below
+        for (; i + 1 < count; ++i, srcBytes += srcStride)
+        {
+            __m128 position = _mm_loadu_ps(reinterpret_cast<const float*>(srcBytes));
+            minValues = _mm_min_ps(minValues, position);
+            maxValues = _mm_max_ps(maxValues, position);
+            if (dstBytes)
+            {
+                std::memcpy(dstBytes, srcBytes, 3 * sizeof(float));
+                dstBytes += dstStride;
+            }
+        }
+
+        alignas(16) float values[4];
+        _mm_store_ps(values, minValues);
+        min = glm::vec3(values[0], values[1], values[2]);
+        _mm_store_ps(values, maxValues);
+        max = glm::vec3(values[0], values[1], values[2]);
+    }
+#endif
+
+    for (; i < count; ++i, srcBytes += srcStride)
+    {
+        glm::vec3 position;
+        std::memcpy(&position, srcBytes, sizeof(position));
+        min = glm::min(min, position);
+        max = glm::max(max, position);
+        if (dstBytes)
+        {
+            std::memcpy(dstBytes, srcBytes, sizeof(position));
+            dstBytes += dstStride;
+        }
+    }
+}
+
+float Mesh::ComputePositionRadius(const void* positions, size_t stride, size_t count, const glm::vec3& center)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(positions);
+    float maxDistance2 = 0.0f;
+    for (size_t i = 0; i < count; ++i, bytes += stride)
+    {
+        glm::vec3 position;
+        std::memcpy(&position, bytes, sizeof(position));
+        glm::vec3 offset = position - center;
+        maxDistance2 = std::max(maxDistance2, glm::dot(offset, offset));
+    }
+    return std::sqrt(maxDistance2);
+}
+
 void Mesh::SetupVertexAttribute(VertexArrayObject& vao, const VertexAttribute::Layout& attributeLayout, GLuint& location, const SemanticMap& locations)
 {
     const VertexAttribute& attribute = attributeLayout.GetAttribute();
@@ -3,7 +3,14 @@
 #include <ituGL/geometry/Mesh.h>
 #include <ituGL/shader/Material.h>
 
-Model::Model(std::shared_ptr<Mesh> mesh) : m_mesh(mesh)
+Model::Model(std::shared_ptr<Mesh> mesh)
+    : m_mesh(mesh)
+    , m_hasBounds(false)
+    , m_boundsCenter(0.0f)
+    , m_boundsSize(0.0f)
+    , m_boundsVersion(0)
+    , m_boundsMesh(mesh.get())
+    , m_boundsMeshVersion(mesh ? mesh->GetBoundsVersion() : 0)
 {
 }
 
@@ -22,6 +29,7 @@ void Model::SetMesh(std::shared_ptr<Mesh> mesh)
     // Clear the material list before changing the mesh
     assert(m_materials.empty());
     m_mesh = mesh;
+    m_boundsVersion++;
 }
 
 unsigned int Model::GetMaterialCount()
@@ -75,3 +83,49 @@ void Model::Draw()
         }
     }
 }
+
+AabbBounds Model::GetAabbBounds() const
+{
+    if (m_hasBounds)
+    {
+        return AabbBounds(m_boundsCenter, m_boundsSize);
+    }
+    return m_mesh ? m_mesh->GetAabbBounds() : AabbBounds(glm::vec3(0.0f), glm::vec3(0.0f));
+}
+
+SphereBounds Model::GetSphereBounds() const
+{
+    if (m_hasBounds)
+    {
+        return SphereBounds(AabbBounds(m_boundsCenter, m_boundsSize));
+    }
+    return m_mesh ? m_mesh->GetSphereBounds() : SphereBounds(glm::vec3(0.0f), 0.0f);
+}
+
+void Model::SetBounds(const AabbBounds& bounds)
+{
+    m_hasBounds = true;
+    m_boundsCenter = bounds.GetCenter();
+    m_boundsSize = bounds.GetSize();
+    m_boundsVersion++;
+}
+
+void Model::ResetBounds()
+{
+    m_hasBounds = false;
+    m_boundsVersion++;
+}
+
+unsigned int Model::GetBoundsVersion() const
+{
+    // Versions of different meshes are unrelated, so the pointer and the version are compared separately
+    const Mesh* mesh = m_mesh.get();
+    unsigned int meshVersion = mesh ? mesh->GetBoundsVersion() : 0;
+    if (mesh != m_boundsMesh || meshVersion != m_boundsMeshVersion)
+    {
+        m_boundsMesh = mesh;
+        m_boundsMeshVersion = meshVersion;
+        m_boundsVersion++;
+    }
+    return m_boundsVersion;
+}
@@ -1,11 +1,10 @@
 #include <ituGL/geometry/VertexArrayObject.h>
 
 #include <ituGL/geometry/VertexAttribute.h>
+#include <ituGL/core/DeviceGL.h>
 #include <cassert>
 
 #ifndef NDEBUG
-#include <ituGL/geometry/VertexBufferObject.h>   // To assert that there is a VertexBufferObject bound
-
 VertexArrayObject::Handle VertexArrayObject::s_boundHandle = VertexArrayObject::NullHandle;
 #endif
 
@@ -21,6 +20,10 @@ VertexArrayObject::~VertexArrayObject()
 {
     Handle& handle = GetHandle();
     glDeleteVertexArrays(1, &handle);
+    if (DeviceGL* device = DeviceGL::GetInstancePointer())
+    {
+        device->OnVertexArrayDeleted(handle);
+    }
 }
 
 VertexArrayObject::VertexArrayObject(VertexArrayObject&& vao) noexcept : Object(std::move(vao))
@@ -37,7 +40,7 @@ VertexArrayObject& VertexArrayObject::operator = (VertexArrayObject&& vao) noexc
 void VertexArrayObject::Bind() const
 {
     Handle handle = GetHandle();
-    glBindVertexArray(handle);
+    DeviceGL::GetInstance().BindVertexArray(handle);
 #ifndef NDEBUG
     s_boundHandle = handle;
 #endif
@@ -47,7 +50,7 @@ void VertexArrayObject::Bind() const
 void VertexArrayObject::Unbind()
 {
     Handle handle = NullHandle;
-    glBindVertexArray(handle);
+    DeviceGL::GetInstance().BindVertexArray(handle);
 #ifndef NDEBUG
     s_boundHandle = handle;
 #endif
@@ -57,7 +60,12 @@ void VertexArrayObject::Unbind()
 void VertexArrayObject::SetAttribute(GLuint location, const VertexAttribute& attribute, GLint offset, GLsizei stride)
 {
     assert(IsBound());
-    assert(VertexBufferObject::IsAnyBound());
+#ifndef NDEBUG
+    // Ask GL, the buffer may be any BufferObject bound as array buffer, like a StreamingBuffer
+    GLint arrayBufferHandle = 0;
+    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &arrayBufferHandle);
+    assert(arrayBufferHandle != 0);
+#endif
 
     // Get the attribute properties in OpenGL expected format
     GLint components = attribute.GetComponents();
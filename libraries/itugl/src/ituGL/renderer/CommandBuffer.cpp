@@ -0,0 +1,200 @@
+#include <ituGL/renderer/CommandBuffer.h>
+
+CommandBuffer::CommandBuffer() : m_commandCount(0), m_skippedCount(0)
+{
+    Clear();
+}
+
+void CommandBuffer::Clear()
+{
+    m_data.clear();
+    m_functions.clear();
+    m_commandCount = 0;
+    m_skippedCount = 0;
+
+    m_features.clear();
+    m_depthFunction = UnknownValue;
+    m_depthMask = UnknownValue;
+    m_blendEquation = { UnknownValue, UnknownValue };
+    m_blendFunction = { UnknownValue, UnknownValue, UnknownValue, UnknownValue };
+    m_scissor = { -1, -1, -1, -1 };
+    m_program = UnknownValue;
+    m_vertexArray = UnknownValue;
+    m_textures.fill(std::make_pair(UnknownValue, UnknownValue));
+}
+
+void CommandBuffer::SetFeatureEnabled(GLenum feature, bool enabled)
+{
+    auto itFind = m_features.find(feature);
+    if (itFind != m_features.end() && itFind->second == enabled)
+    {
+        m_skippedCount++;
+        return;
+    }
+    m_features[feature] = enabled;
+    AddCommand(SetFeatureCommand{ feature, static_cast<GLboolean>(enabled ? GL_TRUE : GL_FALSE) });
+}
+
+void CommandBuffer::SetDepthFunction(GLenum function)
+{
+    if (function == m_depthFunction)
+    {
+        m_skippedCount++;
+        return;
+    }
+    m_depthFunction = function;
+    AddCommand(SetDepthFunctionCommand{ function });
+}
+
+void CommandBuffer::SetDepthMask(bool enabled)
+{
+    GLuint depthMask = enabled ? GL_TRUE : GL_FALSE;
+    if (depthMask == m_depthMask)
+    {
+        m_skippedCount++;
+        return;
+    }
+    m_depthMask = depthMask;
+    AddCommand(SetDepthMaskCommand{ static_cast<GLboolean>(depthMask) });
+}
+
+void CommandBuffer::SetBlendEquation(GLenum colorEquation, GLenum alphaEquation)
+{
+    if (colorEquation == m_blendEquation.colorEquation && alphaEquation == m_blendEquation.alphaEquation)
+    {
+        m_skippedCount++;
+        return;
+    }
+    m_blendEquation = { colorEquation, alphaEquation };
+    AddCommand(m_blendEquation);
+}
+
+void CommandBuffer::SetBlendFunction(GLenum sourceColor, GLenum destColor, GLenum sourceAlpha, GLenum destAlpha)
+{
+    if (sourceColor == m_blendFunction.sourceColor && destColor == m_blendFunction.destColor &&
+        sourceAlpha == m_blendFunction.sourceAlpha && destAlpha == m_blendFunction.destAlpha)
+    {
+        m_skippedCount++;
+        return;
+    }
+    m_blendFunction = { sourceColor, destColor, sourceAlpha, destAlpha };
+    AddCommand(m_blendFunction);
+}
+
+void CommandBuffer::SetBlendColor(const Color& color)
+{
+    AddCommand(SetBlendColorCommand{ { color.GetRed(), color.GetGreen(), color.GetBlue(), color.GetAlpha() } });
+}
+
+void CommandBuffer::SetStencilFunction(GLenum face, GLenum function, GLint refValue, GLuint mask)
+{
+    AddCommand(SetStencilFunctionCommand{ face, function, refValue, mask });
+}
+
+void CommandBuffer::SetStencilOperations(GLenum face, GLenum stencilFail, GLenum depthFail, GLenum depthPass)
+{
+    AddCommand(SetStencilOperationsCommand{ face, stencilFail, depthFail, depthPass });
+}
+
+void CommandBuffer::SetScissor(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    if (x == m_scissor.x && y == m_scissor.y && width == m_scissor.width && height == m_scissor.height)
+    {
+        m_skippedCount++;
+        return;
+    }
+    m_scissor = { x, y, width, height };
+    AddCommand(m_scissor);
+}
+
+void CommandBuffer::UseProgram(GLuint handle)
+{
+    if (handle == m_program)
+    {
+        m_skippedCount++;
+        return;
+    }
+    m_program = handle;
+    AddCommand(UseProgramCommand{ handle });
+}
+
+void CommandBuffer::SetUniforms(GLint location, Data::Type type, int components, int columns, GLsizei count, std::span<const std::byte> values)
+{
+    assert(components >= 1 && components <= 4);
+    assert(columns >= 1 && columns <= 4);
+    assert(values.size() == Data::GetTypeSize(type) * components * columns * count);
+    AddCommand(SetUniformsCommand{ location, type, static_cast<GLubyte>(components), static_cast<GLubyte>(columns), count }, values);
+}
+
+void CommandBuffer::BindUniformBlock(GLuint bindingIndex, GLuint bufferHandle, GLintptr offset, GLsizeiptr size)
+{
+    AddCommand(BindUniformBlockCommand{ bindingIndex, bufferHandle, offset, size });
+}
+
+void CommandBuffer::BindVertexArray(GLuint handle)
+{
+    if (handle == m_vertexArray)
+    {
+        m_skippedCount++;
+        return;
+    }
+    m_vertexArray = handle;
+    AddCommand(BindVertexArrayCommand{ handle });
+}
+
+void CommandBuffer::BindTexture(GLint textureUnit, GLenum target, GLuint handle)
+{
+    if (textureUnit >= 0 && textureUnit < DedupTextureUnits)
+    {
+        std::pair<GLenum, GLuint> binding(target, handle);
+        if (m_textures[textureUnit] == binding)
+        {
+            m_skippedCount++;
+            return;
+        }
+        m_textures[textureUnit] = binding;
+    }
+    AddCommand(BindTextureCommand{ textureUnit, target, handle });
+}
+
+void CommandBuffer::DrawArrays(GLenum primitive, GLint first, GLsizei count, GLsizei instanceCount)
+{
+    AddCommand(DrawArraysCommand{ primitive, first, count, instanceCount });
+}
+
+void CommandBuffer::DrawElements(GLenum primitive, GLsizei count, GLenum eboType, GLint first, GLint baseVertex, GLsizei instanceCount)
+{
+    AddCommand(DrawElementsCommand{ primitive, count, eboType, first, baseVertex, instanceCount });
+}
+
+void CommandBuffer::CallFunction(Function function)
+{
+    assert(function);
+    AddCommand(CallFunctionCommand{ static_cast<std::uint32_t>(m_functions.size()) });
+    m_functions.push_back(std::move(function));
+}
+
+const char* CommandBuffer::GetCommandName(CommandType type)
+{
+    switch (type)
+    {
+    case CommandType::SetFeature: return "SetFeature";
+    case CommandType::SetDepthFunction: return "SetDepthFunction";
+    case CommandType::SetDepthMask: return "SetDepthMask";
+    case CommandType::SetBlendEquation: return "SetBlendEquation";
+    case CommandType::SetBlendFunction: return "SetBlendFunction";
+    case CommandType::SetBlendColor: return "SetBlendColor";
+    case CommandType::SetStencilFunction: return "SetStencilFunction";
+    case CommandType::SetStencilOperations: return "SetStencilOperations";
+    case CommandType::SetScissor: return "SetScissor";
+    case CommandType::UseProgram: return "UseProgram";
+    case CommandType::SetUniforms: return "SetUniforms";
+    case CommandType::BindUniformBlock: return "BindUniformBlock";
+    case CommandType::BindVertexArray: return "BindVertexArray";
+    case CommandType::BindTexture: return "BindTexture";
+    case CommandType::DrawArrays: return "DrawArrays";
+    case CommandType::DrawElements: return "DrawElements";
+    case CommandType::CallFunction: return "CallFunction";
+    default: return "Unknown";
+    }
+}
@@ -0,0 +1,5 @@
+#include <ituGL/renderer/CommandExecutor.h>
+
+CommandExecutor::~CommandExecutor()
+{
+}
@@ -6,10 +6,15 @@
 #include <ituGL/camera/Camera.h>
 #include <ituGL/shader/Material.h>
 #include <ituGL/texture/Texture2DObject.h>
+#include <ituGL/texture/FramebufferObject.h>
 #include <glm/gtx/transform.hpp>
+#include <glm/gtc/constants.hpp>
+#include <vector>
+#include <cmath>
 
-DeferredRenderPass::DeferredRenderPass(std::shared_ptr<Material> material, std::shared_ptr<const FramebufferObject> framebuffer)
-    : RenderPass(framebuffer), m_material(material)
+DeferredRenderPass::DeferredRenderPass(std::shared_ptr<Material> material, std::shared_ptr<const FramebufferObject> framebuffer,
+    std::shared_ptr<const FramebufferObject> depthStencilSource)
+    : RenderPass(framebuffer), m_material(material), m_depthStencilSource(depthStencilSource)
 {
     InitializeMeshes();
 }
@@ -17,11 +22,31 @@ DeferredRenderPass::DeferredRenderPass(std::shared_ptr<Material> material, std::
 void DeferredRenderPass::Render()
 {
     Renderer& renderer = GetRenderer();
-
-    renderer.GetDevice().Clear(true, Color(0.0f, 0.0f, 0.0f, 1.0f), false, 1.0f);
+    DeviceGL& device = renderer.GetDevice();
 
     const Camera& camera = renderer.GetCurrentCamera();
 
+    GLint x, y;
+    GLsizei width, height;
+    device.GetViewport(x, y, width, height);
+    m_lightScreenProjector.SetCamera(camera, x, y, width, height);
+
+    // Blit and clear are limited by the scissor test too
+    device.DisableFeature(GL_SCISSOR_TEST);
+
+    bool useStencil = m_depthStencilSource != nullptr;
+    if (useStencil)
+    {
+        // Copy the depth of the g-buffer, so the volumes can be tested against the surfaces
+        m_depthStencilSource->Bind(FramebufferObject::Target::Read);
+        FramebufferObject::Blit(width, height, GL_DEPTH_BUFFER_BIT);
+        FramebufferObject::Unbind(FramebufferObject::Target::Read);
+    }
+
+    // Depth mask needs to be enabled to clear the depth buffer
+    device.SetDepthMask(true);
+    device.Clear(true, Color(0.0f, 0.0f, 0.0f, 1.0f), false, 1.0f, useStencil, 0);
+
     assert(m_material);
     m_material->Use();
     std::shared_ptr<const ShaderProgram> shaderProgram = m_material->GetShaderProgram();
@@ -38,24 +63,201 @@ void DeferredRenderPass::Render()
         const Light* light = lightIndex <= lights.size() ? lights[lightIndex - 1] : nullptr;
         assert(first || light);
 
+        // Skip the lights that can't reach any pixel, and limit the others to their rectangle
+        if (!first)
+        {
+            LightScreenProjector::ScreenBounds screenBounds = m_lightScreenProjector.GetScreenBounds(*light);
+            if (screenBounds.IsEmpty())
+            {
+                continue;
+            }
+            m_lightScreenProjector.SetScissor(device, screenBounds);
+        }
+
+        // The first pass also adds the ambient light, so it always covers the screen
         const Mesh* mesh = &renderer.GetFullscreenMesh();
         glm::mat4 worldMatrix = fullscreenMatrix;
-
-        // TODO: select different meshes depending on the type
+        bool fullscreen = first || !GetLightVolume(*light, mesh, worldMatrix);
 
         // Set the render states for the first and additional lights
         renderer.SetLightingRenderStates(first);
 
-        renderer.UpdateTransforms(shaderProgram, fullscreenMatrix, first);
-        mesh->DrawSubmesh(0);
+        renderer.UpdateTransforms(shaderProgram, worldMatrix, first);
+        if (fullscreen)
+        {
+            // The triangle is not in the scene, don't test it against the depth
+            device.DisableFeature(GL_DEPTH_TEST);
+            device.SetDepthMask(false);
+            mesh->DrawSubmesh(0);
+        }
+        else
+        {
+            DrawLightVolume(*mesh, useStencil);
+        }
         first = false;
     }
 
-    //TODO: temp hack
-    renderer.GetDevice().EnableFeature(GL_DEPTH_TEST);
+    // Restore the states that the materials don't set
+    device.DisableFeature(GL_SCISSOR_TEST);
+    device.EnableFeature(GL_DEPTH_TEST);
+    device.SetDepthMask(true);
+}
+
+bool DeferredRenderPass::GetLightVolume(const Light& light, const Mesh*& mesh, glm::mat4& worldMatrix) const
+{
+    glm::vec4 attenuation = light.GetAttenuation();
+
+    // Without a range, the light reaches all the surfaces
+    float range = attenuation.y;
+    if (light.GetType() == Light::Type::Directional || range <= 0.0f)
+    {
+        return false;
+    }
+
+    glm::vec3 position = light.GetPosition();
+
+    // Wide spot lights are closer to a sphere than to a cone, and the cone base would get too large
+    float angle = attenuation.w;
+    if (light.GetType() == Light::Type::Spot && angle > 0.0f && angle < glm::radians(80.0f))
+    {
+        // The light shines opposite to its direction, see ComputeAngularAttenuation in the shaders
+        glm::vec3 axis = -glm::normalize(light.GetDirection());
+        glm::vec3 up = std::abs(axis.y) < 0.99f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+        glm::vec3 tangent = glm::normalize(glm::cross(up, axis));
+        glm::vec3 bitangent = glm::cross(axis, tangent);
+
+        // Cone along the axis, as long as the range and wide enough to contain the angle at that distance
+        float radius = range * std::tan(angle);
+        worldMatrix = glm::mat4(
+            glm::vec4(tangent * radius, 0.0f),
+            glm::vec4(bitangent * radius, 0.0f),
+            glm::vec4(axis * range, 0.0f),
+            glm::vec4(position, 1.0f));
+        mesh = &m_coneMesh;
+    }
+    else
+    {
+        worldMatrix = glm::translate(position) * glm::scale(glm::vec3(range));
+        mesh = &m_sphereMesh;
+    }
+    return true;
+}
+
+void DeferredRenderPass::DrawLightVolume(const Mesh& mesh, bool useStencil)
+{
+    DeviceGL& device = GetRenderer().GetDevice();
+
+    // The volume must not be clipped by the near or far planes, or it would miss the surfaces inside
+    device.EnableFeature(GL_DEPTH_CLAMP);
+    device.SetDepthMask(false);
+
+    if (useStencil)
+    {
+        // Mark the pixels with a surface inside the volume: behind the front faces and in front of the back faces
+        // Back faces behind the surface add 1, front faces behind the surface subtract 1, so only the inside is not 0
+        device.EnableFeature(GL_STENCIL_TEST);
+        device.DisableFeature(GL_CULL_FACE);
+        device.SetColorMask(false);
+        device.EnableFeature(GL_DEPTH_TEST);
+        device.SetDepthFunction(GL_LESS);
+        device.SetStencilFunction(GL_FRONT_AND_BACK, GL_ALWAYS, 0, 0xFF);
+        device.SetStencilOperations(GL_BACK, GL_KEEP, GL_INCR_WRAP, GL_KEEP);
+        device.SetStencilOperations(GL_FRONT, GL_KEEP, GL_DECR_WRAP, GL_KEEP);
+        mesh.DrawSubmesh(0);
+
+        // Light the marked pixels, and clear them for the next light
+        device.SetColorMask(true);
+        device.EnableFeature(GL_CULL_FACE);
+        device.DisableFeature(GL_DEPTH_TEST);
+        device.SetStencilFunction(GL_FRONT_AND_BACK, GL_NOTEQUAL, 0, 0xFF);
+        device.SetStencilOperations(GL_FRONT_AND_BACK, GL_KEEP, GL_ZERO, GL_ZERO);
+    }
+    else
+    {
+        // Without stencil, light the pixels with a surface in front of the back faces
+        device.EnableFeature(GL_DEPTH_TEST);
+        device.SetDepthFunction(GL_GEQUAL);
+    }
+
+    // Back faces, so the volume is still drawn when the camera is inside
+    device.SetCullFace(GL_FRONT);
+    mesh.DrawSubmesh(0);
+
+    device.SetCullFace(GL_BACK);
+    device.DisableFeature(GL_STENCIL_TEST);
+    device.DisableFeature(GL_DEPTH_CLAMP);
 }
 
 void DeferredRenderPass::InitializeMeshes()
 {
-    //TODO: Create meshes for spot and point lights
+    VertexFormat vertexFormat;
+    vertexFormat.AddVertexAttribute<float>(3, VertexAttribute::Semantic::Position);
+
+    const float pi = glm::pi<float>();
+
+    // UV sphere. The vertices are pushed out, so the flat faces are outside of the unit sphere
+    {
+        const unsigned int segments = 16, rings = 8;
+        const float scale = 1.0f / (std::cos(pi / segments) * std::cos(pi / (2 * rings)));
+
+        std::vector<glm::vec3> vertices;
+        vertices.emplace_back(0.0f, scale, 0.0f);
+        for (unsigned int ring = 1; ring < rings; ++ring)
+        {
+            float theta = pi * ring / rings;
+            for (unsigned int segment = 0; segment < segments; ++segment)
+            {
+                float phi = 2.0f * pi * segment / segments;
+                vertices.emplace_back(std::sin(theta) * std::cos(phi) * scale, std::cos(theta) * scale, -std::sin(theta) * std::sin(phi) * scale);
+            }
+        }
+        vertices.emplace_back(0.0f, -scale, 0.0f);
+
+        // Counter-clockwise from outside
+        unsigned short bottom = static_cast<unsigned short>(vertices.size() - 1);
+        std::vector<unsigned short> indices;
+        for (unsigned short segment = 0; segment < segments; ++segment)
+        {
+            unsigned short next = (segment + 1) % segments;
+            indices.insert(indices.end(), { 0, static_cast<unsigned short>(1 + segment), static_cast<unsigned short>(1 + next) });
+            for (unsigned short ring = 0; ring < rings - 2; ++ring)
+            {
+                unsigned short a = 1 + ring * segments + segment, b = 1 + ring * segments + next;
+                unsigned short c = a + segments, d = b + segments;
+                indices.insert(indices.end(), { a, c, d, a, d, b });
+            }
+            unsigned short last = 1 + (rings - 2) * segments;
+            indices.insert(indices.end(), { bottom, static_cast<unsigned short>(last + next), static_cast<unsigned short>(last + segment) });
+        }
+
+        m_sphereMesh.AddSubmesh<glm::vec3, unsigned short, VertexFormat::LayoutIterator>(Drawcall::Primitive::Triangles, vertices, indices,
+            vertexFormat.LayoutBegin(static_cast<int>(vertices.size()), false), vertexFormat.LayoutEnd());
+    }
+
+    // Cone with the apex in the origin and a capped base at Z = 1, pushed out to contain the round base
+    {
+        const unsigned int segments = 16;
+        const float scale = 1.0f / std::cos(pi / segments);
+
+        std::vector<glm::vec3> vertices;
+        vertices.emplace_back(0.0f, 0.0f, 0.0f);
+        for (unsigned int segment = 0; segment < segments; ++segment)
+        {
+            float phi = 2.0f * pi * segment / segments;
+            vertices.emplace_back(std::cos(phi) * scale, std::sin(phi) * scale, 1.0f);
+        }
+        vertices.emplace_back(0.0f, 0.0f, 1.0f);
+
+        // Counter-clockwise from outside
+        unsigned short center = static_cast<unsigned short>(vertices.size() - 1);
+        std::vector<unsigned short> indices;
+        for (unsigned short segment = 0; segment < segments; ++segment)
+        {
+            unsigned short a = 1 + segment, b = 1 + (segment + 1) % segments;
+            indices.insert(indices.end(), { 0, b, a, center, a, b });
+        }
+
+        m_coneMesh.AddSubmesh<glm::vec3, unsigned short, VertexFormat::LayoutIterator>(Drawcall::Primitive::Triangles, vertices, indices,
+            vertexFormat.LayoutBegin(static_cast<int>(vertices.size()), false), vertexFormat.LayoutEnd());
+    }
 }
@@ -0,0 +1,116 @@
+#include <ituGL/renderer/DepthPrepassRenderPass.h>
+
+#include <ituGL/camera/Camera.h>
+#include <ituGL/shader/Material.h>
+#include <ituGL/geometry/VertexArrayObject.h>
+#include <algorithm>
+
+DepthPrepassRenderPass::DepthPrepassRenderPass(std::shared_ptr<Material> depthMaterial, int drawcallCollectionIndex,
+    std::shared_ptr<const FramebufferObject> targetFramebuffer)
+    : RenderPass(targetFramebuffer)
+    , m_depthMaterial(depthMaterial)
+    , m_worldMatrixLocation(-1)
+    , m_viewProjMatrixLocation(-1)
+    , m_drawcallCollectionIndex(drawcallCollectionIndex)
+    , m_enabled(true)
+    , m_depthFunction(GL_EQUAL)
+    , m_sharedDrawcallCount(0)
+    , m_ownMaterialDrawcallCount(0)
+{
+    if (m_depthMaterial)
+    {
+        std::shared_ptr<const ShaderProgram> shaderProgram = m_depthMaterial->GetShaderProgram();
+        m_worldMatrixLocation = shaderProgram->GetUniformLocation("WorldMatrix");
+        m_viewProjMatrixLocation = shaderProgram->GetUniformLocation("ViewProjMatrix");
+        assert(m_worldMatrixLocation >= 0 && m_viewProjMatrixLocation >= 0);
+    }
+}
+
+void DepthPrepassRenderPass::SetOwnMaterialFunction(const Renderer::DrawcallSupportedFunction& ownMaterialFunction)
+{
+    m_ownMaterialFunction = ownMaterialFunction;
+}
+
+bool DepthPrepassRenderPass::IsIncluded(const Renderer::DrawcallInfo& drawcallInfo) const
+{
+    return drawcallInfo.GetMaterial().HasCapabilities(Material::Opaque | Material::DepthWrite);
+}
+
+bool DepthPrepassRenderPass::UsesOwnMaterial(const Renderer::DrawcallInfo& drawcallInfo) const
+{
+    return !m_depthMaterial || (m_ownMaterialFunction && m_ownMaterialFunction(drawcallInfo));
+}
+
+void DepthPrepassRenderPass::Render()
+{
+    m_sharedDrawcallCount = 0;
+    m_ownMaterialDrawcallCount = 0;
+
+    if (!m_enabled)
+    {
+        return;
+    }
+
+    Renderer& renderer = GetRenderer();
+    DeviceGL& device = renderer.GetDevice();
+
+    const Camera& camera = renderer.GetCurrentCamera();
+    const glm::mat4& viewMatrix = camera.GetViewMatrix();
+
+    // Sort the included drawcalls front to back, by the view depth of their origin, so the nearest surfaces hide the rest
+    m_sortedDrawcalls.clear();
+    for (const Renderer::DrawcallInfo& drawcallInfo : renderer.GetDrawcalls(m_drawcallCollectionIndex))
+    {
+        if (IsIncluded(drawcallInfo))
+        {
+            const glm::vec3 position(renderer.GetWorldMatrix(drawcallInfo.GetWorldMatrixIndex())[3]);
+            float viewDepth = -(viewMatrix[0][2] * position.x + viewMatrix[1][2] * position.y + viewMatrix[2][2] * position.z + viewMatrix[3][2]);
+            m_sortedDrawcalls.push_back(SortedDrawcall{ viewDepth, &drawcallInfo });
+        }
+    }
+    std::sort(m_sortedDrawcalls.begin(), m_sortedDrawcalls.end(),
+        [](const SortedDrawcall& a, const SortedDrawcall& b) { return a.depth < b.depth; });
+
+    // Depth mask needs to be enabled to clear the depth buffer
+    device.SetDepthMask(true);
+    device.Clear(false, Color(), true, 1.0f);
+
+    device.SetColorMask(false);
+
+    glm::mat4 viewProjMatrix = camera.GetViewProjectionMatrix();
+    bool sharedMaterialActive = false;
+    for (const SortedDrawcall& sortedDrawcall : m_sortedDrawcalls)
+    {
+        const Renderer::DrawcallInfo& drawcallInfo = *sortedDrawcall.drawcallInfo;
+        if (UsesOwnMaterial(drawcallInfo))
+        {
+            // The renderer doesn't know the state left by the shared material
+            if (sharedMaterialActive)
+            {
+                renderer.InvalidateDrawcallState();
+                sharedMaterialActive = false;
+            }
+
+            // One at a time, so they keep the order. Instanced programs get a single instance
+            renderer.PrepareDrawcalls(std::span<const Renderer::DrawcallInfo>(&drawcallInfo, 1));
+            renderer.DrawPreparedDrawcall(drawcallInfo);
+            m_ownMaterialDrawcallCount++;
+            continue;
+        }
+
+        // The shared material is set once, and only the world matrix changes between drawcalls
+        if (!sharedMaterialActive)
+        {
+            m_depthMaterial->Use();
+            m_depthMaterial->GetShaderProgram()->SetUniform(m_viewProjMatrixLocation, viewProjMatrix);
+            sharedMaterialActive = true;
+        }
+        const ShaderProgram& shaderProgram = *m_depthMaterial->GetShaderProgram();
+        shaderProgram.SetUniform(m_worldMatrixLocation, renderer.GetWorldMatrix(drawcallInfo.GetWorldMatrixIndex()));
+        drawcallInfo.GetVAO().Bind();
+        drawcallInfo.GetDrawcall().Draw();
+        m_sharedDrawcallCount++;
+    }
+
+    device.SetColorMask(true);
+}
@@ -1,9 +1,13 @@
 #include <ituGL/renderer/ForwardRenderPass.h>
 
+#include <ituGL/renderer/DepthPrepassRenderPass.h>
 #include <ituGL/camera/Camera.h>
 #include <ituGL/shader/Material.h>
 #include <ituGL/geometry/VertexArrayObject.h>
 #include <ituGL/renderer/Renderer.h>
+#include <ituGL/lighting/Light.h>
+#include <algorithm>
+#include <utility>
 
 ForwardRenderPass::ForwardRenderPass()
     : ForwardRenderPass(0)
@@ -13,37 +17,208 @@ ForwardRenderPass::ForwardRenderPass()
 
 ForwardRenderPass::ForwardRenderPass(int drawcallCollectionIndex)
     : m_drawcallCollectionIndex(drawcallCollectionIndex)
+    , m_depthPrepass(nullptr)
+    , m_overdrawQueryIndex(0)
 {
 }
 
+bool ForwardRenderPass::IsDepthPrepassEnabled() const
+{
+    return m_depthPrepass && m_depthPrepass->IsEnabled();
+}
+
 void ForwardRenderPass::Render()
 {
     Renderer& renderer = GetRenderer();
 
+    GLint x, y;
+    GLsizei width, height;
+    renderer.GetDevice().GetViewport(x, y, width, height);
+
+    PrepareLights(x, y, width, height);
+
+    m_commandBuffer.Clear();
+    Record(m_commandBuffer);
+
+    BeginOverdrawQuery(width * height);
+    renderer.ExecuteCommands(m_commandBuffer);
+    EndOverdrawQuery();
+}
+
+void ForwardRenderPass::PrepareLights(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    const Renderer& renderer = GetRenderer();
     const Camera& camera = renderer.GetCurrentCamera();
+    const auto& lights = renderer.GetLights();
+
+    // Find which kinds of programs are drawn. Consecutive drawcalls usually share the program
+    bool lightClustersNeeded = false;
+    bool lightScreenBoundsNeeded = false;
+    const ShaderProgram* lastShaderProgram = nullptr;
+    for (const Renderer::DrawcallInfo& drawcallInfo : renderer.GetDrawcalls(m_drawcallCollectionIndex))
+    {
+        std::shared_ptr<const ShaderProgram> shaderProgram = drawcallInfo.GetMaterial().GetShaderProgram();
+        if (shaderProgram.get() != lastShaderProgram)
+        {
+            // Also queries the locations of new programs, which can't be done while recording
+            if (GetLightClusterLocations(shaderProgram).IsValid())
+            {
+                lightClustersNeeded = true;
+            }
+            else
+            {
+                lightScreenBoundsNeeded = true;
+            }
+            lastShaderProgram = shaderProgram.get();
+        }
+    }
+
+    // Assign the lights to the clusters
+    if (lightClustersNeeded)
+    {
+        m_lightClusterGrid.Build(camera, width, height, lights);
+    }
+
+    // Project the lights
+    m_lightScreenBounds.clear();
+    if (lightScreenBoundsNeeded)
+    {
+        m_lightScreenProjector.SetCamera(camera, x, y, width, height);
+        for (const Light* light : lights)
+        {
+            m_lightScreenBounds.push_back(m_lightScreenProjector.GetScreenBounds(*light));
+        }
+    }
+}
+
+void ForwardRenderPass::Record(CommandBuffer& commandBuffer)
+{
+    Renderer& renderer = GetRenderer();
+
     const auto& lights = renderer.GetLights();
     const auto& drawcallCollection = renderer.GetDrawcalls(m_drawcallCollectionIndex);
 
-    // for all drawcalls
-    for (const Renderer::DrawcallInfo& drawcallInfo : drawcallCollection)
+    bool depthPrepass = IsDepthPrepassEnabled();
+
+    const ShaderProgram* lightClustersProgram = nullptr;
+
+    // for all drawcalls, consecutive ones may be drawn together as instances
+    for (size_t index = 0; index < drawcallCollection.size(); )
     {
+        const Renderer::DrawcallInfo& drawcallInfo = drawcallCollection[index];
+
+        // The depth of the drawcalls in the prepass is already there, only the visible fragments need to be shaded
+        Material::OverrideFlags materialOverride = Material::NoOverride;
+        if (depthPrepass && m_depthPrepass->IsIncluded(drawcallInfo))
+        {
+            commandBuffer.SetDepthFunction(m_depthPrepass->GetDepthFunction());
+            commandBuffer.SetDepthMask(false);
+            materialOverride = Material::OverrideDepthTest;
+        }
+
         // Prepare drawcall states
-        renderer.PrepareDrawcall(drawcallInfo);
+        index += renderer.RecordPrepareDrawcalls(commandBuffer, drawcallCollection.subspan(index), materialOverride);
 
         std::shared_ptr<const ShaderProgram> shaderProgram = drawcallInfo.GetMaterial().GetShaderProgram();
 
-        //for all lights
+        // Found by PrepareLights
+        const auto itFind = m_lightClusterLocations.find(shaderProgram);
+        assert(itFind != m_lightClusterLocations.end());
+        const LightClusterGrid::Locations& lightClusterLocations = itFind->second;
+        if (lightClusterLocations.IsValid())
+        {
+            // Uniforms are kept by the program, only set them when it changes
+            if (shaderProgram.get() != lightClustersProgram)
+            {
+                m_lightClusterGrid.Record(commandBuffer, lightClusterLocations, LightClusterTextureUnit);
+
+                // Without lights, the program only sets the indirect lighting
+                unsigned int lightIndex = 0;
+                renderer.RecordUpdateLights(commandBuffer, shaderProgram, std::span<const Light* const>(), lightIndex);
+
+                lightClustersProgram = shaderProgram.get();
+            }
+
+            // Single pass with all the lights
+            renderer.RecordDrawPreparedDrawcall(commandBuffer, drawcallInfo);
+            continue;
+        }
+
+        // for all lights, as many passes as the update function asks for. A pass may set more than one light
         bool first = true;
         unsigned int lightIndex = 0;
-        while (renderer.UpdateLights(shaderProgram, lights, lightIndex))
+        unsigned int nextPassLightIndex = 0;
+        while (renderer.RecordUpdateLights(commandBuffer, shaderProgram, lights, lightIndex))
         {
+            unsigned int passLightIndex = std::exchange(nextPassLightIndex, lightIndex);
+
+            // The first pass also adds the ambient light to all the pixels. The others only reach the rectangle of their lights
+            if (!first)
+            {
+                LightScreenProjector::ScreenBounds screenBounds;
+                for (unsigned int i = passLightIndex; i < lightIndex && i < m_lightScreenBounds.size(); ++i)
+                {
+                    screenBounds = LightScreenProjector::GetUnion(screenBounds, m_lightScreenBounds[i]);
+                }
+                if (screenBounds.IsEmpty())
+                {
+                    continue;
+                }
+                m_lightScreenProjector.RecordScissor(commandBuffer, screenBounds);
+            }
+
             // Set the renderstates
-            renderer.SetLightingRenderStates(first);
-            
+            renderer.RecordLightingRenderStates(commandBuffer, first);
+
             // Draw
-            drawcallInfo.GetDrawcall().Draw();
+            renderer.RecordDrawPreparedDrawcall(commandBuffer, drawcallInfo);
 
             first = false;
         }
+        commandBuffer.SetFeatureEnabled(GL_SCISSOR_TEST, false);
+    }
+
+    // Restore the depth states that the prepass replaced
+    if (depthPrepass)
+    {
+        commandBuffer.SetDepthFunction(GL_LESS);
+        commandBuffer.SetDepthMask(true);
+    }
+}
+
+void ForwardRenderPass::BeginOverdrawQuery(GLsizei pixelCount)
+{
+    // Read the results that are ready, oldest first
+    for (unsigned int i = 1; i <= OverdrawQueryCount; ++i)
+    {
+        OverdrawQuery& overdrawQuery = m_overdrawQueries[(m_overdrawQueryIndex + i) % OverdrawQueryCount];
+        if (overdrawQuery.pending && overdrawQuery.query.IsResultAvailable())
+        {
+            m_overdrawStats.samples = overdrawQuery.query.GetResult();
+            m_overdrawStats.samplesPerPixel = overdrawQuery.pixelCount > 0 ? static_cast<float>(m_overdrawStats.samples) / overdrawQuery.pixelCount : 0.0f;
+            overdrawQuery.pending = false;
+        }
+    }
+
+    // Starting a query discards its previous result, if it was never read
+    m_overdrawQueryIndex = (m_overdrawQueryIndex + 1) % OverdrawQueryCount;
+    OverdrawQuery& overdrawQuery = m_overdrawQueries[m_overdrawQueryIndex];
+    overdrawQuery.query.Begin(QueryObject::Target::SamplesPassed);
+    overdrawQuery.pixelCount = pixelCount;
+    overdrawQuery.pending = true;
+}
+
+void ForwardRenderPass::EndOverdrawQuery()
+{
+    QueryObject::End(QueryObject::Target::SamplesPassed);
+}
+
+const LightClusterGrid::Locations& ForwardRenderPass::GetLightClusterLocations(std::shared_ptr<const ShaderProgram> shaderProgram)
+{
+    auto itFind = m_lightClusterLocations.find(shaderProgram);
+    if (itFind == m_lightClusterLocations.end())
+    {
+        itFind = m_lightClusterLocations.emplace(shaderProgram, LightClusterGrid::GetLocations(*shaderProgram)).first;
     }
+    return itFind->second;
 }
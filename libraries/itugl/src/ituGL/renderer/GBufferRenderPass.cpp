@@ -20,7 +20,8 @@ void GBufferRenderPass::InitFramebuffer()
 
     targetFramebuffer->Bind();
 
-    targetFramebuffer->SetTexture(FramebufferObject::Target::Draw, FramebufferObject::Attachment::Depth, *m_depthTexture);
+    // Depth with stencil, so it can be copied to a framebuffer that uses stencil to cull the light volumes
+    targetFramebuffer->SetTexture(FramebufferObject::Target::Draw, FramebufferObject::Attachment::DepthStencil, *m_depthTexture);
 
     // Set the albedo texture as color attachment 0
     targetFramebuffer->SetTexture(FramebufferObject::Target::Draw, FramebufferObject::Attachment::Color0, *m_albedoTexture);
@@ -49,7 +50,7 @@ void GBufferRenderPass::InitTextures(int width, int height)
     // Depth: Set the min and magfilter as nearest
     m_depthTexture = std::make_shared<Texture2DObject>();
     m_depthTexture->Bind();
-    m_depthTexture->SetImage(0, width, height, TextureObject::FormatDepth, TextureObject::InternalFormatDepth);
+    m_depthTexture->SetImage(0, width, height, TextureObject::FormatDepthStencil, TextureObject::InternalFormatDepth24Stencil8);
     m_depthTexture->SetParameter(TextureObject::ParameterEnum::MinFilter, GL_NEAREST);
     m_depthTexture->SetParameter(TextureObject::ParameterEnum::MagFilter, GL_NEAREST);
 
@@ -81,29 +82,32 @@ void GBufferRenderPass::Render()
 {
     Renderer& renderer = GetRenderer();
 
-    const Camera& camera = renderer.GetCurrentCamera();
-    const auto& lights = renderer.GetLights();
     const auto& drawcallCollection = renderer.GetDrawcalls(m_drawcallCollectionIndex);
 
     renderer.GetDevice().Clear(true, Color(0.0f, 0.0f, 0.0f, 1.0f), true, 1.0f);
 
     bool wasSRGB = renderer.GetDevice().IsFeatureEnabled(GL_FRAMEBUFFER_SRGB);
-    renderer.GetDevice().EnableFeature(GL_FRAMEBUFFER_SRGB);
 
-    // for all drawcalls
-    for (const Renderer::DrawcallInfo& drawcallInfo : drawcallCollection)
+    m_commandBuffer.Clear();
+    m_commandBuffer.SetFeatureEnabled(GL_FRAMEBUFFER_SRGB, true);
+
+    // for all drawcalls, consecutive ones may be drawn together as instances
+    for (size_t index = 0; index < drawcallCollection.size(); )
     {
+        const Renderer::DrawcallInfo& drawcallInfo = drawcallCollection[index];
         const Material& material = drawcallInfo.GetMaterial();
         assert(material.GetBlendEquationColor() == Material::BlendEquation::None);
         assert(material.GetBlendEquationAlpha() == Material::BlendEquation::None);
         assert(material.GetDepthWrite());
 
         // Prepare drawcall (similar to forward)
-        renderer.PrepareDrawcall(drawcallInfo);
+        index += renderer.RecordPrepareDrawcalls(m_commandBuffer, drawcallCollection.subspan(index));
 
         // Render drawcall
-        drawcallInfo.GetDrawcall().Draw();
+        renderer.RecordDrawPreparedDrawcall(m_commandBuffer, drawcallInfo);
     }
 
-    renderer.GetDevice().SetFeatureEnabled(GL_FRAMEBUFFER_SRGB, wasSRGB);
+    m_commandBuffer.SetFeatureEnabled(GL_FRAMEBUFFER_SRGB, wasSRGB);
+
+    renderer.ExecuteCommands(m_commandBuffer);
 }
@@ -0,0 +1,210 @@
+#include <ituGL/renderer/GLCommandExecutor.h>
+
+#include <ituGL/core/DeviceGL.h>
+
+GLCommandExecutor::GLCommandExecutor(DeviceGL& device) : m_device(device)
+{
+}
+
+void GLCommandExecutor::Execute(const CommandBuffer& commandBuffer)
+{
+    using CommandType = CommandBuffer::CommandType;
+
+    for (const CommandBuffer::ConstIterator& command : commandBuffer)
+    {
+        switch (command.GetType())
+        {
+        case CommandType::SetFeature:
+        {
+            const auto& setFeature = command.Get<CommandBuffer::SetFeatureCommand>();
+            m_device.SetFeatureEnabled(setFeature.feature, setFeature.enabled == GL_TRUE);
+            break;
+        }
+        case CommandType::SetDepthFunction:
+            m_device.SetDepthFunction(command.Get<CommandBuffer::SetDepthFunctionCommand>().function);
+            break;
+        case CommandType::SetDepthMask:
+            m_device.SetDepthMask(command.Get<CommandBuffer::SetDepthMaskCommand>().enabled == GL_TRUE);
+            break;
+        case CommandType::SetBlendEquation:
+        {
+            const auto& blendEquation = command.Get<CommandBuffer::SetBlendEquationCommand>();
+            m_device.SetBlendEquation(blendEquation.colorEquation, blendEquation.alphaEquation);
+            break;
+        }
+        case CommandType::SetBlendFunction:
+        {
+            const auto& blendFunction = command.Get<CommandBuffer::SetBlendFunctionCommand>();
+            m_device.SetBlendFunction(blendFunction.sourceColor, blendFunction.destColor, blendFunction.sourceAlpha, blendFunction.destAlpha);
+            break;
+        }
+        case CommandType::SetBlendColor:
+        {
+            const GLfloat* color = command.Get<CommandBuffer::SetBlendColorCommand>().color;
+            m_device.SetBlendColor(Color(color[0], color[1], color[2], color[3]));
+            break;
+        }
+        case CommandType::SetStencilFunction:
+        {
+            const auto& stencilFunction = command.Get<CommandBuffer::SetStencilFunctionCommand>();
+            m_device.SetStencilFunction(stencilFunction.face, stencilFunction.function, stencilFunction.refValue, stencilFunction.mask);
+            break;
+        }
+        case CommandType::SetStencilOperations:
+        {
+            const auto& stencilOperations = command.Get<CommandBuffer::SetStencilOperationsCommand>();
+            m_device.SetStencilOperations(stencilOperations.face, stencilOperations.stencilFail, stencilOperations.depthFail, stencilOperations.depthPass);
+            break;
+        }
+        case CommandType::SetScissor:
+        {
+            const auto& scissor = command.Get<CommandBuffer::SetScissorCommand>();
+            m_device.SetScissor(scissor.x, scissor.y, scissor.width, scissor.height);
+            break;
+        }
+        case CommandType::UseProgram:
+            m_device.UseShaderProgram(command.Get<CommandBuffer::UseProgramCommand>().handle);
+            break;
+        case CommandType::SetUniforms:
+            SetUniforms(command.Get<CommandBuffer::SetUniformsCommand>(), command.GetPayload<CommandBuffer::SetUniformsCommand>());
+            break;
+        case CommandType::BindUniformBlock:
+        {
+            const auto& bindUniformBlock = command.Get<CommandBuffer::BindUniformBlockCommand>();
+            glBindBufferRange(GL_UNIFORM_BUFFER, bindUniformBlock.bindingIndex, bindUniformBlock.bufferHandle, bindUniformBlock.offset, bindUniformBlock.size);
+            break;
+        }
+        case CommandType::BindVertexArray:
+            m_device.BindVertexArray(command.Get<CommandBuffer::BindVertexArrayCommand>().handle);
+            break;
+        case CommandType::BindTexture:
+        {
+            const auto& bindTexture = command.Get<CommandBuffer::BindTextureCommand>();
+            m_device.SetActiveTextureUnit(bindTexture.textureUnit);
+            m_device.BindTexture(bindTexture.target, bindTexture.handle);
+            break;
+        }
+        case CommandType::DrawArrays:
+        {
+            const auto& drawArrays = command.Get<CommandBuffer::DrawArraysCommand>();
+            if (drawArrays.instanceCount == 0)
+            {
+                glDrawArrays(drawArrays.primitive, drawArrays.first, drawArrays.count);
+            }
+            else
+            {
+                glDrawArraysInstanced(drawArrays.primitive, drawArrays.first, drawArrays.count, drawArrays.instanceCount);
+            }
+            break;
+        }
+        case CommandType::DrawElements:
+        {
+            // Same as Drawcall::Draw and DrawInstanced, first is an offset in the EBO bound to the VAO
+            const auto& drawElements = command.Get<CommandBuffer::DrawElementsCommand>();
+            const char* basePointer = nullptr;
+            if (drawElements.instanceCount == 0)
+            {
+                if (drawElements.baseVertex == 0)
+                {
+                    glDrawElements(drawElements.primitive, drawElements.count, drawElements.eboType, basePointer + drawElements.first);
+                }
+                else
+                {
+                    glDrawElementsBaseVertex(drawElements.primitive, drawElements.count, drawElements.eboType, basePointer + drawElements.first, drawElements.baseVertex);
+                }
+            }
+            else
+            {
+                if (drawElements.baseVertex == 0)
+                {
+                    glDrawElementsInstanced(drawElements.primitive, drawElements.count, drawElements.eboType, basePointer + drawElements.first, drawElements.instanceCount);
+                }
+                else
+                {
+                    glDrawElementsInstancedBaseVertex(drawElements.primitive, drawElements.count, drawElements.eboType, basePointer + drawElements.first,
+                        drawElements.instanceCount, drawElements.baseVertex);
+                }
+            }
+            break;
+        }
+        case CommandType::CallFunction:
+            commandBuffer.GetFunction(command.Get<CommandBuffer::CallFunctionCommand>().index)();
+            break;
+        default:
+            assert(false);
+        }
+    }
+}
+
+void GLCommandExecutor::SetUniforms(const CommandBuffer::SetUniformsCommand& command, std::span<const std::byte> payload)
+{
+    GLint location = command.location;
+    GLsizei count = command.count;
+    const void* data = payload.data();
+
+    if (command.columns == 1)
+    {
+        // Scalars and vectors
+        switch (command.type)
+        {
+        case Data::Type::Float:
+            switch (command.components)
+            {
+            case 1: glUniform1fv(location, count, static_cast<const GLfloat*>(data)); break;
+            case 2: glUniform2fv(location, count, static_cast<const GLfloat*>(data)); break;
+            case 3: glUniform3fv(location, count, static_cast<const GLfloat*>(data)); break;
+            case 4: glUniform4fv(location, count, static_cast<const GLfloat*>(data)); break;
+            }
+            break;
+        case Data::Type::Int:
+            switch (command.components)
+            {
+            case 1: glUniform1iv(location, count, static_cast<const GLint*>(data)); break;
+            case 2: glUniform2iv(location, count, static_cast<const GLint*>(data)); break;
+            case 3: glUniform3iv(location, count, static_cast<const GLint*>(data)); break;
+            case 4: glUniform4iv(location, count, static_cast<const GLint*>(data)); break;
+            }
+            break;
+        case Data::Type::UInt:
+            switch (command.components)
+            {
+            case 1: glUniform1uiv(location, count, static_cast<const GLuint*>(data)); break;
+            case 2: glUniform2uiv(location, count, static_cast<const GLuint*>(data)); break;
+            case 3: glUniform3uiv(location, count, static_cast<const GLuint*>(data)); break;
+            case 4: glUniform4uiv(location, count, static_cast<const GLuint*>(data)); break;
+            }
+            break;
+        case Data::Type::Double:
+            switch (command.components)
+            {
+            case 1: glUniform1dv(location, count, static_cast<const GLdouble*>(data)); break;
+            case 2: glUniform2dv(location, count, static_cast<const GLdouble*>(data)); break;
+            case 3: glUniform3dv(location, count, static_cast<const GLdouble*>(data)); break;
+            case 4: glUniform4dv(location, count, static_cast<const GLdouble*>(data)); break;
+            }
+            break;
+        default:
+            assert(false);
+        }
+    }
+    else
+    {
+        // Matrices, only float. Columns x rows
+        assert(command.type == Data::Type::Float);
+        const GLfloat* values = static_cast<const GLfloat*>(data);
+        switch (command.columns * 10 + command.components)
+        {
+        case 22: glUniformMatrix2fv(location, count, GL_FALSE, values); break;
+        case 23: glUniformMatrix2x3fv(location, count, GL_FALSE, values); break;
+        case 24: glUniformMatrix2x4fv(location, count, GL_FALSE, values); break;
+        case 32: glUniformMatrix3x2fv(location, count, GL_FALSE, values); break;
+        case 33: glUniformMatrix3fv(location, count, GL_FALSE, values); break;
+        case 34: glUniformMatrix3x4fv(location, count, GL_FALSE, values); break;
+        case 42: glUniformMatrix4x2fv(location, count, GL_FALSE, values); break;
+        case 43: glUniformMatrix4x3fv(location, count, GL_FALSE, values); break;
+        case 44: glUniformMatrix4fv(location, count, GL_FALSE, values); break;
+        default:
+            assert(false);
+        }
+    }
+}
@@ -0,0 +1,256 @@
+#include <ituGL/renderer/GpuDrivenRenderPass.h>
+
+#include <ituGL/camera/Camera.h>
+#include <ituGL/shader/Material.h>
+#include <ituGL/geometry/Model.h>
+#include <ituGL/geometry/Mesh.h>
+#include <ituGL/geometry/VertexArrayObject.h>
+#include <ituGL/renderer/OcclusionCuller.h>
+#include <algorithm>
+#include <array>
+#include <tuple>
+
+static_assert(sizeof(DrawIndirectBufferObject::Command) == 5 * sizeof(GLuint), "Commands are read as 5 uints by the culling program");
+
+GpuDrivenRenderPass::GpuDrivenRenderPass(std::shared_ptr<ShaderProgram> cullingProgram, std::shared_ptr<const FramebufferObject> targetFramebuffer)
+    : RenderPass(targetFramebuffer)
+    , m_cullingProgram(cullingProgram)
+    , m_hiZEnabled(true)
+{
+    assert(m_cullingProgram);
+    m_objectCountLocation = m_cullingProgram->GetUniformLocation("ObjectCount");
+    m_frustumPlanesLocation = m_cullingProgram->GetUniformLocation("FrustumPlanes");
+    m_hiZViewProjMatrixLocation = m_cullingProgram->GetUniformLocation("HiZViewProjMatrix");
+    m_hiZSizeLocation = m_cullingProgram->GetUniformLocation("HiZSize");
+    m_hiZLevelsLocation = m_cullingProgram->GetUniformLocation("HiZLevels");
+    m_hiZLevelCountLocation = m_cullingProgram->GetUniformLocation("HiZLevelCount");
+}
+
+bool GpuDrivenRenderPass::IsSupported()
+{
+    // Compute shaders, storage buffers and multi-draw indirect are all core in 4.3
+    return GLAD_GL_VERSION_4_3;
+}
+
+void GpuDrivenRenderPass::Render()
+{
+    m_stats = Stats();
+
+    Renderer& renderer = GetRenderer();
+    std::span<const Renderer::GpuCulledModel> models = renderer.GetGpuCulledModels();
+    if (models.empty())
+    {
+        return;
+    }
+
+    BuildGroups(models);
+
+    if (!m_objects.empty())
+    {
+        UploadBuffers();
+        Cull();
+
+        // The compute program replaced the one of the last drawcall
+        renderer.InvalidateDrawcallState();
+        DrawBatches();
+    }
+
+    DrawFallback(models);
+}
+
+void GpuDrivenRenderPass::BuildGroups(std::span<const Renderer::GpuCulledModel> models)
+{
+    const Renderer& renderer = GetRenderer();
+
+    // Split the submeshes between the ones that can be instanced and the rest
+    m_items.clear();
+    m_fallbackItems.clear();
+    for (unsigned int modelIndex = 0; modelIndex < models.size(); ++modelIndex)
+    {
+        const Model& model = *models[modelIndex].model;
+        const Mesh& mesh = model.GetMesh();
+        for (unsigned int submeshIndex = 0; submeshIndex < mesh.GetSubmeshCount(); ++submeshIndex)
+        {
+            const Material& material = model.GetMaterial(submeshIndex);
+            Item item{ &material, &mesh.GetSubmeshVertexArray(submeshIndex), &mesh.GetSubmeshDrawcall(submeshIndex), modelIndex };
+            if (renderer.GetInstanceMatrixLocation(material.GetShaderProgram()) >= 0)
+            {
+                m_items.push_back(item);
+            }
+            else
+            {
+                m_fallbackItems.push_back(item);
+            }
+        }
+    }
+
+    // Items of the same group end up together, and groups of the same batch too
+    std::sort(m_items.begin(), m_items.end(), [](const Item& a, const Item& b)
+        {
+            return std::make_tuple(a.material->GetShaderProgram().get(), a.material, a.vao, a.drawcall)
+                < std::make_tuple(b.material->GetShaderProgram().get(), b.material, b.vao, b.drawcall);
+        });
+
+    m_objects.clear();
+    m_commands.clear();
+    m_batches.clear();
+    GLuint groupBaseInstance = 0;
+    for (unsigned int itemIndex = 0; itemIndex < m_items.size(); ++itemIndex)
+    {
+        const Item& item = m_items[itemIndex];
+
+        // Start a group when the drawcall changes, and a batch when the material, VAO or drawcall type change
+        bool newGroup = itemIndex == 0;
+        bool newBatch = itemIndex == 0;
+        if (itemIndex > 0)
+        {
+            const Item& previousItem = m_items[itemIndex - 1];
+            newBatch = item.material != previousItem.material || item.vao != previousItem.vao ||
+                item.drawcall->GetPrimitive() != previousItem.drawcall->GetPrimitive() ||
+                item.drawcall->GetEboType() != previousItem.drawcall->GetEboType();
+            newGroup = newBatch || item.drawcall != previousItem.drawcall;
+        }
+
+        const Renderer::GpuCulledModel& model = models[item.modelIndex];
+        if (newBatch)
+        {
+            Renderer::DrawcallInfo drawcallInfo(*item.material, model.worldMatrixIndex, *item.vao, *item.drawcall);
+            m_batches.push_back(Batch{ static_cast<unsigned int>(m_commands.size()), 0, drawcallInfo });
+        }
+        if (newGroup)
+        {
+            // No instances until the compute shader adds the visible ones
+            groupBaseInstance = static_cast<GLuint>(m_objects.size());
+            m_commands.push_back(DrawIndirectBufferObject::Command::Create(*item.drawcall, 0, groupBaseInstance));
+            m_batches.back().groupCount++;
+        }
+
+        // Visible objects of the group are compacted from its first instance
+        GLuint groupIndex = static_cast<GLuint>(m_commands.size() - 1);
+        ObjectData& object = m_objects.emplace_back();
+        object.center = glm::vec4(model.worldBounds.GetCenter(), 1.0f);
+        object.extents = glm::vec4(model.worldBounds.GetSize(), 0.0f);
+        object.worldMatrix = renderer.GetWorldMatrix(model.worldMatrixIndex);
+        object.info = glm::uvec4(groupIndex, groupBaseInstance, 0, 0);
+    }
+
+    m_stats.objects = static_cast<unsigned int>(m_objects.size());
+    m_stats.groups = static_cast<unsigned int>(m_commands.size());
+}
+
+void GpuDrivenRenderPass::UploadBuffers()
+{
+    // Allocate again every frame, so we don't wait for the last frame to stop using them
+    m_objectBuffer.Bind();
+    m_objectBuffer.AllocateData(std::span<const ObjectData>(m_objects));
+    m_objectBuffer.BindBase(ObjectsBinding);
+
+    m_commandBuffer.Bind();
+    m_commandBuffer.AllocateData(m_commands, BufferObject::Usage::StreamDraw);
+    ShaderStorageBufferObject::BindBase(CommandsBinding, m_commandBuffer);
+
+    // Written by the compute shader and read by the vertex shaders
+    m_instanceBuffer.Bind();
+    m_instanceBuffer.AllocateData(m_objects.size() * sizeof(glm::mat4), BufferObject::Usage::StreamCopy);
+    ShaderStorageBufferObject::BindBase(InstanceMatricesBinding, m_instanceBuffer);
+
+    // All the levels of the depth hierarchy, one after the other
+    m_hiZDepth.clear();
+    const OcclusionCuller* occlusionCuller = GetRenderer().GetOcclusionCuller();
+    if (m_hiZEnabled && occlusionCuller)
+    {
+        int levelCount = std::min(occlusionCuller->GetLevelCount(), MaxHiZLevels);
+        for (int level = 0; level < levelCount; ++level)
+        {
+            std::span<const float> depth = occlusionCuller->GetLevelDepth(level);
+            m_hiZDepth.insert(m_hiZDepth.end(), depth.begin(), depth.end());
+        }
+    }
+    else
+    {
+        // Bindings must point to a buffer even if the shader doesn't read it
+        m_hiZDepth.push_back(1.0f);
+    }
+    m_hiZBuffer.Bind();
+    m_hiZBuffer.AllocateData(std::span<const float>(m_hiZDepth));
+    m_hiZBuffer.BindBase(HiZDepthBinding);
+}
+
+void GpuDrivenRenderPass::Cull()
+{
+    const Renderer& renderer = GetRenderer();
+    const ShaderProgram& program = *m_cullingProgram;
+
+    program.Use();
+
+    GLuint objectCount = static_cast<GLuint>(m_objects.size());
+    program.SetUniform(m_objectCountLocation, objectCount);
+    program.SetUniforms(m_frustumPlanesLocation, std::span<const glm::vec4>(renderer.GetCurrentFrustum().GetPlanes()));
+
+    // Level sizes and offsets in the depth buffer. No levels disable the test
+    const OcclusionCuller* occlusionCuller = renderer.GetOcclusionCuller();
+    int levelCount = 0;
+    std::array<glm::ivec4, MaxHiZLevels> levels = {};
+    if (m_hiZEnabled && occlusionCuller)
+    {
+        levelCount = std::min(occlusionCuller->GetLevelCount(), MaxHiZLevels);
+        int offset = 0;
+        for (int level = 0; level < levelCount; ++level)
+        {
+            glm::ivec2 size = occlusionCuller->GetLevelSize(level);
+            levels[level] = glm::ivec4(size, offset, 0);
+            offset += size.x * size.y;
+        }
+        program.SetUniform(m_hiZViewProjMatrixLocation, occlusionCuller->GetViewProjectionMatrix());
+        program.SetUniform(m_hiZSizeLocation, glm::vec2(occlusionCuller->GetWidth(), occlusionCuller->GetHeight()));
+    }
+    program.SetUniforms(m_hiZLevelsLocation, std::span<const glm::ivec4>(levels));
+    program.SetUniform(m_hiZLevelCountLocation, levelCount);
+
+    glDispatchCompute((objectCount + WorkGroupSize - 1) / WorkGroupSize, 1, 1);
+
+    // Commands and instance matrices are read by the drawcalls
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+}
+
+void GpuDrivenRenderPass::DrawBatches()
+{
+    Renderer& renderer = GetRenderer();
+
+    m_commandBuffer.Bind();
+    for (const Batch& batch : m_batches)
+    {
+        const Renderer::DrawcallInfo& drawcallInfo = batch.drawcallInfo;
+        renderer.PrepareDrawcall(drawcallInfo);
+
+        // Instances of all the groups are in the same buffer, each command starts at its base instance
+        ShaderProgram::Location location = renderer.GetInstanceMatrixLocation(drawcallInfo.GetMaterial().GetShaderProgram());
+        m_instanceBuffer.Bind();
+        Renderer::SetInstanceMatrixAttribute(location, 0);
+
+        const Drawcall& drawcall = drawcallInfo.GetDrawcall();
+        DrawIndirectBufferObject::MultiDraw(drawcall.GetPrimitive(), drawcall.GetEboType(), batch.firstGroup, batch.groupCount);
+        Renderer::ResetInstanceMatrixAttribute(location);
+        m_stats.multiDraws++;
+    }
+    DrawIndirectBufferObject::Unbind();
+
+    // Buffers were bound behind the renderer, start the next drawcalls from scratch
+    renderer.InvalidateDrawcallState();
+}
+
+void GpuDrivenRenderPass::DrawFallback(std::span<const Renderer::GpuCulledModel> models)
+{
+    Renderer& renderer = GetRenderer();
+    for (const Item& item : m_fallbackItems)
+    {
+        const Renderer::GpuCulledModel& model = models[item.modelIndex];
+        if (renderer.IsVisible(model.worldBounds))
+        {
+            Renderer::DrawcallInfo drawcallInfo(*item.material, model.worldMatrixIndex, *item.vao, *item.drawcall);
+            renderer.PrepareDrawcall(drawcallInfo);
+            item.drawcall->Draw();
+            m_stats.fallbackDrawcalls++;
+        }
+    }
+}
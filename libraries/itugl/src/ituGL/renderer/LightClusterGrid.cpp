@@ -0,0 +1,361 @@
+#include <ituGL/renderer/LightClusterGrid.h>
+
+#include <ituGL/camera/Camera.h>
+#include <ituGL/lighting/Light.h>
+#include <ituGL/renderer/CommandBuffer.h>
+#include <glm/common.hpp>
+#include <glm/exponential.hpp>
+#include <glm/matrix.hpp>
+#include <algorithm>
+#include <thread>
+#include <limits>
+#include <cmath>
+#include <cassert>
+
+// Below this number of lights, the cost of waking up the workers is higher than the work they save
+static const unsigned int s_minLightsPerThread = 16;
+
+LightClusterGrid::LightClusterGrid(unsigned int tilesX, unsigned int tilesY, unsigned int slices)
+    : m_tilesX(tilesX)
+    , m_tilesY(tilesY)
+    , m_slices(slices)
+    , m_threadCount(0)
+    , m_projMatrix(0.0f)
+    , m_width(0)
+    , m_height(0)
+    , m_nearDepth(0.0f)
+    , m_farDepth(0.0f)
+    , m_sliceScale(0.0f)
+    , m_sliceBias(0.0f)
+    , m_depthPlane(0.0f)
+    , m_lightCount(0)
+    , m_globalLightCount(0)
+    , m_maxClusterLightCount(0)
+{
+    assert(tilesX > 0 && tilesY > 0 && slices > 0);
+}
+
+void LightClusterGrid::Build(const Camera& camera, int width, int height, std::span<const Light* const> lights)
+{
+    BuildLists(camera, width, height, lights);
+
+    m_lightDataTexture.Bind();
+    m_lightDataTexture.SetData(TextureObject::InternalFormatRGBA32F, std::span<const glm::vec4>(m_lightData));
+    m_clustersTexture.Bind();
+    m_clustersTexture.SetData(TextureObject::InternalFormatRG32UI, std::span<const glm::uvec2>(m_clusters));
+    m_lightIndicesTexture.Bind();
+    m_lightIndicesTexture.SetData(TextureObject::InternalFormatR32UI, std::span<const unsigned int>(m_lightIndices));
+    TextureBufferObject::Unbind();
+}
+
+void LightClusterGrid::BuildLists(const Camera& camera, int width, int height, std::span<const Light* const> lights)
+{
+    assert(width > 0 && height > 0);
+    UpdateClusterBounds(camera.GetProjectionMatrix(), width, height);
+
+    // Third row of the view matrix, negated, gives the distance in front of the camera
+    const glm::mat4& viewMatrix = camera.GetViewMatrix();
+    m_depthPlane = -glm::vec4(viewMatrix[0][2], viewMatrix[1][2], viewMatrix[2][2], viewMatrix[3][2]);
+
+    auto hasRange = [](const Light& light)
+    {
+        return light.GetType() != Light::Type::Directional && light.GetAttenuation().y > 0.0f;
+    };
+    auto addLightData = [this](const Light& light)
+    {
+        m_lightData.push_back(glm::vec4(light.GetPosition(), 0.0f));
+        m_lightData.push_back(glm::vec4(light.GetDirection(), 0.0f));
+        m_lightData.push_back(glm::vec4(light.GetColor() * light.GetIntensity(), 0.0f));
+        m_lightData.push_back(light.GetAttenuation());
+    };
+
+    // Global lights first, they are evaluated for every fragment
+    m_lightData.clear();
+    for (const Light* light : lights)
+    {
+        if (!hasRange(*light))
+        {
+            addLightData(*light);
+        }
+    }
+    m_globalLightCount = static_cast<unsigned int>(m_lightData.size() / 4);
+
+    // Then the lights with a range, keeping only the ones that touch the frustum
+    m_localLights.clear();
+    for (const Light* light : lights)
+    {
+        if (hasRange(*light))
+        {
+            // The sphere of a spot light is conservative, it contains the whole cone
+            LocalLight localLight;
+            localLight.index = static_cast<unsigned int>(m_lightData.size() / 4);
+            localLight.center = glm::vec3(viewMatrix * glm::vec4(light->GetPosition(), 1.0f));
+            localLight.radius = light->GetAttenuation().y;
+            if (ComputeClusterRange(localLight))
+            {
+                addLightData(*light);
+                m_localLights.push_back(localLight);
+            }
+        }
+    }
+    m_lightCount = static_cast<unsigned int>(m_lightData.size() / 4);
+
+    // Split the slices between the threads. Each thread writes only to its own lists
+    unsigned int threadCount = m_threadCount > 0 ? m_threadCount : std::max(std::thread::hardware_concurrency(), 1u);
+    threadCount = std::min(threadCount, static_cast<unsigned int>(m_localLights.size()) / s_minLightsPerThread);
+    threadCount = std::clamp(threadCount, 1u, m_slices);
+
+    m_sliceRangeLists.resize(threadCount);
+    for (unsigned int i = 0; i < threadCount; ++i)
+    {
+        m_sliceRangeLists[i].firstSlice = i * m_slices / threadCount;
+        m_sliceRangeLists[i].lastSlice = (i + 1) * m_slices / threadCount;
+    }
+
+    // The calling thread takes the first range, the workers of the pool the others
+    m_workerPool.Run(threadCount, [this](unsigned int i) { AssignLights(m_sliceRangeLists[i]); });
+
+    // Concatenate the lists of the ranges, in slice order
+    m_clusters.clear();
+    m_lightIndices.clear();
+    m_maxClusterLightCount = 0;
+    for (const SliceRangeLists& lists : m_sliceRangeLists)
+    {
+        unsigned int indexOffset = static_cast<unsigned int>(m_lightIndices.size());
+        for (const glm::uvec2& cluster : lists.clusters)
+        {
+            m_clusters.push_back(glm::uvec2(cluster.x + indexOffset, cluster.y));
+            m_maxClusterLightCount = std::max(m_maxClusterLightCount, cluster.y);
+        }
+        m_lightIndices.insert(m_lightIndices.end(), lists.indices.begin(), lists.indices.end());
+    }
+    assert(m_clusters.size() == GetClusterCount());
+}
+
+std::span<const unsigned int> LightClusterGrid::GetClusterLights(const glm::uvec3& cluster) const
+{
+    assert(cluster.x < m_tilesX && cluster.y < m_tilesY && cluster.z < m_slices);
+    const glm::uvec2& offsetCount = m_clusters[(cluster.z * m_tilesY + cluster.y) * m_tilesX + cluster.x];
+    return std::span<const unsigned int>(m_lightIndices).subspan(offsetCount.x, offsetCount.y);
+}
+
+LightClusterGrid::Locations LightClusterGrid::GetLocations(const ShaderProgram& shaderProgram)
+{
+    Locations locations;
+    locations.lightData = shaderProgram.GetUniformLocation(LightDataName);
+    locations.lightClusters = shaderProgram.GetUniformLocation(LightClustersName);
+    locations.lightIndices = shaderProgram.GetUniformLocation(LightIndicesName);
+    locations.gridSize = shaderProgram.GetUniformLocation(GridSizeName);
+    locations.gridParams = shaderProgram.GetUniformLocation(GridParamsName);
+    locations.depthPlane = shaderProgram.GetUniformLocation(DepthPlaneName);
+    locations.globalLightCount = shaderProgram.GetUniformLocation(GlobalLightCountName);
+    return locations;
+}
+
+void LightClusterGrid::Use(const ShaderProgram& shaderProgram, const Locations& locations, int firstTextureUnit) const
+{
+    assert(locations.IsValid());
+
+    // Tiles are rounded up, so they cover the whole viewport
+    glm::vec2 tileSize(static_cast<float>((m_width + m_tilesX - 1) / m_tilesX), static_cast<float>((m_height + m_tilesY - 1) / m_tilesY));
+
+    shaderProgram.SetTexture(locations.lightData, firstTextureUnit, m_lightDataTexture);
+    shaderProgram.SetTexture(locations.lightClusters, firstTextureUnit + 1, m_clustersTexture);
+    shaderProgram.SetTexture(locations.lightIndices, firstTextureUnit + 2, m_lightIndicesTexture);
+    shaderProgram.SetUniform(locations.gridSize, GetGridSize());
+    shaderProgram.SetUniform(locations.gridParams, glm::vec4(tileSize, m_sliceScale, m_sliceBias));
+    shaderProgram.SetUniform(locations.depthPlane, m_depthPlane);
+    shaderProgram.SetUniform(locations.globalLightCount, m_globalLightCount);
+}
+
+void LightClusterGrid::Record(CommandBuffer& commandBuffer, const Locations& locations, int firstTextureUnit) const
+{
+    assert(locations.IsValid());
+
+    // Same uniforms as Use
+    glm::vec2 tileSize(static_cast<float>((m_width + m_tilesX - 1) / m_tilesX), static_cast<float>((m_height + m_tilesY - 1) / m_tilesY));
+
+    const TextureBufferObject* textures[] = { &m_lightDataTexture, &m_clustersTexture, &m_lightIndicesTexture };
+    const ShaderProgram::Location textureLocations[] = { locations.lightData, locations.lightClusters, locations.lightIndices };
+    for (int i = 0; i < 3; ++i)
+    {
+        commandBuffer.BindTexture(firstTextureUnit + i, static_cast<GLenum>(textures[i]->GetTarget()), textures[i]->GetHandle());
+        commandBuffer.SetUniform(textureLocations[i], firstTextureUnit + i);
+    }
+    commandBuffer.SetUniform(locations.gridSize, GetGridSize());
+    commandBuffer.SetUniform(locations.gridParams, glm::vec4(tileSize, m_sliceScale, m_sliceBias));
+    commandBuffer.SetUniform(locations.depthPlane, m_depthPlane);
+    commandBuffer.SetUniform(locations.globalLightCount, m_globalLightCount);
+}
+
+void LightClusterGrid::UpdateClusterBounds(const glm::mat4& projMatrix, int width, int height)
+{
+    if (projMatrix == m_projMatrix && width == m_width && height == m_height)
+    {
+        return;
+    }
+    m_projMatrix = projMatrix;
+    m_width = width;
+    m_height = height;
+
+    glm::mat4 invProjMatrix = glm::inverse(projMatrix);
+    auto unproject = [&](const glm::vec3& ndcPosition)
+    {
+        glm::vec4 position = invProjMatrix * glm::vec4(ndcPosition, 1.0f);
+        return glm::vec3(position) / position.w;
+    };
+    auto getNdcDepth = [&](float depth)
+    {
+        glm::vec4 position = projMatrix * glm::vec4(0.0f, 0.0f, -depth, 1.0f);
+        return position.z / position.w;
+    };
+
+    // The log needs a positive near depth, orthographic cameras can have near at 0
+    m_nearDepth = std::max(-unproject(glm::vec3(0.0f, 0.0f, -1.0f)).z, 0.01f);
+    m_farDepth = std::max(-unproject(glm::vec3(0.0f, 0.0f, 1.0f)).z, m_nearDepth * 1.01f);
+
+    // slice = log(depth / near) / log(far / near) * slices
+    float logDepthRange = std::log(m_farDepth / m_nearDepth);
+    m_sliceScale = static_cast<float>(m_slices) / logDepthRange;
+    m_sliceBias = -std::log(m_nearDepth) * m_sliceScale;
+
+    unsigned int tileWidth = (width + m_tilesX - 1) / m_tilesX;
+    unsigned int tileHeight = (height + m_tilesY - 1) / m_tilesY;
+
+    m_clusterBounds.resize(GetClusterCount());
+    for (unsigned int z = 0; z < m_slices; ++z)
+    {
+        float ndcDepths[2] = { getNdcDepth(GetSliceDepth(z)), getNdcDepth(GetSliceDepth(z + 1)) };
+        for (unsigned int y = 0; y < m_tilesY; ++y)
+        {
+            float ndcY[2] = { std::min(2.0f * y * tileHeight / height - 1.0f, 1.0f), std::min(2.0f * (y + 1) * tileHeight / height - 1.0f, 1.0f) };
+            for (unsigned int x = 0; x < m_tilesX; ++x)
+            {
+                float ndcX[2] = { std::min(2.0f * x * tileWidth / width - 1.0f, 1.0f), std::min(2.0f * (x + 1) * tileWidth / width - 1.0f, 1.0f) };
+
+                // AABB of the 8 corners of the cluster
+                ClusterBounds& bounds = m_clusterBounds[(z * m_tilesY + y) * m_tilesX + x];
+                bounds.min = glm::vec3(std::numeric_limits<float>::max());
+                bounds.max = glm::vec3(std::numeric_limits<float>::lowest());
+                for (int corner = 0; corner < 8; ++corner)
+                {
+                    glm::vec3 position = unproject(glm::vec3(ndcX[corner & 1], ndcY[(corner >> 1) & 1], ndcDepths[corner >> 2]));
+                    bounds.min = glm::min(bounds.min, position);
+                    bounds.max = glm::max(bounds.max, position);
+                }
+            }
+        }
+    }
+}
+
+float LightClusterGrid::GetSliceDepth(unsigned int slice) const
+{
+    return m_nearDepth * std::pow(m_farDepth / m_nearDepth, static_cast<float>(slice) / m_slices);
+}
+
+bool LightClusterGrid::ComputeClusterRange(LocalLight& localLight) const
+{
+    const glm::vec3& center = localLight.center;
+    float radius = localLight.radius;
+
+    // Slices, from the depth range of the sphere
+    float minDepth = -center.z - radius;
+    float maxDepth = -center.z + radius;
+    if (maxDepth < m_nearDepth || minDepth > m_farDepth)
+    {
+        return false;
+    }
+    auto getSlice = [&](float depth)
+    {
+        float slice = depth > m_nearDepth ? std::log(depth) * m_sliceScale + m_sliceBias : 0.0f;
+        return std::min(static_cast<unsigned int>(slice), m_slices - 1);
+    };
+    localLight.clusterMin.z = getSlice(minDepth);
+    localLight.clusterMax.z = getSlice(maxDepth);
+
+    // Tiles, from the projection of the corners of the bounding box
+    localLight.clusterMin.x = 0;
+    localLight.clusterMin.y = 0;
+    localLight.clusterMax.x = m_tilesX - 1;
+    localLight.clusterMax.y = m_tilesY - 1;
+    if (minDepth > m_nearDepth)
+    {
+        glm::vec2 ndcMin(std::numeric_limits<float>::max());
+        glm::vec2 ndcMax(std::numeric_limits<float>::lowest());
+        for (int corner = 0; corner < 8; ++corner)
+        {
+            glm::vec3 offset(corner & 1 ? radius : -radius, corner & 2 ? radius : -radius, corner & 4 ? radius : -radius);
+            glm::vec4 position = m_projMatrix * glm::vec4(center + offset, 1.0f);
+            glm::vec2 ndcPosition = glm::vec2(position) / position.w;
+            ndcMin = glm::min(ndcMin, ndcPosition);
+            ndcMax = glm::max(ndcMax, ndcPosition);
+        }
+        if (ndcMax.x < -1.0f || ndcMax.y < -1.0f || ndcMin.x > 1.0f || ndcMin.y > 1.0f)
+        {
+            return false;
+        }
+
+        auto getTile = [](float ndc, int size, unsigned int tiles)
+        {
+            unsigned int tileSize = (size + tiles - 1) / tiles;
+            float pixel = glm::clamp(ndc * 0.5f + 0.5f, 0.0f, 1.0f) * size;
+            return std::min(static_cast<unsigned int>(pixel) / tileSize, tiles - 1);
+        };
+        localLight.clusterMin.x = getTile(ndcMin.x, m_width, m_tilesX);
+        localLight.clusterMin.y = getTile(ndcMin.y, m_height, m_tilesY);
+        localLight.clusterMax.x = getTile(ndcMax.x, m_width, m_tilesX);
+        localLight.clusterMax.y = getTile(ndcMax.y, m_height, m_tilesY);
+    }
+    return true;
+}
+
+void LightClusterGrid::AssignLights(SliceRangeLists& lists) const
+{
+    unsigned int clustersPerSlice = m_tilesX * m_tilesY;
+    unsigned int firstCluster = lists.firstSlice * clustersPerSlice;
+
+    // Find the (cluster, light) pairs, testing the sphere against the clusters in the range of the light
+    lists.pairs.clear();
+    for (const LocalLight& localLight : m_localLights)
+    {
+        unsigned int firstSlice = std::max(localLight.clusterMin.z, lists.firstSlice);
+        unsigned int lastSlice = std::min(localLight.clusterMax.z + 1, lists.lastSlice);
+        for (unsigned int z = firstSlice; z < lastSlice; ++z)
+        {
+            for (unsigned int y = localLight.clusterMin.y; y <= localLight.clusterMax.y; ++y)
+            {
+                for (unsigned int x = localLight.clusterMin.x; x <= localLight.clusterMax.x; ++x)
+                {
+                    unsigned int cluster = (z * m_tilesY + y) * m_tilesX + x;
+                    const ClusterBounds& bounds = m_clusterBounds[cluster];
+                    glm::vec3 closestPoint = glm::clamp(localLight.center, bounds.min, bounds.max);
+                    glm::vec3 difference = closestPoint - localLight.center;
+                    if (glm::dot(difference, difference) <= localLight.radius * localLight.radius)
+                    {
+                        lists.pairs.push_back(glm::uvec2(cluster - firstCluster, localLight.index));
+                    }
+                }
+            }
+        }
+    }
+
+    // Counting sort of the pairs by cluster. Lights keep their order inside each cluster
+    lists.clusters.assign((lists.lastSlice - lists.firstSlice) * clustersPerSlice, glm::uvec2(0));
+    for (const glm::uvec2& pair : lists.pairs)
+    {
+        lists.clusters[pair.x].y++;
+    }
+    unsigned int offset = 0;
+    for (glm::uvec2& cluster : lists.clusters)
+    {
+        cluster.x = offset;
+        offset += cluster.y;
+        cluster.y = 0;
+    }
+    lists.indices.resize(offset);
+    for (const glm::uvec2& pair : lists.pairs)
+    {
+        glm::uvec2& cluster = lists.clusters[pair.x];
+        lists.indices[cluster.x + cluster.y++] = pair.y;
+    }
+}
@@ -0,0 +1,225 @@
+#include <ituGL/renderer/LightScreenProjector.h>
+
+#include <ituGL/core/DeviceGL.h>
+#include <ituGL/renderer/CommandBuffer.h>
+#include <ituGL/camera/Camera.h>
+#include <ituGL/lighting/Light.h>
+#include <glm/geometric.hpp>
+#include <glm/trigonometric.hpp>
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+LightScreenProjector::LightScreenProjector()
+    : m_viewMatrix(1.0f)
+    , m_projMatrix(1.0f)
+    , m_perspective(false)
+    , m_nearDepth(0.0f)
+    , m_farDepth(0.0f)
+    , m_viewport({ 0, 0, 0, 0 })
+{
+}
+
+void LightScreenProjector::SetCamera(const Camera& camera, GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    m_viewMatrix = camera.GetViewMatrix();
+    m_projMatrix = camera.GetProjectionMatrix();
+    m_viewport = { x, y, width, height };
+
+    // Perspective projections copy -Z to W
+    m_perspective = m_projMatrix[2][3] != 0.0f;
+
+    // View depth of the near and far planes, from the center of the screen
+    glm::mat4 invProjMatrix = glm::inverse(m_projMatrix);
+    auto unprojectDepth = [&](float z)
+    {
+        glm::vec4 position = invProjMatrix * glm::vec4(0.0f, 0.0f, z, 1.0f);
+        return -position.z / position.w;
+    };
+    m_nearDepth = unprojectDepth(-1.0f);
+    m_farDepth = unprojectDepth(1.0f);
+}
+
+LightScreenProjector::ScreenBounds LightScreenProjector::GetScreenBounds(const Light& light) const
+{
+    glm::vec4 attenuation = light.GetAttenuation();
+
+    // Without a range, the light reaches all the surfaces
+    float range = attenuation.y;
+    if (light.GetType() == Light::Type::Directional || range <= 0.0f)
+    {
+        return GetViewportScreenBounds();
+    }
+
+    glm::vec3 position = glm::vec3(m_viewMatrix * glm::vec4(light.GetPosition(), 1.0f));
+    glm::vec3 center = position;
+    float radius = range;
+    float minDepth = -position.z - range;
+    float maxDepth = -position.z + range;
+
+    float angle = attenuation.w;
+    if (light.GetType() == Light::Type::Spot && angle > 0.0f && angle < glm::half_pi<float>())
+    {
+        // The light shines opposite to its direction, see ComputeAngularAttenuation in the shaders
+        glm::vec3 axis = -glm::normalize(glm::vec3(m_viewMatrix * glm::vec4(light.GetDirection(), 0.0f)));
+
+        // The cone, as long as the range, contains the lit volume. Under 45 degrees, its bounding sphere is smaller than the range
+        float cosAngle = std::cos(angle);
+        if (cosAngle > glm::one_over_root_two<float>())
+        {
+            radius = range / (2.0f * cosAngle * cosAngle);
+            center = position + axis * radius;
+        }
+
+        // Depth range of the apex and of the circle of the base
+        glm::vec3 baseCenter = position + axis * range;
+        float baseExtent = range * std::tan(angle) * std::sqrt(std::max(1.0f - axis.z * axis.z, 0.0f));
+        minDepth = std::max(minDepth, std::min(-position.z, -baseCenter.z - baseExtent));
+        maxDepth = std::min(maxDepth, std::max(-position.z, -baseCenter.z + baseExtent));
+    }
+
+    return GetSphereScreenBounds(center, radius, minDepth, maxDepth);
+}
+
+bool LightScreenProjector::IsFullViewport(const ScreenBounds& bounds) const
+{
+    return bounds.x == m_viewport[0] && bounds.y == m_viewport[1] && bounds.width == m_viewport[2] && bounds.height == m_viewport[3];
+}
+
+void LightScreenProjector::SetScissor(DeviceGL& device, const ScreenBounds& bounds) const
+{
+    bool scissor = !IsFullViewport(bounds);
+    device.SetFeatureEnabled(GL_SCISSOR_TEST, scissor);
+    if (scissor)
+    {
+        device.SetScissor(bounds.x, bounds.y, bounds.width, bounds.height);
+    }
+}
+
+LightScreenProjector::ScreenBounds LightScreenProjector::GetUnion(const ScreenBounds& a, const ScreenBounds& b)
+{
+    if (a.IsEmpty())
+    {
+        return b;
+    }
+    if (b.IsEmpty())
+    {
+        return a;
+    }
+
+    ScreenBounds bounds;
+    bounds.x = std::min(a.x, b.x);
+    bounds.y = std::min(a.y, b.y);
+    bounds.width = std::max(a.x + a.width, b.x + b.width) - bounds.x;
+    bounds.height = std::max(a.y + a.height, b.y + b.height) - bounds.y;
+    bounds.nearDepth = std::min(a.nearDepth, b.nearDepth);
+    bounds.farDepth = std::max(a.farDepth, b.farDepth);
+    return bounds;
+}
+
+void LightScreenProjector::RecordScissor(CommandBuffer& commandBuffer, const ScreenBounds& bounds) const
+{
+    bool scissor = !IsFullViewport(bounds);
+    commandBuffer.SetFeatureEnabled(GL_SCISSOR_TEST, scissor);
+    if (scissor)
+    {
+        commandBuffer.SetScissor(bounds.x, bounds.y, bounds.width, bounds.height);
+    }
+}
+
+LightScreenProjector::ScreenBounds LightScreenProjector::GetSphereScreenBounds(const glm::vec3& center, float radius, float minDepth, float maxDepth) const
+{
+    ScreenBounds bounds;
+
+    // Outside of the depth range of the camera
+    bounds.nearDepth = std::max(minDepth, m_nearDepth);
+    bounds.farDepth = std::min(maxDepth, m_farDepth);
+    if (bounds.nearDepth > bounds.farDepth)
+    {
+        return bounds;
+    }
+
+    // Range of the sphere in NDC
+    glm::vec2 rangeX, rangeY;
+    if (m_perspective)
+    {
+        rangeX = GetSphereAxisRange(glm::vec2(center.x, center.z), radius, m_projMatrix[0][0], m_projMatrix[2][0]);
+        rangeY = GetSphereAxisRange(glm::vec2(center.y, center.z), radius, m_projMatrix[1][1], m_projMatrix[2][1]);
+    }
+    else
+    {
+        // Orthographic projections keep the size, the range is the projected center plus and minus the radius
+        glm::vec4 projectedCenter = m_projMatrix * glm::vec4(center, 1.0f);
+        glm::vec2 extent = glm::abs(glm::vec2(m_projMatrix[0][0], m_projMatrix[1][1])) * radius;
+        rangeX = glm::vec2(projectedCenter.x - extent.x, projectedCenter.x + extent.x);
+        rangeY = glm::vec2(projectedCenter.y - extent.y, projectedCenter.y + extent.y);
+    }
+
+    // Convert to pixels, rounding out, and clip to the viewport
+    auto toPixels = [](glm::vec2 range, GLint start, GLsizei size, GLint& offset, GLsizei& length)
+    {
+        float minPixel = std::floor((range.x * 0.5f + 0.5f) * size);
+        float maxPixel = std::ceil((range.y * 0.5f + 0.5f) * size);
+        GLint first = static_cast<GLint>(std::clamp(minPixel, 0.0f, static_cast<float>(size)));
+        GLint last = static_cast<GLint>(std::clamp(maxPixel, 0.0f, static_cast<float>(size)));
+        offset = start + first;
+        length = last - first;
+    };
+    toPixels(rangeX, m_viewport[0], m_viewport[2], bounds.x, bounds.width);
+    toPixels(rangeY, m_viewport[1], m_viewport[3], bounds.y, bounds.height);
+
+    return bounds;
+}
+
+// Tangents from the camera to the sphere, in the plane of the axis and view Z, clipped by the near plane
+// From "2D Polyhedral Bounds of a Clipped, Perspective-Projected 3D Sphere", Mara and McGuire, JCGT 2013
+glm::vec2 LightScreenProjector::GetSphereAxisRange(glm::vec2 c, float radius, float scale, float offset) const
+{
+    float nearZ = -m_nearDepth;
+
+    float tangentSquared = glm::dot(c, c) - radius * radius;
+    bool cameraInside = tangentSquared <= 0.0f;
+
+    // Rotation from the center to the tangent points: cosine and sine
+    glm::vec2 rotation = cameraInside ? glm::vec2(0.0f) : glm::vec2(std::sqrt(tangentSquared), radius) / glm::length(c);
+
+    // If the sphere crosses the near plane, the tangent points in front of it are replaced by the edge of the section
+    // on the same side
+    bool clipSphere = c.y + radius >= nearZ;
+    float section = std::sqrt(std::max(radius * radius - (nearZ - c.y) * (nearZ - c.y), 0.0f));
+
+    glm::vec2 range(std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest());
+    for (int i = 0; i < 2; ++i)
+    {
+        glm::vec2 point(0.0f);
+        if (!cameraInside)
+        {
+            point = glm::vec2(rotation.x * c.x - rotation.y * c.y, rotation.y * c.x + rotation.x * c.y) * rotation.x;
+        }
+        if (clipSphere && (cameraInside || point.y > nearZ))
+        {
+            point = glm::vec2(c.x + section, nearZ);
+        }
+
+        float ndc = (scale * point.x + offset * point.y) / -point.y;
+        range.x = std::min(range.x, ndc);
+        range.y = std::max(range.y, ndc);
+
+        rotation.y = -rotation.y;
+        section = -section;
+    }
+    return range;
+}
+
+LightScreenProjector::ScreenBounds LightScreenProjector::GetViewportScreenBounds() const
+{
+    ScreenBounds bounds;
+    bounds.x = m_viewport[0];
+    bounds.y = m_viewport[1];
+    bounds.width = m_viewport[2];
+    bounds.height = m_viewport[3];
+    bounds.nearDepth = m_nearDepth;
+    bounds.farDepth = m_farDepth;
+    return bounds;
+}
@@ -0,0 +1,178 @@
+#include <ituGL/renderer/NullCommandExecutor.h>
+
+#include <algorithm>
+
+NullCommandExecutor::NullCommandExecutor(int maxTextureUnits) : m_maxTextureUnits(maxTextureUnits)
+{
+    Reset();
+}
+
+void NullCommandExecutor::Reset()
+{
+    m_commandCounts.fill(0);
+    m_commandCount = 0;
+    m_drawCount = 0;
+    m_vertexCount = 0;
+    m_invalidCount = 0;
+    m_lastError = nullptr;
+    m_program = 0;
+    m_vertexArray = 0;
+}
+
+void NullCommandExecutor::Execute(const CommandBuffer& commandBuffer)
+{
+    for (const CommandBuffer::ConstIterator& command : commandBuffer)
+    {
+        if (!Validate(commandBuffer, command))
+        {
+            m_invalidCount++;
+            continue;
+        }
+
+        m_commandCounts[static_cast<int>(command.GetType())]++;
+        m_commandCount++;
+    }
+}
+
+bool NullCommandExecutor::Validate(const CommandBuffer& commandBuffer, const CommandBuffer::ConstIterator& command)
+{
+    using CommandType = CommandBuffer::CommandType;
+
+    const CommandBuffer::CommandHeader& header = command.GetHeader();
+    if (header.type >= CommandType::Count)
+    {
+        return Fail("Unknown command type");
+    }
+    if (header.size == 0)
+    {
+        return Fail("Empty command");
+    }
+
+    switch (header.type)
+    {
+    case CommandType::UseProgram:
+        m_program = command.Get<CommandBuffer::UseProgramCommand>().handle;
+        break;
+    case CommandType::SetUniforms:
+    {
+        const auto& setUniforms = command.Get<CommandBuffer::SetUniformsCommand>();
+        if (m_program == 0)
+        {
+            return Fail("SetUniforms without a program in use");
+        }
+        if (setUniforms.count <= 0)
+        {
+            return Fail("SetUniforms with no values");
+        }
+        if (setUniforms.columns > 1 && setUniforms.type != Data::Type::Float)
+        {
+            return Fail("SetUniforms with a non-float matrix");
+        }
+        std::size_t size = Data::GetTypeSize(setUniforms.type) * setUniforms.components * setUniforms.columns * setUniforms.count;
+        if (command.GetPayload<CommandBuffer::SetUniformsCommand>().size() < size)
+        {
+            return Fail("SetUniforms payload is too small");
+        }
+        break;
+    }
+    case CommandType::BindUniformBlock:
+    {
+        const auto& bindUniformBlock = command.Get<CommandBuffer::BindUniformBlockCommand>();
+        if (bindUniformBlock.bufferHandle != 0 && (bindUniformBlock.offset < 0 || bindUniformBlock.size <= 0))
+        {
+            return Fail("BindUniformBlock with an invalid range");
+        }
+        break;
+    }
+    case CommandType::BindVertexArray:
+        m_vertexArray = command.Get<CommandBuffer::BindVertexArrayCommand>().handle;
+        break;
+    case CommandType::BindTexture:
+    {
+        const auto& bindTexture = command.Get<CommandBuffer::BindTextureCommand>();
+        if (bindTexture.textureUnit < 0 || bindTexture.textureUnit >= m_maxTextureUnits)
+        {
+            return Fail("BindTexture to an invalid texture unit");
+        }
+        break;
+    }
+    case CommandType::DrawArrays:
+    {
+        const auto& drawArrays = command.Get<CommandBuffer::DrawArraysCommand>();
+        if (m_program == 0 || m_vertexArray == 0)
+        {
+            return Fail("DrawArrays without a program or a vertex array");
+        }
+        if (drawArrays.count <= 0 || drawArrays.first < 0)
+        {
+            return Fail("DrawArrays with an invalid range");
+        }
+        if (drawArrays.instanceCount < 0)
+        {
+            return Fail("DrawArrays with an invalid instance count");
+        }
+        m_drawCount++;
+        m_vertexCount += drawArrays.count * std::max(drawArrays.instanceCount, 1);
+        break;
+    }
+    case CommandType::DrawElements:
+    {
+        const auto& drawElements = command.Get<CommandBuffer::DrawElementsCommand>();
+        if (m_program == 0 || m_vertexArray == 0)
+        {
+            return Fail("DrawElements without a program or a vertex array");
+        }
+        if (drawElements.count <= 0 || drawElements.first < 0)
+        {
+            return Fail("DrawElements with an invalid range");
+        }
+        if (drawElements.eboType != GL_UNSIGNED_BYTE && drawElements.eboType != GL_UNSIGNED_SHORT && drawElements.eboType != GL_UNSIGNED_INT)
+        {
+            return Fail("DrawElements with an invalid element type");
+        }
+        if (drawElements.instanceCount < 0)
+        {
+            return Fail("DrawElements with an invalid instance count");
+        }
+        m_drawCount++;
+        m_vertexCount += drawElements.count * std::max(drawElements.instanceCount, 1);
+        break;
+    }
+    case CommandType::SetScissor:
+    {
+        const auto& scissor = command.Get<CommandBuffer::SetScissorCommand>();
+        if (scissor.width < 0 || scissor.height < 0)
+        {
+            return Fail("SetScissor with a negative size");
+        }
+        break;
+    }
+    case CommandType::CallFunction:
+        if (command.Get<CommandBuffer::CallFunctionCommand>().index >= commandBuffer.GetFunctionCount())
+        {
+            return Fail("CallFunction with an invalid function");
+        }
+        break;
+    case CommandType::SetStencilFunction:
+    case CommandType::SetStencilOperations:
+    {
+        GLenum face = header.type == CommandType::SetStencilFunction ?
+            command.Get<CommandBuffer::SetStencilFunctionCommand>().face : command.Get<CommandBuffer::SetStencilOperationsCommand>().face;
+        if (face != GL_FRONT && face != GL_BACK && face != GL_FRONT_AND_BACK)
+        {
+            return Fail("Stencil command with an invalid face");
+        }
+        break;
+    }
+    default:
+        // Other state commands are always valid
+        break;
+    }
+    return true;
+}
+
+bool NullCommandExecutor::Fail(const char* error)
+{
+    m_lastError = error;
+    return false;
+}
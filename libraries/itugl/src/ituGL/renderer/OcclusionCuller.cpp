@@ -0,0 +1,365 @@
+#include <ituGL/renderer/OcclusionCuller.h>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <cmath>
+#include <limits>
+#include <cassert>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OCCLUSION_CULLER_SSE
+#include <emmintrin.h>
+#endif
+
+// Below these numbers, the cost of waking up the workers is higher than the work they save
+const unsigned int s_minTrianglesPerThread = 256;
+const int s_minRowsPerThread = 16;
+
+OcclusionCuller::OcclusionCuller(int width, int height)
+    : m_width(width)
+    , m_height(height)
+    , m_threadCount(0)
+    , m_viewProjMatrix(1.0f)
+{
+    // Rows are rasterized in groups of 4 pixels
+    assert(width > 0 && height > 0 && width % 4 == 0);
+
+    // Halve the size until one of the sides is a single texel
+    m_levels.push_back(Level{ width, height, std::vector<float>(width * height, 1.0f) });
+    while (width > 1 && height > 1)
+    {
+        width = (width + 1) / 2;
+        height = (height + 1) / 2;
+        m_levels.push_back(Level{ width, height, std::vector<float>(width * height, 1.0f) });
+    }
+}
+
+unsigned int OcclusionCuller::AddOccluderMesh(std::span<const glm::vec3> vertices, std::span<const unsigned int> indices)
+{
+    assert(indices.size() % 3 == 0);
+    unsigned int meshIndex = static_cast<unsigned int>(m_meshes.size());
+    m_meshes.push_back(OccluderMesh{ std::vector<glm::vec3>(vertices.begin(), vertices.end()), std::vector<unsigned int>(indices.begin(), indices.end()) });
+    return meshIndex;
+}
+
+void OcclusionCuller::SetOccluderVertices(unsigned int meshIndex, std::span<const glm::vec3> vertices)
+{
+    assert(meshIndex < m_meshes.size());
+    OccluderMesh& mesh = m_meshes[meshIndex];
+    assert(vertices.size() == mesh.vertices.size());
+    std::copy(vertices.begin(), vertices.end(), mesh.vertices.begin());
+}
+
+void OcclusionCuller::AddOccluder(unsigned int meshIndex, const glm::mat4& worldMatrix)
+{
+    assert(meshIndex < m_meshes.size());
+    m_occluders.push_back(Occluder{ meshIndex, worldMatrix });
+}
+
+void OcclusionCuller::ClearOccluders()
+{
+    m_occluders.clear();
+}
+
+void OcclusionCuller::Rasterize(const glm::mat4& viewProjMatrix)
+{
+    auto startTime = std::chrono::steady_clock::now();
+
+    m_viewProjMatrix = viewProjMatrix;
+    m_stats = Stats();
+    m_stats.occluders = static_cast<unsigned int>(m_occluders.size());
+
+    m_triangles.clear();
+    for (const Occluder& occluder : m_occluders)
+    {
+        SetupTriangles(occluder, viewProjMatrix);
+    }
+    m_stats.triangles = static_cast<unsigned int>(m_triangles.size());
+
+    // Split the rows between the threads. Each thread writes only to its own rows
+    unsigned int threadCount = m_threadCount > 0 ? m_threadCount : std::max(std::thread::hardware_concurrency(), 1u);
+    threadCount = std::min(threadCount, m_stats.triangles / s_minTrianglesPerThread);
+    threadCount = std::clamp(threadCount, 1u, static_cast<unsigned int>(std::max(m_height / s_minRowsPerThread, 1)));
+
+    // The calling thread takes the first band, the workers of the pool the others
+    m_workerPool.Run(threadCount, [this, threadCount](unsigned int i)
+        {
+            RasterizeRows(i * m_height / threadCount, (i + 1) * m_height / threadCount);
+        });
+
+    BuildHierarchy();
+
+    m_stats.rasterizeTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+void OcclusionCuller::SetupTriangles(const Occluder& occluder, const glm::mat4& viewProjMatrix)
+{
+    const OccluderMesh& mesh = m_meshes[occluder.meshIndex];
+    glm::mat4 worldViewProjMatrix = viewProjMatrix * occluder.worldMatrix;
+
+    for (size_t i = 0; i < mesh.indices.size(); i += 3)
+    {
+        glm::vec4 vertices[3];
+        float distances[3];
+        unsigned int insideCount = 0;
+        for (int v = 0; v < 3; ++v)
+        {
+            vertices[v] = worldViewProjMatrix * glm::vec4(mesh.vertices[mesh.indices[i + v]], 1.0f);
+            // Distance to the near plane in clip space, z >= -w inside
+            distances[v] = vertices[v].z + vertices[v].w;
+            insideCount += distances[v] >= 0.0f;
+        }
+
+        if (insideCount == 3)
+        {
+            AddTriangle(vertices[0], vertices[1], vertices[2]);
+        }
+        else if (insideCount > 0)
+        {
+            // Clip against the near plane, keeping the order of the vertices. The result has 3 or 4 vertices
+            glm::vec4 clipped[4];
+            unsigned int clippedCount = 0;
+            for (int v = 0; v < 3; ++v)
+            {
+                int next = (v + 1) % 3;
+                if (distances[v] >= 0.0f)
+                {
+                    clipped[clippedCount++] = vertices[v];
+                }
+                if ((distances[v] >= 0.0f) != (distances[next] >= 0.0f))
+                {
+                    float t = distances[v] / (distances[v] - distances[next]);
+                    clipped[clippedCount++] = vertices[v] + t * (vertices[next] - vertices[v]);
+                }
+            }
+
+            AddTriangle(clipped[0], clipped[1], clipped[2]);
+            if (clippedCount == 4)
+            {
+                AddTriangle(clipped[0], clipped[2], clipped[3]);
+            }
+        }
+    }
+}
+
+void OcclusionCuller::AddTriangle(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2)
+{
+    // Screen position in pixels and depth from 0 to 1
+    glm::vec3 screen[3];
+    const glm::vec4* clip[3] = { &v0, &v1, &v2 };
+    for (int v = 0; v < 3; ++v)
+    {
+        // Vertices on the near plane can have w = 0 only if the near plane is 0
+        float invW = 1.0f / std::max(clip[v]->w, 1e-6f);
+        screen[v] = glm::vec3(
+            (clip[v]->x * invW * 0.5f + 0.5f) * m_width,
+            (clip[v]->y * invW * 0.5f + 0.5f) * m_height,
+            clip[v]->z * invW * 0.5f + 0.5f);
+    }
+
+    // Skip the triangles facing away, and the degenerate ones
+    float area = (screen[1].x - screen[0].x) * (screen[2].y - screen[0].y) - (screen[1].y - screen[0].y) * (screen[2].x - screen[0].x);
+    if (area <= 0.0f)
+    {
+        return;
+    }
+
+    // Pixels with the center inside the bounding rectangle
+    float minX = std::min({ screen[0].x, screen[1].x, screen[2].x });
+    float maxX = std::max({ screen[0].x, screen[1].x, screen[2].x });
+    float minY = std::min({ screen[0].y, screen[1].y, screen[2].y });
+    float maxY = std::max({ screen[0].y, screen[1].y, screen[2].y });
+    float minDepth = std::min({ screen[0].z, screen[1].z, screen[2].z });
+
+    Triangle triangle;
+    triangle.minX = static_cast<int>(std::max(std::ceil(minX - 0.5f), 0.0f));
+    triangle.minY = static_cast<int>(std::max(std::ceil(minY - 0.5f), 0.0f));
+    triangle.maxX = static_cast<int>(std::min(std::floor(maxX - 0.5f) + 1.0f, static_cast<float>(m_width)));
+    triangle.maxY = static_cast<int>(std::min(std::floor(maxY - 0.5f) + 1.0f, static_cast<float>(m_height)));
+    if (triangle.minX >= triangle.maxX || triangle.minY >= triangle.maxY || minDepth > 1.0f)
+    {
+        return;
+    }
+
+    // Edge from a to b, positive on the side of the triangle. Shifted so integer coordinates sample the pixel centers
+    auto edgeFunction = [](const glm::vec3& a, const glm::vec3& b)
+    {
+        glm::vec3 edge(a.y - b.y, b.x - a.x, (b.y - a.y) * a.x - (b.x - a.x) * a.y);
+        edge.z += 0.5f * (edge.x + edge.y);
+        return edge;
+    };
+    // Each edge is the weight of the opposite vertex
+    triangle.edges[0] = edgeFunction(screen[1], screen[2]);
+    triangle.edges[1] = edgeFunction(screen[2], screen[0]);
+    triangle.edges[2] = edgeFunction(screen[0], screen[1]);
+
+    // Depth is linear in screen space
+    triangle.depth = (triangle.edges[0] * screen[0].z + triangle.edges[1] * screen[1].z + triangle.edges[2] * screen[2].z) / area;
+
+    m_triangles.push_back(triangle);
+}
+
+void OcclusionCuller::RasterizeRows(int firstRow, int lastRow)
+{
+    std::fill(m_levels[0].depth.begin() + firstRow * m_width, m_levels[0].depth.begin() + lastRow * m_width, 1.0f);
+
+    for (const Triangle& triangle : m_triangles)
+    {
+        if (triangle.minY < lastRow && triangle.maxY > firstRow)
+        {
+            RasterizeTriangle(triangle, std::max(triangle.minY, firstRow), std::min(triangle.maxY, lastRow));
+        }
+    }
+}
+
+void OcclusionCuller::RasterizeTriangle(const Triangle& triangle, int firstRow, int lastRow)
+{
+    // Start in a group of 4 pixels. Pixels outside of the triangle fail the edge test
+    int firstColumn = triangle.minX & ~3;
+
+#if defined(OCCLUSION_CULLER_SSE)
+    const __m128 columnOffsets = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 edgeX0 = _mm_set1_ps(triangle.edges[0].x);
+    const __m128 edgeX1 = _mm_set1_ps(triangle.edges[1].x);
+    const __m128 edgeX2 = _mm_set1_ps(triangle.edges[2].x);
+    const __m128 depthX = _mm_set1_ps(triangle.depth.x);
+
+    for (int y = firstRow; y < lastRow; ++y)
+    {
+        float* row = &m_levels[0].depth[y * m_width];
+
+        // Values at the start of the row, stepped 4 pixels at a time
+        float fy = static_cast<float>(y), fx = static_cast<float>(firstColumn);
+        __m128 x = _mm_add_ps(_mm_set1_ps(fx), columnOffsets);
+        __m128 edge0 = _mm_add_ps(_mm_mul_ps(edgeX0, x), _mm_set1_ps(triangle.edges[0].y * fy + triangle.edges[0].z));
+        __m128 edge1 = _mm_add_ps(_mm_mul_ps(edgeX1, x), _mm_set1_ps(triangle.edges[1].y * fy + triangle.edges[1].z));
+        __m128 edge2 = _mm_add_ps(_mm_mul_ps(edgeX2, x), _mm_set1_ps(triangle.edges[2].y * fy + triangle.edges[2].z));
+        __m128 depth = _mm_add_ps(_mm_mul_ps(depthX, x), _mm_set1_ps(triangle.depth.y * fy + triangle.depth.z));
+
+        const __m128 edgeStep0 = _mm_set1_ps(triangle.edges[0].x * 4.0f);
+        const __m128 edgeStep1 = _mm_set1_ps(triangle.edges[1].x * 4.0f);
+        const __m128 edgeStep2 = _mm_set1_ps(triangle.edges[2].x * 4.0f);
+        const __m128 depthStep = _mm_set1_ps(triangle.depth.x * 4.0f);
+
+        for (int column = firstColumn; column < triangle.maxX; column += 4)
+        {
+            __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(edge0, zero), _mm_cmpge_ps(edge1, zero)), _mm_cmpge_ps(edge2, zero));
+            if (_mm_movemask_ps(inside))
+            {
+                __m128 previous = _mm_loadu_ps(row + column);
+                __m128 nearest = _mm_min_ps(previous, depth);
+                _mm_storeu_ps(row + column, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, previous)));
+            }
+
+            edge0 = _mm_add_ps(edge0, edgeStep0);
+            edge1 = _mm_add_ps(edge1, edgeStep1);
+            edge2 = _mm_add_ps(edge2, edgeStep2);
+            depth = _mm_add_ps(depth, depthStep);
+        }
+    }
+#else
+    for (int y = firstRow; y < lastRow; ++y)
+    {
+        float* row = &m_levels[0].depth[y * m_width];
+        float fy = static_cast<float>(y);
+        for (int column = firstColumn; column < triangle.maxX; ++column)
+        {
+            glm::vec3 p(static_cast<float>(column), fy, 1.0f);
+            if (glm::dot(triangle.edges[0], p) >= 0.0f && glm::dot(triangle.edges[1], p) >= 0.0f && glm::dot(triangle.edges[2], p) >= 0.0f)
+            {
+                row[column] = std::min(row[column], glm::dot(triangle.depth, p));
+            }
+        }
+    }
+#endif
+}
+
+void OcclusionCuller::BuildHierarchy()
+{
+    for (size_t i = 1; i < m_levels.size(); ++i)
+    {
+        const Level& source = m_levels[i - 1];
+        Level& level = m_levels[i];
+        for (int y = 0; y < level.height; ++y)
+        {
+            // Odd sizes repeat the last row or column
+            int y0 = 2 * y, y1 = std::min(2 * y + 1, source.height - 1);
+            for (int x = 0; x < level.width; ++x)
+            {
+                int x0 = 2 * x, x1 = std::min(2 * x + 1, source.width - 1);
+                level.depth[y * level.width + x] = std::max(
+                    std::max(source.depth[y0 * source.width + x0], source.depth[y0 * source.width + x1]),
+                    std::max(source.depth[y1 * source.width + x0], source.depth[y1 * source.width + x1]));
+            }
+        }
+    }
+}
+
+bool OcclusionCuller::IsVisible(const BoxBounds& worldBounds)
+{
+    m_stats.tested++;
+
+    // Project the corners, and keep the screen rectangle and the nearest depth
+    const glm::mat3 axes = worldBounds.GetScaledMatrix();
+    glm::vec2 minScreen(std::numeric_limits<float>::max());
+    glm::vec2 maxScreen(std::numeric_limits<float>::lowest());
+    float minDepth = std::numeric_limits<float>::max();
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        glm::vec3 position = worldBounds.GetCenter()
+            + axes[0] * ((corner & 1) ? 1.0f : -1.0f)
+            + axes[1] * ((corner & 2) ? 1.0f : -1.0f)
+            + axes[2] * ((corner & 4) ? 1.0f : -1.0f);
+        glm::vec4 clip = m_viewProjMatrix * glm::vec4(position, 1.0f);
+
+        // Crossing the near plane, the rectangle would be unbounded
+        if (clip.z < -clip.w || clip.w <= 0.0f)
+        {
+            return true;
+        }
+
+        glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        glm::vec2 screen((ndc.x * 0.5f + 0.5f) * m_width, (ndc.y * 0.5f + 0.5f) * m_height);
+        minScreen = glm::min(minScreen, screen);
+        maxScreen = glm::max(maxScreen, screen);
+        minDepth = std::min(minDepth, ndc.z * 0.5f + 0.5f);
+    }
+
+    // All the pixels touched by the rectangle. Outside of the screen, it is left to the frustum test
+    int minX = std::max(static_cast<int>(std::floor(minScreen.x)), 0);
+    int minY = std::max(static_cast<int>(std::floor(minScreen.y)), 0);
+    int maxX = std::min(static_cast<int>(std::floor(maxScreen.x)), m_width - 1);
+    int maxY = std::min(static_cast<int>(std::floor(maxScreen.y)), m_height - 1);
+    if (minX > maxX || minY > maxY)
+    {
+        return true;
+    }
+
+    // Level where the rectangle covers at most 4x4 texels
+    int size = std::max(maxX - minX, maxY - minY) + 1;
+    int levelIndex = 0;
+    while ((size >> (levelIndex + 1)) > 1 && levelIndex + 1 < static_cast<int>(m_levels.size()))
+    {
+        levelIndex++;
+    }
+    const Level& level = m_levels[levelIndex];
+
+    // Farthest depth of the occluders in the rectangle
+    float maxDepth = 0.0f;
+    for (int y = minY >> levelIndex; y <= (maxY >> levelIndex); ++y)
+    {
+        for (int x = minX >> levelIndex; x <= (maxX >> levelIndex); ++x)
+        {
+            maxDepth = std::max(maxDepth, level.depth[y * level.width + x]);
+        }
+    }
+
+    bool visible = minDepth <= maxDepth;
+    if (!visible)
+    {
+        m_stats.occluded++;
+    }
+    return visible;
+}
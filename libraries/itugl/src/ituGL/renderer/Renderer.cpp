@@ -9,21 +9,49 @@
 #include <ituGL/camera/Camera.h>
 #include <ituGL/texture/FramebufferObject.h>
 #include <ituGL/renderer/RenderPass.h>
+#include <ituGL/renderer/CommandBuffer.h>
+#include <ituGL/renderer/NullCommandExecutor.h>
+#include <ituGL/renderer/OcclusionCuller.h>
+#include <glm/matrix.hpp>
 #include <span>
 #include <algorithm>
+#include <array>
+#include <bit>
 #include <cassert>
 
-Renderer::DrawcallInfo::DrawcallInfo(const Material& material, unsigned int worldMatrixIndex, const VertexArrayObject& vao, const Drawcall& drawcall)
-    : m_material(material), m_worldMatrixIndex(worldMatrixIndex), m_vao(vao), m_drawcall(drawcall)
+// Bit layout of the sort keys, see Renderer::SortKey
+constexpr unsigned int SortKeyLayerShift = 60;
+constexpr unsigned int SortKeyTranslucentShift = 59;
+constexpr unsigned int SortKeyProgramBits = 11;
+constexpr unsigned int SortKeyMaterialBits = 12;
+constexpr unsigned int SortKeyVAOBits = 12;
+constexpr unsigned int SortKeyDepthBits = 24;
+
+constexpr Renderer::SortKey SortKeyMask(unsigned int bits) { return (Renderer::SortKey(1) << bits) - 1; }
+
+Renderer::DrawcallInfo::DrawcallInfo(const Material& material, unsigned int worldMatrixIndex, const VertexArrayObject& vao, const Drawcall& drawcall, SortKey sortKey)
+    : m_material(material), m_worldMatrixIndex(worldMatrixIndex), m_vao(vao), m_drawcall(drawcall), m_sortKey(sortKey)
+{
+}
+
+Renderer::DrawcallCollection::DrawcallCollection(const DrawcallSupportedFunction& isSupported)
+    : m_requiredCapabilities(0), m_excludedCapabilities(0), m_isSupported(isSupported)
 {
 }
 
-Renderer::DrawcallCollection::DrawcallCollection(const DrawcallSupportedFunction& isSupported) : m_isSupported(isSupported)
+Renderer::DrawcallCollection::DrawcallCollection(unsigned int requiredCapabilities, unsigned int excludedCapabilities)
+    : m_requiredCapabilities(requiredCapabilities), m_excludedCapabilities(excludedCapabilities)
 {
 }
 
 bool Renderer::DrawcallCollection::IsSupported(const DrawcallInfo& drawcallInfo) const
 {
+    // Fast path: the capabilities are computed when the material changes
+    unsigned int capabilities = drawcallInfo.GetMaterial().GetCapabilities();
+    if ((capabilities & m_requiredCapabilities) != m_requiredCapabilities || (capabilities & m_excludedCapabilities) != 0)
+    {
+        return false;
+    }
     return !m_isSupported || m_isSupported(drawcallInfo);
 }
 
@@ -32,6 +60,30 @@ void Renderer::DrawcallCollection::SetSupportedFunction(const DrawcallSupportedF
     m_isSupported = isSupported;
 }
 
+void Renderer::DrawcallCollection::SetCapabilities(unsigned int requiredCapabilities, unsigned int excludedCapabilities)
+{
+    m_requiredCapabilities = requiredCapabilities;
+    m_excludedCapabilities = excludedCapabilities;
+}
+
+std::span<Renderer::DrawcallInfo> Renderer::DrawcallCollection::GetDrawcalls()
+{
+    if (!m_mergedDrawcalls.empty())
+    {
+        return m_mergedDrawcalls;
+    }
+    return m_drawcallInfos.empty() ? m_retainedDrawcalls : m_drawcallInfos;
+}
+
+std::span<const Renderer::DrawcallInfo> Renderer::DrawcallCollection::GetDrawcalls() const
+{
+    if (!m_mergedDrawcalls.empty())
+    {
+        return m_mergedDrawcalls;
+    }
+    return m_drawcallInfos.empty() ? m_retainedDrawcalls : m_drawcallInfos;
+}
+
 void Renderer::DrawcallCollection::AddDrawcall(const DrawcallInfo& drawcallInfo)
 {
     if (IsSupported(drawcallInfo))
@@ -43,15 +95,172 @@ void Renderer::DrawcallCollection::AddDrawcall(const DrawcallInfo& drawcallInfo)
 void Renderer::DrawcallCollection::Clear()
 {
     m_drawcallInfos.clear();
+    m_mergedDrawcalls.clear();
+    m_sortFunction = nullptr;
+}
+
+void Renderer::DrawcallCollection::AddRetainedDrawcall(const DrawcallInfo& drawcallInfo)
+{
+    if (IsSupported(drawcallInfo))
+    {
+        m_pendingRetainedDrawcalls.push_back(drawcallInfo);
+    }
+}
+
+void Renderer::DrawcallCollection::RemoveRetainedDrawcalls(const DrawcallSupportedFunction& isRemoved)
+{
+    // Erasing keeps the order of the rest, so the list stays sorted
+    std::erase_if(m_retainedDrawcalls, isRemoved);
+    std::erase_if(m_pendingRetainedDrawcalls, isRemoved);
+}
+
+void Renderer::DrawcallCollection::MergeRetainedDrawcalls(std::vector<DrawcallInfo>& scratch)
+{
+    if (m_pendingRetainedDrawcalls.empty())
+    {
+        return;
+    }
+
+    SortByKey(m_pendingRetainedDrawcalls, scratch);
+
+    size_t sortedCount = m_retainedDrawcalls.size();
+    m_retainedDrawcalls.insert(m_retainedDrawcalls.end(), m_pendingRetainedDrawcalls.begin(), m_pendingRetainedDrawcalls.end());
+    std::inplace_merge(m_retainedDrawcalls.begin(), m_retainedDrawcalls.begin() + sortedCount, m_retainedDrawcalls.end(),
+        [](const DrawcallInfo& a, const DrawcallInfo& b) { return a.GetSortKey() < b.GetSortKey(); });
+
+    m_pendingRetainedDrawcalls.clear();
+}
+
+void Renderer::DrawcallCollection::MergeFrameDrawcalls()
+{
+    m_mergedDrawcalls.clear();
+    if (m_retainedDrawcalls.empty())
+    {
+        return;
+    }
+
+    // The retained drawcalls must keep their key order, the custom order is only applied to the copy
+    if (m_sortFunction)
+    {
+        m_mergedDrawcalls.reserve(m_drawcallInfos.size() + m_retainedDrawcalls.size());
+        m_mergedDrawcalls.insert(m_mergedDrawcalls.end(), m_retainedDrawcalls.begin(), m_retainedDrawcalls.end());
+        m_mergedDrawcalls.insert(m_mergedDrawcalls.end(), m_drawcallInfos.begin(), m_drawcallInfos.end());
+        std::sort(m_mergedDrawcalls.begin(), m_mergedDrawcalls.end(), m_sortFunction);
+        return;
+    }
+
+    if (m_drawcallInfos.empty())
+    {
+        return;
+    }
+
+    m_mergedDrawcalls.reserve(m_drawcallInfos.size() + m_retainedDrawcalls.size());
+    std::merge(m_retainedDrawcalls.begin(), m_retainedDrawcalls.end(), m_drawcallInfos.begin(), m_drawcallInfos.end(),
+        std::back_inserter(m_mergedDrawcalls),
+        [](const DrawcallInfo& a, const DrawcallInfo& b) { return a.GetSortKey() < b.GetSortKey(); });
+}
+
+void Renderer::DrawcallCollection::SortByKey(std::vector<DrawcallInfo>& scratch)
+{
+    SortByKey(m_drawcallInfos, scratch);
+}
+
+void Renderer::DrawcallCollection::SetSortFunction(const DrawcallSortFunction& sortFunction)
+{
+    m_sortFunction = sortFunction;
+}
+
+void Renderer::DrawcallCollection::Sort(std::vector<DrawcallInfo>& scratch)
+{
+    if (m_sortFunction)
+    {
+        std::sort(m_drawcallInfos.begin(), m_drawcallInfos.end(), m_sortFunction);
+    }
+    else
+    {
+        SortByKey(m_drawcallInfos, scratch);
+    }
+}
+
+void Renderer::DrawcallCollection::SortByKey(std::vector<DrawcallInfo>& drawcallInfos, std::vector<DrawcallInfo>& scratch)
+{
+    const size_t count = drawcallInfos.size();
+    if (count < 2)
+    {
+        return;
+    }
+
+    // Build the histograms of the 8 bytes of the keys in a single pass
+    constexpr unsigned int byteCount = sizeof(SortKey);
+    std::array<std::array<size_t, 256>, byteCount> histograms = {};
+    for (const DrawcallInfo& drawcallInfo : drawcallInfos)
+    {
+        SortKey key = drawcallInfo.GetSortKey();
+        for (unsigned int byteIndex = 0; byteIndex < byteCount; ++byteIndex)
+        {
+            histograms[byteIndex][(key >> (byteIndex * 8)) & 0xFF]++;
+        }
+    }
+
+    // Scratch buffer needs the same size, contents are overwritten
+    scratch.assign(drawcallInfos.begin(), drawcallInfos.end());
+
+    std::vector<DrawcallInfo>* source = &drawcallInfos;
+    std::vector<DrawcallInfo>* destination = &scratch;
+
+    // One counting sort per byte, starting with the least significant one
+    for (unsigned int byteIndex = 0; byteIndex < byteCount; ++byteIndex)
+    {
+        std::array<size_t, 256>& histogram = histograms[byteIndex];
+        unsigned int shift = byteIndex * 8;
+
+        // If all keys have the same value for this byte, the pass would not change the order
+        if (histogram[((*source)[0].GetSortKey() >> shift) & 0xFF] == count)
+        {
+            continue;
+        }
+
+        // Convert the counts to offsets
+        size_t offset = 0;
+        for (size_t& bucket : histogram)
+        {
+            size_t bucketCount = bucket;
+            bucket = offset;
+            offset += bucketCount;
+        }
+
+        for (const DrawcallInfo& drawcallInfo : *source)
+        {
+            (*destination)[histogram[(drawcallInfo.GetSortKey() >> shift) & 0xFF]++] = drawcallInfo;
+        }
+
+        std::swap(source, destination);
+    }
+
+    // After an odd number of passes the result is in the scratch buffer
+    if (source != &drawcallInfos)
+    {
+        drawcallInfos.swap(scratch);
+    }
 }
 
 
 Renderer::Renderer(DeviceGL& device)
     : m_device(device)
     , m_currentCamera(nullptr)
+    , m_occlusionCuller(nullptr)
     , m_defaultFramebuffer(FramebufferObject::GetDefault())
     , m_currentFramebuffer(m_defaultFramebuffer)
+    , m_modelProxyCount(0)
+    , m_shadowCastersEnabled(false)
+    , m_gpuCullingEnabled(false)
     , m_drawcallCollections(1)
+    , m_sortKeysNeedDepth(false)
+    , m_instanceBufferSize(0)
+    , m_instanceBufferOffset(0)
+    , m_commandExecutor(device)
+    , m_time(0.0f)
+    , m_ambientColor(0.0f)
 {
     InitializeFullscreenMesh();
 
@@ -75,6 +284,25 @@ const Camera& Renderer::GetCurrentCamera() const
 void Renderer::SetCurrentCamera(const Camera& camera)
 {
     m_currentCamera = &camera;
+    m_currentFrustum.SetViewProjectionMatrix(camera.GetViewProjectionMatrix());
+
+    // The occluders are drawn once per frame, before any object is tested
+    if (m_occlusionCuller)
+    {
+        m_occlusionCuller->Rasterize(camera.GetViewProjectionMatrix());
+    }
+}
+
+bool Renderer::IsOccluded(const BoxBounds& worldBounds) const
+{
+    assert(m_occlusionCuller);
+    return !m_occlusionCuller->IsVisible(worldBounds);
+}
+
+const FrustumBounds& Renderer::GetCurrentFrustum() const
+{
+    assert(m_currentCamera);
+    return m_currentFrustum;
 }
 
 std::shared_ptr<const FramebufferObject> Renderer::GetDefaultFramebuffer() const
@@ -106,9 +334,34 @@ void Renderer::Render()
 {
     assert(m_currentCamera);
 
+    // Models added before the camera was known are missing the depth part of their keys
+    if (m_sortKeysNeedDepth)
+    {
+        UpdateSortKeysDepth();
+    }
+
+    UpdateRetainedDrawcalls();
+
+    for (DrawcallCollection& collection : m_drawcallCollections)
+    {
+        collection.Sort(m_sortScratch);
+        collection.MergeFrameDrawcalls();
+    }
+
+    m_drawcallStats = DrawcallStats();
+    m_lastCullingStats = m_cullingStats;
+
+    UpdateFrameUniforms();
+
+    // Orphan the instance buffer on the first instanced drawcall, instead of waiting for the last frame to finish with it
+    m_instanceBufferOffset = m_instanceBufferSize;
+
     for (auto& pass : m_passes)
     {
         SetCurrentFramebuffer(pass->GetTargetFramebuffer());
+
+        // Passes may change state without PrepareDrawcall, start each one from scratch
+        InvalidateDrawcallState();
         pass->Render();
     }
 
@@ -127,6 +380,9 @@ void Renderer::Reset()
 {
     m_worldMatrices.clear();
     m_lights.clear();
+    m_shadowCasters.clear();
+    m_gpuCulledModels.clear();
+    m_recordedInstanceMatrices.clear();
 
     for (auto& collection : m_drawcallCollections)
     {
@@ -134,6 +390,8 @@ void Renderer::Reset()
     }
 
     m_currentCamera = nullptr;
+    m_sortKeysNeedDepth = false;
+    m_cullingStats = CullingStats();
 }
 
 int Renderer::AddRenderPass(std::unique_ptr<RenderPass> renderPass)
@@ -160,12 +418,24 @@ void Renderer::RegisterShaderProgram(std::shared_ptr<const ShaderProgram> shader
     {
         m_updateLightsFunctions[shaderProgramPtr] = updateLightsFunction;
     }
+
+    GLuint frameUniformsIndex = shaderProgramPtr->GetUniformBlockIndex(FrameUniformsName);
+    if (frameUniformsIndex != GL_INVALID_INDEX)
+    {
+        shaderProgramPtr->SetUniformBlockBinding(frameUniformsIndex, FrameUniformsBinding);
+    }
+
+    ShaderProgram::Location instanceMatrixLocation = shaderProgramPtr->GetAttributeLocation(InstanceWorldMatrixName);
+    if (instanceMatrixLocation >= 0)
+    {
+        m_instanceMatrixLocations[shaderProgramPtr] = instanceMatrixLocation;
+    }
 }
 
 void Renderer::UpdateTransforms(std::shared_ptr<const ShaderProgram> shaderProgramPtr, unsigned int worldMatrixIndex, bool cameraChanged) const
 {
-    const glm::mat4& worldMatrix = m_worldMatrices[worldMatrixIndex];
-    UpdateTransforms(shaderProgramPtr, worldMatrix);
+    const glm::mat4& worldMatrix = GetWorldMatrix(worldMatrixIndex);
+    UpdateTransforms(shaderProgramPtr, worldMatrix, cameraChanged);
 }
 
 void Renderer::UpdateTransforms(std::shared_ptr<const ShaderProgram> shaderProgramPtr, const glm::mat4& worldMatrix, bool cameraChanged) const
@@ -177,6 +447,31 @@ void Renderer::UpdateTransforms(std::shared_ptr<const ShaderProgram> shaderProgr
     }
 }
 
+void Renderer::RegisterRecordTransformsFunction(std::shared_ptr<const ShaderProgram> shaderProgramPtr, const RecordTransformsFunction& recordTransformsFunction)
+{
+    assert(shaderProgramPtr);
+    m_recordTransformsFunctions[shaderProgramPtr] = recordTransformsFunction;
+}
+
+void Renderer::RecordTransforms(CommandBuffer& commandBuffer, const DrawcallInfo& drawcallInfo, bool cameraChanged) const
+{
+    std::shared_ptr<const ShaderProgram> shaderProgram = drawcallInfo.GetMaterial().GetShaderProgram();
+    const auto& itFind = m_recordTransformsFunctions.find(shaderProgram);
+    if (itFind != m_recordTransformsFunctions.end())
+    {
+        assert(m_currentCamera);
+        itFind->second(commandBuffer, *shaderProgram, GetWorldMatrix(drawcallInfo), *m_currentCamera, cameraChanged);
+    }
+    else if (m_updateTransformsFunctions.find(shaderProgram) != m_updateTransformsFunctions.end())
+    {
+        unsigned int worldMatrixIndex = drawcallInfo.GetWorldMatrixIndex();
+        commandBuffer.CallFunction([this, shaderProgram, worldMatrixIndex, cameraChanged]()
+            {
+                UpdateTransforms(shaderProgram, worldMatrixIndex, cameraChanged);
+            });
+    }
+}
+
 Renderer::UpdateLightsFunction Renderer::GetDefaultUpdateLightsFunction(const ShaderProgram& shaderProgram)
 {
     // Get lighting related uniform locations
@@ -223,6 +518,20 @@ bool Renderer::UpdateLights(std::shared_ptr<const ShaderProgram> shaderProgramPt
     return false;
 }
 
+bool Renderer::HasUpdateLightsFunction(std::shared_ptr<const ShaderProgram> shaderProgramPtr) const
+{
+    return m_updateLightsFunctions.find(shaderProgramPtr) != m_updateLightsFunctions.end();
+}
+
+bool Renderer::RecordUpdateLights(CommandBuffer& commandBuffer, std::shared_ptr<const ShaderProgram> shaderProgramPtr, std::span<const Light* const> lights, unsigned int& lightIndex) const
+{
+    // The function runs now, its uniforms go to the buffer instead of GL
+    ShaderProgram::SetRecordingCommandBuffer(&commandBuffer);
+    bool needsRender = UpdateLights(shaderProgramPtr, lights, lightIndex);
+    ShaderProgram::SetRecordingCommandBuffer(nullptr);
+    return needsRender;
+}
+
 std::span<const Light* const> Renderer::GetLights() const
 {
     return m_lights;
@@ -233,21 +542,43 @@ void Renderer::AddLight(const Light& light)
     m_lights.push_back(&light);
 }
 
+void Renderer::AddShadowCaster(const Model& model, const glm::mat4& worldMatrix, const AabbBounds& worldBounds)
+{
+    unsigned int worldMatrixIndex = static_cast<unsigned int>(m_worldMatrices.size());
+    m_worldMatrices.push_back(worldMatrix);
+
+    m_shadowCasters.push_back(ShadowCaster{ &model, worldMatrixIndex, worldBounds });
+}
+
+void Renderer::AddGpuCulledModel(const Model& model, const glm::mat4& worldMatrix, const AabbBounds& worldBounds)
+{
+    unsigned int worldMatrixIndex = static_cast<unsigned int>(m_worldMatrices.size());
+    m_worldMatrices.push_back(worldMatrix);
+
+    m_gpuCulledModels.push_back(GpuCulledModel{ &model, worldMatrixIndex, worldBounds });
+}
+
 std::span<const Renderer::DrawcallInfo> Renderer::GetDrawcalls(unsigned int collectionIndex) const
 {
     return m_drawcallCollections[collectionIndex].GetDrawcalls();
 }
 
-void Renderer::AddModel(const Model& model, const glm::mat4& worldMatrix)
+void Renderer::AddModel(const Model& model, const glm::mat4& worldMatrix, unsigned int layer)
 {
     unsigned int worldMatrixIndex = static_cast<unsigned int>(m_worldMatrices.size());
     m_worldMatrices.push_back(worldMatrix);
 
+    if (!m_currentCamera)
+    {
+        m_sortKeysNeedDepth = true;
+    }
+
     const Mesh& mesh = model.GetMesh();
     for (unsigned int submeshIndex = 0; submeshIndex < mesh.GetSubmeshCount(); ++submeshIndex)
     {
         DrawcallInfo drawcallInfo(model.GetMaterial(submeshIndex), worldMatrixIndex,
             mesh.GetSubmeshVertexArray(submeshIndex), mesh.GetSubmeshDrawcall(submeshIndex));
+        drawcallInfo.SetSortKey(ComputeSortKey(drawcallInfo, layer));
 
         for (DrawcallCollection& collection : m_drawcallCollections)
         {
@@ -256,6 +587,64 @@ void Renderer::AddModel(const Model& model, const glm::mat4& worldMatrix)
     }
 }
 
+Renderer::ProxyId Renderer::AddModelProxy(const Model& model, const glm::mat4& worldMatrix, unsigned int layer)
+{
+    ProxyId proxyId;
+    if (!m_freeProxyIds.empty())
+    {
+        proxyId = m_freeProxyIds.back();
+        m_freeProxyIds.pop_back();
+    }
+    else
+    {
+        proxyId = static_cast<ProxyId>(m_modelProxies.size());
+        assert((proxyId & ProxyWorldMatrixFlag) == 0);
+        m_modelProxies.emplace_back();
+        m_proxyWorldMatrices.emplace_back();
+    }
+    m_modelProxies[proxyId] = ModelProxy{ &model, false };
+    m_proxyWorldMatrices[proxyId] = worldMatrix;
+    m_modelProxyCount++;
+
+    // Opaque keys don't get the depth, it would be wrong as soon as the camera moves. Translucent ones get it every frame
+    unsigned int worldMatrixIndex = ProxyWorldMatrixFlag | proxyId;
+    const Mesh& mesh = model.GetMesh();
+    for (unsigned int submeshIndex = 0; submeshIndex < mesh.GetSubmeshCount(); ++submeshIndex)
+    {
+        DrawcallInfo drawcallInfo(model.GetMaterial(submeshIndex), worldMatrixIndex,
+            mesh.GetSubmeshVertexArray(submeshIndex), mesh.GetSubmeshDrawcall(submeshIndex));
+        drawcallInfo.SetSortKey(ComputeSortKey(drawcallInfo, layer, false));
+
+        for (DrawcallCollection& collection : m_drawcallCollections)
+        {
+            collection.AddRetainedDrawcall(drawcallInfo);
+        }
+    }
+
+    return proxyId;
+}
+
+void Renderer::UpdateModelProxy(ProxyId proxyId, const glm::mat4& worldMatrix)
+{
+    assert(proxyId < m_modelProxies.size() && m_modelProxies[proxyId].model && !m_modelProxies[proxyId].removed);
+    m_proxyWorldMatrices[proxyId] = worldMatrix;
+}
+
+void Renderer::RemoveModelProxy(ProxyId proxyId)
+{
+    assert(proxyId < m_modelProxies.size() && m_modelProxies[proxyId].model && !m_modelProxies[proxyId].removed);
+
+    // The id is reused only after the drawcalls are gone, in the next Render
+    m_modelProxies[proxyId].removed = true;
+    m_removedProxyIds.push_back(proxyId);
+    m_modelProxyCount--;
+}
+
+unsigned int Renderer::GetModelProxyCount() const
+{
+    return m_modelProxyCount;
+}
+
 unsigned int Renderer::AddDrawcallCollection(const DrawcallSupportedFunction& drawcallSupportedFunction)
 {
     unsigned int index = static_cast<unsigned int>(m_drawcallCollections.size());
@@ -263,15 +652,32 @@ unsigned int Renderer::AddDrawcallCollection(const DrawcallSupportedFunction& dr
     return index;
 }
 
+unsigned int Renderer::AddDrawcallCollection(unsigned int requiredCapabilities, unsigned int excludedCapabilities)
+{
+    unsigned int index = static_cast<unsigned int>(m_drawcallCollections.size());
+    m_drawcallCollections.push_back(DrawcallCollection(requiredCapabilities, excludedCapabilities));
+    return index;
+}
+
 void Renderer::SetDrawcallCollectionSupportedFunction(unsigned int index, const DrawcallSupportedFunction& drawcallSupportedFunction)
 {
     m_drawcallCollections[index].SetSupportedFunction(drawcallSupportedFunction);
 }
 
+void Renderer::SetDrawcallCollectionCapabilities(unsigned int index, unsigned int requiredCapabilities, unsigned int excludedCapabilities)
+{
+    m_drawcallCollections[index].SetCapabilities(requiredCapabilities, excludedCapabilities);
+}
+
+void Renderer::SortDrawcallCollection(unsigned int index)
+{
+    m_drawcallCollections[index].SortByKey(m_sortScratch);
+}
+
 void Renderer::SortDrawcallCollection(unsigned int index, const DrawcallSortFunction& drawcallSortFunction)
 {
-    auto drawcalls = m_drawcallCollections[index].GetDrawcalls();
-    std::sort(drawcalls.begin(), drawcalls.end(), drawcallSortFunction);
+    // Render skips the key sort of this collection until the end of the frame
+    m_drawcallCollections[index].SetSortFunction(drawcallSortFunction);
 }
 
 bool Renderer::IsBackToFront(const DrawcallInfo& a, const DrawcallInfo& b) const
@@ -293,19 +699,335 @@ bool Renderer::IsFrontToBack(const DrawcallInfo& a, const DrawcallInfo& b) const
 
 void Renderer::PrepareDrawcall(const DrawcallInfo& drawcallInfo, Material::OverrideFlags materialOverride)
 {
-    std::shared_ptr<const ShaderProgram> shaderProgram = drawcallInfo.GetMaterial().GetShaderProgram();
+    const Material& material = drawcallInfo.GetMaterial();
+    std::shared_ptr<const ShaderProgram> shaderProgram = material.GetShaderProgram();
+    DrawcallState& state = m_drawcallState;
+
+    m_drawcallStats.drawcalls++;
+    state.instanceCount = 0;
+
+    // Setup shader program
+    bool shaderProgramChanged = shaderProgram.get() != state.shaderProgram;
+    if (shaderProgramChanged)
+    {
+        shaderProgram->Use();
+        state.shaderProgram = shaderProgram.get();
+        m_drawcallStats.shaderPrograms.issued++;
+    }
+    else
+    {
+        m_drawcallStats.shaderPrograms.skipped++;
+    }
 
-    // TODO: Room for optimization here, caching current material, current worldMatrixIndex and current VAO
+    // Setup material properties. Uniforms are stored per program, so a different program always needs them
+    bool materialChanged = shaderProgramChanged || &material != state.material;
+    if (materialChanged)
+    {
+        material.UseProperties(state.boundTextures, m_drawcallStats.textures.issued, m_drawcallStats.textures.skipped);
+        state.material = &material;
+        m_drawcallStats.materials.issued++;
+    }
+    else
+    {
+        m_drawcallStats.materials.skipped++;
+    }
 
-    // Setup material
-    drawcallInfo.GetMaterial().Use(materialOverride);
+    // Setup depth, stencil and blend states
+    if (materialChanged || materialOverride != state.materialOverride || state.renderStatesDirty)
+    {
+        material.UseRenderStates(materialOverride);
+        state.materialOverride = materialOverride;
+        state.renderStatesDirty = false;
+        m_drawcallStats.renderStates.issued++;
+    }
+    else
+    {
+        m_drawcallStats.renderStates.skipped++;
+    }
 
-    // Setup world matrix
-    // Setup camera
-    UpdateTransforms(shaderProgram, drawcallInfo.GetWorldMatrixIndex());
+    // Setup world matrix and camera. Material uniforms may have overwritten the camera ones
+    if (materialChanged || drawcallInfo.GetWorldMatrixIndex() != state.worldMatrixIndex)
+    {
+        UpdateTransforms(shaderProgram, drawcallInfo.GetWorldMatrixIndex(), materialChanged);
+        state.worldMatrixIndex = drawcallInfo.GetWorldMatrixIndex();
+        m_drawcallStats.transforms.issued++;
+    }
+    else
+    {
+        m_drawcallStats.transforms.skipped++;
+    }
 
     // Setup VAO
-    drawcallInfo.GetVAO().Bind();
+    const VertexArrayObject& vao = drawcallInfo.GetVAO();
+    if (&vao != state.vao)
+    {
+        vao.Bind();
+        state.vao = &vao;
+        m_drawcallStats.vaos.issued++;
+    }
+    else
+    {
+        m_drawcallStats.vaos.skipped++;
+    }
+}
+
+unsigned int Renderer::PrepareDrawcalls(std::span<const DrawcallInfo> drawcallInfos, Material::OverrideFlags materialOverride)
+{
+    assert(!drawcallInfos.empty());
+    const DrawcallInfo& drawcallInfo = drawcallInfos[0];
+
+    PrepareDrawcall(drawcallInfo, materialOverride);
+
+    const auto& itFind = m_instanceMatrixLocations.find(drawcallInfo.GetMaterial().GetShaderProgram());
+    if (itFind == m_instanceMatrixLocations.end())
+    {
+        return 1;
+    }
+
+    // Sorting keeps the drawcalls with the same material and VAO together, take all the consecutive ones
+    m_instanceMatrices.clear();
+    m_instanceMatrices.push_back(GetWorldMatrix(drawcallInfo));
+    while (m_instanceMatrices.size() < drawcallInfos.size())
+    {
+        const DrawcallInfo& instanceInfo = drawcallInfos[m_instanceMatrices.size()];
+        if (&instanceInfo.GetMaterial() != &drawcallInfo.GetMaterial() ||
+            &instanceInfo.GetVAO() != &drawcallInfo.GetVAO() ||
+            &instanceInfo.GetDrawcall() != &drawcallInfo.GetDrawcall())
+        {
+            break;
+        }
+        m_instanceMatrices.push_back(GetWorldMatrix(instanceInfo));
+    }
+
+    unsigned int instanceCount = static_cast<unsigned int>(m_instanceMatrices.size());
+    m_drawcallState.instanceCount = instanceCount;
+    m_drawcallState.instanceLocation = itFind->second;
+    m_drawcallState.instanceOffset = UpdateInstanceBuffer(m_instanceMatrices);
+    m_drawcallStats.instancedDrawcalls++;
+    m_drawcallStats.instances += instanceCount;
+    return instanceCount;
+}
+
+void Renderer::DrawPreparedDrawcall(const DrawcallInfo& drawcallInfo) const
+{
+    if (m_drawcallState.instanceCount > 0)
+    {
+        // There is no base instance before GL 4.2, so the attribute of the VAO is pointed to the first matrix of the run.
+        // Other drawcalls use the same VAO, the attribute is only enabled for this draw
+        m_instanceBuffer.Bind();
+        SetInstanceMatrixAttribute(m_drawcallState.instanceLocation, m_drawcallState.instanceOffset);
+        drawcallInfo.GetDrawcall().DrawInstanced(m_drawcallState.instanceCount);
+        ResetInstanceMatrixAttribute(m_drawcallState.instanceLocation);
+    }
+    else
+    {
+        drawcallInfo.GetDrawcall().Draw();
+    }
+}
+
+size_t Renderer::UpdateInstanceBuffer(std::span<const glm::mat4> worldMatrices)
+{
+    size_t size = worldMatrices.size_bytes();
+
+    m_instanceBuffer.Bind();
+    if (m_instanceBufferOffset + size > m_instanceBufferSize)
+    {
+        // Get new storage, the GL keeps the old one alive until the drawcalls using it are done
+        m_instanceBufferSize = std::max(m_instanceBufferSize, 2 * size);
+        m_instanceBuffer.AllocateData(m_instanceBufferSize, BufferObject::Usage::StreamDraw);
+        m_instanceBufferOffset = 0;
+    }
+    m_instanceBuffer.UpdateData(worldMatrices, m_instanceBufferOffset);
+
+    size_t offset = m_instanceBufferOffset;
+    m_instanceBufferOffset += size;
+    return offset;
+}
+
+ShaderProgram::Location Renderer::GetInstanceMatrixLocation(std::shared_ptr<const ShaderProgram> shaderProgramPtr) const
+{
+    const auto& itFind = m_instanceMatrixLocations.find(shaderProgramPtr);
+    return itFind != m_instanceMatrixLocations.end() ? itFind->second : -1;
+}
+
+void Renderer::SetInstanceMatrixAttribute(ShaderProgram::Location location, size_t offset)
+{
+    assert(location >= 0);
+
+    // A mat4 attribute takes 4 consecutive locations, one per column
+    const unsigned char* pointer = nullptr;
+    pointer += offset;
+    for (GLuint column = 0; column < 4; ++column)
+    {
+        GLuint columnLocation = static_cast<GLuint>(location) + column;
+        glVertexAttribPointer(columnLocation, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), pointer + column * sizeof(glm::vec4));
+        glVertexAttribDivisor(columnLocation, 1);
+        glEnableVertexAttribArray(columnLocation);
+    }
+}
+
+void Renderer::ResetInstanceMatrixAttribute(ShaderProgram::Location location)
+{
+    assert(location >= 0);
+
+    for (GLuint column = 0; column < 4; ++column)
+    {
+        GLuint columnLocation = static_cast<GLuint>(location) + column;
+        glDisableVertexAttribArray(columnLocation);
+        glVertexAttribDivisor(columnLocation, 0);
+    }
+}
+
+void Renderer::RecordPrepareDrawcall(CommandBuffer& commandBuffer, const DrawcallInfo& drawcallInfo, Material::OverrideFlags materialOverride)
+{
+    // Same as PrepareDrawcall
+    const Material& material = drawcallInfo.GetMaterial();
+    std::shared_ptr<const ShaderProgram> shaderProgram = material.GetShaderProgram();
+    DrawcallState& state = m_recordState;
+
+    // The VAO of the last instanced drawcall is still bound when this command runs
+    if (state.instanceCount > 0)
+    {
+        ShaderProgram::Location location = state.instanceLocation;
+        commandBuffer.CallFunction([location]() { ResetInstanceMatrixAttribute(location); });
+    }
+
+    m_drawcallStats.drawcalls++;
+    state.instanceCount = 0;
+
+    bool shaderProgramChanged = shaderProgram.get() != state.shaderProgram;
+    if (shaderProgramChanged)
+    {
+        commandBuffer.UseProgram(shaderProgram->GetHandle());
+        state.shaderProgram = shaderProgram.get();
+        m_drawcallStats.shaderPrograms.issued++;
+    }
+    else
+    {
+        m_drawcallStats.shaderPrograms.skipped++;
+    }
+
+    bool materialChanged = shaderProgramChanged || &material != state.material;
+    if (materialChanged)
+    {
+        material.RecordProperties(commandBuffer);
+        state.material = &material;
+        m_drawcallStats.materials.issued++;
+    }
+    else
+    {
+        m_drawcallStats.materials.skipped++;
+    }
+
+    if (materialChanged || materialOverride != state.materialOverride || state.renderStatesDirty)
+    {
+        material.RecordRenderStates(commandBuffer, materialOverride);
+        state.materialOverride = materialOverride;
+        state.renderStatesDirty = false;
+        m_drawcallStats.renderStates.issued++;
+    }
+    else
+    {
+        m_drawcallStats.renderStates.skipped++;
+    }
+
+    if (materialChanged || drawcallInfo.GetWorldMatrixIndex() != state.worldMatrixIndex)
+    {
+        RecordTransforms(commandBuffer, drawcallInfo, materialChanged);
+        state.worldMatrixIndex = drawcallInfo.GetWorldMatrixIndex();
+        m_drawcallStats.transforms.issued++;
+    }
+    else
+    {
+        m_drawcallStats.transforms.skipped++;
+    }
+
+    const VertexArrayObject& vao = drawcallInfo.GetVAO();
+    if (&vao != state.vao)
+    {
+        commandBuffer.BindVertexArray(vao.GetHandle());
+        state.vao = &vao;
+        m_drawcallStats.vaos.issued++;
+    }
+    else
+    {
+        m_drawcallStats.vaos.skipped++;
+    }
+}
+
+unsigned int Renderer::RecordPrepareDrawcalls(CommandBuffer& commandBuffer, std::span<const DrawcallInfo> drawcallInfos, Material::OverrideFlags materialOverride)
+{
+    assert(!drawcallInfos.empty());
+    const DrawcallInfo& drawcallInfo = drawcallInfos[0];
+
+    RecordPrepareDrawcall(commandBuffer, drawcallInfo, materialOverride);
+
+    ShaderProgram::Location location = GetInstanceMatrixLocation(drawcallInfo.GetMaterial().GetShaderProgram());
+    if (location < 0)
+    {
+        return 1;
+    }
+
+    // Same runs as PrepareDrawcalls. The matrices are kept until the end of the frame, and uploaded when executed
+    size_t offset = m_recordedInstanceMatrices.size();
+    m_recordedInstanceMatrices.push_back(GetWorldMatrix(drawcallInfo));
+    size_t instanceCount = 1;
+    while (instanceCount < drawcallInfos.size())
+    {
+        const DrawcallInfo& instanceInfo = drawcallInfos[instanceCount];
+        if (&instanceInfo.GetMaterial() != &drawcallInfo.GetMaterial() ||
+            &instanceInfo.GetVAO() != &drawcallInfo.GetVAO() ||
+            &instanceInfo.GetDrawcall() != &drawcallInfo.GetDrawcall())
+        {
+            break;
+        }
+        m_recordedInstanceMatrices.push_back(GetWorldMatrix(instanceInfo));
+        instanceCount++;
+    }
+
+    // The attribute stays enabled for the draws of the run, the next RecordPrepareDrawcall or ExecuteCommands disables it
+    commandBuffer.CallFunction([this, location, offset, instanceCount]()
+        {
+            size_t bufferOffset = UpdateInstanceBuffer(std::span<const glm::mat4>(m_recordedInstanceMatrices).subspan(offset, instanceCount));
+            SetInstanceMatrixAttribute(location, bufferOffset);
+        });
+
+    m_recordState.instanceCount = static_cast<unsigned int>(instanceCount);
+    m_recordState.instanceLocation = location;
+    m_drawcallStats.instancedDrawcalls++;
+    m_drawcallStats.instances += static_cast<unsigned int>(instanceCount);
+    return static_cast<unsigned int>(instanceCount);
+}
+
+void Renderer::RecordDrawPreparedDrawcall(CommandBuffer& commandBuffer, const DrawcallInfo& drawcallInfo) const
+{
+    drawcallInfo.GetDrawcall().Record(commandBuffer, m_recordState.instanceCount);
+}
+
+void Renderer::ExecuteCommands(const CommandBuffer& commandBuffer)
+{
+#ifndef NDEBUG
+    NullCommandExecutor validator;
+    validator.Execute(commandBuffer);
+    assert(validator.GetInvalidCount() == 0);
+#endif
+
+    m_commandExecutor.Execute(commandBuffer);
+
+    // The VAO of the last recorded drawcall is still bound. If it was instanced, disable the attribute it left enabled
+    if (m_recordState.instanceCount > 0)
+    {
+        ResetInstanceMatrixAttribute(m_recordState.instanceLocation);
+    }
+
+    // The commands changed the state behind PrepareDrawcall
+    InvalidateDrawcallState();
+}
+
+void Renderer::InvalidateDrawcallState()
+{
+    m_drawcallState = DrawcallState();
+    m_recordState = DrawcallState();
 }
 
 void Renderer::SetLightingRenderStates(bool firstPass)
@@ -313,9 +1035,25 @@ void Renderer::SetLightingRenderStates(bool firstPass)
     // Set the render states for the first and additional lights
     if (!firstPass)
     {
+        // The material states need to be restored for the next drawcall
+        m_drawcallState.renderStatesDirty = true;
+
         m_device.SetFeatureEnabled(GL_BLEND, true);
-        glDepthFunc(firstPass ? GL_LESS : GL_EQUAL);
-        glBlendFunc(GL_ONE, GL_ONE);
+        m_device.SetDepthFunction(firstPass ? GL_LESS : GL_EQUAL);
+        m_device.SetBlendFunction(GL_ONE, GL_ONE, GL_ONE, GL_ONE);
+    }
+}
+
+void Renderer::RecordLightingRenderStates(CommandBuffer& commandBuffer, bool firstPass)
+{
+    // Same states as SetLightingRenderStates
+    if (!firstPass)
+    {
+        m_recordState.renderStatesDirty = true;
+
+        commandBuffer.SetFeatureEnabled(GL_BLEND, true);
+        commandBuffer.SetDepthFunction(GL_EQUAL);
+        commandBuffer.SetBlendFunction(GL_ONE, GL_ONE, GL_ONE, GL_ONE);
     }
 }
 
@@ -332,7 +1070,141 @@ void Renderer::InitializeFullscreenMesh()
     m_fullscreenMesh.AddSubmesh<glm::vec3, VertexFormat::LayoutIterator>(Drawcall::Primitive::Triangles, fullscreenVertices, vertexFormat.LayoutBegin(3, false), vertexFormat.LayoutEnd());
 }
 
+void Renderer::UpdateFrameUniforms()
+{
+    assert(m_currentCamera);
+    const Camera& camera = *m_currentCamera;
+
+    // Same order as the block declaration, see Renderer::FrameUniformsName
+    m_frameUniforms.Clear();
+    m_frameUniforms.Write(camera.GetViewMatrix());
+    m_frameUniforms.Write(camera.GetProjectionMatrix());
+    m_frameUniforms.Write(camera.GetViewProjectionMatrix());
+    m_frameUniforms.Write(glm::inverse(camera.GetViewMatrix()));
+    m_frameUniforms.Write(glm::inverse(camera.GetProjectionMatrix()));
+    m_frameUniforms.Write(camera.ExtractTranslation());
+    m_frameUniforms.Write(m_time);
+    m_frameUniforms.Write(m_ambientColor);
+    m_frameUniforms.Write(static_cast<int>(m_lights.size()));
+    m_frameUniforms.EndStruct();
+
+    // Allocate again instead of updating, so we don't wait for the last frame to stop reading it
+    m_frameUniformBuffer.Bind();
+    m_frameUniformBuffer.AllocateData(m_frameUniforms.GetData(), BufferObject::Usage::StreamDraw);
+    m_frameUniformBuffer.BindBase(FrameUniformsBinding);
+}
+
 const glm::mat4& Renderer::GetWorldMatrix(const DrawcallInfo& drawcallInfo) const
 {
-    return m_worldMatrices[drawcallInfo.GetWorldMatrixIndex()];
+    return GetWorldMatrix(drawcallInfo.GetWorldMatrixIndex());
+}
+
+Renderer::SortKey Renderer::ComputeSortKey(const DrawcallInfo& drawcallInfo, unsigned int layer, bool viewDepth) const
+{
+    const Material& material = drawcallInfo.GetMaterial();
+
+    // Handles are small consecutive numbers, keep only the lower bits
+    SortKey program = material.GetShaderProgram()->GetHandle() & SortKeyMask(SortKeyProgramBits);
+    SortKey vao = drawcallInfo.GetVAO().GetHandle() & SortKeyMask(SortKeyVAOBits);
+
+    // Materials have no id, hash the address. We only need equal materials to end up together
+    SortKey materialAddress = reinterpret_cast<std::uintptr_t>(&material);
+    SortKey materialHash = ((materialAddress >> 4) * 0x9E3779B97F4A7C15ull) >> (64 - SortKeyMaterialBits);
+
+    SortKey depth = 0;
+    if (m_currentCamera && viewDepth)
+    {
+        // View depth of the object origin. Positive floats keep their order when compared as integers
+        const glm::mat4& viewMatrix = m_currentCamera->GetViewMatrix();
+        glm::vec3 position = GetWorldMatrix(drawcallInfo)[3];
+        float viewDepth = -(viewMatrix[0][2] * position.x + viewMatrix[1][2] * position.y + viewMatrix[2][2] * position.z + viewMatrix[3][2]);
+        if (viewDepth > 0.0f)
+        {
+            depth = std::bit_cast<std::uint32_t>(viewDepth) >> (31 - SortKeyDepthBits);
+        }
+    }
+
+    SortKey key = SortKey(layer & 0xF) << SortKeyLayerShift;
+    if (material.GetCapabilities() & Material::Blended)
+    {
+        // Translucent: back to front first, then by state
+        SortKey invertedDepth = SortKeyMask(SortKeyDepthBits) - depth;
+        key |= SortKey(1) << SortKeyTranslucentShift;
+        key |= invertedDepth << (SortKeyProgramBits + SortKeyMaterialBits + SortKeyVAOBits);
+        key |= program << (SortKeyMaterialBits + SortKeyVAOBits);
+        key |= materialHash << SortKeyVAOBits;
+        key |= vao;
+    }
+    else
+    {
+        // Opaque: by state first, then front to back
+        key |= program << (SortKeyMaterialBits + SortKeyVAOBits + SortKeyDepthBits);
+        key |= materialHash << (SortKeyVAOBits + SortKeyDepthBits);
+        key |= vao << SortKeyDepthBits;
+        key |= depth;
+    }
+    return key;
+}
+
+void Renderer::UpdateSortKeysDepth()
+{
+    assert(m_currentCamera);
+    for (DrawcallCollection& collection : m_drawcallCollections)
+    {
+        for (DrawcallInfo& drawcallInfo : collection.GetFrameDrawcalls())
+        {
+            unsigned int layer = static_cast<unsigned int>(drawcallInfo.GetSortKey() >> SortKeyLayerShift);
+            drawcallInfo.SetSortKey(ComputeSortKey(drawcallInfo, layer));
+        }
+    }
+    m_sortKeysNeedDepth = false;
+}
+
+void Renderer::UpdateRetainedDrawcalls()
+{
+    assert(m_currentCamera);
+
+    if (!m_removedProxyIds.empty())
+    {
+        auto isRemoved = [this](const DrawcallInfo& drawcallInfo)
+        {
+            return m_modelProxies[drawcallInfo.GetWorldMatrixIndex() & ~ProxyWorldMatrixFlag].removed;
+        };
+        for (DrawcallCollection& collection : m_drawcallCollections)
+        {
+            collection.RemoveRetainedDrawcalls(isRemoved);
+        }
+
+        for (ProxyId proxyId : m_removedProxyIds)
+        {
+            m_modelProxies[proxyId] = ModelProxy();
+            m_freeProxyIds.push_back(proxyId);
+        }
+        m_removedProxyIds.clear();
+    }
+
+    auto keyLess = [](const DrawcallInfo& a, const DrawcallInfo& b) { return a.GetSortKey() < b.GetSortKey(); };
+    for (DrawcallCollection& collection : m_drawcallCollections)
+    {
+        collection.MergeRetainedDrawcalls(m_sortScratch);
+
+        // The translucent drawcalls of each layer are together at the end of it. Only they need the view depth,
+        // so only their range is sorted again
+        std::span<DrawcallInfo> drawcalls = collection.GetRetainedDrawcalls();
+        for (SortKey layer = 0; layer < 16 && !drawcalls.empty(); ++layer)
+        {
+            SortKey firstKey = (layer << SortKeyLayerShift) | (SortKey(1) << SortKeyTranslucentShift);
+            SortKey lastKey = firstKey | SortKeyMask(SortKeyTranslucentShift);
+            auto first = std::lower_bound(drawcalls.begin(), drawcalls.end(), firstKey,
+                [](const DrawcallInfo& drawcallInfo, SortKey key) { return drawcallInfo.GetSortKey() < key; });
+            auto last = std::upper_bound(first, drawcalls.end(), lastKey,
+                [](SortKey key, const DrawcallInfo& drawcallInfo) { return key < drawcallInfo.GetSortKey(); });
+
+            for (auto it = first; it != last; ++it)
+            {
+                it->SetSortKey(ComputeSortKey(*it, static_cast<unsigned int>(layer)));
+            }
+            std::sort(first, last, keyLess);
+        }
+    }
 }
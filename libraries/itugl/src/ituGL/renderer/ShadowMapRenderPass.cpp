@@ -0,0 +1,370 @@
+#include <ituGL/renderer/ShadowMapRenderPass.h>
+
+#include <ituGL/renderer/Renderer.h>
+#include <ituGL/lighting/DirectionalLight.h>
+#include <ituGL/camera/Camera.h>
+#include <ituGL/geometry/Model.h>
+#include <ituGL/geometry/Mesh.h>
+#include <ituGL/geometry/VertexArrayObject.h>
+#include <ituGL/shader/Material.h>
+#include <ituGL/texture/Texture2DArrayObject.h>
+#include <ituGL/texture/FramebufferObject.h>
+#include <glm/common.hpp>
+#include <glm/gtx/transform.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <functional>
+#include <array>
+#include <cmath>
+
+// Extra size of the cascades, as a fraction of the radius of their slice. Their position is snapped to a grid of this
+// size, so they only move when the camera crosses a cell, and static cascades can keep their contents meanwhile
+constexpr float CascadeSnapFraction = 0.125f;
+
+// Size of the box that contains a box of the given half size, rotated by the matrix
+static glm::vec3 GetRotatedSize(const glm::mat3& rotationMatrix, const glm::vec3& size)
+{
+    return glm::abs(rotationMatrix[0]) * size.x + glm::abs(rotationMatrix[1]) * size.y + glm::abs(rotationMatrix[2]) * size.z;
+}
+
+static void HashCombine(size_t& hash, size_t value)
+{
+    hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+}
+
+static void HashCombine(size_t& hash, const glm::mat4& matrix)
+{
+    for (int column = 0; column < 4; ++column)
+    {
+        for (int row = 0; row < 4; ++row)
+        {
+            HashCombine(hash, std::hash<float>()(matrix[column][row]));
+        }
+    }
+}
+
+ShadowMapRenderPass::ShadowMapRenderPass(std::shared_ptr<Material> depthMaterial, int resolution, unsigned int cascadeCount)
+    : m_depthMaterial(depthMaterial)
+    , m_worldViewProjMatrixLocation(-1)
+    , m_resolution(resolution)
+    , m_cascadeCount(cascadeCount)
+    , m_maxDistance(100.0f)
+    , m_splitLambda(0.75f)
+    , m_depthBiasFactor(2.0f)
+    , m_depthBiasUnits(4.0f)
+    , m_hasLight(false)
+    , m_lightViewMatrix(1.0f)
+    , m_cascades(cascadeCount)
+    , m_splitDepths(cascadeCount, 0.0f)
+    , m_drawnCascadeCount(0)
+    , m_cachedCascadeCount(0)
+    , m_drawnCasterCount(0)
+{
+    assert(m_depthMaterial);
+    assert(cascadeCount > 0 && cascadeCount <= MaxCascadeCount);
+
+    m_worldViewProjMatrixLocation = m_depthMaterial->GetShaderProgram()->GetUniformLocation("WorldViewProjMatrix");
+    assert(m_worldViewProjMatrixLocation >= 0);
+
+    InitializeTextures();
+}
+
+ShadowMapRenderPass::~ShadowMapRenderPass()
+{
+}
+
+void ShadowMapRenderPass::Render()
+{
+    Renderer& renderer = GetRenderer();
+    DeviceGL& device = renderer.GetDevice();
+
+    m_drawnCascadeCount = 0;
+    m_cachedCascadeCount = 0;
+    m_drawnCasterCount = 0;
+
+    const DirectionalLight* light = FindLight();
+    m_hasLight = light != nullptr;
+    if (!m_hasLight)
+    {
+        return;
+    }
+
+    const Camera& camera = renderer.GetCurrentCamera();
+
+    // Light view at the origin, so it only changes with the direction. Light travels along the direction
+    glm::vec3 lightDirection = glm::normalize(light->GetDirection());
+    glm::vec3 up = std::abs(lightDirection.y) < 0.99f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+    m_lightViewMatrix = glm::lookAt(glm::vec3(0.0f), lightDirection, up);
+
+    // Bounds of the casters in light view space, and their farthest view depth
+    // All the models of the scene are casters, so they also contain all the surfaces that receive shadows
+    std::span<const Renderer::ShadowCaster> casters = renderer.GetShadowCasters();
+    glm::mat3 lightRotation(m_lightViewMatrix);
+    glm::mat3 viewRotation(camera.GetViewMatrix());
+    float casterMaxDepth = 0.0f;
+    m_casterLightBounds.clear();
+    for (const Renderer::ShadowCaster& caster : casters)
+    {
+        const AabbBounds& bounds = caster.worldBounds;
+        glm::vec3 lightCenter = glm::vec3(m_lightViewMatrix * glm::vec4(bounds.GetCenter(), 1.0f));
+        m_casterLightBounds.emplace_back(lightCenter, GetRotatedSize(lightRotation, bounds.GetSize()));
+
+        glm::vec3 viewCenter = glm::vec3(camera.GetViewMatrix() * glm::vec4(bounds.GetCenter(), 1.0f));
+        glm::vec3 viewSize = GetRotatedSize(viewRotation, bounds.GetSize());
+        casterMaxDepth = std::max(casterMaxDepth, -viewCenter.z + viewSize.z);
+    }
+
+    // View depth of the camera near and far planes
+    glm::mat4 invProjMatrix = glm::inverse(camera.GetProjectionMatrix());
+    auto unprojectDepth = [&](float z)
+    {
+        glm::vec4 position = invProjMatrix * glm::vec4(0.0f, 0.0f, z, 1.0f);
+        return -position.z / position.w;
+    };
+    // The caster depth is rounded up, so the splits, and the cached cascades, don't change with every camera movement
+    float depthStep = m_maxDistance / 16.0f;
+    casterMaxDepth = std::ceil(casterMaxDepth / depthStep) * depthStep;
+
+    float nearDepth = unprojectDepth(-1.0f);
+    float farDepth = std::min({ unprojectDepth(1.0f), m_maxDistance, casterMaxDepth });
+    farDepth = std::max(farDepth, nearDepth * 2.0f);
+    ComputeSplitDepths(nearDepth, farDepth);
+
+    GLint x, y;
+    GLsizei width, height;
+    device.GetViewport(x, y, width, height);
+    device.SetViewport(0, 0, m_resolution, m_resolution);
+
+    // Slope scaled offset, so the surfaces don't shadow themselves
+    device.EnableFeature(GL_POLYGON_OFFSET_FILL);
+    device.SetPolygonOffset(m_depthBiasFactor, m_depthBiasUnits);
+
+    float cascadeNearDepth = nearDepth;
+    for (unsigned int cascadeIndex = 0; cascadeIndex < m_cascadeCount; ++cascadeIndex)
+    {
+        Cascade& cascade = m_cascades[cascadeIndex];
+        FitCascade(cascade, camera, cascadeNearDepth, m_splitDepths[cascadeIndex]);
+        cascadeNearDepth = m_splitDepths[cascadeIndex];
+
+        // Keep the contents if the same casters are drawn with the same projection
+        size_t hash = CullCasters(cascade);
+        if (cascade.drawn && cascade.drawnHash == hash)
+        {
+            m_cachedCascadeCount++;
+            continue;
+        }
+
+        DrawCascade(cascade, cascadeIndex);
+        cascade.drawnHash = hash;
+        cascade.drawn = true;
+    }
+
+    // Restore the states, and the framebuffer that the renderer expects
+    device.SetPolygonOffset(0.0f, 0.0f);
+    device.DisableFeature(GL_POLYGON_OFFSET_FILL);
+    device.SetViewport(x, y, width, height);
+    renderer.GetCurrentFramebuffer()->Bind();
+}
+
+const DirectionalLight* ShadowMapRenderPass::FindLight() const
+{
+    for (const Light* light : GetRenderer().GetLights())
+    {
+        if (light->GetType() == Light::Type::Directional)
+        {
+            return static_cast<const DirectionalLight*>(light);
+        }
+    }
+    return nullptr;
+}
+
+// Practical split scheme: blend of the logarithmic split, that keeps the same texel density on screen, and the uniform split
+void ShadowMapRenderPass::ComputeSplitDepths(float nearDepth, float farDepth)
+{
+    for (unsigned int cascadeIndex = 0; cascadeIndex < m_cascadeCount; ++cascadeIndex)
+    {
+        float t = static_cast<float>(cascadeIndex + 1) / m_cascadeCount;
+        float uniformDepth = nearDepth + (farDepth - nearDepth) * t;
+        float logDepth = nearDepth * std::pow(farDepth / nearDepth, t);
+        m_splitDepths[cascadeIndex] = uniformDepth + (logDepth - uniformDepth) * m_splitLambda;
+    }
+}
+
+void ShadowMapRenderPass::FitCascade(Cascade& cascade, const Camera& camera, float nearDepth, float farDepth) const
+{
+    // Corners of the slice in view space. Along the edges of the frustum, the position is linear with the depth
+    glm::mat4 invProjMatrix = glm::inverse(camera.GetProjectionMatrix());
+    std::array<glm::vec3, 8> corners;
+    for (int i = 0; i < 4; ++i)
+    {
+        glm::vec2 ndc((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f);
+        glm::vec4 nearCorner = invProjMatrix * glm::vec4(ndc, -1.0f, 1.0f);
+        glm::vec4 farCorner = invProjMatrix * glm::vec4(ndc, 1.0f, 1.0f);
+        glm::vec3 nearPoint = glm::vec3(nearCorner) / nearCorner.w;
+        glm::vec3 farPoint = glm::vec3(farCorner) / farCorner.w;
+
+        float depthRange = farPoint.z - nearPoint.z;
+        corners[i] = nearPoint + (farPoint - nearPoint) * ((-nearDepth - nearPoint.z) / depthRange);
+        corners[i + 4] = nearPoint + (farPoint - nearPoint) * ((-farDepth - nearPoint.z) / depthRange);
+    }
+
+    // Sphere around the slice, computed in view space, so its radius doesn't change when the camera moves or rotates
+    glm::vec3 center(0.0f);
+    for (const glm::vec3& corner : corners)
+    {
+        center += corner;
+    }
+    center /= static_cast<float>(corners.size());
+
+    float radius = 0.0f;
+    for (const glm::vec3& corner : corners)
+    {
+        radius = std::max(radius, glm::distance(corner, center));
+    }
+    radius = std::ceil(radius * 16.0f) / 16.0f;
+
+    // Snap the center in light space to a grid that is a multiple of the texel size
+    float halfSize = radius * (1.0f + CascadeSnapFraction);
+    float texelSize = 2.0f * halfSize / m_resolution;
+    float snapSize = std::ceil(radius * CascadeSnapFraction / texelSize) * texelSize;
+
+    glm::vec3 worldCenter = glm::vec3(glm::inverse(camera.GetViewMatrix()) * glm::vec4(center, 1.0f));
+    glm::vec3 lightCenter = glm::vec3(m_lightViewMatrix * glm::vec4(worldCenter, 1.0f));
+    lightCenter = glm::round(lightCenter / snapSize) * snapSize;
+
+    // Depth is snapped too, so the projection and the cached contents stay the same while the camera moves.
+    // The depth range grows by the snap size, to cover the slice wherever it is inside the snapped cell
+    float halfDepth = radius + snapSize;
+
+    // The side toward the light is extended later, to include the casters
+    cascade.boundsMin = glm::vec3(lightCenter.x - halfSize, lightCenter.y - halfSize, lightCenter.z - halfDepth);
+    cascade.boundsMax = glm::vec3(lightCenter.x + halfSize, lightCenter.y + halfSize, lightCenter.z + halfDepth);
+}
+
+size_t ShadowMapRenderPass::CullCasters(Cascade& cascade) const
+{
+    const Renderer& renderer = GetRenderer();
+    std::span<const Renderer::ShadowCaster> casters = renderer.GetShadowCasters();
+
+    // The projection is a box in light view space, so the casters only need to overlap in X and Y, and not be behind it
+    cascade.casters.clear();
+    for (unsigned int casterIndex = 0; casterIndex < casters.size(); ++casterIndex)
+    {
+        const AabbBounds& bounds = m_casterLightBounds[casterIndex];
+        glm::vec3 boundsMin = bounds.GetMin();
+        glm::vec3 boundsMax = bounds.GetMax();
+        if (boundsMax.x < cascade.boundsMin.x || boundsMin.x > cascade.boundsMax.x ||
+            boundsMax.y < cascade.boundsMin.y || boundsMin.y > cascade.boundsMax.y ||
+            boundsMax.z < cascade.boundsMin.z)
+        {
+            continue;
+        }
+        cascade.casters.push_back(casterIndex);
+        cascade.boundsMax.z = std::max(cascade.boundsMax.z, boundsMax.z);
+    }
+
+    // Light view looks along -Z, so the near and far distances are the negated Z bounds
+    glm::mat4 projMatrix = glm::ortho(cascade.boundsMin.x, cascade.boundsMax.x, cascade.boundsMin.y, cascade.boundsMax.y,
+        -cascade.boundsMax.z, -cascade.boundsMin.z);
+    cascade.viewProjMatrix = projMatrix * m_lightViewMatrix;
+
+    // From clip space to texture coordinates and depth in [0, 1]
+    cascade.shadowMatrix = glm::translate(glm::vec3(0.5f)) * glm::scale(glm::vec3(0.5f)) * cascade.viewProjMatrix;
+
+    size_t hash = 0;
+    HashCombine(hash, cascade.viewProjMatrix);
+    for (unsigned int casterIndex : cascade.casters)
+    {
+        const Renderer::ShadowCaster& caster = casters[casterIndex];
+        HashCombine(hash, std::hash<const Model*>()(caster.model));
+        HashCombine(hash, renderer.GetWorldMatrix(caster.worldMatrixIndex));
+    }
+    return hash;
+}
+
+void ShadowMapRenderPass::DrawCascade(const Cascade& cascade, unsigned int cascadeIndex)
+{
+    const Renderer& renderer = GetRenderer();
+    DeviceGL& device = GetRenderer().GetDevice();
+    std::span<const Renderer::ShadowCaster> casters = renderer.GetShadowCasters();
+
+    m_framebuffers[cascadeIndex]->Bind();
+
+    // Depth mask needs to be enabled to clear the depth buffer
+    device.SetDepthMask(true);
+    device.Clear(false, Color(), true, 1.0f);
+
+    // Only the transform changes between the casters, the material is set once
+    m_depthMaterial->Use();
+    const ShaderProgram& shaderProgram = *m_depthMaterial->GetShaderProgram();
+
+    for (unsigned int casterIndex : cascade.casters)
+    {
+        const Renderer::ShadowCaster& caster = casters[casterIndex];
+        shaderProgram.SetUniform(m_worldViewProjMatrixLocation, cascade.viewProjMatrix * renderer.GetWorldMatrix(caster.worldMatrixIndex));
+
+        const Mesh& mesh = caster.model->GetMesh();
+        for (unsigned int submeshIndex = 0; submeshIndex < mesh.GetSubmeshCount(); ++submeshIndex)
+        {
+            if (!caster.model->GetMaterial(submeshIndex).HasCapabilities(Material::ShadowCaster))
+            {
+                continue;
+            }
+            mesh.GetSubmeshVertexArray(submeshIndex).Bind();
+            mesh.GetSubmeshDrawcall(submeshIndex).Draw();
+        }
+    }
+
+    m_drawnCascadeCount++;
+    m_drawnCasterCount += static_cast<unsigned int>(cascade.casters.size());
+}
+
+ShadowMapRenderPass::Locations ShadowMapRenderPass::GetLocations(const ShaderProgram& shaderProgram)
+{
+    Locations locations;
+    locations.shadowMap = shaderProgram.GetUniformLocation(ShadowMapName);
+    locations.shadowMatrices = shaderProgram.GetUniformLocation(ShadowMatricesName);
+    locations.cascadeCount = shaderProgram.GetUniformLocation(CascadeCountName);
+    return locations;
+}
+
+void ShadowMapRenderPass::Use(const ShaderProgram& shaderProgram, const Locations& locations, int textureUnit) const
+{
+    assert(locations.IsValid());
+
+    std::array<glm::mat4, MaxCascadeCount> shadowMatrices;
+    for (unsigned int cascadeIndex = 0; cascadeIndex < m_cascadeCount; ++cascadeIndex)
+    {
+        shadowMatrices[cascadeIndex] = m_cascades[cascadeIndex].shadowMatrix;
+    }
+
+    shaderProgram.SetTexture(locations.shadowMap, textureUnit, *m_shadowMap);
+    shaderProgram.SetUniforms(locations.shadowMatrices, std::span<const glm::mat4>(shadowMatrices.data(), m_cascadeCount));
+    shaderProgram.SetUniform(locations.cascadeCount, m_hasLight ? static_cast<int>(m_cascadeCount) : 0);
+}
+
+void ShadowMapRenderPass::InitializeTextures()
+{
+    // Depth comparison in the sampler, with linear filtering to blend 4 comparisons
+    m_shadowMap = std::make_shared<Texture2DArrayObject>();
+    m_shadowMap->Bind();
+    m_shadowMap->SetImage(0, m_resolution, m_resolution, m_cascadeCount, TextureObject::FormatDepth, TextureObject::InternalFormatDepth32F);
+    m_shadowMap->SetParameter(TextureObject::ParameterEnum::MinFilter, GL_LINEAR);
+    m_shadowMap->SetParameter(TextureObject::ParameterEnum::MagFilter, GL_LINEAR);
+    m_shadowMap->SetParameter(TextureObject::ParameterEnum::WrapS, GL_CLAMP_TO_EDGE);
+    m_shadowMap->SetParameter(TextureObject::ParameterEnum::WrapT, GL_CLAMP_TO_EDGE);
+    m_shadowMap->SetParameter(TextureObject::ParameterEnum::CompareMode, GL_COMPARE_REF_TO_TEXTURE);
+    m_shadowMap->SetParameter(TextureObject::ParameterEnum::CompareFunction, GL_LEQUAL);
+    Texture2DArrayObject::Unbind();
+
+    // Only depth, no color buffers
+    for (unsigned int cascadeIndex = 0; cascadeIndex < m_cascadeCount; ++cascadeIndex)
+    {
+        std::shared_ptr<FramebufferObject> framebuffer = std::make_shared<FramebufferObject>();
+        framebuffer->Bind();
+        framebuffer->SetTextureLayer(FramebufferObject::Target::Draw, FramebufferObject::Attachment::Depth, *m_shadowMap, cascadeIndex);
+        framebuffer->SetDrawBuffers(std::span<const FramebufferObject::Attachment>());
+        m_framebuffers.push_back(framebuffer);
+    }
+    FramebufferObject::Unbind();
+}
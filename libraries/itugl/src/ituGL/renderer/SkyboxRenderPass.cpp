@@ -45,11 +45,12 @@ void SkyboxRenderPass::Render()
     m_shaderProgram.SetTexture(m_skyboxTextureLocation, 0, *m_texture);
 
     // Only write to depth == 1
-    glDepthFunc(GL_EQUAL);
+    DeviceGL& device = renderer.GetDevice();
+    device.SetDepthFunction(GL_EQUAL);
 
     const Mesh& fullscreenMesh = renderer.GetFullscreenMesh();
     fullscreenMesh.DrawSubmesh(0);
     
     // Restore default value
-    glDepthFunc(GL_LESS);
+    device.SetDepthFunction(GL_LESS);
 }
@@ -1,5 +1,7 @@
 #include <ituGL/scene/Bounds.h>
 
+#include <glm/glm.hpp>
+
 SphereBounds::SphereBounds(const Bounds& bounds) : Bounds(bounds.GetCenter()), m_radius(0.0f)
 {
     switch (bounds.GetType())
@@ -8,10 +10,10 @@ SphereBounds::SphereBounds(const Bounds& bounds) : Bounds(bounds.GetCenter()), m
         m_radius = static_cast<const SphereBounds&>(bounds).GetRadius();
         break;
     case Type::AABB:
-        m_radius = static_cast<const AabbBounds&>(bounds).GetSize().length();
+        m_radius = glm::length(static_cast<const AabbBounds&>(bounds).GetSize());
         break;
     case Type::Box:
-        m_radius = static_cast<const BoxBounds&>(bounds).GetSize().length();
+        m_radius = glm::length(static_cast<const BoxBounds&>(bounds).GetSize());
         break;
     default:
         assert(false);
@@ -30,10 +32,9 @@ AabbBounds::AabbBounds(const Bounds& bounds) : Bounds(bounds.GetCenter()), m_siz
         break;
     case Type::Box:
         {
+            // Each axis of the box adds its projection to the extents
             glm::mat3 scaledMatrix = static_cast<const BoxBounds&>(bounds).GetScaledMatrix();
-            m_size = glm::abs(scaledMatrix[0]);
-            m_size = glm::max(m_size, glm::abs(scaledMatrix[1]));
-            m_size = glm::max(m_size, glm::abs(scaledMatrix[2]));
+            m_size = glm::abs(scaledMatrix[0]) + glm::abs(scaledMatrix[1]) + glm::abs(scaledMatrix[2]);
         }
         break;
     default:
@@ -61,6 +62,39 @@ BoxBounds::BoxBounds(const Bounds& bounds) : RotatedBounds(bounds.GetCenter(), g
     }
 }
 
+FrustumBounds::FrustumBounds(const glm::mat4& viewProjMatrix) : Bounds(glm::vec3(0.0f))
+{
+    SetViewProjectionMatrix(viewProjMatrix);
+}
+
+void FrustumBounds::SetViewProjectionMatrix(const glm::mat4& viewProjMatrix)
+{
+    // Planes are the sum or difference of the 4th row with the other rows (Gribb and Hartmann)
+    glm::mat4 transposed = glm::transpose(viewProjMatrix);
+    m_planes[Left] = transposed[3] + transposed[0];
+    m_planes[Right] = transposed[3] - transposed[0];
+    m_planes[Bottom] = transposed[3] + transposed[1];
+    m_planes[Top] = transposed[3] - transposed[1];
+    m_planes[Near] = transposed[3] + transposed[2];
+    m_planes[Far] = transposed[3] - transposed[2];
+
+    // Normalize, so distances to the planes are in world units
+    for (glm::vec4& plane : m_planes)
+    {
+        plane /= glm::length(glm::vec3(plane));
+    }
+
+    // Center and corners of the frustum are the ones of the clip space volume
+    glm::mat4 inverseViewProjMatrix = glm::inverse(viewProjMatrix);
+    glm::vec4 center = inverseViewProjMatrix * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    m_center = glm::vec3(center) / center.w;
+    for (int i = 0; i < 8; ++i)
+    {
+        glm::vec4 corner = inverseViewProjMatrix * glm::vec4(i & 1 ? 1.0f : -1.0f, i & 2 ? 1.0f : -1.0f, i & 4 ? 1.0f : -1.0f, 1.0f);
+        m_corners[i] = glm::vec3(corner) / corner.w;
+    }
+}
+
 template<>
 bool Bounds::Intersects(const SphereBounds& boundsA, const SphereBounds& boundsB)
 {
@@ -100,6 +134,7 @@ bool Bounds::Intersects(const BoxBounds& boundsA, const AabbBounds& boundsB)
     return Bounds::Intersects(boundsA, BoxBounds(boundsB.GetCenter(), glm::mat3(1.0f), boundsB.GetSize()));
 }
 
+// True if the projections of the boxes on the axis overlap, so the axis doesn't separate them
 bool TestSeparationAxis(const glm::vec3& axis, const glm::vec3& distance, const glm::mat3& mA, const glm::mat3& mB)
 {
     float projDistance = std::abs(glm::dot(distance, axis));
@@ -109,7 +144,7 @@ bool TestSeparationAxis(const glm::vec3& axis, const glm::vec3& distance, const
         projSize += std::abs(glm::dot(mA[i], axis));
         projSize += std::abs(glm::dot(mB[i], axis));
     }
-    return projSize <= projDistance;
+    return projDistance <= projSize;
 }
 
 template<>
@@ -117,7 +152,7 @@ bool Bounds::Intersects(const BoxBounds& boundsA, const BoxBounds& boundsB)
 {
     glm::vec3 distance = boundsB.GetCenter() - boundsA.GetCenter();
     glm::mat3 mA = boundsA.GetScaledMatrix();
-    glm::mat3 mB = boundsA.GetScaledMatrix();
+    glm::mat3 mB = boundsB.GetScaledMatrix();
     return TestSeparationAxis(boundsA.GetXVector(), distance, mA, mB)
         && TestSeparationAxis(boundsA.GetYVector(), distance, mA, mB)
         && TestSeparationAxis(boundsA.GetZVector(), distance, mA, mB)
@@ -135,24 +170,86 @@ bool Bounds::Intersects(const BoxBounds& boundsA, const BoxBounds& boundsB)
         && TestSeparationAxis(glm::cross(boundsA.GetZVector(), boundsB.GetZVector()), distance, mA, mB);
 }
 
+// The bounds are outside if they are completely behind any of the planes
+// Conservative: bounds close to the corners can pass even if they are outside
 template<>
 bool Bounds::Intersects(const FrustumBounds& boundsA, const SphereBounds& boundsB)
 {
+    glm::vec4 center(boundsB.GetCenter(), 1.0f);
+    for (const glm::vec4& plane : boundsA.GetPlanes())
+    {
+        if (glm::dot(plane, center) < -boundsB.GetRadius())
+        {
+            return false;
+        }
+    }
     return true;
 }
 
 template<>
 bool Bounds::Intersects(const FrustumBounds& boundsA, const AabbBounds& boundsB)
 {
+    glm::vec4 center(boundsB.GetCenter(), 1.0f);
+    for (const glm::vec4& plane : boundsA.GetPlanes())
+    {
+        // Projected radius of the box on the plane normal
+        float radius = glm::dot(glm::abs(glm::vec3(plane)), boundsB.GetSize());
+        if (glm::dot(plane, center) < -radius)
+        {
+            return false;
+        }
+    }
     return true;
 }
 
 template<>
 bool Bounds::Intersects(const FrustumBounds& boundsA, const BoxBounds& boundsB)
 {
+    glm::vec4 center(boundsB.GetCenter(), 1.0f);
+    glm::mat3 scaledMatrix = boundsB.GetScaledMatrix();
+    for (const glm::vec4& plane : boundsA.GetPlanes())
+    {
+        // Projected radius of the box on the plane normal, adding each rotated axis
+        glm::vec3 normal(plane);
+        float radius = std::abs(glm::dot(normal, scaledMatrix[0])) + std::abs(glm::dot(normal, scaledMatrix[1])) + std::abs(glm::dot(normal, scaledMatrix[2]));
+        if (glm::dot(plane, center) < -radius)
+        {
+            return false;
+        }
+    }
     return true;
 }
 
+// True if all the corners of the frustum are behind one of the planes
+static bool IsBehindAnyPlane(const std::array<glm::vec3, 8>& corners, const std::array<glm::vec4, FrustumBounds::PlaneCount>& planes)
+{
+    for (const glm::vec4& plane : planes)
+    {
+        bool allBehind = true;
+        for (const glm::vec3& corner : corners)
+        {
+            if (glm::dot(plane, glm::vec4(corner, 1.0f)) >= 0.0f)
+            {
+                allBehind = false;
+                break;
+            }
+        }
+        if (allBehind)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Planes of each frustum against the corners of the other one. Conservative, like the other frustum tests
+template<>
+bool Bounds::Intersects(const FrustumBounds& boundsA, const FrustumBounds& boundsB)
+{
+    return !IsBehindAnyPlane(boundsB.GetCorners(), boundsA.GetPlanes())
+        && !IsBehindAnyPlane(boundsA.GetCorners(), boundsB.GetPlanes());
+}
+
 bool Bounds::Intersects(const Bounds& boundsA, const Bounds& boundsB)
 {
     switch (boundsA.GetType())
@@ -163,6 +260,8 @@ bool Bounds::Intersects(const Bounds& boundsA, const Bounds& boundsB)
         return Bounds::Intersects(static_cast<const AabbBounds&>(boundsA), boundsB);
     case Type::Box:
         return Bounds::Intersects(static_cast<const BoxBounds&>(boundsA), boundsB);
+    case Type::Frustum:
+        return Bounds::Intersects(static_cast<const FrustumBounds&>(boundsA), boundsB);
     default:
         assert(false);
         return false;
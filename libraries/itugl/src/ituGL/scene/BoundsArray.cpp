@@ -0,0 +1,238 @@
+#include <ituGL/scene/BoundsArray.h>
+
+#include <cstring>
+#include <cassert>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BOUNDS_ARRAY_SSE
+#include <emmintrin.h>
+#endif
+#if defined(__AVX__)
+#define BOUNDS_ARRAY_AVX
+#include <immintrin.h>
+#endif
+
+BoundsArray::BoundsArray() : m_size(0)
+{
+}
+
+void BoundsArray::Reserve(unsigned int capacity)
+{
+    unsigned int paddedCapacity = (capacity + BatchSize - 1) / BatchSize * BatchSize;
+    for (std::vector<float>* values : { &m_centersX, &m_centersY, &m_centersZ, &m_radii, &m_extentsX, &m_extentsY, &m_extentsZ })
+    {
+        values->reserve(paddedCapacity);
+    }
+}
+
+void BoundsArray::Clear()
+{
+    Resize(0);
+}
+
+unsigned int BoundsArray::Add(const SphereBounds& bounds)
+{
+    unsigned int index = m_size;
+    Resize(m_size + 1);
+    Set(index, bounds);
+    return index;
+}
+
+unsigned int BoundsArray::Add(const AabbBounds& bounds)
+{
+    unsigned int index = m_size;
+    Resize(m_size + 1);
+    Set(index, bounds);
+    return index;
+}
+
+void BoundsArray::Set(unsigned int index, const SphereBounds& bounds)
+{
+    Set(index, bounds.GetCenter(), bounds.GetRadius(), glm::vec3(0.0f));
+}
+
+void BoundsArray::Set(unsigned int index, const AabbBounds& bounds)
+{
+    Set(index, bounds.GetCenter(), 0.0f, bounds.GetSize());
+}
+
+void BoundsArray::Set(unsigned int index, const glm::vec3& center, float radius, const glm::vec3& extents)
+{
+    assert(index < m_size);
+    m_centersX[index] = center.x;
+    m_centersY[index] = center.y;
+    m_centersZ[index] = center.z;
+    m_radii[index] = radius;
+    m_extentsX[index] = extents.x;
+    m_extentsY[index] = extents.y;
+    m_extentsZ[index] = extents.z;
+}
+
+bool BoundsArray::IsSphere(unsigned int index) const
+{
+    assert(index < m_size);
+    return m_extentsX[index] == 0.0f && m_extentsY[index] == 0.0f && m_extentsZ[index] == 0.0f;
+}
+
+void BoundsArray::Resize(unsigned int size)
+{
+    // Padding elements are zero, they are tested but their bits are never written
+    unsigned int paddedSize = (size + BatchSize - 1) / BatchSize * BatchSize;
+    for (std::vector<float>* values : { &m_centersX, &m_centersY, &m_centersZ, &m_radii, &m_extentsX, &m_extentsY, &m_extentsZ })
+    {
+        values->resize(paddedSize, 0.0f);
+    }
+    m_size = size;
+}
+
+void BoundsArray::TestFrustum(const FrustumBounds& frustum, std::span<std::uint8_t> visibilityMask) const
+{
+    assert(visibilityMask.size() >= GetVisibilityMaskSize());
+#if defined(BOUNDS_ARRAY_AVX)
+    TestFrustumAVX(frustum, visibilityMask);
+#elif defined(BOUNDS_ARRAY_SSE)
+    TestFrustumSSE(frustum, visibilityMask);
+#else
+    TestFrustumScalar(frustum, 0, visibilityMask);
+#endif
+}
+
+void BoundsArray::TestFrustumReference(const FrustumBounds& frustum, std::span<std::uint8_t> visibilityMask) const
+{
+    assert(visibilityMask.size() >= GetVisibilityMaskSize());
+    std::memset(visibilityMask.data(), 0, GetVisibilityMaskSize());
+    for (unsigned int i = 0; i < m_size; ++i)
+    {
+        glm::vec3 center(m_centersX[i], m_centersY[i], m_centersZ[i]);
+        bool visible = IsSphere(i)
+            ? Bounds::Intersects(frustum, SphereBounds(center, m_radii[i]))
+            : Bounds::Intersects(frustum, AabbBounds(center, glm::vec3(m_extentsX[i], m_extentsY[i], m_extentsZ[i])));
+        if (visible)
+        {
+            visibilityMask[i / 8] |= 1 << (i % 8);
+        }
+    }
+}
+
+// Same formula as the SIMD versions, for the elements after begin
+void BoundsArray::TestFrustumScalar(const FrustumBounds& frustum, unsigned int begin, std::span<std::uint8_t> visibilityMask) const
+{
+    for (unsigned int i = begin; i < m_size; ++i)
+    {
+        bool visible = true;
+        for (const glm::vec4& plane : frustum.GetPlanes())
+        {
+            float distance = plane.x * m_centersX[i] + plane.y * m_centersY[i] + plane.z * m_centersZ[i] + plane.w;
+            float radius = m_radii[i] + std::abs(plane.x) * m_extentsX[i] + std::abs(plane.y) * m_extentsY[i] + std::abs(plane.z) * m_extentsZ[i];
+            visible &= distance + radius >= 0.0f;
+        }
+
+        std::uint8_t bit = static_cast<std::uint8_t>(1 << (i % 8));
+        visibilityMask[i / 8] = visible ? (visibilityMask[i / 8] | bit) : (visibilityMask[i / 8] & ~bit);
+    }
+
+    // Clear the bits after the last element, the caller's buffer may have anything there
+    if (m_size % 8 != 0)
+    {
+        visibilityMask[m_size / 8] &= static_cast<std::uint8_t>((1 << (m_size % 8)) - 1);
+    }
+}
+
+#if defined(BOUNDS_ARRAY_SSE)
+void BoundsArray::TestFrustumSSE(const FrustumBounds& frustum, std::span<std::uint8_t> visibilityMask) const
+{
+    // Broadcast the planes and their absolute normals once
+    const std::array<glm::vec4, FrustumBounds::PlaneCount>& planes = frustum.GetPlanes();
+    __m128 planeX[FrustumBounds::PlaneCount], planeY[FrustumBounds::PlaneCount], planeZ[FrustumBounds::PlaneCount], planeW[FrustumBounds::PlaneCount];
+    __m128 absPlaneX[FrustumBounds::PlaneCount], absPlaneY[FrustumBounds::PlaneCount], absPlaneZ[FrustumBounds::PlaneCount];
+    for (int p = 0; p < FrustumBounds::PlaneCount; ++p)
+    {
+        planeX[p] = _mm_set1_ps(planes[p].x);
+        planeY[p] = _mm_set1_ps(planes[p].y);
+        planeZ[p] = _mm_set1_ps(planes[p].z);
+        planeW[p] = _mm_set1_ps(planes[p].w);
+        absPlaneX[p] = _mm_set1_ps(std::abs(planes[p].x));
+        absPlaneY[p] = _mm_set1_ps(std::abs(planes[p].y));
+        absPlaneZ[p] = _mm_set1_ps(std::abs(planes[p].z));
+    }
+    const __m128 zero = _mm_setzero_ps();
+
+    // 2 groups of 4 elements fill 1 byte of the mask
+    unsigned int fullBatches = m_size / BatchSize;
+    for (unsigned int batch = 0; batch < fullBatches; ++batch)
+    {
+        int bits = 0;
+        for (unsigned int group = 0; group < 2; ++group)
+        {
+            unsigned int i = batch * BatchSize + group * 4;
+            __m128 centerX = _mm_loadu_ps(&m_centersX[i]);
+            __m128 centerY = _mm_loadu_ps(&m_centersY[i]);
+            __m128 centerZ = _mm_loadu_ps(&m_centersZ[i]);
+            __m128 radius = _mm_loadu_ps(&m_radii[i]);
+            __m128 extentsX = _mm_loadu_ps(&m_extentsX[i]);
+            __m128 extentsY = _mm_loadu_ps(&m_extentsY[i]);
+            __m128 extentsZ = _mm_loadu_ps(&m_extentsZ[i]);
+
+            __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (int p = 0; p < FrustumBounds::PlaneCount; ++p)
+            {
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], centerX), _mm_mul_ps(planeY[p], centerY)), _mm_add_ps(_mm_mul_ps(planeZ[p], centerZ), planeW[p]));
+                __m128 projectedRadius = _mm_add_ps(_mm_add_ps(radius, _mm_mul_ps(absPlaneX[p], extentsX)), _mm_add_ps(_mm_mul_ps(absPlaneY[p], extentsY), _mm_mul_ps(absPlaneZ[p], extentsZ)));
+                visible = _mm_and_ps(visible, _mm_cmpge_ps(_mm_add_ps(distance, projectedRadius), zero));
+            }
+            bits |= _mm_movemask_ps(visible) << (group * 4);
+        }
+        visibilityMask[batch] = static_cast<std::uint8_t>(bits);
+    }
+
+    // Last elements, that don't fill a byte
+    TestFrustumScalar(frustum, fullBatches * BatchSize, visibilityMask);
+}
+#endif
+
+#if defined(BOUNDS_ARRAY_AVX)
+void BoundsArray::TestFrustumAVX(const FrustumBounds& frustum, std::span<std::uint8_t> visibilityMask) const
+{
+    // Broadcast the planes and their absolute normals once
+    const std::array<glm::vec4, FrustumBounds::PlaneCount>& planes = frustum.GetPlanes();
+    __m256 planeX[FrustumBounds::PlaneCount], planeY[FrustumBounds::PlaneCount], planeZ[FrustumBounds::PlaneCount], planeW[FrustumBounds::PlaneCount];
+    __m256 absPlaneX[FrustumBounds::PlaneCount], absPlaneY[FrustumBounds::PlaneCount], absPlaneZ[FrustumBounds::PlaneCount];
+    for (int p = 0; p < FrustumBounds::PlaneCount; ++p)
+    {
+        planeX[p] = _mm256_set1_ps(planes[p].x);
+        planeY[p] = _mm256_set1_ps(planes[p].y);
+        planeZ[p] = _mm256_set1_ps(planes[p].z);
+        planeW[p] = _mm256_set1_ps(planes[p].w);
+        absPlaneX[p] = _mm256_set1_ps(std::abs(planes[p].x));
+        absPlaneY[p] = _mm256_set1_ps(std::abs(planes[p].y));
+        absPlaneZ[p] = _mm256_set1_ps(std::abs(planes[p].z));
+    }
+    const __m256 zero = _mm256_setzero_ps();
+
+    // 8 elements fill 1 byte of the mask
+    unsigned int fullBatches = m_size / BatchSize;
+    for (unsigned int batch = 0; batch < fullBatches; ++batch)
+    {
+        unsigned int i = batch * BatchSize;
+        __m256 centerX = _mm256_loadu_ps(&m_centersX[i]);
+        __m256 centerY = _mm256_loadu_ps(&m_centersY[i]);
+        __m256 centerZ = _mm256_loadu_ps(&m_centersZ[i]);
+        __m256 radius = _mm256_loadu_ps(&m_radii[i]);
+        __m256 extentsX = _mm256_loadu_ps(&m_extentsX[i]);
+        __m256 extentsY = _mm256_loadu_ps(&m_extentsY[i]);
+        __m256 extentsZ = _mm256_loadu_ps(&m_extentsZ[i]);
+
+        __m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < FrustumBounds::PlaneCount; ++p)
+        {
+            __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(planeX[p], centerX), _mm256_mul_ps(planeY[p], centerY)), _mm256_add_ps(_mm256_mul_ps(planeZ[p], centerZ), planeW[p]));
+            __m256 projectedRadius = _mm256_add_ps(_mm256_add_ps(radius, _mm256_mul_ps(absPlaneX[p], extentsX)), _mm256_add_ps(_mm256_mul_ps(absPlaneY[p], extentsY), _mm256_mul_ps(absPlaneZ[p], extentsZ)));
+            visible = _mm256_and_ps(visible, _mm256_cmp_ps(_mm256_add_ps(distance, projectedRadius), zero, _CMP_GE_OQ));
+        }
+        visibilityMask[batch] = static_cast<std::uint8_t>(_mm256_movemask_ps(visible));
+    }
+
+    // Last elements, that don't fill a byte
+    TestFrustumScalar(frustum, fullBatches * BatchSize, visibilityMask);
+}
+#endif
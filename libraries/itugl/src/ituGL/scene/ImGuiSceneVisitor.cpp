@@ -1,6 +1,7 @@
 #include <ituGL/scene/ImGuiSceneVisitor.h>
 
 #include <ituGL/utils/DearImGui.h>
+#include <ituGL/scene/Scene.h>
 #include <ituGL/scene/SceneCamera.h>
 #include <ituGL/scene/SceneLight.h>
 #include <ituGL/scene/SceneModel.h>
@@ -12,6 +13,13 @@ ImGuiSceneVisitor::ImGuiSceneVisitor(DearImGui& imGui, const char* windowName) :
 {
 }
 
+void ImGuiSceneVisitor::VisitScene(Scene& scene)
+{
+    scene.ForEach<SceneCamera>([this](SceneCamera& sceneCamera) { VisitCamera(sceneCamera); });
+    scene.ForEach<SceneLight>([this](SceneLight& sceneLight) { VisitLight(sceneLight); });
+    scene.ForEach<SceneModel>([this](SceneModel& sceneModel) { VisitModel(sceneModel); });
+}
+
 void ImGuiSceneVisitor::VisitCamera(SceneCamera& sceneCamera)
 {
     if (auto window = m_imGui.UseWindow(m_windowName.c_str()))
@@ -0,0 +1,149 @@
+#include <ituGL/scene/RendererSceneProxies.h>
+
+#include <ituGL/scene/Scene.h>
+#include <ituGL/scene/SceneNode.h>
+#include <ituGL/scene/SceneModel.h>
+#include <ituGL/scene/SceneCamera.h>
+#include <ituGL/scene/SceneLight.h>
+#include <ituGL/scene/Transform.h>
+#include <ituGL/scene/RendererSceneVisitor.h>
+#include <ituGL/geometry/Model.h>
+#include <unordered_map>
+#include <cassert>
+
+RendererSceneProxies::RendererSceneProxies(Renderer& renderer, Scene& scene)
+    : m_renderer(renderer)
+    , m_scene(scene)
+    , m_nodesVersion(0)
+    , m_nodesCollected(false)
+{
+}
+
+RendererSceneProxies::~RendererSceneProxies()
+{
+    Clear();
+}
+
+void RendererSceneProxies::Update()
+{
+    m_stats = Stats();
+
+    if (!m_nodesCollected || m_nodesVersion != m_scene.GetNodesVersion())
+    {
+        CollectNodes();
+    }
+
+    // Most of the proxies don't change, checking the versions is all they cost
+    for (Proxy& proxy : m_proxies)
+    {
+        const SceneModel& sceneModel = *proxy.sceneModel;
+        if (sceneModel.GetModel() != proxy.model)
+        {
+            RemoveProxy(proxy);
+            AddProxy(proxy);
+            continue;
+        }
+
+        const Transform* transform = sceneModel.GetTransform().get();
+        assert(transform);
+        if (proxy.proxyId != Renderer::InvalidProxyId && (transform != proxy.transform || transform->GetVersion() != proxy.version))
+        {
+            m_renderer.UpdateModelProxy(proxy.proxyId, transform->GetTransformMatrix());
+            proxy.transform = transform;
+            proxy.version = transform->GetVersion();
+            m_stats.updated++;
+        }
+    }
+
+    // Casters are not retained by the renderer
+    if (m_renderer.GetShadowCastersEnabled())
+    {
+        for (const Proxy& proxy : m_proxies)
+        {
+            if (proxy.model)
+            {
+                const SceneModel& sceneModel = *proxy.sceneModel;
+                m_renderer.AddShadowCaster(*proxy.model, sceneModel.GetTransform()->GetTransformMatrix(), sceneModel.GetAabbBounds());
+            }
+        }
+    }
+
+    // Only the cameras and the lights, the models are in the proxies
+    RendererSceneVisitor rendererSceneVisitor(m_renderer);
+    m_scene.ForEach<SceneCamera>([&](SceneCamera& sceneCamera) { rendererSceneVisitor.VisitCamera(sceneCamera); });
+    m_scene.ForEach<SceneLight>([&](SceneLight& sceneLight) { rendererSceneVisitor.VisitLight(sceneLight); });
+
+    m_stats.proxies = static_cast<unsigned int>(m_proxies.size());
+}
+
+void RendererSceneProxies::Clear()
+{
+    for (Proxy& proxy : m_proxies)
+    {
+        RemoveProxy(proxy);
+    }
+    m_proxies.clear();
+    m_nodesCollected = false;
+}
+
+void RendererSceneProxies::CollectNodes()
+{
+    std::unordered_map<const SceneModel*, Proxy> oldProxies;
+    for (Proxy& proxy : m_proxies)
+    {
+        oldProxies.emplace(proxy.sceneModel, std::move(proxy));
+    }
+
+    // Models that were already in the scene keep their proxy, new ones get it in Update
+    m_proxies.clear();
+    for (SceneModel* sceneModel : m_scene.GetModels())
+    {
+        auto itFind = oldProxies.find(sceneModel);
+        if (itFind != oldProxies.end())
+        {
+            m_proxies.push_back(std::move(itFind->second));
+            oldProxies.erase(itFind);
+        }
+        else
+        {
+            m_proxies.push_back(Proxy{ sceneModel, nullptr, nullptr, 0, Renderer::InvalidProxyId });
+        }
+    }
+
+    // Removed from the scene. The nodes may be gone, only the proxy data is used
+    for (auto& pair : oldProxies)
+    {
+        RemoveProxy(pair.second);
+    }
+
+    m_nodesVersion = m_scene.GetNodesVersion();
+    m_nodesCollected = true;
+}
+
+void RendererSceneProxies::AddProxy(Proxy& proxy)
+{
+    const SceneModel& sceneModel = *proxy.sceneModel;
+    proxy.model = sceneModel.GetModel();
+    if (!proxy.model)
+    {
+        return;
+    }
+
+    const Transform* transform = sceneModel.GetTransform().get();
+    assert(transform);
+    proxy.transform = transform;
+    proxy.version = transform->GetVersion();
+    proxy.proxyId = m_renderer.AddModelProxy(*proxy.model, transform->GetTransformMatrix());
+    m_stats.added++;
+}
+
+void RendererSceneProxies::RemoveProxy(Proxy& proxy)
+{
+    if (proxy.proxyId != Renderer::InvalidProxyId)
+    {
+        m_renderer.RemoveModelProxy(proxy.proxyId);
+        proxy.proxyId = Renderer::InvalidProxyId;
+        m_stats.removed++;
+    }
+    proxy.model = nullptr;
+}
@@ -1,6 +1,7 @@
 #include <ituGL/scene/RendererSceneVisitor.h>
 
 #include <ituGL/renderer/Renderer.h>
+#include <ituGL/scene/Scene.h>
 #include <ituGL/scene/SceneCamera.h>
 #include <ituGL/scene/SceneLight.h>
 #include <ituGL/scene/SceneModel.h>
@@ -10,10 +11,39 @@ RendererSceneVisitor::RendererSceneVisitor(Renderer& renderer) : m_renderer(rend
 {
 }
 
+RendererSceneVisitor::~RendererSceneVisitor()
+{
+    for (const SceneModel* sceneModel : m_pendingModels)
+    {
+        m_renderer.AddModel(*sceneModel->GetModel(), sceneModel->GetTransform()->GetTransformMatrix());
+    }
+}
+
+void RendererSceneVisitor::VisitScene(Scene& scene)
+{
+    scene.ForEach<SceneCamera>([this](SceneCamera& sceneCamera) { VisitCamera(sceneCamera); });
+    scene.ForEach<SceneLight>([this](SceneLight& sceneLight) { VisitLight(sceneLight); });
+    scene.ForEach<SceneModel>([this](SceneModel& sceneModel) { VisitModel(sceneModel); });
+}
+
+void RendererSceneVisitor::VisitScene(Scene& scene, const FrustumBounds& frustum)
+{
+    scene.ForEach<SceneCamera>([this](SceneCamera& sceneCamera) { VisitCamera(sceneCamera); });
+    scene.ForEach<SceneLight>([this](SceneLight& sceneLight) { VisitLight(sceneLight); });
+    scene.ForEachModel(frustum, [this](SceneModel& sceneModel) { VisitModel(sceneModel); });
+}
+
 void RendererSceneVisitor::VisitCamera(SceneCamera& sceneCamera)
 {
     assert(!m_renderer.HasCamera()); // Currently, only one camera per scene supported
     m_renderer.SetCurrentCamera(*sceneCamera.GetCamera());
+
+    // Scene order is arbitrary, now we can cull the models that came before the camera
+    for (const SceneModel* sceneModel : m_pendingModels)
+    {
+        AddModel(*sceneModel);
+    }
+    m_pendingModels.clear();
 }
 
 void RendererSceneVisitor::VisitLight(SceneLight& sceneLight)
@@ -24,5 +54,33 @@ void RendererSceneVisitor::VisitLight(SceneLight& sceneLight)
 void RendererSceneVisitor::VisitModel(SceneModel& sceneModel)
 {
     assert(sceneModel.GetTransform());
-    m_renderer.AddModel(*sceneModel.GetModel(), sceneModel.GetTransform()->GetTransformMatrix());
+
+    // Casters don't depend on the camera, models outside of the view can still cast shadows into it
+    if (m_renderer.GetShadowCastersEnabled())
+    {
+        m_renderer.AddShadowCaster(*sceneModel.GetModel(), sceneModel.GetTransform()->GetTransformMatrix(), sceneModel.GetAabbBounds());
+    }
+
+    // The GPU-driven pass culls them later, they don't need the camera
+    if (m_renderer.GetGpuCullingEnabled())
+    {
+        m_renderer.AddGpuCulledModel(*sceneModel.GetModel(), sceneModel.GetTransform()->GetTransformMatrix(), sceneModel.GetAabbBounds());
+    }
+    else if (m_renderer.HasCamera())
+    {
+        AddModel(sceneModel);
+    }
+    else
+    {
+        m_pendingModels.push_back(&sceneModel);
+    }
+}
+
+void RendererSceneVisitor::AddModel(const SceneModel& sceneModel)
+{
+    // Test the oriented box, before any drawcall is created
+    if (m_renderer.IsVisible(sceneModel.GetBoxBounds()))
+    {
+        m_renderer.AddModel(*sceneModel.GetModel(), sceneModel.GetTransform()->GetTransformMatrix());
+    }
 }
@@ -2,71 +2,290 @@
 
 #include <ituGL/scene/SceneNode.h>
 #include <ituGL/scene/SceneVisitor.h>
+#include <ituGL/scene/SceneModel.h>
+#include <ituGL/scene/SceneLight.h>
+#include <ituGL/scene/SceneCamera.h>
 #include <cassert>
 
-Scene::Scene()
+// Visitor to find the type of a node when it is added
+class SceneNodeClassifier : public SceneVisitor
+{
+public:
+    void VisitCamera(SceneCamera& sceneCamera) override { camera = &sceneCamera; }
+    void VisitLight(SceneLight& sceneLight) override { light = &sceneLight; }
+    void VisitModel(SceneModel& sceneModel) override { model = &sceneModel; }
+
+    SceneCamera* camera = nullptr;
+    SceneLight* light = nullptr;
+    SceneModel* model = nullptr;
+};
+
+Scene::Scene() : m_nodesVersion(0), m_bvhEnabled(false), m_bvhDirty(true)
 {
 }
 
 Scene::~Scene()
 {
-    for (auto& pair : m_nodes)
+    for (SceneNode* node : m_nodes)
     {
-        pair.second->SetOwnerScene(nullptr);
+        node->SetOwnerScene(nullptr);
     }
 }
 
 std::shared_ptr<SceneNode> Scene::GetSceneNode(const std::string& name) const
 {
-    auto it = m_nodes.find(name);
-    if (it != m_nodes.end())
+    return GetSceneNode(FindSceneNode(name));
+}
+
+std::shared_ptr<SceneNode> Scene::GetSceneNode(SceneNodeHandle handle) const
+{
+    const Slot* slot = GetSlot(handle);
+    return slot ? slot->node : nullptr;
+}
+
+SceneNodeHandle Scene::FindSceneNode(const std::string& name) const
+{
+    auto it = m_nameIndex.find(name);
+    return it != m_nameIndex.end() ? it->second : SceneNodeHandle();
+}
+
+bool Scene::IsValid(SceneNodeHandle handle) const
+{
+    return GetSlot(handle) != nullptr;
+}
+
+const Scene::Slot* Scene::GetSlot(SceneNodeHandle handle) const
+{
+    if (handle.index >= m_slots.size())
     {
-        return it->second;
+        return nullptr;
     }
-    return nullptr;
+    const Slot& slot = m_slots[handle.index];
+    return slot.generation == handle.generation && slot.node ? &slot : nullptr;
 }
 
-bool Scene::AddSceneNode(std::shared_ptr<SceneNode> node)
+SceneNodeHandle Scene::AddSceneNode(std::shared_ptr<SceneNode> node)
 {
     assert(node);
-    assert(m_nodes.find(node->GetName()) == m_nodes.end());
-    m_nodes[node->GetName()] = node;
-    node->SetOwnerScene(this);
-    return true;
+    assert(!node->GetOwnerScene());
+    assert(m_nameIndex.find(node->GetName()) == m_nameIndex.end());
+
+    unsigned int slotIndex;
+    if (!m_freeSlots.empty())
+    {
+        slotIndex = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+    else
+    {
+        slotIndex = static_cast<unsigned int>(m_slots.size());
+        m_slots.emplace_back();
+    }
+
+    Slot& slot = m_slots[slotIndex];
+    slot.node = node;
+    slot.nodeIndex = static_cast<unsigned int>(m_nodes.size());
+    m_nodes.push_back(node.get());
+
+    // The type doesn't change, so it is found once and the node goes to the array of its type
+    SceneNodeClassifier classifier;
+    node->AcceptVisitor(classifier);
+    if (classifier.model)
+    {
+        slot.type = NodeType::Model;
+        slot.typeIndex = static_cast<unsigned int>(m_models.size());
+        m_models.push_back(classifier.model);
+    }
+    else if (classifier.light)
+    {
+        slot.type = NodeType::Light;
+        slot.typeIndex = static_cast<unsigned int>(m_lights.size());
+        m_lights.push_back(classifier.light);
+    }
+    else if (classifier.camera)
+    {
+        slot.type = NodeType::Camera;
+        slot.typeIndex = static_cast<unsigned int>(m_cameras.size());
+        m_cameras.push_back(classifier.camera);
+    }
+    else
+    {
+        slot.type = NodeType::Other;
+        slot.typeIndex = static_cast<unsigned int>(m_otherNodes.size());
+        m_otherNodes.push_back(node.get());
+    }
+
+    SceneNodeHandle handle{ slotIndex, slot.generation };
+    m_nameIndex[node->GetName()] = handle;
+    node->SetOwnerScene(this, handle);
+
+    m_nodesVersion++;
+    m_bvhDirty = true;
+    return handle;
 }
 
 bool Scene::RemoveSceneNode(std::shared_ptr<SceneNode> node)
 {
-    assert(m_nodes.find(node->GetName()) == m_nodes.end() || m_nodes.find(node->GetName())->second == node);
-    return RemoveSceneNode(node->GetName());
+    assert(node);
+    return node->GetOwnerScene() == this && RemoveSceneNode(node->GetHandle());
 }
 
 bool Scene::RemoveSceneNode(const std::string& name)
 {
-    auto it = m_nodes.find(name);
-    if (it != m_nodes.end())
+    return RemoveSceneNode(FindSceneNode(name));
+}
+
+bool Scene::RemoveSceneNode(SceneNodeHandle handle)
+{
+    if (!GetSlot(handle))
+    {
+        return false;
+    }
+
+    Slot& slot = m_slots[handle.index];
+    assert(slot.node->GetOwnerScene() == this);
+
+    RemoveDense(m_nodes, slot.nodeIndex, &Slot::nodeIndex);
+    switch (slot.type)
     {
-        assert(it->second);
-        assert(it->second->GetOwnerScene() == this);
-        it->second->SetOwnerScene(nullptr);
-        m_nodes.erase(it);
-        return true;
+    case NodeType::Model:
+        RemoveDense(m_models, slot.typeIndex, &Slot::typeIndex);
+        break;
+    case NodeType::Light:
+        RemoveDense(m_lights, slot.typeIndex, &Slot::typeIndex);
+        break;
+    case NodeType::Camera:
+        RemoveDense(m_cameras, slot.typeIndex, &Slot::typeIndex);
+        break;
+    case NodeType::Other:
+        RemoveDense(m_otherNodes, slot.typeIndex, &Slot::typeIndex);
+        break;
     }
-    return false;
+
+    m_nameIndex.erase(slot.node->GetName());
+    slot.node->SetOwnerScene(nullptr);
+    slot.node.reset();
+    slot.generation++;
+    m_freeSlots.push_back(handle.index);
+
+    m_nodesVersion++;
+    m_bvhDirty = true;
+    return true;
+}
+
+template<typename T>
+void Scene::RemoveDense(std::vector<T*>& nodes, unsigned int index, unsigned int Slot::* slotIndex)
+{
+    T* lastNode = nodes.back();
+    nodes[index] = lastNode;
+    nodes.pop_back();
+
+    // If the last node was the removed one, there is no slot to fix
+    if (index < nodes.size())
+    {
+        m_slots[lastNode->GetHandle().index].*slotIndex = index;
+    }
+}
+
+void Scene::RenameSceneNode(const SceneNode& node, const std::string& name)
+{
+    assert(node.GetOwnerScene() == this);
+    assert(m_nameIndex.find(name) == m_nameIndex.end());
+    m_nameIndex.erase(node.GetName());
+    m_nameIndex[name] = node.GetHandle();
+}
+
+unsigned int Scene::GetNodesVersion() const
+{
+    return m_nodesVersion;
+}
+
+void Scene::CollectNodes(std::vector<SceneModel*>& sceneModels, std::vector<SceneNode*>& otherNodes)
+{
+    sceneModels.assign(m_models.begin(), m_models.end());
+
+    otherNodes.clear();
+    otherNodes.insert(otherNodes.end(), m_lights.begin(), m_lights.end());
+    otherNodes.insert(otherNodes.end(), m_cameras.begin(), m_cameras.end());
+    otherNodes.insert(otherNodes.end(), m_otherNodes.begin(), m_otherNodes.end());
 }
 
 void Scene::AcceptVisitor(SceneVisitor& visitor)
 {
-    for (auto& pair : m_nodes)
+    for (SceneNode* node : m_nodes)
     {
-        pair.second->AcceptVisitor(visitor);
+        node->AcceptVisitor(visitor);
     }
 }
 
 void Scene::AcceptVisitor(SceneVisitor& visitor) const
 {
-    for (auto& pair : m_nodes)
+    for (const SceneNode* node : m_nodes)
+    {
+        node->AcceptVisitor(visitor);
+    }
+}
+
+void Scene::AcceptVisitor(SceneVisitor& visitor, const FrustumBounds& frustum)
+{
+    if (!m_bvhEnabled)
+    {
+        AcceptVisitor(visitor);
+        return;
+    }
+
+    std::span<SceneModel* const> visibleModels = QueryBvh(frustum);
+
+    for (SceneNode* node : m_nonBvhNodes)
+    {
+        node->AcceptVisitor(visitor);
+    }
+
+    for (SceneModel* sceneModel : visibleModels)
+    {
+        sceneModel->AcceptVisitor(visitor);
+    }
+}
+
+std::span<SceneModel* const> Scene::QueryBvh(const FrustumBounds& frustum)
+{
+    UpdateBvh();
+
+    m_visibleModels.clear();
+    m_bvh.QueryFrustum(frustum, m_visibleModels);
+    return m_visibleModels;
+}
+
+bool Scene::IsBvhEnabled() const
+{
+    return m_bvhEnabled;
+}
+
+void Scene::SetBvhEnabled(bool enabled)
+{
+    m_bvhEnabled = enabled;
+    m_bvhDirty = true;
+}
+
+const SceneBvh& Scene::UpdateBvh()
+{
+    assert(m_bvhEnabled);
+    if (m_bvhDirty)
     {
-        pair.second->AcceptVisitor(visitor);
+        RebuildBvh();
     }
+    else
+    {
+        m_bvh.Update();
+    }
+    return m_bvh;
+}
+
+void Scene::RebuildBvh()
+{
+    std::vector<SceneModel*> sceneModels;
+    CollectNodes(sceneModels, m_nonBvhNodes);
+
+    m_bvh.Build(sceneModels);
+    m_bvhDirty = false;
 }
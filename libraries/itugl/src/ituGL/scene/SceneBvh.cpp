@@ -0,0 +1,289 @@
+#include <ituGL/scene/SceneBvh.h>
+
+#include <ituGL/scene/SceneModel.h>
+#include <ituGL/scene/Transform.h>
+#include <ituGL/geometry/Model.h>
+#include <glm/common.hpp>
+#include <algorithm>
+#include <utility>
+#include <limits>
+#include <cassert>
+
+SceneBvh::SceneBvh()
+{
+}
+
+void SceneBvh::Build(const std::vector<SceneModel*>& sceneModels)
+{
+    m_items.clear();
+    m_nodes.clear();
+
+    m_items.reserve(sceneModels.size());
+    for (SceneModel* sceneModel : sceneModels)
+    {
+        assert(sceneModel);
+        Item item;
+        item.sceneModel = sceneModel;
+        item.leaf = -1;
+        UpdateItemBounds(item);
+        m_items.push_back(item);
+    }
+
+    if (!m_items.empty())
+    {
+        // A binary tree with leaves of at least 1 item has less than 2N nodes
+        m_nodes.reserve(2 * m_items.size());
+        BuildNode(0, static_cast<unsigned int>(m_items.size()), -1);
+    }
+}
+
+int SceneBvh::BuildNode(unsigned int begin, unsigned int end, int parent)
+{
+    assert(begin < end);
+
+    int nodeIndex = static_cast<int>(m_nodes.size());
+    m_nodes.push_back(Node());
+    m_nodes[nodeIndex].parent = parent;
+
+    unsigned int count = end - begin;
+    if (count <= MaxLeafSize)
+    {
+        m_nodes[nodeIndex].index = static_cast<int>(begin);
+        m_nodes[nodeIndex].count = count;
+        for (unsigned int i = begin; i < end; ++i)
+        {
+            m_items[i].leaf = nodeIndex;
+        }
+    }
+    else
+    {
+        // Split at the median of the centroids, along the largest axis
+        glm::vec3 centroidMin = m_items[begin].centroid;
+        glm::vec3 centroidMax = m_items[begin].centroid;
+        for (unsigned int i = begin + 1; i < end; ++i)
+        {
+            centroidMin = glm::min(centroidMin, m_items[i].centroid);
+            centroidMax = glm::max(centroidMax, m_items[i].centroid);
+        }
+        glm::vec3 extents = centroidMax - centroidMin;
+        int axis = extents.x > extents.y ? (extents.x > extents.z ? 0 : 2) : (extents.y > extents.z ? 1 : 2);
+
+        unsigned int middle = begin + count / 2;
+        std::nth_element(m_items.begin() + begin, m_items.begin() + middle, m_items.begin() + end,
+            [axis](const Item& a, const Item& b) { return a.centroid[axis] < b.centroid[axis]; });
+
+        // First child goes right after this node, depth-first
+        BuildNode(begin, middle, nodeIndex);
+        int secondChild = BuildNode(middle, end, nodeIndex);
+        m_nodes[nodeIndex].index = secondChild;
+        m_nodes[nodeIndex].count = 0;
+    }
+
+    RefitNode(m_nodes[nodeIndex], nodeIndex);
+    return nodeIndex;
+}
+
+unsigned int SceneBvh::Update()
+{
+    if (m_nodes.empty())
+    {
+        return 0;
+    }
+
+    // Mark the leaves of the changed items and their ancestors
+    std::vector<bool> dirtyNodes(m_nodes.size(), false);
+    unsigned int updatedCount = 0;
+    for (Item& item : m_items)
+    {
+        if (!IsItemChanged(item))
+        {
+            continue;
+        }
+
+        UpdateItemBounds(item);
+        updatedCount++;
+
+        for (int nodeIndex = item.leaf; nodeIndex >= 0 && !dirtyNodes[nodeIndex]; nodeIndex = m_nodes[nodeIndex].parent)
+        {
+            dirtyNodes[nodeIndex] = true;
+        }
+    }
+
+    // Children are always after their parent, refit from the back
+    if (updatedCount > 0)
+    {
+        for (int nodeIndex = static_cast<int>(m_nodes.size()) - 1; nodeIndex >= 0; --nodeIndex)
+        {
+            if (dirtyNodes[nodeIndex])
+            {
+                RefitNode(m_nodes[nodeIndex], nodeIndex);
+            }
+        }
+    }
+
+    return updatedCount;
+}
+
+AabbBounds SceneBvh::GetBounds() const
+{
+    if (m_nodes.empty())
+    {
+        return AabbBounds(glm::vec3(0.0f), glm::vec3(0.0f));
+    }
+    const Node& root = m_nodes[0];
+    return AabbBounds(0.5f * (root.min + root.max), 0.5f * (root.max - root.min));
+}
+
+void SceneBvh::UpdateItemBounds(Item& item)
+{
+    const Transform* transform = item.sceneModel->GetTransform().get();
+    assert(transform);
+    item.transform = transform;
+    item.version = transform->GetVersion();
+
+    const Model* model = item.sceneModel->GetModel().get();
+    assert(model);
+    item.model = model;
+    item.modelVersion = model->GetBoundsVersion();
+
+    AabbBounds aabb = item.sceneModel->GetAabbBounds();
+    item.min = aabb.GetMin();
+    item.max = aabb.GetMax();
+    item.centroid = aabb.GetCenter();
+}
+
+bool SceneBvh::IsItemChanged(const Item& item)
+{
+    const Transform* transform = item.sceneModel->GetTransform().get();
+    const Model* model = item.sceneModel->GetModel().get();
+    return transform != item.transform || transform->GetVersion() != item.version
+        || model != item.model || model->GetBoundsVersion() != item.modelVersion;
+}
+
+void SceneBvh::RefitNode(Node& node, int nodeIndex)
+{
+    if (node.count > 0)
+    {
+        node.min = m_items[node.index].min;
+        node.max = m_items[node.index].max;
+        for (unsigned int i = 1; i < node.count; ++i)
+        {
+            node.min = glm::min(node.min, m_items[node.index + i].min);
+            node.max = glm::max(node.max, m_items[node.index + i].max);
+        }
+    }
+    else
+    {
+        const Node& firstChild = m_nodes[nodeIndex + 1];
+        const Node& secondChild = m_nodes[node.index];
+        node.min = glm::min(firstChild.min, secondChild.min);
+        node.max = glm::max(firstChild.max, secondChild.max);
+    }
+}
+
+template<typename T, typename F>
+void SceneBvh::Traverse(const T& isInside, F&& visit) const
+{
+    if (m_nodes.empty())
+    {
+        return;
+    }
+
+    // Balanced tree, depth is log2(N / MaxLeafSize)
+    int stack[64];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0)
+    {
+        const Node& node = m_nodes[stack[--stackSize]];
+        if (!isInside(node.min, node.max))
+        {
+            continue;
+        }
+
+        if (node.count > 0)
+        {
+            for (unsigned int i = 0; i < node.count; ++i)
+            {
+                const Item& item = m_items[node.index + i];
+                if (isInside(item.min, item.max))
+                {
+                    visit(item);
+                }
+            }
+        }
+        else
+        {
+            // Push the second child first, so the first child (next in memory) is visited next
+            assert(stackSize + 2 <= 64);
+            stack[stackSize++] = node.index;
+            stack[stackSize++] = static_cast<int>(&node - m_nodes.data()) + 1;
+        }
+    }
+}
+
+void SceneBvh::QueryFrustum(const FrustumBounds& frustum, std::vector<SceneModel*>& results) const
+{
+    Traverse([&](const glm::vec3& min, const glm::vec3& max)
+        {
+            return Bounds::Intersects(frustum, AabbBounds(0.5f * (min + max), 0.5f * (max - min)));
+        },
+        [&](const Item& item) { results.push_back(item.sceneModel); });
+}
+
+void SceneBvh::QueryOverlap(const SphereBounds& sphere, std::vector<SceneModel*>& results) const
+{
+    Traverse([&](const glm::vec3& min, const glm::vec3& max)
+        {
+            return Bounds::Intersects(AabbBounds(0.5f * (min + max), 0.5f * (max - min)), sphere);
+        },
+        [&](const Item& item) { results.push_back(item.sceneModel); });
+}
+
+void SceneBvh::QueryOverlap(const AabbBounds& aabb, std::vector<SceneModel*>& results) const
+{
+    glm::vec3 queryMin = aabb.GetMin();
+    glm::vec3 queryMax = aabb.GetMax();
+    Traverse([&](const glm::vec3& min, const glm::vec3& max)
+        {
+            return queryMin.x <= max.x && queryMin.y <= max.y && queryMin.z <= max.z
+                && min.x <= queryMax.x && min.y <= queryMax.y && min.z <= queryMax.z;
+        },
+        [&](const Item& item) { results.push_back(item.sceneModel); });
+}
+
+void SceneBvh::QueryRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, std::vector<SceneModel*>& results) const
+{
+    // Slab test, division by 0 gives infinity and works as expected
+    glm::vec3 inverseDirection = 1.0f / direction;
+    auto intersectRay = [&](const glm::vec3& min, const glm::vec3& max, float& distance)
+    {
+        glm::vec3 t0 = (min - origin) * inverseDirection;
+        glm::vec3 t1 = (max - origin) * inverseDirection;
+        glm::vec3 tMin = glm::min(t0, t1);
+        glm::vec3 tMax = glm::max(t0, t1);
+        float entry = std::max(std::max(tMin.x, tMin.y), std::max(tMin.z, 0.0f));
+        float exit = std::min(std::min(tMax.x, tMax.y), std::min(tMax.z, maxDistance));
+        distance = entry;
+        return entry <= exit;
+    };
+
+    std::vector<std::pair<float, SceneModel*>> hits;
+    Traverse([&](const glm::vec3& min, const glm::vec3& max)
+        {
+            float distance;
+            return intersectRay(min, max, distance);
+        },
+        [&](const Item& item)
+        {
+            float distance;
+            intersectRay(item.min, item.max, distance);
+            hits.emplace_back(distance, item.sceneModel);
+        });
+
+    std::sort(hits.begin(), hits.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    for (const auto& hit : hits)
+    {
+        results.push_back(hit.second);
+    }
+}
@@ -43,7 +43,7 @@ void SceneLight::MatchLightToTransform()
         assert(!m_transform->GetParent());
         glm::vec3 position = m_transform->GetTranslation();
         m_light->SetPosition(position);
-        glm::vec3 direction = glm::mat3(m_transform->GetRotationMatrix()) * glm::vec3(0.0f, -1.0f, 0.0f);
+        glm::vec3 direction = m_transform->GetRotationBasis() * glm::vec3(0.0f, -1.0f, 0.0f);
         m_light->SetDirection(direction);
     }
 }
@@ -54,7 +54,7 @@ void SceneLight::MatchTransformToLight()
     {
         assert(!m_transform->GetParent());
         glm::vec3 position = m_light->GetPosition(m_transform->GetTranslation());
-        glm::vec3 transformDirection = glm::mat3(m_transform->GetRotationMatrix()) * glm::vec3(0.0f, -1.0f, 0.0f);
+        glm::vec3 transformDirection = m_transform->GetRotationBasis() * glm::vec3(0.0f, -1.0f, 0.0f);
         glm::vec3 direction = m_light->GetDirection(transformDirection);
         glm::vec3 rotation = GetRotationFromDirection(direction);
         m_transform->SetTranslation(position);
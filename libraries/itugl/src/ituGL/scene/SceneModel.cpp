@@ -4,13 +4,24 @@
 #include <ituGL/geometry/Mesh.h>
 #include <ituGL/scene/Transform.h>
 #include <ituGL/scene/SceneVisitor.h>
+#include <glm/glm.hpp>
+#include <algorithm>
 #include <cassert>
 
-SceneModel::SceneModel(const std::string& name, std::shared_ptr<Model> model) : SceneNode(name), m_model(model)
+SceneModel::SceneModel(const std::string& name, std::shared_ptr<Model> model) : SceneModel(name, model, std::make_shared<Transform>())
 {
 }
 
-SceneModel::SceneModel(const std::string& name, std::shared_ptr<Model> model, std::shared_ptr<Transform> transform) : SceneNode(name, transform), m_model(model)
+SceneModel::SceneModel(const std::string& name, std::shared_ptr<Model> model, std::shared_ptr<Transform> transform)
+    : SceneNode(name, transform)
+    , m_model(model)
+    , m_sphereBounds(glm::vec3(0.0f), 0.0f)
+    , m_aabbBounds(glm::vec3(0.0f), glm::vec3(0.0f))
+    , m_boxBounds(glm::vec3(0.0f), glm::mat3(1.0f), glm::vec3(0.0f))
+    , m_boundsTransform(nullptr)
+    , m_boundsModel(nullptr)
+    , m_boundsTransformVersion(0)
+    , m_boundsModelVersion(0)
 {
 }
 
@@ -22,6 +33,7 @@ std::shared_ptr<Model> SceneModel::GetModel() const
 void SceneModel::SetModel(std::shared_ptr<Model> model)
 {
     m_model = model;
+    m_boundsModel = nullptr;
 }
 
 /*glm::mat4 SceneModel::GetWorldMatrix() const
@@ -45,19 +57,67 @@ const Drawcall& SceneModel::GetDrawcall(int index, const VertexArrayObject*& vao
 
 SphereBounds SceneModel::GetSphereBounds() const
 {
-    return SphereBounds(GetBoxBounds());
+    UpdateBounds();
+    return m_sphereBounds;
 }
 
 AabbBounds SceneModel::GetAabbBounds() const
 {
-    return AabbBounds(GetBoxBounds());
+    UpdateBounds();
+    return m_aabbBounds;
 }
 
 BoxBounds SceneModel::GetBoxBounds() const
+{
+    UpdateBounds();
+    return m_boxBounds;
+}
+
+void SceneModel::UpdateBounds() const
 {
     assert(m_transform);
     assert(m_model);
-    return BoxBounds(m_transform->GetTranslation(), m_transform->GetRotationMatrix(), m_transform->GetScale() /* * m_model->GetSize()*/);
+
+    unsigned int transformVersion = m_transform->GetVersion();
+    unsigned int modelVersion = m_model->GetBoundsVersion();
+    if (m_boundsTransform == m_transform.get() && m_boundsTransformVersion == transformVersion
+        && m_boundsModel == m_model.get() && m_boundsModelVersion == modelVersion)
+    {
+        return;
+    }
+
+    glm::mat4 worldMatrix = m_transform->GetTransformMatrix();
+    glm::mat3 worldBasis(worldMatrix);
+    AabbBounds localAabb = m_model->GetAabbBounds();
+    SphereBounds localSphere = m_model->GetSphereBounds();
+
+    // The box keeps the axes of the transform, with the scale moved into its size
+    glm::vec3 axisScale(glm::length(worldBasis[0]), glm::length(worldBasis[1]), glm::length(worldBasis[2]));
+    glm::mat3 rotation(1.0f);
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        if (axisScale[axis] > 0.0f)
+        {
+            rotation[axis] = worldBasis[axis] / axisScale[axis];
+        }
+    }
+    glm::vec3 center = glm::vec3(worldMatrix * glm::vec4(localAabb.GetCenter(), 1.0f));
+    m_boxBounds = BoxBounds(center, rotation, localAabb.GetSize() * axisScale);
+
+    // Each local axis adds its projection to the extents
+    glm::vec3 size = glm::abs(worldBasis[0]) * localAabb.GetSize().x
+        + glm::abs(worldBasis[1]) * localAabb.GetSize().y
+        + glm::abs(worldBasis[2]) * localAabb.GetSize().z;
+    m_aabbBounds = AabbBounds(center, size);
+
+    glm::vec3 sphereCenter = glm::vec3(worldMatrix * glm::vec4(localSphere.GetCenter(), 1.0f));
+    float maxScale = std::max(axisScale.x, std::max(axisScale.y, axisScale.z));
+    m_sphereBounds = SphereBounds(sphereCenter, localSphere.GetRadius() * maxScale);
+
+    m_boundsTransform = m_transform.get();
+    m_boundsModel = m_model.get();
+    m_boundsTransformVersion = transformVersion;
+    m_boundsModelVersion = modelVersion;
 }
 
 void SceneModel::AcceptVisitor(SceneVisitor& visitor)
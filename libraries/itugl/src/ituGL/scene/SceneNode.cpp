@@ -22,18 +22,17 @@ const std::string& SceneNode::GetName() const
 
 void SceneNode::Rename(const std::string& name)
 {
-    std::shared_ptr<SceneNode> sceneNode;
+    // Only the name index changes, the node keeps its slot and handle
     if (m_scene)
     {
-        sceneNode = m_scene->GetSceneNode(m_name);
-        assert(sceneNode.get() == this);
-        m_scene->RemoveSceneNode(m_name);
+        m_scene->RenameSceneNode(*this, name);
     }
     m_name = name;
-    if (m_scene)
-    {
-        m_scene->AddSceneNode(sceneNode);
-    }
+}
+
+SceneNodeHandle SceneNode::GetHandle() const
+{
+    return m_handle;
 }
 
 std::shared_ptr<Transform> SceneNode::GetTransform()
@@ -56,9 +55,10 @@ Scene* SceneNode::GetOwnerScene() const
     return m_scene;
 }
 
-void SceneNode::SetOwnerScene(Scene* scene)
+void SceneNode::SetOwnerScene(Scene* scene, SceneNodeHandle handle)
 {
     m_scene = scene;
+    m_handle = handle;
 }
 
 SphereBounds SceneNode::GetSphereBounds() const
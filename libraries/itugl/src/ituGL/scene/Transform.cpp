@@ -1,9 +1,39 @@
 #include <ituGL/scene/Transform.h>
 
 #include <glm/ext/matrix_transform.hpp>
+#include <glm/gtx/euler_angles.hpp>
+#include <algorithm>
 
-Transform::Transform() : m_translation(0, 0, 0), m_rotation(0, 0, 0), m_scale(1, 1, 1), m_matrix(1.0f), m_dirty(false)
+unsigned int Transform::s_lastVersion = 0;
+
+Transform::Transform()
+    : m_translation(0, 0, 0)
+    , m_rotation(0, 0, 0)
+    , m_rotationQuaternion(1, 0, 0, 0)
+    , m_rotationBasis(1.0f)
+    , m_scale(1, 1, 1)
+    , m_matrix(1.0f)
+    , m_matrixVersion(0)
+    , m_version(0)
+{
+}
+
+void Transform::SetRotation(const glm::vec3& rotation)
+{
+    m_rotation = rotation;
+    m_rotationQuaternion = glm::angleAxis(rotation.y, glm::vec3(0, 1, 0))
+        * glm::angleAxis(rotation.x, glm::vec3(1, 0, 0))
+        * glm::angleAxis(rotation.z, glm::vec3(0, 0, 1));
+    m_rotationBasis = glm::mat3_cast(m_rotationQuaternion);
+    UpdateVersion();
+}
+
+void Transform::SetRotationQuaternion(const glm::quat& rotation)
 {
+    m_rotationQuaternion = glm::normalize(rotation);
+    m_rotationBasis = glm::mat3_cast(m_rotationQuaternion);
+    glm::extractEulerAngleYXZ(glm::mat4(m_rotationBasis), m_rotation.y, m_rotation.x, m_rotation.z);
+    UpdateVersion();
 }
 
 glm::mat4 Transform::GetTranslationMatrix() const
@@ -13,11 +43,7 @@ glm::mat4 Transform::GetTranslationMatrix() const
 
 glm::mat4 Transform::GetRotationMatrix() const
 {
-    glm::mat4 matrix = glm::identity<glm::mat4>();
-    matrix = glm::rotate(matrix, m_rotation.y, glm::vec3(0, 1, 0));
-    matrix = glm::rotate(matrix, m_rotation.x, glm::vec3(1, 0, 0));
-    matrix = glm::rotate(matrix, m_rotation.z, glm::vec3(0, 0, 1));
-    return matrix;
+    return glm::mat4(m_rotationBasis);
 }
 
 glm::mat4 Transform::GetScaleMatrix() const
@@ -27,19 +53,41 @@ glm::mat4 Transform::GetScaleMatrix() const
 
 glm::mat4 Transform::GetTransformMatrix() const
 {
-    if (IsDirty())
+    unsigned int version = GetVersion();
+    if (version != m_matrixVersion)
     {
-        m_matrix = GetTranslationMatrix() * GetRotationMatrix() * GetScaleMatrix();
+        // Same as translation * rotation * scale, written directly: scaled basis vectors and the translation
+        glm::vec3 axisX = m_rotationBasis[0] * m_scale.x;
+        glm::vec3 axisY = m_rotationBasis[1] * m_scale.y;
+        glm::vec3 axisZ = m_rotationBasis[2] * m_scale.z;
+        glm::vec3 translation = m_translation;
+
         if (m_parent)
         {
-            m_matrix = m_parent->GetTransformMatrix() * m_matrix;
+            // Both are affine, so only the 3x3 part and the translation of the parent are needed
+            glm::mat4 parentMatrix = m_parent->GetTransformMatrix();
+            glm::mat3 parentBasis(parentMatrix);
+            axisX = parentBasis * axisX;
+            axisY = parentBasis * axisY;
+            axisZ = parentBasis * axisZ;
+            translation = parentBasis * translation + glm::vec3(parentMatrix[3]);
         }
-        m_dirty = false;
+
+        m_matrix[0] = glm::vec4(axisX, 0.0f);
+        m_matrix[1] = glm::vec4(axisY, 0.0f);
+        m_matrix[2] = glm::vec4(axisZ, 0.0f);
+        m_matrix[3] = glm::vec4(translation, 1.0f);
+        m_matrixVersion = version;
     }
     return m_matrix;
 }
 
 bool Transform::IsDirty() const
 {
-    return m_dirty || (m_parent && m_parent->IsDirty());
+    return GetVersion() != m_matrixVersion;
+}
+
+unsigned int Transform::GetVersion() const
+{
+    return m_parent ? std::max(m_version, m_parent->GetVersion()) : m_version;
 }
@@ -0,0 +1,175 @@
+#include <ituGL/scene/TransformHierarchy.h>
+
+#include <glm/mat3x3.hpp>
+#include <algorithm>
+#include <thread>
+#include <cmath>
+#include <cassert>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TRANSFORM_HIERARCHY_SSE
+#include <emmintrin.h>
+#endif
+
+// Below this number, the cost of starting the threads is higher than the work they save
+const unsigned int s_minNodesPerThread = 4096;
+
+TransformHierarchy::TransformHierarchy() : m_anyDirty(false), m_threadCount(0)
+{
+}
+
+TransformHierarchy::Handle TransformHierarchy::Add(Handle parent)
+{
+    Handle handle = GetCount();
+    assert(parent == InvalidHandle || parent < handle);
+
+    m_translations.emplace_back(0.0f);
+    m_rotations.emplace_back(0.0f);
+    m_scales.emplace_back(1.0f);
+    m_parents.push_back(parent);
+    m_worldMatrices.emplace_back(1.0f);
+    m_dirty.push_back(0);
+
+    // A node whose parent is in the current run has to wait for it, so it starts a new one
+    if (m_runStarts.empty() || (parent != InvalidHandle && parent >= m_runStarts.back()))
+    {
+        m_runStarts.push_back(handle);
+    }
+
+    return handle;
+}
+
+void TransformHierarchy::Clear()
+{
+    m_translations.clear();
+    m_rotations.clear();
+    m_scales.clear();
+    m_parents.clear();
+    m_worldMatrices.clear();
+    m_dirty.clear();
+    m_runStarts.clear();
+    m_anyDirty = false;
+}
+
+unsigned int TransformHierarchy::Update()
+{
+    if (!m_anyDirty)
+    {
+        return 0;
+    }
+
+    unsigned int maxThreadCount = m_threadCount > 0 ? m_threadCount : std::max(std::thread::hardware_concurrency(), 1u);
+
+    unsigned int updatedCount = 0;
+    for (size_t runIndex = 0; runIndex < m_runStarts.size(); ++runIndex)
+    {
+        Handle first = m_runStarts[runIndex];
+        Handle last = runIndex + 1 < m_runStarts.size() ? m_runStarts[runIndex + 1] : GetCount();
+
+        unsigned int threadCount = std::clamp((last - first) / s_minNodesPerThread, 1u, maxThreadCount);
+        if (threadCount == 1)
+        {
+            updatedCount += UpdateRange(first, last);
+            continue;
+        }
+
+        // The nodes of a run only read the matrices of the previous runs, so they can be split freely
+        // The calling thread takes the first part
+        std::vector<unsigned int> threadUpdatedCounts(threadCount, 0);
+        std::vector<std::thread> threads;
+        threads.reserve(threadCount - 1);
+        for (unsigned int i = 1; i < threadCount; ++i)
+        {
+            Handle threadFirst = first + i * (last - first) / threadCount;
+            Handle threadLast = first + (i + 1) * (last - first) / threadCount;
+            threads.emplace_back([this, threadFirst, threadLast, &threadUpdatedCounts, i]()
+                {
+                    threadUpdatedCounts[i] = UpdateRange(threadFirst, threadLast);
+                });
+        }
+        threadUpdatedCounts[0] = UpdateRange(first, first + (last - first) / threadCount);
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+
+        for (unsigned int threadUpdatedCount : threadUpdatedCounts)
+        {
+            updatedCount += threadUpdatedCount;
+        }
+    }
+
+    std::fill(m_dirty.begin(), m_dirty.end(), 0);
+    m_anyDirty = false;
+
+    return updatedCount;
+}
+
+unsigned int TransformHierarchy::UpdateRange(Handle first, Handle last)
+{
+    unsigned int updatedCount = 0;
+    for (Handle handle = first; handle < last; ++handle)
+    {
+        // The parent was swept before, so its flag already says if its matrix changed
+        Handle parent = m_parents[handle];
+        if (!m_dirty[handle] && (parent == InvalidHandle || !m_dirty[parent]))
+        {
+            continue;
+        }
+        m_dirty[handle] = 1;
+
+        glm::mat4 localMatrix = ComputeLocalMatrix(m_translations[handle], m_rotations[handle], m_scales[handle]);
+        if (parent != InvalidHandle)
+        {
+            Multiply(m_worldMatrices[parent], localMatrix, m_worldMatrices[handle]);
+        }
+        else
+        {
+            m_worldMatrices[handle] = localMatrix;
+        }
+        updatedCount++;
+    }
+    return updatedCount;
+}
+
+glm::mat4 TransformHierarchy::ComputeLocalMatrix(const glm::vec3& translation, const glm::vec3& rotation, const glm::vec3& scale)
+{
+    // Built directly from the sines and cosines, instead of a matrix product per axis
+    float sx = std::sin(rotation.x), cx = std::cos(rotation.x);
+    float sy = std::sin(rotation.y), cy = std::cos(rotation.y);
+    float sz = std::sin(rotation.z), cz = std::cos(rotation.z);
+
+    glm::mat3 rotationY(cy, 0.0f, -sy, 0.0f, 1.0f, 0.0f, sy, 0.0f, cy);
+    glm::mat3 rotationX(1.0f, 0.0f, 0.0f, 0.0f, cx, sx, 0.0f, -sx, cx);
+    glm::mat3 rotationZ(cz, sz, 0.0f, -sz, cz, 0.0f, 0.0f, 0.0f, 1.0f);
+    glm::mat3 rotationMatrix = rotationY * rotationX * rotationZ;
+
+    glm::mat4 matrix;
+    matrix[0] = glm::vec4(rotationMatrix[0] * scale.x, 0.0f);
+    matrix[1] = glm::vec4(rotationMatrix[1] * scale.y, 0.0f);
+    matrix[2] = glm::vec4(rotationMatrix[2] * scale.z, 0.0f);
+    matrix[3] = glm::vec4(translation, 1.0f);
+    return matrix;
+}
+
+void TransformHierarchy::Multiply(const glm::mat4& a, const glm::mat4& b, glm::mat4& result)
+{
+#if defined(TRANSFORM_HIERARCHY_SSE)
+    // Each column of the result is a combination of the columns of a, weighted by a column of b
+    const __m128 a0 = _mm_loadu_ps(&a[0][0]);
+    const __m128 a1 = _mm_loadu_ps(&a[1][0]);
+    const __m128 a2 = _mm_loadu_ps(&a[2][0]);
+    const __m128 a3 = _mm_loadu_ps(&a[3][0]);
+    for (int column = 0; column < 4; ++column)
+    {
+        const glm::vec4& bColumn = b[column];
+        __m128 sum = _mm_mul_ps(a0, _mm_set1_ps(bColumn.x));
+        sum = _mm_add_ps(sum, _mm_mul_ps(a1, _mm_set1_ps(bColumn.y)));
+        sum = _mm_add_ps(sum, _mm_mul_ps(a2, _mm_set1_ps(bColumn.z)));
+        sum = _mm_add_ps(sum, _mm_mul_ps(a3, _mm_set1_ps(bColumn.w)));
+        _mm_storeu_ps(&result[column][0], sum);
+    }
+#else
+    result = a * b;
+#endif
+}
@@ -1,5 +1,6 @@
 #include <ituGL/shader/Material.h>
 #include <ituGL/core/DeviceGL.h>
+#include <ituGL/renderer/CommandBuffer.h>
 #include <cassert>
 
 Material::Material() : Material(nullptr)
@@ -8,6 +9,7 @@ Material::Material() : Material(nullptr)
 
 Material::Material(std::shared_ptr<ShaderProgram> shaderProgram, const NameSet& filteredUniforms)
     : ShaderUniformCollection(shaderProgram, filteredUniforms)
+    , m_capabilities(ShadowCaster)
     , m_depthTestFunction(TestFunction::Less)
     , m_depthWrite(true)
     , m_stencilTestFunctions{ TestFunction::Never, TestFunction::Never }
@@ -19,6 +21,7 @@ Material::Material(std::shared_ptr<ShaderProgram> shaderProgram, const NameSet&
     , m_blendEquations{ BlendEquation::None }
     , m_blendParams{ BlendParam::One, BlendParam::Zero, BlendParam::One, BlendParam::Zero }
 {
+    UpdateCapabilities();
 }
 
 void Material::SetShaderSetupFunction(ShaderSetupFunction shaderSetupFunction)
@@ -26,6 +29,29 @@ void Material::SetShaderSetupFunction(ShaderSetupFunction shaderSetupFunction)
     m_shaderSetupFunction = shaderSetupFunction;
 }
 
+void Material::SetCapability(Capabilities capability, bool enabled)
+{
+    assert(capability != Opaque && capability != Blended && capability != DepthWrite);
+    if (enabled)
+    {
+        m_capabilities |= capability;
+    }
+    else
+    {
+        m_capabilities &= ~capability;
+    }
+}
+
+void Material::UpdateCapabilities()
+{
+    m_capabilities &= ~(Opaque | Blended | DepthWrite);
+    m_capabilities |= HasBlend() ? Blended : Opaque;
+    if (m_depthWrite)
+    {
+        m_capabilities |= DepthWrite;
+    }
+}
+
 Material::TestFunction Material::GetDepthTestFunction() const
 {
     return m_depthTestFunction;
@@ -44,6 +70,7 @@ bool Material::GetDepthWrite() const
 void Material::SetDepthWrite(bool depthWrite)
 {
     m_depthWrite = depthWrite;
+    UpdateCapabilities();
 }
 
 void Material::SetStencilTestFunction(TestFunction function, int refValue, unsigned int mask)
@@ -138,6 +165,7 @@ void Material::SetBlendEquation(BlendEquation blendEquationColor, BlendEquation
 {
     m_blendEquations[0] = blendEquationColor;
     m_blendEquations[1] = blendEquationAlpha;
+    UpdateCapabilities();
 }
 
 Material::BlendParam Material::GetBlendParamSourceColor() const
@@ -202,6 +230,13 @@ void Material::Use(OverrideFlags overrideFlags) const
     // Set the shader program as the one currently in use
     m_shaderProgram->Use();
 
+    UseProperties();
+
+    UseRenderStates(overrideFlags);
+}
+
+void Material::UseProperties() const
+{
     // Set the value of all the uniforms stored as properties
     SetUniforms();
 
@@ -210,115 +245,130 @@ void Material::Use(OverrideFlags overrideFlags) const
         // if needed, do extra set up for the shader
         m_shaderSetupFunction(*m_shaderProgram);
     }
+}
+
+void Material::UseProperties(std::span<const TextureObject*> boundTextures, unsigned int& texturesBound, unsigned int& texturesSkipped) const
+{
+    // Set the value of all the uniforms stored as properties, skipping textures already bound
+    SetUniforms(boundTextures, texturesBound, texturesSkipped);
+
+    if (m_shaderSetupFunction)
+    {
+        // if needed, do extra set up for the shader
+        m_shaderSetupFunction(*m_shaderProgram);
+    }
+}
+
+void Material::UseRenderStates(OverrideFlags overrideFlags) const
+{
+    SetRenderStates(DeviceGL::GetInstance(), overrideFlags);
+}
+
+void Material::Record(CommandBuffer& commandBuffer, OverrideFlags overrideFlags) const
+{
+    assert(m_shaderProgram);
+
+    commandBuffer.UseProgram(m_shaderProgram->GetHandle());
+
+    RecordProperties(commandBuffer);
+
+    RecordRenderStates(commandBuffer, overrideFlags);
+}
+
+void Material::RecordProperties(CommandBuffer& commandBuffer) const
+{
+    RecordUniforms(commandBuffer);
+
+    if (m_shaderSetupFunction)
+    {
+        // It sets the uniforms through the program, so it can only run when the commands are executed
+        commandBuffer.CallFunction([this]() { m_shaderSetupFunction(*m_shaderProgram); });
+    }
+}
+
+void Material::RecordRenderStates(CommandBuffer& commandBuffer, OverrideFlags overrideFlags) const
+{
+    SetRenderStates(commandBuffer, overrideFlags);
+}
 
+template<typename T>
+void Material::SetRenderStates(T& target, OverrideFlags overrideFlags) const
+{
     // If not skipped, set the depth settings
     if ((overrideFlags & OverrideFlags::OverrideDepthTest) == 0)
     {
-        UseDepthTest();
+        SetDepthTest(target);
     }
 
     // If not skipped, set the stencil settings
     if ((overrideFlags & OverrideFlags::OverrideStencilTest) == 0)
     {
-        UseStencilTest();
+        SetStencilTest(target);
     }
 
     // If not skipped, set the blend settings
     if ((overrideFlags & OverrideFlags::OverrideBlend) == 0)
     {
-        UseBlend();
+        SetBlend(target);
     }
 }
 
-void Material::UseDepthTest() const
+template<typename T>
+void Material::SetDepthTest(T& target) const
 {
     // Depth function
-    glDepthFunc(static_cast<GLenum>(m_depthTestFunction));
+    target.SetDepthFunction(static_cast<GLenum>(m_depthTestFunction));
 
     // Depth write
-    glDepthMask(m_depthWrite ? GL_TRUE : GL_FALSE);
+    target.SetDepthMask(m_depthWrite);
 }
 
-void Material::UseStencilTest() const
+template<typename T>
+void Material::SetStencilTest(T& target) const
 {
-    // Stencil operations
-    if (m_stencilFail[0] == m_stencilFail[1] && m_stencilDepthFail[0] == m_stencilDepthFail[1] && m_stencilDepthPass[0] == m_stencilDepthPass[1])
-    {
-        // Same for front and back
-        glStencilOp(static_cast<GLenum>(m_stencilFail[0]), static_cast<GLenum>(m_stencilDepthFail[0]), static_cast<GLenum>(m_stencilDepthPass[0]));
-    }
-    else
-    {
-        // Separate functions for front and back
-        glStencilOpSeparate(GL_FRONT, static_cast<GLenum>(m_stencilFail[0]), static_cast<GLenum>(m_stencilDepthFail[0]), static_cast<GLenum>(m_stencilDepthPass[0]));
-        glStencilOpSeparate(GL_BACK, static_cast<GLenum>(m_stencilFail[1]), static_cast<GLenum>(m_stencilDepthFail[1]), static_cast<GLenum>(m_stencilDepthPass[1]));
-    }
+    // Stencil operations, the device merges front and back if they are the same
+    target.SetStencilOperations(GL_FRONT, static_cast<GLenum>(m_stencilFail[0]), static_cast<GLenum>(m_stencilDepthFail[0]), static_cast<GLenum>(m_stencilDepthPass[0]));
+    target.SetStencilOperations(GL_BACK, static_cast<GLenum>(m_stencilFail[1]), static_cast<GLenum>(m_stencilDepthFail[1]), static_cast<GLenum>(m_stencilDepthPass[1]));
 
     // Stencil functions
-    if (m_stencilTestFunctions[0] == m_stencilTestFunctions[1] && m_stencilRefValues[0] == m_stencilRefValues[1] && m_stencilMasks[0] == m_stencilMasks[1])
-    {
-        // Same for front and back
-        glStencilFunc(static_cast<GLenum>(m_stencilTestFunctions[0]), m_stencilRefValues[0], m_stencilMasks[0]);
-    }
-    else
-    {
-        // Separate functions for front and back
-        glStencilFuncSeparate(GL_FRONT, static_cast<GLenum>(m_stencilTestFunctions[0]), m_stencilRefValues[0], m_stencilMasks[0]);
-        glStencilFuncSeparate(GL_BACK, static_cast<GLenum>(m_stencilTestFunctions[1]), m_stencilRefValues[1], m_stencilMasks[1]);
-    }
+    target.SetStencilFunction(GL_FRONT, static_cast<GLenum>(m_stencilTestFunctions[0]), m_stencilRefValues[0], m_stencilMasks[0]);
+    target.SetStencilFunction(GL_BACK, static_cast<GLenum>(m_stencilTestFunctions[1]), m_stencilRefValues[1], m_stencilMasks[1]);
 }
 
-void Material::UseBlend() const
+template<typename T>
+void Material::SetBlend(T& target) const
 {
     // If the blend equation is None for color and alpha, do nothing
     bool blending = HasBlend();
-    DeviceGL::GetInstance().SetFeatureEnabled(GL_BLEND, blending);
+    target.SetFeatureEnabled(GL_BLEND, blending);
     if (blending)
     {
         std::array<BlendParam, 4> blendParams = m_blendParams;
 
-        // Set blend equation
-        if (m_blendEquations[0] == m_blendEquations[1])
+        GLenum blendEquationColor = static_cast<GLenum>(m_blendEquations[0]);
+        GLenum blendEquationAlpha = static_cast<GLenum>(m_blendEquations[1]);
+
+        // Because there is no "None" equation, we replace it with (Source * 1 + Dest * 0)
+        if (m_blendEquations[0] == BlendEquation::None)
         {
-            // Set the same blend equation for color and alpha
-            glBlendEquation(static_cast<GLenum>(m_blendEquations[0]));
+            blendEquationColor = GL_FUNC_ADD;
+            blendParams[0] = BlendParam::One;
+            blendParams[1] = BlendParam::Zero;
         }
-        else
+        if (m_blendEquations[1] == BlendEquation::None)
         {
-            GLenum blendEquationColor = static_cast<GLenum>(m_blendEquations[0]);
-            GLenum blendEquationAlpha = static_cast<GLenum>(m_blendEquations[1]);
-
-            // Because there is no "None" equation, we replace it with (Source * 1 + Dest * 0)
-            if (m_blendEquations[0] == BlendEquation::None)
-            {
-                blendEquationColor = GL_FUNC_ADD;
-                blendParams[0] = BlendParam::One;
-                blendParams[1] = BlendParam::Zero;
-            }
-            if (m_blendEquations[1] == BlendEquation::None)
-            {
-                blendEquationAlpha = GL_FUNC_ADD;
-                blendParams[2] = BlendParam::One;
-                blendParams[3] = BlendParam::Zero;
-            }
-
-            // Set separate blend equation for color and alpha
-            glBlendEquationSeparate(blendEquationColor, blendEquationAlpha);
+            blendEquationAlpha = GL_FUNC_ADD;
+            blendParams[2] = BlendParam::One;
+            blendParams[3] = BlendParam::Zero;
         }
 
+        // Set blend equation
+        target.SetBlendEquation(blendEquationColor, blendEquationAlpha);
+
         // Set blend params
-        if (blendParams[0] == blendParams[2] && blendParams[1] == blendParams[3])
-        {
-            // Set the same blend params for color and alpha
-            glBlendFunc(static_cast<GLenum>(blendParams[0]), static_cast<GLenum>(blendParams[1]));
-        }
-        else
-        {
-            // Set separate blend params for color and alpha
-            glBlendFuncSeparate(
-                static_cast<GLenum>(blendParams[0]), static_cast<GLenum>(blendParams[1]),
-                static_cast<GLenum>(blendParams[2]), static_cast<GLenum>(blendParams[3]));
-        }
+        target.SetBlendFunction(
+            static_cast<GLenum>(blendParams[0]), static_cast<GLenum>(blendParams[1]),
+            static_cast<GLenum>(blendParams[2]), static_cast<GLenum>(blendParams[3]));
 
         // Set blend color only if one param is using constant color or constant alpha
         if (blendParams[0] == BlendParam::ConstantColor || blendParams[0] == BlendParam::ConstantAlpha ||
@@ -326,7 +376,7 @@ void Material::UseBlend() const
             blendParams[2] == BlendParam::ConstantColor || blendParams[2] == BlendParam::ConstantAlpha ||
             blendParams[3] == BlendParam::ConstantColor || blendParams[3] == BlendParam::ConstantAlpha)
         {
-            glBlendColor(m_blendColor.GetRed(), m_blendColor.GetGreen(), m_blendColor.GetBlue(), m_blendColor.GetAlpha());
+            target.SetBlendColor(m_blendColor);
         }
     }
 }
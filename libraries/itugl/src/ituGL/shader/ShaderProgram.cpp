@@ -1,9 +1,13 @@
 #include <ituGL/shader/ShaderProgram.h>
 
 #include <ituGL/shader/Shader.h>
+#include <ituGL/core/DeviceGL.h>
 #include <ituGL/texture/TextureObject.h>
+#include <ituGL/renderer/CommandBuffer.h>
 #include <cassert>
 
+thread_local CommandBuffer* ShaderProgram::s_recordingCommandBuffer = nullptr;
+
 #ifndef NDEBUG
 ShaderProgram::Handle ShaderProgram::s_usedHandle = ShaderProgram::NullHandle;
 #endif
@@ -20,6 +24,10 @@ ShaderProgram::~ShaderProgram()
     {
         Handle& handle = GetHandle();
         glDeleteProgram(handle);
+        if (DeviceGL* device = DeviceGL::GetInstancePointer())
+        {
+            device->OnShaderProgramDeleted(handle);
+        }
         handle = NullHandle;
     }
 }
@@ -132,7 +140,7 @@ void ShaderProgram::Use() const
     assert(IsValid());
     assert(IsLinked());
     Handle handle = GetHandle();
-    glUseProgram(handle);
+    DeviceGL::GetInstance().UseShaderProgram(handle);
 #ifndef NDEBUG
     s_usedHandle = handle;
 #endif
@@ -157,6 +165,22 @@ ShaderProgram::Location ShaderProgram::GetUniformLocation(const char* name) cons
     return glGetUniformLocation(handle, name);
 }
 
+// Find the uniform block index
+GLuint ShaderProgram::GetUniformBlockIndex(const char* name) const
+{
+    assert(IsValid());
+    assert(IsLinked());
+    return glGetUniformBlockIndex(GetHandle(), name);
+}
+
+// Assign the block to the binding point
+void ShaderProgram::SetUniformBlockBinding(GLuint blockIndex, GLuint bindingIndex) const
+{
+    assert(IsValid());
+    assert(blockIndex != GL_INVALID_INDEX);
+    glUniformBlockBinding(GetHandle(), blockIndex, bindingIndex);
+}
+
 // Get how many uniforms exist in this shader program
 unsigned int ShaderProgram::GetUniformCount() const
 {
@@ -406,9 +430,23 @@ void ShaderProgram::SetUniforms<GLfloat, 4, 4>(Location location, const GLfloat*
 
 void ShaderProgram::SetTexture(Location location, GLint textureUnit, const TextureObject& texture) const
 {
+    // Binding the texture can't be recorded
+    assert(!s_recordingCommandBuffer);
     assert(IsValid());
     assert(IsUsed());
     TextureObject::SetActiveTexture(textureUnit);
     texture.Bind();
     SetUniform(location, textureUnit);
 }
+
+void ShaderProgram::SetRecordingCommandBuffer(CommandBuffer* commandBuffer)
+{
+    s_recordingCommandBuffer = commandBuffer;
+}
+
+void ShaderProgram::RecordUniforms(Location location, Data::Type type, int components, int columns, GLsizei count, const void* values)
+{
+    assert(s_recordingCommandBuffer);
+    std::size_t size = static_cast<std::size_t>(Data::GetTypeSize(type)) * components * columns * count;
+    s_recordingCommandBuffer->SetUniforms(location, type, components, columns, count, std::span<const std::byte>(static_cast<const std::byte*>(values), size));
+}
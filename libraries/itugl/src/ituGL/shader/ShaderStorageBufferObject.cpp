@@ -0,0 +1,18 @@
+#include <ituGL/shader/ShaderStorageBufferObject.h>
+
+ShaderStorageBufferObject::ShaderStorageBufferObject()
+{
+    // Nothing to do here, it is done by the base class
+}
+
+// Bind the buffer to the indexed target. It also binds it to the generic target, like Bind()
+void ShaderStorageBufferObject::BindBase(GLuint bindingIndex) const
+{
+    BindBase(bindingIndex, *this);
+}
+
+// The binding points don't depend on the target the buffer was created for
+void ShaderStorageBufferObject::BindBase(GLuint bindingIndex, const BufferObject& buffer)
+{
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, bindingIndex, buffer.GetHandle());
+}
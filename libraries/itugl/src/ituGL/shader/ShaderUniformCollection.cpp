@@ -1,4 +1,6 @@
 #include <ituGL/shader/ShaderUniformCollection.h>
+
+#include <ituGL/renderer/CommandBuffer.h>
 #include <cassert>
 #include <array>
 
@@ -85,9 +87,10 @@ void ShaderUniformCollection::ExtractUniforms(const NameSet& filteredUniforms)
         if (filteredUniforms.contains(uniformName))
             continue;
 
-        // Get the uniform location
+        // Get the uniform location. Uniforms in blocks have none, their values come from a uniform buffer
         ShaderProgram::Location location = GetUniformLocation(uniformName);
-        assert(location >= 0);
+        if (location < 0)
+            continue;
 
         Data::Type type;
         UniformDimension dimension;
@@ -233,9 +236,11 @@ bool ShaderUniformCollection::IsTextureUniform(GLenum glType, TextureObject::Tar
         target = TextureObject::Target::Texture1DArray;
         break;
     case GL_SAMPLER_2D:
+    case GL_SAMPLER_2D_SHADOW:
         target = TextureObject::Target::Texture2D;
         break;
     case GL_SAMPLER_2D_ARRAY:
+    case GL_SAMPLER_2D_ARRAY_SHADOW:
         target = TextureObject::Target::Texture2DArray;
         break;
     case GL_SAMPLER_2D_MULTISAMPLE:
@@ -248,11 +253,17 @@ bool ShaderUniformCollection::IsTextureUniform(GLenum glType, TextureObject::Tar
         target = TextureObject::Target::Texture3D;
         break;
     case GL_SAMPLER_CUBE:
+    case GL_SAMPLER_CUBE_SHADOW:
         target = TextureObject::Target::TextureCubemap;
         break;
     case GL_SAMPLER_CUBE_MAP_ARRAY:
         target = TextureObject::Target::TextureCubemapArray;
         break;
+    case GL_SAMPLER_BUFFER:
+    case GL_INT_SAMPLER_BUFFER:
+    case GL_UNSIGNED_INT_SAMPLER_BUFFER:
+        target = TextureObject::Target::TextureBuffer;
+        break;
     default:
         return false;
     }
@@ -298,6 +309,71 @@ void ShaderUniformCollection::SetUniforms() const
     }
 }
 
+void ShaderUniformCollection::SetUniforms(std::span<const TextureObject*> boundTextures, unsigned int& texturesBound, unsigned int& texturesSkipped) const
+{
+    for (const DataUniform& uniform : m_dataUniforms)
+    {
+        UseUniform(uniform);
+    }
+    for (const TextureUniform& uniform : m_textureUniforms)
+    {
+        UseUniform(uniform, boundTextures, texturesBound, texturesSkipped);
+    }
+}
+
+void ShaderUniformCollection::RecordUniforms(CommandBuffer& commandBuffer) const
+{
+    for (const DataUniform& uniform : m_dataUniforms)
+    {
+        // Vectors have 1 column, matrices have 1 component per row
+        int components = 1;
+        int columns = 1;
+        if (uniform.dimension >= UniformDimension::VectorFirst && uniform.dimension <= UniformDimension::VectorLast)
+        {
+            components = 2 + static_cast<int>(uniform.dimension) - static_cast<int>(UniformDimension::VectorFirst);
+        }
+        else if (uniform.dimension >= UniformDimension::MatrixFirst && uniform.dimension <= UniformDimension::MatrixLast)
+        {
+            int matrixIndex = static_cast<int>(uniform.dimension) - static_cast<int>(UniformDimension::MatrixFirst);
+            columns = 2 + matrixIndex / 3;
+            components = 2 + matrixIndex % 3;
+        }
+
+        const std::byte* data = nullptr;
+        switch (uniform.type)
+        {
+        case Data::Type::Int:
+            data = reinterpret_cast<const std::byte*>(&m_intDataValues[uniform.index]);
+            break;
+        case Data::Type::UInt:
+            data = reinterpret_cast<const std::byte*>(&m_uintDataValues[uniform.index]);
+            break;
+        case Data::Type::Float:
+            data = reinterpret_cast<const std::byte*>(&m_floatDataValues[uniform.index]);
+            break;
+        case Data::Type::Double:
+            data = reinterpret_cast<const std::byte*>(&m_doubleDataValues[uniform.index]);
+            break;
+        default:
+            assert(false);
+        }
+
+        std::size_t size = Data::GetTypeSize(uniform.type) * components * columns * uniform.count;
+        commandBuffer.SetUniforms(uniform.location, uniform.type, components, columns, uniform.count, std::span(data, size));
+    }
+
+    for (const TextureUniform& uniform : m_textureUniforms)
+    {
+        if (uniform.texture)
+        {
+            // Same texture units as UseUniform
+            int textureUnit = static_cast<int>(&uniform - m_textureUniforms.data());
+            commandBuffer.BindTexture(textureUnit, static_cast<GLenum>(uniform.target), uniform.texture->GetHandle());
+            commandBuffer.SetUniform(uniform.location, textureUnit);
+        }
+    }
+}
+
 void ShaderUniformCollection::UseUniform(const DataUniform& uniform) const
 {
     switch (uniform.type)
@@ -329,6 +405,29 @@ void ShaderUniformCollection::UseUniform(const TextureUniform& uniform) const
     }
 }
 
+void ShaderUniformCollection::UseUniform(const TextureUniform& uniform, std::span<const TextureObject*> boundTextures, unsigned int& texturesBound, unsigned int& texturesSkipped) const
+{
+    if (uniform.texture)
+    {
+        size_t textureIndex = &uniform - m_textureUniforms.data();
+        if (textureIndex < boundTextures.size() && boundTextures[textureIndex] == uniform.texture.get())
+        {
+            // Texture is already in the unit, only the sampler needs to point to it
+            m_shaderProgram->SetUniform(uniform.location, static_cast<int>(textureIndex));
+            texturesSkipped++;
+        }
+        else
+        {
+            m_shaderProgram->SetTexture(uniform.location, static_cast<int>(textureIndex), *uniform.texture);
+            if (textureIndex < boundTextures.size())
+            {
+                boundTextures[textureIndex] = uniform.texture.get();
+            }
+            texturesBound++;
+        }
+    }
+}
+
 template<>
 void ShaderUniformCollection::UseUniform<float>(const DataUniform& uniform) const
 {
@@ -0,0 +1,94 @@
+#include <ituGL/shader/UniformBufferObject.h>
+
+#include <cstring>
+#include <cassert>
+
+UniformBufferObject::UniformBufferObject()
+{
+    // Nothing to do here, it is done by the base class
+}
+
+// Call the base implementation with Usage::DynamicDraw
+void UniformBufferObject::AllocateData(size_t size)
+{
+    AllocateData(size, Usage::DynamicDraw);
+}
+
+// Bind the buffer to the indexed target. It also binds it to the generic target, like Bind()
+void UniformBufferObject::BindBase(GLuint bindingIndex) const
+{
+    glBindBufferBase(GL_UNIFORM_BUFFER, bindingIndex, GetHandle());
+}
+
+// Bind part of the buffer to the indexed target
+void UniformBufferObject::BindRange(GLuint bindingIndex, size_t offset, size_t size) const
+{
+    assert(offset % GetOffsetAlignment() == 0);
+    glBindBufferRange(GL_UNIFORM_BUFFER, bindingIndex, GetHandle(), offset, size);
+}
+
+// Query the alignment once, it doesn't change
+size_t UniformBufferObject::GetOffsetAlignment()
+{
+    static GLint s_offsetAlignment = 0;
+    if (s_offsetAlignment == 0)
+    {
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &s_offsetAlignment);
+    }
+    return static_cast<size_t>(s_offsetAlignment);
+}
+
+
+UniformBufferObject::Std140Writer::Std140Writer()
+{
+}
+
+void UniformBufferObject::Std140Writer::Clear()
+{
+    m_data.clear();
+}
+
+size_t UniformBufferObject::Std140Writer::Write(float value)
+{
+    size_t offset = Align(4);
+    Append(&value, sizeof(value));
+    return offset;
+}
+
+size_t UniformBufferObject::Std140Writer::Write(int value)
+{
+    size_t offset = Align(4);
+    Append(&value, sizeof(value));
+    return offset;
+}
+
+size_t UniformBufferObject::Std140Writer::Write(unsigned int value)
+{
+    size_t offset = Align(4);
+    Append(&value, sizeof(value));
+    return offset;
+}
+
+size_t UniformBufferObject::Std140Writer::Write(bool value)
+{
+    return Write(value ? 1u : 0u);
+}
+
+void UniformBufferObject::Std140Writer::EndStruct()
+{
+    Align(16);
+}
+
+size_t UniformBufferObject::Std140Writer::Align(size_t alignment)
+{
+    size_t size = (m_data.size() + alignment - 1) & ~(alignment - 1);
+    m_data.resize(size);
+    return size;
+}
+
+void UniformBufferObject::Std140Writer::Append(const void* data, size_t size)
+{
+    size_t offset = m_data.size();
+    m_data.resize(offset + size);
+    std::memcpy(m_data.data() + offset, data, size);
+}
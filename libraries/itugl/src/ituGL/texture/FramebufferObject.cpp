@@ -58,7 +58,18 @@ void FramebufferObject::SetTexture(Target target, Attachment attachment, const T
     glFramebufferTexture2D(static_cast<GLenum>(target), static_cast<GLenum>(attachment), texture.GetTarget(), texture.GetHandle(), level);
 }
 
+void FramebufferObject::SetTextureLayer(Target target, Attachment attachment, const TextureObject& texture, int layer, int level)
+{
+    glFramebufferTextureLayer(static_cast<GLenum>(target), static_cast<GLenum>(attachment), texture.GetHandle(), level, layer);
+}
+
 void FramebufferObject::SetDrawBuffers(std::span<const Attachment> attachments)
 {
     glDrawBuffers(static_cast<GLint>(attachments.size()), reinterpret_cast<const GLenum*>(attachments.data()));
 }
+
+void FramebufferObject::Blit(GLint width, GLint height, GLbitfield mask)
+{
+    // Same size, so there is no filtering
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, mask, GL_NEAREST);
+}
@@ -0,0 +1,24 @@
+#include <ituGL/texture/Texture2DArrayObject.h>
+
+#include <cassert>
+
+Texture2DArrayObject::Texture2DArrayObject()
+{
+}
+
+template <>
+void Texture2DArrayObject::SetImage<std::byte>(GLint level, GLsizei width, GLsizei height, GLsizei layerCount, Format format, InternalFormat internalFormat, std::span<const std::byte> data, Data::Type type)
+{
+    assert(IsBound());
+    assert(data.empty() || type != Data::Type::None);
+    assert(IsValidFormat(format, internalFormat));
+    assert(data.empty() || data.size_bytes() == width * height * layerCount * GetDataComponentCount(internalFormat) * Data::GetTypeSize(type));
+    glTexImage3D(GetTarget(), level, internalFormat, width, height, layerCount, 0, format, type == Data::Type::None ? GL_BYTE : static_cast<GLenum>(type), data.data());
+}
+
+void Texture2DArrayObject::SetImage(GLint level, GLsizei width, GLsizei height, GLsizei layerCount, Format format, InternalFormat internalFormat)
+{
+    // Without data, the type is only checked to be compatible with the format
+    Data::Type type = format == FormatDepthStencil ? Data::Type::UInt24_8 : Data::Type::Float;
+    SetImage<std::byte>(level, width, height, layerCount, format, internalFormat, std::span<const std::byte>(), type);
+}
@@ -0,0 +1,29 @@
+#include <ituGL/texture/TextureBufferObject.h>
+
+#include <cassert>
+
+TextureBufferObject::TextureBufferObject() : m_dataSize(0)
+{
+}
+
+void TextureBufferObject::SetData(InternalFormat internalFormat, std::span<const std::byte> data)
+{
+    assert(IsBound());
+    assert(GetDataComponentCount(internalFormat) > 0);
+
+    m_dataSize = data.size();
+
+    // Empty buffers are not allowed, keep at least one texel
+    std::byte emptyData[16] = {};
+    if (data.empty())
+    {
+        data = emptyData;
+    }
+
+    // Allocate again instead of updating, so we don't wait for the GL to stop reading the previous data
+    m_buffer.Bind();
+    m_buffer.AllocateData(data, BufferObject::Usage::StreamDraw);
+    m_buffer.Unbind();
+
+    glTexBuffer(GetTarget(), internalFormat, m_buffer.GetHandle());
+}
@@ -1,5 +1,6 @@
 #include <ituGL/texture/TextureObject.h>
 
+#include <ituGL/core/DeviceGL.h>
 #include <cassert>
 
 TextureObject::TextureObject() : Object(NullHandle)
@@ -12,6 +13,10 @@ TextureObject::~TextureObject()
 {
     Handle& handle = GetHandle();
     glDeleteTextures(1, &handle);
+    if (DeviceGL* device = DeviceGL::GetInstancePointer())
+    {
+        device->OnTextureDeleted(handle);
+    }
 }
 
 #ifndef NDEBUG
@@ -25,19 +30,19 @@ GLint TextureObject::GetActiveTexture()
 
 void TextureObject::SetActiveTexture(GLint textureUnit)
 {
-    glActiveTexture(GL_TEXTURE0 + textureUnit);
+    DeviceGL::GetInstance().SetActiveTextureUnit(textureUnit);
 }
 
 void TextureObject::Bind(Target target) const
 {
     Handle handle = GetHandle();
-    glBindTexture(target, handle);
+    DeviceGL::GetInstance().BindTexture(target, handle);
 }
 
 void TextureObject::Unbind(Target target)
 {
     Handle handle = NullHandle;
-    glBindTexture(target, handle);
+    DeviceGL::GetInstance().BindTexture(target, handle);
 }
 
 void TextureObject::GenerateMipmap()
@@ -203,6 +208,7 @@ int TextureObject::GetDataComponentCount(InternalFormat internalFormat)
     case InternalFormatR16SNorm:
     case InternalFormatR16F:
     case InternalFormatR32F:
+    case InternalFormatR32UI:
     case InternalFormatRCompressed:
     case InternalFormatR11G11B10:
     case InternalFormatRGB10A2:
@@ -221,6 +227,7 @@ int TextureObject::GetDataComponentCount(InternalFormat internalFormat)
     case InternalFormatRG16SNorm:
     case InternalFormatRG16F:
     case InternalFormatRG32F:
+    case InternalFormatRG32UI:
     case InternalFormatRGCompressed:
         return 2;
     case InternalFormatRGB:
@@ -230,6 +237,7 @@ int TextureObject::GetDataComponentCount(InternalFormat internalFormat)
     case InternalFormatRGB16SNorm:
     case InternalFormatRGB16F:
     case InternalFormatRGB32F:
+    case InternalFormatRGB32UI:
     case InternalFormatSRGB8:
     case InternalFormatRGBCompressed:
     case InternalFormatSRGBCompressed:
@@ -241,6 +249,7 @@ int TextureObject::GetDataComponentCount(InternalFormat internalFormat)
     case InternalFormatRGBA16SNorm:
     case InternalFormatRGBA16F:
     case InternalFormatRGBA32F:
+    case InternalFormatRGBA32UI:
     case InternalFormatSRGBA8:
     case InternalFormatRGBACompressed:
     case InternalFormatSRGBACompressed:
@@ -1,5 +1,6 @@
 #include <ituGL/utils/DearImGui.h>
 
+#include <ituGL/core/DeviceGL.h>
 #include <ituGL/application/Window.h>
 #include <imgui.h>
 #include <imgui_impl_glfw.h>
@@ -43,6 +44,12 @@ void DearImGui::EndFrame()
 {
     ImGui::Render();
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+
+    // The backend changes GL state without the device knowing
+    if (DeviceGL* device = DeviceGL::GetInstancePointer())
+    {
+        device->InvalidateState();
+    }
 }
 
 DearImGui::Window DearImGui::UseWindow(const char* name)
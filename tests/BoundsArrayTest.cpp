@@ -0,0 +1,109 @@
+#include "TestUtils.h"
+
+#include <ituGL/scene/BoundsArray.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <random>
+#include <vector>
+
+static FrustumBounds CreateFrustum()
+{
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 50.0f);
+    return FrustumBounds(projection * view);
+}
+
+// Half spheres and half AABBs around the camera, many of them crossing the planes of the frustum
+static void AddBounds(BoundsArray& boundsArray, unsigned int count)
+{
+    std::mt19937 random(count);
+    std::uniform_real_distribution<float> position(-60.0f, 60.0f);
+    std::uniform_real_distribution<float> size(0.5f, 10.0f);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        glm::vec3 center(position(random), position(random), position(random));
+        if (i % 2 == 0)
+        {
+            boundsArray.Add(SphereBounds(center, size(random)));
+        }
+        else
+        {
+            boundsArray.Add(AabbBounds(center, glm::vec3(size(random), size(random), size(random))));
+        }
+    }
+}
+
+// Counts that are not a multiple of the SIMD width, so the last byte is filled by the scalar loop
+static void TestMatchesReference()
+{
+    FrustumBounds frustum = CreateFrustum();
+    for (unsigned int count : { 1u, 3u, 5u, 7u, 8u, 13u, 100u, 1001u })
+    {
+        BoundsArray boundsArray;
+        AddBounds(boundsArray, count);
+        CHECK(boundsArray.GetSize() == count);
+        CHECK(boundsArray.GetVisibilityMaskSize() == (count + 7) / 8);
+
+        std::vector<std::uint8_t> referenceMask(boundsArray.GetVisibilityMaskSize());
+        boundsArray.TestFrustumReference(frustum, referenceMask);
+
+        // Stale bits in the buffer must not survive the test
+        std::vector<std::uint8_t> mask(boundsArray.GetVisibilityMaskSize(), 0xFF);
+        boundsArray.TestFrustum(frustum, mask);
+        CHECK(mask == referenceMask);
+
+        // The larger arrays have visible and culled elements, so the comparison means something
+        unsigned int visibleCount = 0;
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            visibleCount += (referenceMask[i / 8] >> (i % 8)) & 1;
+        }
+        if (count >= 100)
+        {
+            CHECK(visibleCount > 0 && visibleCount < count);
+        }
+
+        // Bits after the last element are zero
+        if (count % 8 != 0)
+        {
+            CHECK((mask.back() >> (count % 8)) == 0);
+        }
+    }
+}
+
+static void TestSet()
+{
+    FrustumBounds frustum = CreateFrustum();
+    BoundsArray boundsArray;
+    AddBounds(boundsArray, 13);
+
+    // Move an element in front of the camera, and another one behind it
+    boundsArray.Set(9, SphereBounds(glm::vec3(0.0f, 0.0f, -10.0f), 1.0f));
+    boundsArray.Set(10, AabbBounds(glm::vec3(0.0f, 0.0f, 10.0f), glm::vec3(1.0f)));
+    CHECK(boundsArray.IsSphere(9));
+    CHECK(!boundsArray.IsSphere(10));
+
+    std::vector<std::uint8_t> mask(boundsArray.GetVisibilityMaskSize());
+    boundsArray.TestFrustum(frustum, mask);
+    CHECK((mask[1] & (1 << 1)) != 0);
+    CHECK((mask[1] & (1 << 2)) == 0);
+
+    std::vector<std::uint8_t> referenceMask(boundsArray.GetVisibilityMaskSize());
+    boundsArray.TestFrustumReference(frustum, referenceMask);
+    CHECK(mask == referenceMask);
+
+    // Cleared arrays can be filled again
+    boundsArray.Clear();
+    CHECK(boundsArray.GetSize() == 0);
+    CHECK(boundsArray.GetVisibilityMaskSize() == 0);
+    boundsArray.Add(SphereBounds(glm::vec3(0.0f, 0.0f, -10.0f), 1.0f));
+    std::uint8_t singleMask = 0xFF;
+    boundsArray.TestFrustum(frustum, std::span<std::uint8_t>(&singleMask, 1));
+    CHECK(singleMask == 1);
+}
+
+int main()
+{
+    TestMatchesReference();
+    TestSet();
+    return TestResult();
+}
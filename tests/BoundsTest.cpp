@@ -0,0 +1,71 @@
+#include "TestUtils.h"
+
+#include <ituGL/scene/Bounds.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+// Rotation of angle radians around the Y axis
+static glm::mat3 RotationY(float angle)
+{
+    return glm::mat3(glm::rotate(glm::mat4(1.0f), angle, glm::vec3(0.0f, 1.0f, 0.0f)));
+}
+
+static void TestBoxBox()
+{
+    BoxBounds box(glm::vec3(0.0f), glm::mat3(1.0f), glm::vec3(1.0f));
+
+    // Overlapping, touching and separated on each kind of axis
+    CHECK(Bounds::Intersects(box, BoxBounds(glm::vec3(1.5f, 0.0f, 0.0f), glm::mat3(1.0f), glm::vec3(1.0f))));
+    CHECK(Bounds::Intersects(box, BoxBounds(glm::vec3(0.0f), glm::mat3(1.0f), glm::vec3(0.5f))));
+    CHECK(!Bounds::Intersects(box, BoxBounds(glm::vec3(3.0f, 0.0f, 0.0f), glm::mat3(1.0f), glm::vec3(1.0f))));
+    CHECK(!Bounds::Intersects(box, BoxBounds(glm::vec3(0.0f, 0.0f, -2.5f), glm::mat3(1.0f), glm::vec3(1.0f))));
+
+    // Rotated 45 degrees, the corner reaches sqrt(2) along X
+    glm::mat3 rotation = RotationY(glm::radians(45.0f));
+    CHECK(Bounds::Intersects(box, BoxBounds(glm::vec3(2.3f, 0.0f, 0.0f), rotation, glm::vec3(1.0f))));
+    CHECK(!Bounds::Intersects(box, BoxBounds(glm::vec3(2.5f, 0.0f, 0.0f), rotation, glm::vec3(1.0f))));
+
+    // Same through the generic dispatch
+    const Bounds& boundsA = box;
+    BoxBounds far(glm::vec3(10.0f), glm::mat3(1.0f), glm::vec3(1.0f));
+    const Bounds& boundsB = far;
+    CHECK(!Bounds::Intersects(boundsA, boundsB));
+    CHECK(Bounds::Intersects(boundsA, boundsA));
+}
+
+static void TestBoxAabbSphere()
+{
+    BoxBounds box(glm::vec3(0.0f), RotationY(glm::radians(30.0f)), glm::vec3(1.0f));
+    CHECK(Bounds::Intersects(box, AabbBounds(glm::vec3(1.5f, 0.0f, 0.0f), glm::vec3(0.5f))));
+    CHECK(!Bounds::Intersects(box, AabbBounds(glm::vec3(4.0f, 0.0f, 0.0f), glm::vec3(0.5f))));
+    CHECK(Bounds::Intersects(box, SphereBounds(glm::vec3(0.0f, 1.5f, 0.0f), 0.6f)));
+    CHECK(!Bounds::Intersects(box, SphereBounds(glm::vec3(0.0f, 1.5f, 0.0f), 0.4f)));
+}
+
+static void TestFrustum()
+{
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 100.0f);
+    FrustumBounds frustum(projection * view);
+
+    CHECK(Bounds::Intersects(frustum, SphereBounds(glm::vec3(0.0f, 0.0f, -10.0f), 1.0f)));
+    CHECK(!Bounds::Intersects(frustum, SphereBounds(glm::vec3(0.0f, 0.0f, 10.0f), 1.0f)));
+    CHECK(!Bounds::Intersects(frustum, BoxBounds(glm::vec3(0.0f, 0.0f, -200.0f), glm::mat3(1.0f), glm::vec3(1.0f))));
+
+    // Frustum against frustum, also through the generic dispatch
+    const Bounds& bounds = frustum;
+    CHECK(Bounds::Intersects(bounds, bounds));
+    glm::mat4 behindView = glm::lookAt(glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, 2.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    CHECK(!Bounds::Intersects(frustum, FrustumBounds(projection * behindView)));
+    glm::mat4 sideView = glm::lookAt(glm::vec3(0.0f, 0.0f, -10.0f), glm::vec3(1.0f, 0.0f, -10.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    CHECK(Bounds::Intersects(frustum, FrustumBounds(projection * sideView)));
+    glm::mat4 farView = glm::lookAt(glm::vec3(0.0f, 0.0f, -500.0f), glm::vec3(0.0f, 0.0f, -501.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    CHECK(!Bounds::Intersects(frustum, FrustumBounds(projection * farView)));
+}
+
+int main()
+{
+    TestBoxBox();
+    TestBoxAabbSphere();
+    TestFrustum();
+    return TestResult();
+}
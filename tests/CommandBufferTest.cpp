@@ -0,0 +1,172 @@
+#include "TestUtils.h"
+
+#include <ituGL/renderer/CommandBuffer.h>
+#include <ituGL/renderer/NullCommandExecutor.h>
+#include <ituGL/geometry/Drawcall.h>
+#include <ituGL/shader/ShaderProgram.h>
+#include <glm/mat4x4.hpp>
+
+using CommandType = CommandBuffer::CommandType;
+
+// Handles are only numbers for the null executor, no GL objects are needed
+static const GLuint ProgramHandle = 3;
+static const GLuint VertexArrayHandles[] = { 5, 6 };
+static const GLuint TextureHandle = 7;
+
+// Same commands that the G-buffer pass records for a frame: 2 meshes with 2 objects each, the second one instanced
+static void RecordGBufferFrame(CommandBuffer& commandBuffer, int& functionCalls)
+{
+    Drawcall drawcalls[] = {
+        Drawcall(Drawcall::Primitive::Triangles, 36, Data::Type::UShort, 0),
+        Drawcall(Drawcall::Primitive::Triangles, 24)
+    };
+
+    commandBuffer.SetFeatureEnabled(GL_FRAMEBUFFER_SRGB, true);
+    for (int mesh = 0; mesh < 2; ++mesh)
+    {
+        // Material
+        commandBuffer.UseProgram(ProgramHandle);
+        commandBuffer.SetUniform(1, glm::vec4(1.0f));
+        commandBuffer.BindTexture(0, GL_TEXTURE_2D, TextureHandle);
+        commandBuffer.SetUniform(2, 0);
+        commandBuffer.SetFeatureEnabled(GL_BLEND, false);
+        commandBuffer.SetDepthFunction(GL_LESS);
+        commandBuffer.SetDepthMask(true);
+
+        commandBuffer.BindVertexArray(VertexArrayHandles[mesh]);
+        if (mesh == 0)
+        {
+            for (int object = 0; object < 2; ++object)
+            {
+                // Transforms of a program without a record function
+                commandBuffer.CallFunction([&functionCalls]() { functionCalls++; });
+                drawcalls[mesh].Record(commandBuffer);
+            }
+        }
+        else
+        {
+            // Instance matrices upload
+            commandBuffer.CallFunction([&functionCalls]() { functionCalls++; });
+            drawcalls[mesh].Record(commandBuffer, 2);
+        }
+    }
+    commandBuffer.SetFeatureEnabled(GL_FRAMEBUFFER_SRGB, false);
+}
+
+static void TestRecordedFrame()
+{
+    CommandBuffer commandBuffer;
+    int functionCalls = 0;
+    RecordGBufferFrame(commandBuffer, functionCalls);
+
+    NullCommandExecutor executor;
+    executor.Execute(commandBuffer);
+    CHECK(executor.GetInvalidCount() == 0);
+    CHECK(executor.GetCommandCount() == commandBuffer.GetCommandCount());
+
+    // The second material only records its uniforms and VAO, the rest is the same state
+    CHECK(executor.GetCommandCount(CommandType::UseProgram) == 1);
+    CHECK(executor.GetCommandCount(CommandType::BindTexture) == 1);
+    CHECK(executor.GetCommandCount(CommandType::SetUniforms) == 4);
+    CHECK(executor.GetCommandCount(CommandType::BindVertexArray) == 2);
+    CHECK(executor.GetCommandCount(CommandType::SetFeature) == 3);
+    CHECK(commandBuffer.GetSkippedCount() == 5);
+
+    // 2 draws of 36 elements, and 2 instances of 24 vertices
+    CHECK(executor.GetDrawCount() == 3);
+    CHECK(executor.GetVertexCount() == 2 * 36 + 2 * 24);
+
+    // Functions need GL, they are counted but not called
+    CHECK(executor.GetCommandCount(CommandType::CallFunction) == 3);
+    CHECK(commandBuffer.GetFunctionCount() == 3);
+    CHECK(functionCalls == 0);
+
+    // Functions are called in order by the GL executor, check them without it
+    for (const CommandBuffer::ConstIterator& command : commandBuffer)
+    {
+        if (command.GetType() == CommandType::CallFunction)
+        {
+            commandBuffer.GetFunction(command.Get<CommandBuffer::CallFunctionCommand>().index)();
+        }
+    }
+    CHECK(functionCalls == 3);
+
+    // Clearing forgets the state, so the same frame records the same commands
+    unsigned int commandCount = commandBuffer.GetCommandCount();
+    commandBuffer.Clear();
+    CHECK(commandBuffer.GetCommandCount() == 0 && commandBuffer.GetFunctionCount() == 0);
+    RecordGBufferFrame(commandBuffer, functionCalls);
+    CHECK(commandBuffer.GetCommandCount() == commandCount);
+}
+
+static void TestInvalidCommands()
+{
+    NullCommandExecutor executor(16);
+
+    // Draw without a program
+    CommandBuffer commandBuffer;
+    commandBuffer.BindVertexArray(VertexArrayHandles[0]);
+    commandBuffer.DrawArrays(GL_TRIANGLES, 0, 3);
+    executor.Execute(commandBuffer);
+    CHECK(executor.GetInvalidCount() == 1);
+    CHECK(executor.GetDrawCount() == 0);
+
+    // Texture unit out of range, and scissor with negative size
+    executor.Reset();
+    commandBuffer.Clear();
+    commandBuffer.BindTexture(16, GL_TEXTURE_2D, TextureHandle);
+    commandBuffer.SetScissor(0, 0, -1, 10);
+    executor.Execute(commandBuffer);
+    CHECK(executor.GetInvalidCount() == 2);
+
+    // Redundant scissor is skipped
+    commandBuffer.Clear();
+    commandBuffer.SetScissor(0, 0, 10, 10);
+    commandBuffer.SetScissor(0, 0, 10, 10);
+    CHECK(commandBuffer.GetCommandCount() == 1);
+    CHECK(commandBuffer.GetSkippedCount() == 1);
+}
+
+// ShaderProgram creates a GL object, fake it. The debug build of glad checks glGetError after every call
+static GLenum APIENTRY GetError() { return GL_NO_ERROR; }
+static GLuint APIENTRY CreateProgram() { return ProgramHandle; }
+static void APIENTRY DeleteProgram(GLuint) {}
+
+static void TestRecordedShaderProgramUniforms()
+{
+    glad_glGetError = GetError;
+    glad_glCreateProgram = CreateProgram;
+    glad_glDeleteProgram = DeleteProgram;
+
+    // glUniform is not loaded, calling it would crash: the values must only be recorded
+    ShaderProgram shaderProgram;
+    CommandBuffer commandBuffer;
+    ShaderProgram::SetRecordingCommandBuffer(&commandBuffer);
+    shaderProgram.SetUniform(1, 1);
+    shaderProgram.SetUniform(2, glm::vec3(1.0f, 2.0f, 3.0f));
+    shaderProgram.SetUniform(3, glm::mat4(1.0f));
+    ShaderProgram::SetRecordingCommandBuffer(nullptr);
+
+    CHECK(commandBuffer.GetCommandCount() == 3);
+    std::size_t payloadSizes[] = { sizeof(GLint), sizeof(glm::vec3), sizeof(glm::mat4) };
+    int index = 0;
+    for (const CommandBuffer::ConstIterator& command : commandBuffer)
+    {
+        CHECK(command.GetType() == CommandType::SetUniforms);
+        const auto& setUniforms = command.Get<CommandBuffer::SetUniformsCommand>();
+        CHECK(setUniforms.location == index + 1);
+        CHECK(command.GetPayload<CommandBuffer::SetUniformsCommand>().size() >= payloadSizes[index]);
+        index++;
+    }
+
+    const auto& vec3Command = (++commandBuffer.begin()).Get<CommandBuffer::SetUniformsCommand>();
+    CHECK(vec3Command.type == Data::Type::Float && vec3Command.components == 3 && vec3Command.columns == 1);
+}
+
+int main()
+{
+    TestRecordedFrame();
+    TestInvalidCommands();
+    TestRecordedShaderProgramUniforms();
+    return TestResult();
+}
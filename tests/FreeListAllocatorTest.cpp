@@ -0,0 +1,158 @@
+#include "TestUtils.h"
+
+#include <ituGL/core/FreeListAllocator.h>
+
+static void TestAllocate()
+{
+    FreeListAllocator allocator(100);
+    CHECK(allocator.GetCapacity() == 100);
+
+    // Ranges are handed out one after the other while there is a single free block
+    size_t a = allocator.Allocate(10);
+    size_t b = allocator.Allocate(20);
+    size_t c = allocator.Allocate(30);
+    CHECK(a == 0);
+    CHECK(b == 10);
+    CHECK(c == 30);
+
+    FreeListAllocator::Stats stats = allocator.GetStats();
+    CHECK(stats.used == 60);
+    CHECK(stats.allocationCount == 3);
+    CHECK(stats.freeBlockCount == 1);
+    CHECK(stats.largestFreeBlock == 40);
+    CHECK(stats.GetFragmentation() == 0.0f);
+}
+
+static void TestFree()
+{
+    FreeListAllocator allocator(100);
+    size_t a = allocator.Allocate(10);
+    size_t b = allocator.Allocate(20);
+    allocator.Allocate(30);
+
+    // A hole in the middle is reused, the best fit is the smallest block that is large enough
+    allocator.Free(b, 20);
+    FreeListAllocator::Stats stats = allocator.GetStats();
+    CHECK(stats.used == 40);
+    CHECK(stats.allocationCount == 2);
+    CHECK(stats.freeBlockCount == 2);
+    CHECK(stats.GetFragmentation() > 0.0f);
+
+    CHECK(allocator.Allocate(15) == b);
+    CHECK(allocator.Allocate(5) == b + 15);
+    CHECK(allocator.GetStats().freeBlockCount == 1);
+
+    // Too large for the hole, goes to the end
+    allocator.Free(a, 10);
+    CHECK(allocator.Allocate(20) == 60);
+}
+
+static void TestMerge()
+{
+    FreeListAllocator allocator(40);
+    size_t a = allocator.Allocate(10);
+    size_t b = allocator.Allocate(10);
+    size_t c = allocator.Allocate(10);
+    size_t d = allocator.Allocate(10);
+    CHECK(allocator.GetStats().freeBlockCount == 0);
+
+    // Not adjacent, two blocks
+    allocator.Free(a, 10);
+    allocator.Free(c, 10);
+    CHECK(allocator.GetStats().freeBlockCount == 2);
+
+    // Merged with the previous and the next block
+    allocator.Free(b, 10);
+    FreeListAllocator::Stats stats = allocator.GetStats();
+    CHECK(stats.freeBlockCount == 1);
+    CHECK(stats.largestFreeBlock == 30);
+
+    // Merged with the previous block, everything is free again
+    allocator.Free(d, 10);
+    stats = allocator.GetStats();
+    CHECK(stats.freeBlockCount == 1);
+    CHECK(stats.largestFreeBlock == 40);
+    CHECK(stats.used == 0);
+    CHECK(stats.allocationCount == 0);
+    CHECK(allocator.Allocate(40) == 0);
+}
+
+static void TestAlignment()
+{
+    FreeListAllocator allocator(64);
+    CHECK(allocator.Allocate(3) == 0);
+
+    // The padding before the aligned offset stays free
+    size_t offset = allocator.Allocate(8, 16);
+    CHECK(offset == 16);
+    FreeListAllocator::Stats stats = allocator.GetStats();
+    CHECK(stats.used == 11);
+    CHECK(stats.freeBlockCount == 2);
+
+    // And it can be used by smaller allocations
+    CHECK(allocator.Allocate(4, 4) == 4);
+    CHECK(allocator.Allocate(8, 8) == 8);
+    CHECK(allocator.GetStats().freeBlockCount == 2);
+}
+
+static void TestOutOfSpace()
+{
+    FreeListAllocator allocator(32);
+    size_t a = allocator.Allocate(16);
+    allocator.Allocate(8);
+    allocator.Free(a, 16);
+
+    // 24 units are free, but not in a single block
+    CHECK(allocator.Allocate(20) == FreeListAllocator::InvalidOffset);
+    CHECK(allocator.Allocate(32) == FreeListAllocator::InvalidOffset);
+    // The failed allocations don't change anything
+    FreeListAllocator::Stats stats = allocator.GetStats();
+    CHECK(stats.used == 8);
+    CHECK(stats.allocationCount == 1);
+
+    // The alignment padding counts too
+    CHECK(allocator.Allocate(8, 32) == 0);
+    CHECK(allocator.Allocate(8, 32) == FreeListAllocator::InvalidOffset);
+
+    // Growing extends the last free block
+    allocator.Grow(64);
+    stats = allocator.GetStats();
+    CHECK(stats.capacity == 64);
+    CHECK(stats.largestFreeBlock == 40);
+    CHECK(allocator.Allocate(40) == 24);
+}
+
+static void TestReset()
+{
+    FreeListAllocator allocator(100);
+    allocator.Allocate(10);
+    size_t b = allocator.Allocate(20);
+    allocator.Allocate(30);
+    allocator.Free(b, 20);
+
+    // After compacting, the two remaining allocations are packed at the start
+    allocator.Reset(40, 2);
+    FreeListAllocator::Stats stats = allocator.GetStats();
+    CHECK(stats.capacity == 100);
+    CHECK(stats.used == 40);
+    CHECK(stats.allocationCount == 2);
+    CHECK(stats.freeBlockCount == 1);
+    CHECK(stats.largestFreeBlock == 60);
+    CHECK(allocator.Allocate(60) == 40);
+
+    // Reset to the full capacity leaves no free block
+    allocator.Reset(100, 3);
+    CHECK(allocator.GetStats().freeBlockCount == 0);
+    CHECK(allocator.Allocate(1) == FreeListAllocator::InvalidOffset);
+}
+
+int main()
+{
+    TestAllocate();
+    TestFree();
+    TestMerge();
+    TestAlignment();
+    TestOutOfSpace();
+    TestReset();
+    return TestResult();
+}
@@ -0,0 +1,166 @@
+#include "TestUtils.h"
+
+#include <ituGL/renderer/LightClusterGrid.h>
+#include <ituGL/camera/Camera.h>
+#include <ituGL/lighting/DirectionalLight.h>
+#include <ituGL/lighting/PointLight.h>
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+// The grid creates its texture buffers, fake them. Only BuildLists is tested, it doesn't call GL
+// The debug build of glad checks glGetError after every call
+static GLenum APIENTRY GetError() { return GL_NO_ERROR; }
+static void APIENTRY GenObjects(GLsizei count, GLuint* handles) { std::fill(handles, handles + count, 1); }
+static void APIENTRY DeleteObjects(GLsizei, const GLuint*) {}
+
+static const float NearDepth = 1.0f;
+static const float FarDepth = 100.0f;
+static const int ViewportWidth = 64;
+static const int ViewportHeight = 64;
+
+// Looking down -Z from the origin, so view space is world space
+static Camera CreateCamera()
+{
+    Camera camera;
+    camera.SetViewMatrix(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f));
+    camera.SetPerspectiveProjectionMatrix(glm::half_pi<float>(), 1.0f, NearDepth, FarDepth);
+    return camera;
+}
+
+static std::shared_ptr<PointLight> CreatePointLight(const glm::vec3& position, float range)
+{
+    auto light = std::make_shared<PointLight>();
+    light->SetPosition(position);
+    light->SetDistanceAttenuation(glm::vec2(0.0f, range));
+    return light;
+}
+
+// Cluster that contains the point, computed from the projection and the exponential slices
+static glm::uvec3 GetCluster(const LightClusterGrid& grid, const Camera& camera, const glm::vec3& position)
+{
+    glm::uvec3 gridSize = grid.GetGridSize();
+    glm::vec4 clipPosition = camera.GetProjectionMatrix() * glm::vec4(position, 1.0f);
+    glm::vec2 pixel = (glm::vec2(clipPosition) / clipPosition.w * 0.5f + 0.5f) * glm::vec2(ViewportWidth, ViewportHeight);
+    float slice = std::log(-position.z / NearDepth) / std::log(FarDepth / NearDepth) * gridSize.z;
+    return glm::uvec3(static_cast<unsigned int>(pixel.x) / (ViewportWidth / gridSize.x),
+        static_cast<unsigned int>(pixel.y) / (ViewportHeight / gridSize.y),
+        static_cast<unsigned int>(slice));
+}
+
+static bool HasLight(const LightClusterGrid& grid, const glm::uvec3& cluster, unsigned int lightIndex)
+{
+    std::span<const unsigned int> lights = grid.GetClusterLights(cluster);
+    return std::find(lights.begin(), lights.end(), lightIndex) != lights.end();
+}
+
+// All the lists of the grid, one after the other, with the size of each list first
+static std::vector<unsigned int> GetAllLists(const LightClusterGrid& grid)
+{
+    std::vector<unsigned int> lists;
+    glm::uvec3 gridSize = grid.GetGridSize();
+    for (unsigned int z = 0; z < gridSize.z; ++z)
+    {
+        for (unsigned int y = 0; y < gridSize.y; ++y)
+        {
+            for (unsigned int x = 0; x < gridSize.x; ++x)
+            {
+                std::span<const unsigned int> lights = grid.GetClusterLights(glm::uvec3(x, y, z));
+                lists.push_back(static_cast<unsigned int>(lights.size()));
+                lists.insert(lists.end(), lights.begin(), lights.end());
+            }
+        }
+    }
+    return lists;
+}
+
+static void TestAssignLights()
+{
+    Camera camera = CreateCamera();
+    LightClusterGrid grid(4, 4, 8);
+
+    auto directionalLight = std::make_shared<DirectionalLight>();
+    auto visibleLight = CreatePointLight(glm::vec3(0.3f, 0.2f, -12.0f), 0.5f);
+    auto behindLight = CreatePointLight(glm::vec3(0.0f, 0.0f, 10.0f), 1.0f);
+    auto farLight = CreatePointLight(glm::vec3(0.0f, 0.0f, -200.0f), 1.0f);
+    auto sideLight = CreatePointLight(glm::vec3(-50.0f, 0.0f, -12.0f), 1.0f);
+    const Light* lights[] = { visibleLight.get(), behindLight.get(), directionalLight.get(), farLight.get(), sideLight.get() };
+    grid.BuildLists(camera, ViewportWidth, ViewportHeight, lights);
+
+    // The directional light is global and goes first, the lights outside the frustum are dropped
+    CHECK(grid.GetGlobalLightCount() == 1);
+    CHECK(grid.GetLightCount() == 2);
+    const unsigned int visibleLightIndex = 1;
+
+    // Only the clusters around the light have it
+    glm::uvec3 cluster = GetCluster(grid, camera, visibleLight->GetPosition());
+    CHECK(cluster == glm::uvec3(2, 2, 4));
+    CHECK(HasLight(grid, cluster, visibleLightIndex));
+    CHECK(!HasLight(grid, glm::uvec3(0, 0, 4), visibleLightIndex));
+    CHECK(!HasLight(grid, glm::uvec3(2, 2, 0), visibleLightIndex));
+    CHECK(!HasLight(grid, glm::uvec3(2, 2, 7), visibleLightIndex));
+    CHECK(grid.GetMaxClusterLightCount() == 1);
+    CHECK(grid.GetIndexCount() >= 1 && grid.GetIndexCount() < grid.GetClusterCount());
+}
+
+static void TestThreads()
+{
+    Camera camera = CreateCamera();
+
+    // Enough lights to split the slices between several threads
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> side(-0.9f, 0.9f);
+    std::uniform_real_distribution<float> depth(NearDepth * 1.1f, FarDepth * 0.9f);
+    std::uniform_real_distribution<float> range(0.5f, 8.0f);
+    std::vector<std::shared_ptr<PointLight>> pointLights;
+    std::vector<const Light*> lights;
+    for (int i = 0; i < 300; ++i)
+    {
+        float z = depth(random);
+        pointLights.push_back(CreatePointLight(glm::vec3(side(random) * z, side(random) * z, -z), range(random)));
+        lights.push_back(pointLights.back().get());
+    }
+
+    LightClusterGrid singleThreadGrid(8, 8, 16);
+    singleThreadGrid.SetThreadCount(1);
+    singleThreadGrid.BuildLists(camera, ViewportWidth, ViewportHeight, lights);
+    CHECK(singleThreadGrid.GetLightCount() == lights.size());
+    std::vector<unsigned int> singleThreadLists = GetAllLists(singleThreadGrid);
+
+    // Each light is in the cluster of its center
+    for (unsigned int i = 0; i < lights.size(); ++i)
+    {
+        CHECK(HasLight(singleThreadGrid, GetCluster(singleThreadGrid, camera, lights[i]->GetPosition()), i));
+    }
+
+    // Same lists with the worker pool, also when it is reused by the next frames
+    LightClusterGrid grid(8, 8, 16);
+    grid.SetThreadCount(4);
+    for (int frame = 0; frame < 3; ++frame)
+    {
+        grid.BuildLists(camera, ViewportWidth, ViewportHeight, lights);
+        CHECK(GetAllLists(grid) == singleThreadLists);
+        CHECK(grid.GetMaxClusterLightCount() == singleThreadGrid.GetMaxClusterLightCount());
+    }
+
+    // And with fewer lights than needed for a second thread
+    lights.resize(10);
+    grid.BuildLists(camera, ViewportWidth, ViewportHeight, lights);
+    singleThreadGrid.BuildLists(camera, ViewportWidth, ViewportHeight, lights);
+    CHECK(GetAllLists(grid) == GetAllLists(singleThreadGrid));
+}
+
+int main()
+{
+    glad_glGetError = GetError;
+    glad_glGenTextures = GenObjects;
+    glad_glDeleteTextures = DeleteObjects;
+    glad_glGenBuffers = GenObjects;
+    glad_glDeleteBuffers = DeleteObjects;
+
+    TestAssignLights();
+    TestThreads();
+    return TestResult();
+}
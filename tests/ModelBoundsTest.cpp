@@ -0,0 +1,64 @@
+#include "TestUtils.h"
+
+#include <ituGL/geometry/Model.h>
+#include <ituGL/geometry/Mesh.h>
+#include <limits>
+#include <memory>
+
+// Empty mesh with the given bounds version. Moving an empty mesh doesn't need a GL context
+static std::shared_ptr<Mesh> CreateMesh(unsigned int boundsVersion)
+{
+    std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>();
+    for (unsigned int i = 0; i < boundsVersion; ++i)
+    {
+        *mesh = Mesh();
+    }
+    return mesh;
+}
+
+static void TestVersions()
+{
+    std::shared_ptr<Mesh> mesh3 = CreateMesh(3);
+    std::shared_ptr<Mesh> mesh2 = CreateMesh(2);
+    CHECK(mesh3->GetBoundsVersion() == 3);
+    CHECK(mesh2->GetBoundsVersion() == 2);
+
+    // Changing to a mesh with a lower version must still change the version of the model
+    Model model(mesh3);
+    unsigned int version = model.GetBoundsVersion();
+    model.SetMesh(mesh2);
+    CHECK(model.GetBoundsVersion() != version);
+
+    // Changes of the mesh are seen by the model
+    version = model.GetBoundsVersion();
+    CHECK(model.GetBoundsVersion() == version);
+    *mesh2 = Mesh();
+    CHECK(model.GetBoundsVersion() != version);
+
+    version = model.GetBoundsVersion();
+    model.SetBounds(AabbBounds(glm::vec3(1.0f), glm::vec3(2.0f)));
+    CHECK(model.GetBoundsVersion() != version);
+    CHECK(model.GetAabbBounds().GetCenter() == glm::vec3(1.0f));
+
+    version = model.GetBoundsVersion();
+    model.ResetBounds();
+    CHECK(model.GetBoundsVersion() != version);
+    CHECK(model.GetAabbBounds().GetSize() == glm::vec3(0.0f));
+}
+
+static void TestPositionBounds()
+{
+    const float positions[] = { 1.0f, 2.0f, 3.0f, -1.0f, 5.0f, 0.0f, 0.5f, -2.0f, 4.0f };
+    glm::vec3 min(std::numeric_limits<float>::max());
+    glm::vec3 max(-std::numeric_limits<float>::max());
+    Mesh::AccumulatePositionBounds(positions, 3 * sizeof(float), 3, min, max);
+    CHECK(min == glm::vec3(-1.0f, -2.0f, 0.0f));
+    CHECK(max == glm::vec3(1.0f, 5.0f, 4.0f));
+}
+
+int main()
+{
+    TestVersions();
+    TestPositionBounds();
+    return TestResult();
+}
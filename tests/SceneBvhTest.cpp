@@ -0,0 +1,77 @@
+#include "TestUtils.h"
+
+#include <ituGL/scene/SceneBvh.h>
+#include <ituGL/scene/SceneModel.h>
+#include <ituGL/scene/Transform.h>
+#include <ituGL/geometry/Model.h>
+#include <memory>
+#include <vector>
+
+// Models without a mesh, with bounds of size 1 around the origin, placed along the X axis
+static std::vector<std::shared_ptr<SceneModel>> CreateSceneModels(unsigned int count)
+{
+    std::vector<std::shared_ptr<SceneModel>> sceneModels;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        std::shared_ptr<Model> model = std::make_shared<Model>();
+        model->SetBounds(AabbBounds(glm::vec3(0.0f), glm::vec3(0.5f)));
+        std::shared_ptr<SceneModel> sceneModel = std::make_shared<SceneModel>("model", model);
+        sceneModel->GetTransform()->SetTranslation(glm::vec3(10.0f * i, 0.0f, 0.0f));
+        sceneModels.push_back(sceneModel);
+    }
+    return sceneModels;
+}
+
+static unsigned int QueryCount(const SceneBvh& bvh, const AabbBounds& aabb)
+{
+    std::vector<SceneModel*> results;
+    bvh.QueryOverlap(aabb, results);
+    return static_cast<unsigned int>(results.size());
+}
+
+static void TestModelBoundsChange()
+{
+    std::vector<std::shared_ptr<SceneModel>> sceneModels = CreateSceneModels(16);
+    std::vector<SceneModel*> sceneModelPointers;
+    for (const std::shared_ptr<SceneModel>& sceneModel : sceneModels)
+    {
+        sceneModelPointers.push_back(sceneModel.get());
+    }
+
+    SceneBvh bvh;
+    bvh.Build(sceneModelPointers);
+    CHECK(bvh.Update() == 0);
+
+    // Above the first model, nothing there yet
+    AabbBounds query(glm::vec3(0.0f, 5.0f, 0.0f), glm::vec3(0.5f));
+    CHECK(QueryCount(bvh, query) == 0);
+
+    // Growing the model bounds refits the leaf
+    sceneModels[0]->GetModel()->SetBounds(AabbBounds(glm::vec3(0.0f, 2.5f, 0.0f), glm::vec3(0.5f, 3.0f, 0.5f)));
+    CHECK(bvh.Update() == 1);
+    CHECK(QueryCount(bvh, query) == 1);
+
+    // Shrinking them too
+    sceneModels[0]->GetModel()->ResetBounds();
+    CHECK(bvh.Update() == 1);
+    CHECK(QueryCount(bvh, query) == 0);
+
+    // Replacing the model, even by one with the same bounds version
+    std::shared_ptr<Model> model = std::make_shared<Model>();
+    model->SetBounds(AabbBounds(glm::vec3(0.0f, 5.0f, 0.0f), glm::vec3(1.0f)));
+    sceneModels[0]->SetModel(model);
+    CHECK(bvh.Update() == 1);
+    CHECK(QueryCount(bvh, query) == 1);
+
+    // Transform changes are still seen
+    sceneModels[0]->GetTransform()->SetTranslation(glm::vec3(0.0f, 0.0f, 20.0f));
+    CHECK(bvh.Update() == 1);
+    CHECK(QueryCount(bvh, query) == 0);
+    CHECK(bvh.Update() == 0);
+}
+
+int main()
+{
+    TestModelBoundsChange();
+    return TestResult();
+}
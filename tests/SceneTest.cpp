@@ -0,0 +1,59 @@
+#include "TestUtils.h"
+
+#include <ituGL/scene/Scene.h>
+#include <ituGL/scene/SceneCamera.h>
+#include <ituGL/scene/SceneLight.h>
+#include <ituGL/camera/Camera.h>
+#include <ituGL/lighting/PointLight.h>
+#include <type_traits>
+
+template<typename T>
+constexpr bool IsConstReference = std::is_const_v<std::remove_reference_t<T>>;
+
+static void TestForEach()
+{
+    Scene scene;
+    scene.AddSceneNode(std::make_shared<SceneNode>("node"));
+    scene.AddSceneNode(std::make_shared<SceneCamera>("camera", std::make_shared<Camera>()));
+    scene.AddSceneNode(std::make_shared<SceneLight>("light 0", std::make_shared<PointLight>()));
+    scene.AddSceneNode(std::make_shared<SceneLight>("light 1", std::make_shared<PointLight>()));
+
+    // Each type comes from its own array, SceneNode gets all of them
+    unsigned int lightCount = 0;
+    scene.ForEach<SceneLight>([&](auto& sceneLight)
+        {
+            static_assert(!IsConstReference<decltype(sceneLight)>, "A mutable scene yields mutable nodes");
+            lightCount++;
+        });
+    CHECK(lightCount == 2);
+
+    unsigned int cameraCount = 0;
+    scene.ForEach<SceneCamera>([&](SceneCamera&) { cameraCount++; });
+    CHECK(cameraCount == 1);
+
+    // A const scene only yields const nodes
+    const Scene& constScene = scene;
+    unsigned int nodeCount = 0;
+    constScene.ForEach<SceneNode>([&](auto& sceneNode)
+        {
+            static_assert(IsConstReference<decltype(sceneNode)>, "A const scene yields const nodes");
+            nodeCount++;
+        });
+    CHECK(nodeCount == 4);
+
+    // Removed nodes are not visited
+    scene.RemoveSceneNode("light 0");
+    lightCount = 0;
+    constScene.ForEach<SceneLight>([&](const SceneLight& sceneLight)
+        {
+            CHECK(sceneLight.GetName() == "light 1");
+            lightCount++;
+        });
+    CHECK(lightCount == 1);
+}
+
+int main()
+{
+    TestForEach();
+    return TestResult();
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdio>
+
+// Checks that are still evaluated in release builds, where assert is disabled
+// Each test returns the result of TestResult, so ctest sees the failures
+inline int& GetTestFailureCount()
+{
+    static int failureCount = 0;
+    return failureCount;
+}
+
+#define CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            GetTestFailureCount()++; \
+        } \
+    } while (false)
+
+inline int TestResult()
+{
+    return GetTestFailureCount() > 0 ? 1 : 0;
+}
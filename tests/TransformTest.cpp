@@ -0,0 +1,91 @@
+#include "TestUtils.h"
+
+#include <ituGL/scene/Transform.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <memory>
+
+static bool IsNear(const glm::mat4& a, const glm::mat4& b)
+{
+    for (int column = 0; column < 4; ++column)
+    {
+        for (int row = 0; row < 4; ++row)
+        {
+            if (std::abs(a[column][row] - b[column][row]) > 1e-5f)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Same matrix as Transform, built with glm
+static glm::mat4 ComputeLocalMatrix(const Transform& transform)
+{
+    glm::vec3 rotation = transform.GetRotation();
+    glm::mat4 matrix = glm::translate(glm::mat4(1.0f), transform.GetTranslation());
+    matrix = glm::rotate(matrix, rotation.y, glm::vec3(0, 1, 0));
+    matrix = glm::rotate(matrix, rotation.x, glm::vec3(1, 0, 0));
+    matrix = glm::rotate(matrix, rotation.z, glm::vec3(0, 0, 1));
+    return glm::scale(matrix, transform.GetScale());
+}
+
+static void TestMatrix()
+{
+    auto parent = std::make_shared<Transform>();
+    parent->SetTranslation(glm::vec3(1.0f, 2.0f, 3.0f));
+    parent->SetRotation(glm::vec3(0.3f, -1.2f, 0.7f));
+    parent->SetScale(glm::vec3(2.0f, 1.0f, 0.5f));
+
+    Transform child;
+    child.SetTranslation(glm::vec3(-4.0f, 0.5f, 1.0f));
+    child.SetRotation(glm::vec3(1.1f, 0.2f, -0.4f));
+    child.SetScale(glm::vec3(0.5f));
+    child.SetParent(parent);
+
+    CHECK(IsNear(child.GetTransformMatrix(), ComputeLocalMatrix(*parent) * ComputeLocalMatrix(child)));
+
+    // The Euler angles round-trip through the quaternion
+    Transform other;
+    other.SetRotationQuaternion(child.GetRotationQuaternion());
+    CHECK(glm::all(glm::lessThan(glm::abs(other.GetRotation() - child.GetRotation()), glm::vec3(1e-5f))));
+}
+
+static void TestVersions()
+{
+    // An old parent with one change less than the new one. Adding the change counts would repeat the version
+    auto oldParent = std::make_shared<Transform>();
+    oldParent->SetTranslation(glm::vec3(5.0f, 0.0f, 0.0f));
+    oldParent->SetScale(glm::vec3(1.5f));
+
+    auto newParent = std::make_shared<Transform>();
+    newParent->SetTranslation(glm::vec3(0.0f, 7.0f, 0.0f));
+    newParent->SetScale(glm::vec3(2.0f));
+    newParent->SetRotation(glm::vec3(0.0f, 1.0f, 0.0f));
+
+    Transform child;
+    child.SetParent(newParent);
+    glm::mat4 matrix = child.GetTransformMatrix();
+    unsigned int version = child.GetVersion();
+    CHECK(!child.IsDirty());
+
+    // Replacing the parent must invalidate the cached matrix, whatever the versions of the parents
+    child.SetParent(oldParent);
+    CHECK(child.GetVersion() != version);
+    CHECK(child.IsDirty());
+    CHECK(IsNear(child.GetTransformMatrix(), ComputeLocalMatrix(*oldParent)));
+    CHECK(!IsNear(child.GetTransformMatrix(), matrix));
+
+    // Changing the parent invalidates the child
+    version = child.GetVersion();
+    oldParent->SetTranslation(glm::vec3(-1.0f, 0.0f, 0.0f));
+    CHECK(child.GetVersion() != version);
+    CHECK(IsNear(child.GetTransformMatrix(), ComputeLocalMatrix(*oldParent)));
+}
+
+int main()
+{
+    TestMatrix();
+    TestVersions();
+    return TestResult();
+}